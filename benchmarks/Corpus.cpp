@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include "Corpus.h"
+
+#include <formula/bench/benchmark_data.h>
+#include <formula/parser/ParseOptions.h>
+#include <formula/parser/Preprocessor.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace formula::bench
+{
+
+namespace
+{
+
+constexpr int LARGE_LIBRARY_ENTRIES{2000};
+
+std::string read_file(std::string_view filename)
+{
+    std::ifstream in{std::string{filename}};
+    if (!in)
+    {
+        throw std::runtime_error("Couldn't open " + std::string{filename});
+    }
+    return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+std::vector<FileEntry> named_entries(std::string_view text, std::string filename)
+{
+    std::vector<FileEntry> entries{load_file_entries(text, std::move(filename))};
+    entries.erase(std::remove_if(entries.begin(), entries.end(), //
+                      [](const FileEntry &entry) { return entry.name.empty(); }),
+        entries.end());
+    return entries;
+}
+
+} // namespace
+
+const std::string &id_frm_text()
+{
+    static const std::string text{read_file(ID_FRM_FILE)};
+    return text;
+}
+
+const std::vector<FileEntry> &id_frm_entries()
+{
+    static const std::vector<FileEntry> entries{named_entries(id_frm_text(), "id.frm")};
+    return entries;
+}
+
+const FileEntry &id_frm_entry(std::string_view name)
+{
+    const std::vector<FileEntry> &entries{id_frm_entries()};
+    const auto it{std::find_if(
+        entries.begin(), entries.end(), [name](const FileEntry &entry) { return entry.name == name; })};
+    if (it == entries.end())
+    {
+        throw std::runtime_error("No entry " + std::string{name} + " in id.frm");
+    }
+    return *it;
+}
+
+std::string synthetic_library(int num_entries)
+{
+    static constexpr std::string_view functions[]{"sin", "cos", "sinh", "cosh", "exp", "log", "sqr", "tan"};
+    static constexpr std::string_view operators[]{"+", "-", "*", "/"};
+    constexpr int num_functions{static_cast<int>(std::size(functions))};
+    constexpr int num_operators{static_cast<int>(std::size(operators))};
+
+    std::ostringstream str;
+    str << "comment {\n  Synthetic library of " << num_entries << " formulas.\n}\n\n";
+    for (int i = 0; i < num_entries; ++i)
+    {
+        const bool directives{i % 4 == 3};
+        const std::string_view fn{functions[i % num_functions]};
+        const std::string_view op{operators[i % num_operators]};
+        const std::string_view other_fn{functions[(i / num_functions) % num_functions]};
+        str << "Synthetic" << i << (i % 2 == 0 ? "(XAXIS)" : "") << " { ; generated entry " << i << '\n'
+            << "  z = pixel, c = p1 + " << (i % 10) << ".25, k = " << (i % 7 + 2) << ":\n";
+        if (directives)
+        {
+            str << "$ifdef VER50\n"
+                << "  t = " << fn << "(z) " << op << " c\n"
+                << "$else\n"
+                << "  t = z " << op << " c\n"
+                << "$endif\n";
+        }
+        else
+        {
+            str << "  t = " << fn << "(z) " << op << " c\n";
+        }
+        str << "  if (|t| > k)\n"
+            << "    z = sqr(z) + " << other_fn << "(c)\n"
+            << "  elseif (real(t) < 0)\n"
+            << "    z = z*z*z " << op << " pixel\n"
+            << "  else\n"
+            << "    z = t*z + c/k\n"
+            << "  endif\n"
+            << "  |z| <= " << (4 + i % 16) << '\n'
+            << "}\n\n";
+    }
+    return str.str();
+}
+
+const std::string &large_library_text()
+{
+    static const std::string text{synthetic_library(LARGE_LIBRARY_ENTRIES)};
+    return text;
+}
+
+const std::vector<FileEntry> &large_library_entries()
+{
+    static const std::vector<FileEntry> entries{[]
+        {
+            preprocessor::Preprocessor preprocessor{preprocessor::UltraFractalMacros::ULTRAFRACTAL6};
+            return named_entries(preprocessor.process(large_library_text()), "synthetic.frm");
+        }()};
+    return entries;
+}
+
+FormulaPtr create_id_formula(std::string_view name)
+{
+    parser::Options options;
+    options.dialect = Dialect::BASIC;
+    FormulaPtr formula{create_formula(id_frm_entry(name).body, options)};
+    if (!formula)
+    {
+        throw std::runtime_error("Couldn't parse id.frm entry " + std::string{name});
+    }
+    return formula;
+}
+
+} // namespace formula::bench
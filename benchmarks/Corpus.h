@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/core/FileEntry.h>
+#include <formula/facade/Formula.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace formula::bench
+{
+
+// Benchmark inputs are loaded once per process and shared by all benchmarks.
+const std::string &id_frm_text();
+const std::vector<FileEntry> &id_frm_entries();
+const FileEntry &id_frm_entry(std::string_view name);
+
+// A deterministic synthetic formula library with the given number of entries.  Every fourth entry
+// is wrapped in compiler directives so the preprocessor has real work to do.
+std::string synthetic_library(int num_entries);
+
+// The default large synthetic library, before and after preprocessing.
+const std::string &large_library_text();
+const std::vector<FileEntry> &large_library_entries();
+
+// Creates a basic dialect formula from an id.frm entry; throws if the entry does not parse.
+FormulaPtr create_id_formula(std::string_view name);
+
+} // namespace formula::bench
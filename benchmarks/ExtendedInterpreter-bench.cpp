@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include "Corpus.h"
+
+#include <formula/interpreter/ExtendedInterpreter.h>
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace formula::bench
+{
+
+namespace
+{
+
+// id.frm is written in the basic dialect; these are extended dialect equivalents of a few of its entries.
+constexpr const char *MANDELBROT{
+    "init:\n"
+    "  z = #pixel\n"
+    "loop:\n"
+    "  z = sqr(z) + #pixel\n"
+    "bailout:\n"
+    "  |z| <= 4\n"};
+constexpr const char *RICHARD1{
+    "init:\n"
+    "  z = #pixel\n"
+    "loop:\n"
+    "  complex sq = z*z\n"
+    "  z = (sq*sin(sq) + sq) + #pixel\n"
+    "bailout:\n"
+    "  |z| <= 50\n"};
+constexpr const char *LOOP_HEAVY{
+    "init:\n"
+    "  z = #pixel\n"
+    "  complex c = #pixel\n"
+    "loop:\n"
+    "  int i = 0\n"
+    "  while i < 8\n"
+    "    c = c*0.5 + z*0.125\n"
+    "    i = i + 1\n"
+    "  endwhile\n"
+    "  z = sqr(z) + c\n"
+    "bailout:\n"
+    "  |z| <= 4\n"};
+
+constexpr Complex PIXEL{-0.1, 0.1};
+
+ExtendedInterpreter create_interpreter(const char *body)
+{
+    FileEntry entry;
+    entry.name = "Benchmark";
+    entry.body = body;
+    ExtendedInterpreterOptions options;
+    options.parser.dialect = Dialect::EXTENDED;
+    return ExtendedInterpreter{entry, options};
+}
+
+void BM_ExtendedCreate(benchmark::State &state, const char *body)
+{
+    for (auto _ : state)
+    {
+        ExtendedInterpreter interpreter{create_interpreter(body)};
+        benchmark::DoNotOptimize(interpreter.ok());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ExtendedIteration(benchmark::State &state, const char *body)
+{
+    ExtendedInterpreter interpreter{create_interpreter(body)};
+    if (!interpreter.ok())
+    {
+        state.SkipWithError("formula has diagnostics");
+        return;
+    }
+    interpreter.set_value("#pixel", Value{PIXEL});
+    interpreter.interpret(Section::INITIALIZE);
+    for (auto _ : state)
+    {
+        interpreter.interpret(Section::ITERATE);
+        if (!is_truthy(interpreter.interpret(Section::BAILOUT)))
+        {
+            interpreter.interpret(Section::INITIALIZE);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_ExtendedCreate, Mandelbrot, MANDELBROT);
+BENCHMARK_CAPTURE(BM_ExtendedIteration, Mandelbrot, MANDELBROT);
+BENCHMARK_CAPTURE(BM_ExtendedIteration, Richard1, RICHARD1);
+BENCHMARK_CAPTURE(BM_ExtendedIteration, LoopHeavy, LOOP_HEAVY);
+
+} // namespace formula::bench
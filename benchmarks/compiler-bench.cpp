@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include "Corpus.h"
+
+#include <benchmark/benchmark.h>
+
+namespace formula::bench
+{
+
+namespace
+{
+
+void BM_Compile(benchmark::State &state, const char *name)
+{
+    const FormulaPtr formula{create_id_formula(name)};
+    for (auto _ : state)
+    {
+        if (!formula->compile())
+        {
+            state.SkipWithError("compile failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_Compile, Mandelbrot, "Mandelbrot");
+BENCHMARK_CAPTURE(BM_Compile, Richard1, "Richard1");
+BENCHMARK_CAPTURE(BM_Compile, inandout04, "inandout04");
+
+} // namespace formula::bench
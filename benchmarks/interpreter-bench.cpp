@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include "Corpus.h"
+
+#include <benchmark/benchmark.h>
+
+namespace formula::bench
+{
+
+namespace
+{
+
+// A point inside the Mandelbrot set, so orbits rarely need to be restarted.
+constexpr Complex PIXEL{-0.1, 0.1};
+
+// Measures one iteration: the loop section followed by the bailout test.  When the orbit escapes,
+// it is restarted from the init section so every measured iteration does the same work.
+template <typename Evaluate>
+void iterate(benchmark::State &state, Formula &formula, Evaluate evaluate)
+{
+    formula.set_value("pixel", PIXEL);
+    evaluate(Section::INITIALIZE);
+    for (auto _ : state)
+    {
+        evaluate(Section::ITERATE);
+        if (evaluate(Section::BAILOUT).re == 0.0)
+        {
+            evaluate(Section::INITIALIZE);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_InterpretIteration(benchmark::State &state, const char *name)
+{
+    const FormulaPtr formula{create_id_formula(name)};
+    iterate(state, *formula, [&formula](Section section) { return formula->interpret(section); });
+}
+
+void BM_RunIteration(benchmark::State &state, const char *name)
+{
+    const FormulaPtr formula{create_id_formula(name)};
+    if (!formula->compile())
+    {
+        state.SkipWithError("compile failed");
+        return;
+    }
+    iterate(state, *formula, [&formula](Section section) { return formula->run(section); });
+}
+
+// The host's share of evaluating a pixel: setting pixel and reading z back.
+void BM_SymbolAccessByName(benchmark::State &state)
+{
+    const FormulaPtr formula{create_id_formula("Mandelbrot")};
+    for (auto _ : state)
+    {
+        formula->set_value("pixel", PIXEL);
+        benchmark::DoNotOptimize(formula->get_value("z"));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SymbolAccessByHandle(benchmark::State &state)
+{
+    const FormulaPtr formula{create_id_formula("Mandelbrot")};
+    const SymbolHandle pixel{formula->lookup_symbol("pixel")};
+    const SymbolHandle z{formula->lookup_symbol("z")};
+    for (auto _ : state)
+    {
+        formula->set(pixel, PIXEL);
+        benchmark::DoNotOptimize(formula->get(z));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_SymbolAccessByName);
+BENCHMARK(BM_SymbolAccessByHandle);
+BENCHMARK_CAPTURE(BM_InterpretIteration, Mandelbrot, "Mandelbrot");
+BENCHMARK_CAPTURE(BM_InterpretIteration, Richard1, "Richard1");
+BENCHMARK_CAPTURE(BM_InterpretIteration, inandout04, "inandout04");
+BENCHMARK_CAPTURE(BM_RunIteration, Mandelbrot, "Mandelbrot");
+BENCHMARK_CAPTURE(BM_RunIteration, Richard1, "Richard1");
+BENCHMARK_CAPTURE(BM_RunIteration, inandout04, "inandout04");
+
+} // namespace formula::bench
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include "Corpus.h"
+
+#include <formula/parser/Lexer.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace formula::bench
+{
+
+namespace
+{
+
+void lex_entries(benchmark::State &state, const std::vector<FileEntry> &entries)
+{
+    lexer::Options options;
+    options.dialect = Dialect::BASIC;
+    std::int64_t tokens{};
+    std::int64_t bytes{};
+    for (auto _ : state)
+    {
+        for (const FileEntry &entry : entries)
+        {
+            lexer::Lexer lexer{entry.body, options};
+            for (lexer::Token token{lexer.get_token()}; token.type != lexer::TokenType::END_OF_INPUT;
+                 token = lexer.get_token())
+            {
+                benchmark::DoNotOptimize(token);
+                ++tokens;
+            }
+            bytes += static_cast<std::int64_t>(entry.body.size());
+        }
+    }
+    state.SetItemsProcessed(tokens);
+    state.SetBytesProcessed(bytes);
+}
+
+void BM_LexIdFrm(benchmark::State &state)
+{
+    lex_entries(state, id_frm_entries());
+}
+
+void BM_LexSyntheticLibrary(benchmark::State &state)
+{
+    lex_entries(state, large_library_entries());
+}
+
+} // namespace
+
+BENCHMARK(BM_LexIdFrm);
+BENCHMARK(BM_LexSyntheticLibrary);
+
+} // namespace formula::bench
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include "Corpus.h"
+
+#include <formula/parser/ParseOptions.h>
+#include <formula/parser/Parser.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace formula::bench
+{
+
+namespace
+{
+
+void parse_entries(benchmark::State &state, const std::vector<FileEntry> &entries, Dialect dialect)
+{
+    parser::Options options;
+    options.dialect = dialect;
+    std::int64_t bytes{};
+    for (auto _ : state)
+    {
+        for (const FileEntry &entry : entries)
+        {
+            ast::FormulaSectionsPtr result{parser::create_parser(entry.body, options)->parse()};
+            benchmark::DoNotOptimize(result.get());
+            bytes += static_cast<std::int64_t>(entry.body.size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(entries.size()));
+    state.SetBytesProcessed(bytes);
+}
+
+void BM_ParseIdFrmBasic(benchmark::State &state)
+{
+    parse_entries(state, id_frm_entries(), Dialect::BASIC);
+}
+
+void BM_ParseIdFrmExtended(benchmark::State &state)
+{
+    parse_entries(state, id_frm_entries(), Dialect::EXTENDED);
+}
+
+void BM_ParseSyntheticLibrary(benchmark::State &state)
+{
+    parse_entries(state, large_library_entries(), Dialect::BASIC);
+}
+
+} // namespace
+
+BENCHMARK(BM_ParseIdFrmBasic);
+BENCHMARK(BM_ParseIdFrmExtended);
+BENCHMARK(BM_ParseSyntheticLibrary);
+
+} // namespace formula::bench
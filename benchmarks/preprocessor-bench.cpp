@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include "Corpus.h"
+
+#include <formula/parser/Preprocessor.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+
+namespace formula::bench
+{
+
+namespace
+{
+
+void preprocess(benchmark::State &state, const std::string &text)
+{
+    for (auto _ : state)
+    {
+        preprocessor::Preprocessor preprocessor{preprocessor::UltraFractalMacros::ULTRAFRACTAL6};
+        std::string result{preprocessor.process(text)};
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(text.size()));
+}
+
+void BM_PreprocessIdFrm(benchmark::State &state)
+{
+    preprocess(state, id_frm_text());
+}
+
+void BM_PreprocessSyntheticLibrary(benchmark::State &state)
+{
+    const std::string text{synthetic_library(static_cast<int>(state.range(0)))};
+    preprocess(state, text);
+}
+
+} // namespace
+
+BENCHMARK(BM_PreprocessIdFrm);
+BENCHMARK(BM_PreprocessSyntheticLibrary)->Arg(100)->Arg(1000)->Arg(10000);
+
+} // namespace formula::bench
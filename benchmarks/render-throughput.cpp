@@ -0,0 +1,363 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include "Corpus.h"
+
+#include <formula/renderer/Renderer.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace formula;
+using namespace formula::renderer;
+
+namespace
+{
+
+// The fixed render benchmark: each basic dialect entry from id.frm is paired with an extended dialect
+// translation of the same recurrence for the extended interpreter, which can't run Fractint formulas.
+// SJMand01 with p1 = 1 is the classic Mandelbrot set; id.frm's Mandelbrot entry relies on the
+// mixed-case LastSqr symbol, which basic symbol lookup doesn't fold to lastsqr.
+struct Scenario
+{
+    std::string_view name;
+    std::string_view entry;
+    Complex center;
+    double width;
+    std::vector<std::pair<std::string, Complex>> values;
+    std::string_view extended_body;
+};
+
+const std::vector<Scenario> &scenarios()
+{
+    static const std::vector<Scenario> result{
+        {"mandelbrot", "SJMand01", {-0.5, 0.0}, 3.0, {{"p1", {1.0, 0.0}}},
+            "init:\n"
+            "  z = #pixel\n"
+            "  complex c = #pixel\n"
+            "loop:\n"
+            "  z = z*z + c\n"
+            "bailout:\n"
+            "  |z| <= 64\n"},
+        {"julia", "Julike", {0.0, 0.0}, 3.0, {{"p1", {0.4, 0.3}}},
+            "init:\n"
+            "  z = #pixel\n"
+            "loop:\n"
+            "  z = z*z*z + ((0.4,0.3) - 1)*z - (0.4,0.3)\n"
+            "bailout:\n"
+            "  |z| <= 4\n"},
+        {"trig-heavy", "Richard1", {0.0, 0.0}, 4.0, {},
+            "init:\n"
+            "  z = #pixel\n"
+            "loop:\n"
+            "  complex sq = z*z\n"
+            "  z = (sq*sin(sq) + sq) + #pixel\n"
+            "bailout:\n"
+            "  |z| <= 50\n"},
+        {"loop-heavy", "inandout04", {-0.5, 0.0}, 3.0, {},
+            "init:\n"
+            "  complex k = 1\n"
+            "  complex test = 4\n"
+            "  z = #pixel\n"
+            "  complex c = #pixel\n"
+            "  complex mz = |z|\n"
+            "  complex moldz = mz\n"
+            "loop:\n"
+            "  if mz > moldz\n"
+            "    c = c*k\n"
+            "  endif\n"
+            "  moldz = mz\n"
+            "  z = sin(z*z) + c\n"
+            "  mz = |z|\n"
+            "bailout:\n"
+            "  mz <= test\n"},
+    };
+    return result;
+}
+
+struct Measurement
+{
+    std::string formula;
+    Backend backend{};
+    int threads{};
+    RenderStats stats;
+    double efficiency{};
+    std::string error;
+};
+
+RenderFormula render_formula(const Scenario &scenario, Backend backend)
+{
+    RenderFormula result;
+    result.name = std::string{scenario.entry};
+    if (backend == Backend::EXTENDED)
+    {
+        result.body = std::string{scenario.extended_body};
+        result.dialect = Dialect::EXTENDED;
+        return result;
+    }
+    result.body = bench::id_frm_entry(scenario.entry).body;
+    result.dialect = Dialect::BASIC;
+    for (const auto &[name, value] : scenario.values)
+    {
+        result.values[name] = value;
+    }
+    return result;
+}
+
+std::string json_escape(std::string_view text)
+{
+    std::string result;
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            result += '\\';
+            result += c;
+        }
+        else if (c == '\n')
+        {
+            result += "\\n";
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    return result;
+}
+
+void write_json(std::ostream &out, const RenderOptions &options, const std::vector<Measurement> &measurements)
+{
+    out << "{\n"
+        << "  \"context\": {\n"
+        << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"width\": " << options.viewport.pixel_width << ",\n"
+        << "    \"height\": " << options.viewport.pixel_height << ",\n"
+        << "    \"max_iterations\": " << options.max_iterations << "\n"
+        << "  },\n"
+        << "  \"results\": [";
+    const char *separator{"\n"};
+    for (const Measurement &measurement : measurements)
+    {
+        out << separator << "    {\"formula\": \"" << measurement.formula << "\", \"backend\": \""
+            << to_string(measurement.backend) << "\", \"threads\": " << measurement.threads;
+        if (measurement.error.empty())
+        {
+            out << ", \"pixels\": " << measurement.stats.pixels                                 //
+                << ", \"iterations\": " << measurement.stats.iterations                         //
+                << ", \"seconds\": " << measurement.stats.elapsed.count()                       //
+                << ", \"pixels_per_second\": " << pixels_per_second(measurement.stats)         //
+                << ", \"iterations_per_second\": " << iterations_per_second(measurement.stats) //
+                << ", \"scaling_efficiency\": " << measurement.efficiency;
+        }
+        else
+        {
+            out << ", \"error\": \"" << json_escape(measurement.error) << '"';
+        }
+        out << '}';
+        separator = ",\n";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void print(const Measurement &measurement)
+{
+    std::cout << std::left << std::setw(12) << measurement.formula << std::setw(13) << to_string(measurement.backend)
+              << std::right << std::setw(8) << measurement.threads;
+    if (!measurement.error.empty())
+    {
+        std::cout << "  skipped: " << measurement.error.substr(0, measurement.error.find('\n')) << '\n';
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(3)                                       //
+              << std::setw(12) << measurement.stats.elapsed.count()                         //
+              << std::setw(12) << pixels_per_second(measurement.stats) / 1.0e6             //
+              << std::setw(12) << iterations_per_second(measurement.stats) / 1.0e9         //
+              << std::setw(12) << std::setprecision(2) << measurement.efficiency * 100.0 //
+              << "%\n";
+}
+
+Measurement measure(const Scenario &scenario, Backend backend, RenderOptions options, int threads)
+{
+    Measurement result;
+    result.formula = std::string{scenario.name};
+    result.backend = backend;
+    result.threads = threads;
+    options.viewport.center = scenario.center;
+    options.viewport.width = scenario.width;
+    options.threads = threads;
+    try
+    {
+        result.stats = render(render_formula(scenario, backend), backend, options).stats;
+    }
+    catch (const std::exception &error)
+    {
+        result.error = error.what();
+    }
+    return result;
+}
+
+bool parse_size(std::string_view text, Viewport &viewport)
+{
+    const std::size_t x{text.find('x')};
+    if (x == std::string_view::npos)
+    {
+        return false;
+    }
+    viewport.pixel_width = std::stoi(std::string{text.substr(0, x)});
+    viewport.pixel_height = std::stoi(std::string{text.substr(x + 1)});
+    return viewport.pixel_width > 0 && viewport.pixel_height > 0;
+}
+
+std::optional<Backend> parse_backend(std::string_view text)
+{
+    for (const Backend backend : {Backend::INTERPRETER, Backend::COMPILER, Backend::EXTENDED, Backend::KERNEL})
+    {
+        if (text == to_string(backend))
+        {
+            return backend;
+        }
+    }
+    return {};
+}
+
+int usage(std::string_view program)
+{
+    std::cerr << "Usage: " << program
+              << " [--size WxH] [--max-iterations N] [--threads N] [--backend interpreter|compiler|extended|kernel]"
+                 " [--formula NAME] [--json FILE] [--perf-map] [--gdb-jit]\n";
+    return 1;
+}
+
+int main(const std::vector<std::string_view> &args)
+{
+    RenderOptions options;
+    options.viewport.pixel_width = 320;
+    options.viewport.pixel_height = 240;
+    options.max_iterations = 256;
+    int max_threads{std::max(1, static_cast<int>(std::thread::hardware_concurrency()))};
+    std::vector<Backend> backends{Backend::INTERPRETER, Backend::COMPILER, Backend::EXTENDED, Backend::KERNEL};
+    std::string_view formula_filter;
+    std::string json_file;
+    for (std::size_t i = 1; i < args.size(); ++i)
+    {
+        const bool has_value{i + 1 < args.size()};
+        if (args[i] == "--size" && has_value)
+        {
+            if (!parse_size(args[++i], options.viewport))
+            {
+                return usage(args[0]);
+            }
+        }
+        else if (args[i] == "--max-iterations" && has_value)
+        {
+            options.max_iterations = std::stoi(std::string{args[++i]});
+        }
+        else if (args[i] == "--threads" && has_value)
+        {
+            max_threads = std::max(1, std::stoi(std::string{args[++i]}));
+        }
+        else if (args[i] == "--backend" && has_value)
+        {
+            const std::optional<Backend> backend{parse_backend(args[++i])};
+            if (!backend)
+            {
+                return usage(args[0]);
+            }
+            backends = {*backend};
+        }
+        else if (args[i] == "--formula" && has_value)
+        {
+            formula_filter = args[++i];
+        }
+        else if (args[i] == "--json" && has_value)
+        {
+            json_file = std::string{args[++i]};
+        }
+        else if (args[i] == "--perf-map")
+        {
+            options.compile.perf_map = true;
+        }
+        else if (args[i] == "--gdb-jit")
+        {
+            options.compile.gdb_jit = true;
+        }
+        else
+        {
+            return usage(args[0]);
+        }
+    }
+
+    std::cout << options.viewport.pixel_width << 'x' << options.viewport.pixel_height << " pixels, "
+              << options.max_iterations << " iterations maximum\n\n"
+              << std::left << std::setw(12) << "formula" << std::setw(13) << "backend" << std::right
+              << std::setw(8) << "threads" << std::setw(12) << "seconds" << std::setw(12) << "Mpixel/s"
+              << std::setw(12) << "Giter/s" << std::setw(13) << "efficiency\n";
+    std::vector<Measurement> measurements;
+    for (const Scenario &scenario : scenarios())
+    {
+        if (!formula_filter.empty() && formula_filter != scenario.name)
+        {
+            continue;
+        }
+        for (const Backend backend : backends)
+        {
+            Measurement single{measure(scenario, backend, options, 1)};
+            single.efficiency = 1.0;
+            print(single);
+            measurements.push_back(single);
+            if (max_threads > 1)
+            {
+                Measurement full{measure(scenario, backend, options, max_threads)};
+                if (full.error.empty() && single.error.empty())
+                {
+                    full.efficiency = pixels_per_second(full.stats) / (pixels_per_second(single.stats) * max_threads);
+                }
+                print(full);
+                measurements.push_back(full);
+            }
+        }
+    }
+
+    if (!json_file.empty())
+    {
+        std::ofstream out{json_file};
+        if (!out)
+        {
+            std::cerr << "Error: couldn't write " << json_file << '\n';
+            return 1;
+        }
+        write_json(out, options, measurements);
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string_view> args;
+    for (int i = 0; i < argc; ++i)
+    {
+        args.emplace_back(argv[i]);
+    }
+    try
+    {
+        return main(args);
+    }
+    catch (const std::exception &error)
+    {
+        std::cerr << "Error: " << error.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include "Corpus.h"
+
+#include <formula/parser/ParseOptions.h>
+#include <formula/parser/Parser.h>
+#include <formula/semantics/SemanticAnalyzer.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace formula::bench
+{
+
+namespace
+{
+
+std::vector<ast::FormulaSectionsPtr> parse_all(const std::vector<FileEntry> &entries)
+{
+    parser::Options options;
+    options.dialect = Dialect::BASIC;
+    std::vector<ast::FormulaSectionsPtr> result;
+    for (const FileEntry &entry : entries)
+    {
+        if (ast::FormulaSectionsPtr sections{parser::create_parser(entry.body, options)->parse()})
+        {
+            result.push_back(std::move(sections));
+        }
+    }
+    return result;
+}
+
+void analyze_all(benchmark::State &state, const std::vector<FileEntry> &entries)
+{
+    const std::vector<ast::FormulaSectionsPtr> formulas{parse_all(entries)};
+    const semantic::FormulaSemanticContext context;
+    for (auto _ : state)
+    {
+        for (const ast::FormulaSectionsPtr &formula : formulas)
+        {
+            std::vector<semantic::SemanticDiagnostic> diagnostics{semantic::analyze_formula(*formula, context)};
+            benchmark::DoNotOptimize(diagnostics.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(formulas.size()));
+}
+
+void BM_AnalyzeIdFrm(benchmark::State &state)
+{
+    analyze_all(state, id_frm_entries());
+}
+
+void BM_AnalyzeSyntheticLibrary(benchmark::State &state)
+{
+    analyze_all(state, large_library_entries());
+}
+
+} // namespace
+
+BENCHMARK(BM_AnalyzeIdFrm);
+BENCHMARK(BM_AnalyzeSyntheticLibrary);
+
+} // namespace formula::bench
@@ -9,10 +9,13 @@
 #include <formula/core/functions.h>
 #include <formula/core/Node.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
-#include <random>
+#include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
 #define ASMJIT_STORE(expr_)                       \
@@ -79,6 +82,82 @@ static CompileError store_double(asmjit::x86::Compiler &comp, double &dest, asmj
     return {};
 }
 
+InstructionSet detect_instruction_set(const asmjit::CpuFeatures &features)
+{
+    const asmjit::CpuFeatures::X86 &x86{features.x86()};
+    if (!x86.hasAVX2() || !x86.hasFMA())
+    {
+        return InstructionSet::SSE2;
+    }
+    if (!x86.hasAVX512_F() || !x86.hasAVX512_VL())
+    {
+        return InstructionSet::AVX2;
+    }
+    return InstructionSet::AVX512;
+}
+
+void enable_instruction_set(asmjit::FuncNode &func, const EmitterState &state)
+{
+    // The register allocator only hands out xmm16-xmm31 to AVX-512 enabled functions.
+    if (state.instruction_set == InstructionSet::AVX512)
+    {
+        func.frame().setAvx512Enabled();
+    }
+    else if (state.instruction_set == InstructionSet::AVX2)
+    {
+        func.frame().setAvxEnabled();
+    }
+}
+
+static bool has_fma(const EmitterState &state)
+{
+    return state.instruction_set >= InstructionSet::AVX2;
+}
+
+// sum.x = x^2 + y^2 for argument = [x, y]; the high lane of sum is left undefined.
+static CompileError fma_norm(asmjit::x86::Compiler &comp, asmjit::x86::Xmm sum, asmjit::x86::Xmm argument)
+{
+    asmjit::x86::Xmm swapped{comp.newXmm()};
+    ASMJIT_CHECK(comp.vpermilpd(swapped, argument, 1));    // swapped = [y, x]
+    ASMJIT_CHECK(comp.vmulsd(sum, argument, argument));    // sum.x = x^2
+    ASMJIT_CHECK(comp.vfmadd231sd(sum, swapped, swapped)); // sum.x += y^2
+    return {};
+}
+
+// (a + bi)(c + di) = (ac - bd) + (ad + bc)i, one fused multiply-add per lane.
+static CompileError fma_multiply(asmjit::x86::Compiler &comp, asmjit::x86::Xmm result, asmjit::x86::Xmm right)
+{
+    asmjit::x86::Xmm real{comp.newXmm()};
+    asmjit::x86::Xmm imag{comp.newXmm()};
+    asmjit::x86::Xmm swapped{comp.newXmm()};
+    ASMJIT_CHECK(comp.vmovddup(real, result));              // real = [a, a]
+    ASMJIT_CHECK(comp.vpermilpd(imag, result, 3));          // imag = [b, b]
+    ASMJIT_CHECK(comp.vpermilpd(swapped, right, 1));        // swapped = [d, c]
+    ASMJIT_CHECK(comp.vmulpd(result, imag, swapped));       // result = [bd, bc]
+    ASMJIT_CHECK(comp.vfmaddsub231pd(result, real, right)); // result = [ac - bd, ad + bc]
+    return {};
+}
+
+// (u + vi) / (x + yi) = ((ux + vy) + (vx - uy)i) / (x^2 + y^2).  The denominator isn't fused, so both
+// lanes divide by the same value.
+static CompileError fma_divide(asmjit::x86::Compiler &comp, asmjit::x86::Xmm result, asmjit::x86::Xmm right)
+{
+    asmjit::x86::Xmm real{comp.newXmm()};
+    asmjit::x86::Xmm imag{comp.newXmm()};
+    asmjit::x86::Xmm swapped{comp.newXmm()};
+    asmjit::x86::Xmm denominator{comp.newXmm()};
+    ASMJIT_CHECK(comp.vmovddup(real, result));                    // real = [u, u]
+    ASMJIT_CHECK(comp.vpermilpd(imag, result, 3));                // imag = [v, v]
+    ASMJIT_CHECK(comp.vmulpd(denominator, right, right));         // denominator = [x^2, y^2]
+    ASMJIT_CHECK(comp.vpermilpd(swapped, denominator, 1));        // swapped = [y^2, x^2]
+    ASMJIT_CHECK(comp.vaddpd(denominator, denominator, swapped)); // denominator = [x^2 + y^2, x^2 + y^2]
+    ASMJIT_CHECK(comp.vpermilpd(swapped, right, 1));              // swapped = [y, x]
+    ASMJIT_CHECK(comp.vmulpd(result, real, right));               // result = [ux, uy]
+    ASMJIT_CHECK(comp.vfmsubadd231pd(result, imag, swapped));     // result = [ux + vy, vx - uy]
+    ASMJIT_CHECK(comp.vdivpd(result, result, denominator));
+    return {};
+}
+
 class Compiler : public NullVisitor
 {
 public:
@@ -121,6 +200,11 @@ public:
 
 private:
     void compile_operand(const Node &node, asmjit::x86::Xmm operand);
+    void fall_back(const Node &node);
+    bool is_real(const Node &node) const
+    {
+        return state.real_expressions.count(&node) != 0;
+    }
 
     asmjit::x86::Compiler &comp;
     EmitterState &state;
@@ -128,54 +212,54 @@ private:
     CompileError &m_err;
 };
 
-void Compiler::visit(const ConstantRefNode &)
+void Compiler::visit(const ConstantRefNode &node)
 {
-    m_err = asmjit::kErrorInvalidState;
+    fall_back(node);
 }
 
-void Compiler::visit(const DeclarationNode &)
+void Compiler::visit(const DeclarationNode &node)
 {
-    m_err = asmjit::kErrorInvalidState;
+    fall_back(node);
 }
 
-void Compiler::visit(const FunctionDeclNode &)
+void Compiler::visit(const FunctionDeclNode &node)
 {
-    m_err = asmjit::kErrorInvalidState;
+    fall_back(node);
 }
 
-void Compiler::visit(const IndexNode &)
+void Compiler::visit(const IndexNode &node)
 {
-    m_err = asmjit::kErrorInvalidState;
+    fall_back(node);
 }
 
-void Compiler::visit(const MemberAccessNode &)
+void Compiler::visit(const MemberAccessNode &node)
 {
-    m_err = asmjit::kErrorInvalidState;
+    fall_back(node);
 }
 
-void Compiler::visit(const NewNode &)
+void Compiler::visit(const NewNode &node)
 {
-    m_err = asmjit::kErrorInvalidState;
+    fall_back(node);
 }
 
-void Compiler::visit(const ParameterRefNode &)
+void Compiler::visit(const ParameterRefNode &node)
 {
-    m_err = asmjit::kErrorInvalidState;
+    fall_back(node);
 }
 
-void Compiler::visit(const RepeatUntilNode &)
+void Compiler::visit(const RepeatUntilNode &node)
 {
-    m_err = asmjit::kErrorInvalidState;
+    fall_back(node);
 }
 
-void Compiler::visit(const ReturnNode &)
+void Compiler::visit(const ReturnNode &node)
 {
-    m_err = asmjit::kErrorInvalidState;
+    fall_back(node);
 }
 
-void Compiler::visit(const WhileNode &)
+void Compiler::visit(const WhileNode &node)
 {
-    m_err = asmjit::kErrorInvalidState;
+    fall_back(node);
 }
 
 void Compiler::visit(const LiteralNode &node)
@@ -195,6 +279,10 @@ void Compiler::visit(const LiteralNode &node)
         value = std::get<Complex>(node.value());
         break;
 
+    case 3:
+        value.re = std::get<bool>(node.value()) ? 1.0 : 0.0;
+        break;
+
     default:
         throw std::runtime_error("Unknown LiteralNode variant index " + std::to_string(node.value().index()));
     }
@@ -308,11 +396,21 @@ static CompileError store_lastsqr(asmjit::x86::Compiler &comp, EmitterState &sta
     asmjit::x86::Xmm squared{comp.newXmm()};
     asmjit::x86::Xmm sum{comp.newXmm()};
     asmjit::x86::Xmm zero{comp.newXmm()};
-    ASMJIT_CHECK(comp.movapd(squared, argument));
-    ASMJIT_CHECK(comp.mulpd(squared, squared));
-    ASMJIT_CHECK(comp.movapd(sum, squared));
-    ASMJIT_CHECK(comp.shufpd(sum, sum, 1));
-    ASMJIT_CHECK(comp.addsd(sum, squared));
+    if (has_fma(state))
+    {
+        if (const CompileError err = fma_norm(comp, sum, argument); err)
+        {
+            return err;
+        }
+    }
+    else
+    {
+        ASMJIT_CHECK(comp.movapd(squared, argument));
+        ASMJIT_CHECK(comp.mulpd(squared, squared));
+        ASMJIT_CHECK(comp.movapd(sum, squared));
+        ASMJIT_CHECK(comp.shufpd(sum, sum, 1));
+        ASMJIT_CHECK(comp.addsd(sum, squared));
+    }
     if (const CompileError err = store_double(comp, lastsqr.re, sum); err)
     {
         return err;
@@ -327,12 +425,12 @@ static CompileError store_lastsqr(asmjit::x86::Compiler &comp, EmitterState &sta
 
 static void seed_random(void *random, const void *seed_arg, void *rand_symbol)
 {
-    auto *generator{static_cast<std::mt19937 *>(random)};
+    auto *generator{static_cast<RandomState *>(random)};
     const auto *seed{static_cast<const Complex *>(seed_arg)};
     auto *rand{static_cast<Complex *>(rand_symbol)};
     if (generator != nullptr && seed != nullptr)
     {
-        generator->seed(static_cast<std::mt19937::result_type>(seed->re));
+        generator->seed(static_cast<std::uint32_t>(seed->re));
     }
     if (rand != nullptr)
     {
@@ -366,8 +464,94 @@ static CompileError call_srand(asmjit::x86::Compiler &comp, EmitterState &state,
     return {};
 }
 
+static int poll_cancellation(const void *slot)
+{
+    const CancellationToken *token{*static_cast<const CancellationToken *const *>(slot)};
+    return token != nullptr && token->cancelled() ? 1 : 0;
+}
+
+// Polls when iteration reaches a multiple of the interval; a loop advancing iteration by stride polls
+// when it passes one instead.
+static CompileError call_poll_cancellation(asmjit::x86::Compiler &comp, EmitterState &state,
+    asmjit::x86::Gp iteration, int stride, asmjit::Label &cancelled)
+{
+    asmjit::Label skip{comp.newLabel()};
+    if (stride == 1)
+    {
+        ASMJIT_CHECK(comp.test(iteration, asmjit::imm(ORBIT_CANCELLATION_INTERVAL - 1)));
+        ASMJIT_CHECK(comp.jnz(skip));
+    }
+    else
+    {
+        asmjit::x86::Gp phase = comp.newInt32();
+        ASMJIT_CHECK(comp.mov(phase, iteration));
+        ASMJIT_CHECK(comp.and_(phase, asmjit::imm(ORBIT_CANCELLATION_INTERVAL - 1)));
+        ASMJIT_CHECK(comp.cmp(phase, asmjit::imm(stride)));
+        ASMJIT_CHECK(comp.jae(skip));
+    }
+    asmjit::x86::Gp slot_ptr = comp.newIntPtr();
+    asmjit::x86::Gp stop = comp.newInt32();
+    ASMJIT_CHECK(comp.mov(slot_ptr, asmjit::imm(reinterpret_cast<std::uintptr_t>(state.cancellation))));
+
+    asmjit::InvokeNode *invoke_node;
+    asmjit::Imm target{asmjit::imm(reinterpret_cast<void *>(poll_cancellation))};
+    ASMJIT_CHECK(comp.invoke(&invoke_node, target, asmjit::FuncSignature::build<int, const void *>()));
+    invoke_node->setArg(0, slot_ptr);
+    invoke_node->setRet(0, stop);
+    ASMJIT_CHECK(comp.test(stop, stop));
+    ASMJIT_CHECK(comp.jnz(cancelled));
+    ASMJIT_CHECK(comp.bind(skip));
+    return {};
+}
+
+static void advance_random(void *random, void *rand_symbol)
+{
+    *static_cast<Complex *>(rand_symbol) = static_cast<RandomState *>(random)->next();
+}
+
+static void rewind_random(void *random, int steps)
+{
+    static_cast<RandomState *>(random)->rewind(static_cast<std::uint32_t>(steps));
+}
+
+static CompileError call_rewind_random(asmjit::x86::Compiler &comp, EmitterState &state, int steps)
+{
+    asmjit::x86::Gp random_ptr = comp.newIntPtr();
+    asmjit::x86::Gp steps_arg = comp.newInt32();
+    ASMJIT_CHECK(comp.mov(random_ptr, asmjit::imm(reinterpret_cast<std::uintptr_t>(state.random))));
+    ASMJIT_CHECK(comp.mov(steps_arg, asmjit::imm(steps)));
+
+    asmjit::InvokeNode *invoke_node;
+    asmjit::Imm target{asmjit::imm(reinterpret_cast<void *>(rewind_random))};
+    ASMJIT_CHECK(comp.invoke(&invoke_node, target, asmjit::FuncSignature::build<void, void *, int>()));
+    invoke_node->setArg(0, random_ptr);
+    invoke_node->setArg(1, steps_arg);
+    return {};
+}
+
+static CompileError call_advance_random(asmjit::x86::Compiler &comp, EmitterState &state)
+{
+    Complex &rand{get_symbol_storage(state, "rand")};
+    asmjit::x86::Gp random_ptr = comp.newIntPtr();
+    asmjit::x86::Gp rand_ptr = comp.newIntPtr();
+    ASMJIT_CHECK(comp.mov(random_ptr, asmjit::imm(reinterpret_cast<std::uintptr_t>(state.random))));
+    ASMJIT_CHECK(comp.mov(rand_ptr, asmjit::imm(reinterpret_cast<std::uintptr_t>(&rand))));
+
+    asmjit::InvokeNode *invoke_node;
+    asmjit::Imm target{asmjit::imm(reinterpret_cast<void *>(advance_random))};
+    ASMJIT_CHECK(comp.invoke(&invoke_node, target, asmjit::FuncSignature::build<void, void *, void *>()));
+    invoke_node->setArg(0, random_ptr);
+    invoke_node->setArg(1, rand_ptr);
+    return {};
+}
+
 void Compiler::visit(const FunctionCallNode &node)
 {
+    if (node.has_target())
+    {
+        fall_back(node);
+        return;
+    }
     node.arg()->visit(*this);
     if (!success())
     {
@@ -408,6 +592,17 @@ void Compiler::visit(const FunctionCallNode &node)
             return;
         }
     }
+    RealFunction *real_fn{lookup_real(name)};
+    if (real_fn != nullptr && is_real(node) && is_real(*node.arg()))
+    {
+        if (const CompileError err = call(comp, real_fn, m_result.back()); err)
+        {
+            m_err = err;
+            return;
+        }
+        ASMJIT_STORE(comp.movq(m_result.back(), m_result.back())); // result = [f(re), 0.0]
+        return;
+    }
     if (ComplexFunction *fn = lookup_complex(name))
     {
         if (const CompileError err = call_unary(comp, fn, m_result.back()); err)
@@ -433,6 +628,12 @@ void Compiler::visit(const UnaryOpNode &node)
             return;
         }
         asmjit::x86::Xmm tmp = comp.newXmm();
+        if (has_fma(state))
+        {
+            ASMJIT_STORE(comp.vxorpd(tmp, tmp, tmp));                 // tmp = 0.0          [0.0, 0.0]
+            ASMJIT_STORE(comp.vsubpd(m_result.back(), tmp, operand)); // result = tmp - op  [-re, -im]
+            return;
+        }
         ASMJIT_STORE(comp.xorpd(tmp, tmp));              // tmp = 0.0          [0.0, 0.0]
         ASMJIT_STORE(comp.subpd(tmp, operand));          // tmp -= operand     [-re, -im]      negate operand
         ASMJIT_STORE(comp.movapd(m_result.back(), tmp)); // result = tmp       [-re, -im]
@@ -445,6 +646,25 @@ void Compiler::visit(const UnaryOpNode &node)
         {
             return;
         }
+        if (is_real(*node.operand()))
+        {
+            ASMJIT_STORE(comp.mulsd(operand, operand));                 // op.x *= op.x       [x^2, 0.0]
+            ASMJIT_STORE(comp.xorpd(m_result.back(), m_result.back())); // result = 0         [0.0, 0.0]
+            ASMJIT_STORE(comp.movsd(m_result.back(), operand));         // result.x = op.x    [x^2, 0.0]
+            return;
+        }
+        if (has_fma(state))
+        {
+            asmjit::x86::Xmm sum{comp.newXmm()};
+            if (const CompileError err = fma_norm(comp, sum, operand); err)
+            {
+                m_err = err;
+                return;
+            }
+            ASMJIT_STORE(comp.vxorpd(m_result.back(), m_result.back(), m_result.back())); // result = [0.0, 0.0]
+            ASMJIT_STORE(comp.vmovsd(m_result.back(), m_result.back(), sum));             // result.x = sum.x
+            return;
+        }
         ASMJIT_STORE(comp.mulpd(operand, operand));                 // op *= op           [x^2, y^2]
         ASMJIT_STORE(comp.xorpd(m_result.back(), m_result.back())); // result = 0         [0.0, 0.0]
         ASMJIT_STORE(comp.movsd(m_result.back(), operand));         // result.x = op.x    [x^2, 0.0]
@@ -528,6 +748,47 @@ void Compiler::visit(const BinaryOpNode &node)
         comp.subpd(m_result.back(), right); // result -= right
         return;
     }
+    const bool left_real{is_real(*node.left())};
+    const bool right_real{is_real(*node.right())};
+    if (op == "*" && left_real && right_real)
+    {
+        // [a, 0] * [c, 0] = [ac, 0]
+        ASMJIT_STORE(comp.mulsd(m_result.back(), right));
+        return;
+    }
+    if (op == "*" && (left_real || right_real))
+    {
+        // A real factor scales both lanes of the other: [a, 0] * [c, d] = [ac, ad]
+        ASMJIT_STORE(left_real ? comp.unpcklpd(m_result.back(), m_result.back()) : comp.unpcklpd(right, right));
+        ASMJIT_STORE(comp.mulpd(m_result.back(), right));
+        return;
+    }
+    if (op == "/" && right_real)
+    {
+        // [u, v] / [x, 0] = [ux/x^2, vx/x^2], the complex quotient without the zero cross terms, so a zero
+        // divisor gives NaN like the interpreter instead of infinity.
+        ASMJIT_STORE(comp.unpcklpd(right, right));        // right = [x, x]
+        ASMJIT_STORE(comp.mulpd(m_result.back(), right)); // result = [ux, vx]
+        ASMJIT_STORE(comp.mulpd(right, right));           // right = [x^2, x^2]
+        ASMJIT_STORE(comp.divpd(m_result.back(), right)); // result = [ux/x^2, vx/x^2]
+        return;
+    }
+    if (op == "*" && has_fma(state))
+    {
+        if (const CompileError err = fma_multiply(comp, m_result.back(), right); err)
+        {
+            m_err = err;
+        }
+        return;
+    }
+    if (op == "/" && has_fma(state))
+    {
+        if (const CompileError err = fma_divide(comp, m_result.back(), right); err)
+        {
+            m_err = err;
+        }
+        return;
+    }
     if (op == "*")
     {
         // (a + bi)(c + di) = (ac - bd) + (ad + bc)i
@@ -752,6 +1013,34 @@ void Compiler::compile_operand(const Node &node, asmjit::x86::Xmm operand)
     m_result.pop_back();
 }
 
+void Compiler::fall_back(const Node &node)
+{
+    const InterpreterFallback &fallback{state.fallback};
+    if (fallback.evaluate == nullptr || !fallback.supports(node, state.functions))
+    {
+        m_err = asmjit::kErrorInvalidState;
+        return;
+    }
+    asmjit::x86::Mem result_slot = comp.newStack(sizeof(Complex), alignof(Complex));
+    asmjit::x86::Gp context_ptr = comp.newUIntPtr();
+    asmjit::x86::Gp node_ptr = comp.newUIntPtr();
+    asmjit::x86::Gp result_ptr = comp.newUIntPtr();
+    ASMJIT_STORE(comp.mov(context_ptr, asmjit::imm(reinterpret_cast<std::uintptr_t>(fallback.context))));
+    ASMJIT_STORE(comp.mov(node_ptr, asmjit::imm(reinterpret_cast<std::uintptr_t>(&node))));
+    ASMJIT_STORE(comp.lea(result_ptr, result_slot));
+
+    asmjit::InvokeNode *invoke_node;
+    asmjit::Imm target{asmjit::imm(reinterpret_cast<void *>(fallback.evaluate))};
+    ASMJIT_STORE(
+        comp.invoke(&invoke_node, target, asmjit::FuncSignature::build<void, void *, const void *, void *>()));
+    invoke_node->setArg(0, context_ptr);
+    invoke_node->setArg(1, node_ptr);
+    invoke_node->setArg(2, result_ptr);
+
+    ASMJIT_STORE(comp.movlpd(m_result.back(), result_slot));
+    ASMJIT_STORE(comp.movhpd(m_result.back(), result_slot.cloneAdjusted(sizeof(double))));
+}
+
 CompileError compile(
     const std::shared_ptr<Node> &expr, asmjit::x86::Compiler &comp, EmitterState &state, asmjit::x86::Xmm result)
 {
@@ -761,4 +1050,315 @@ CompileError compile(
     return err;
 }
 
+namespace
+{
+
+// The symbols an orbit step can write, so an unrolled orbit can checkpoint them, whether it reseeds rand,
+// which a checkpoint can't undo, and whether it calls the interpreter fallback, whose errors in steps past
+// the escape would outlive the rollback.
+class OrbitEffects : public NullVisitor
+{
+public:
+    OrbitEffects() = default;
+    ~OrbitEffects() override = default;
+
+    void add(const std::shared_ptr<Node> &node)
+    {
+        if (node)
+        {
+            node->visit(*this);
+        }
+    }
+
+    void visit(const AssignmentNode &node) override
+    {
+        m_written.insert(node.variable());
+        add(node.expression());
+    }
+    void visit(const ConstantRefNode &) override
+    {
+        m_interprets = true;
+    }
+    void visit(const DeclarationNode &) override
+    {
+        m_interprets = true;
+    }
+    void visit(const FunctionDeclNode &) override
+    {
+        m_interprets = true;
+    }
+    void visit(const IndexNode &) override
+    {
+        m_interprets = true;
+    }
+    void visit(const MemberAccessNode &) override
+    {
+        m_interprets = true;
+    }
+    void visit(const NewNode &) override
+    {
+        m_interprets = true;
+    }
+    void visit(const ParameterRefNode &) override
+    {
+        m_interprets = true;
+    }
+    void visit(const ReturnNode &) override
+    {
+        m_interprets = true;
+    }
+    void visit(const BinaryOpNode &node) override
+    {
+        add(node.left());
+        add(node.right());
+    }
+    void visit(const FunctionCallNode &node) override
+    {
+        if (node.name() == "srand")
+        {
+            m_reseeds = true;
+        }
+        if (node.has_target())
+        {
+            m_interprets = true;
+        }
+        for (const std::shared_ptr<Node> &arg : node.args())
+        {
+            add(arg);
+        }
+    }
+    void visit(const IfStatementNode &node) override
+    {
+        add(node.condition());
+        if (node.has_then_block())
+        {
+            add(node.then_block());
+        }
+        if (node.has_else_block())
+        {
+            add(node.else_block());
+        }
+    }
+    void visit(const RepeatUntilNode &node) override
+    {
+        m_interprets = true;
+        add(node.body());
+        add(node.condition());
+    }
+    void visit(const StatementSeqNode &node) override
+    {
+        for (const std::shared_ptr<Node> &statement : node.statements())
+        {
+            add(statement);
+        }
+    }
+    void visit(const UnaryOpNode &node) override
+    {
+        add(node.operand());
+    }
+    void visit(const WhileNode &node) override
+    {
+        m_interprets = true;
+        add(node.condition());
+        add(node.body());
+    }
+
+    const std::set<std::string> &written() const
+    {
+        return m_written;
+    }
+    bool reseeds() const
+    {
+        return m_reseeds;
+    }
+    bool interprets() const
+    {
+        return m_interprets;
+    }
+
+private:
+    std::set<std::string> m_written{"_result", "lastsqr", "rand"};
+    bool m_reseeds{};
+    bool m_interprets{};
+};
+
+} // namespace
+
+// Advances rand, runs iterate and leaves the bailout value in result, also storing it in _result.
+static CompileError compile_orbit_step(const std::shared_ptr<Node> &iterate, const std::shared_ptr<Node> &bailout,
+    asmjit::x86::Compiler &comp, EmitterState &state, asmjit::x86::Xmm result)
+{
+    if (state.random != nullptr)
+    {
+        if (const CompileError err = call_advance_random(comp, state); err)
+        {
+            return err;
+        }
+    }
+    if (iterate)
+    {
+        ASMJIT_CHECK(comp.xorpd(result, result));
+        if (const CompileError err = compile(iterate, comp, state, result); err)
+        {
+            return err;
+        }
+    }
+    if (bailout)
+    {
+        ASMJIT_CHECK(comp.xorpd(result, result));
+        if (const CompileError err = compile(bailout, comp, state, result); err)
+        {
+            return err;
+        }
+        if (const CompileError err = store_complex(comp, get_symbol_storage(state, "_result"), result); err)
+        {
+            return err;
+        }
+    }
+    return {};
+}
+
+// Emits blocks of unroll steps with one escape test per block, falling through to single_step when fewer
+// than unroll iterations remain.  A block in which any step escaped is rolled back to the checkpoint taken
+// at its start and replayed by single_step, which then stops at the exact iteration.
+static CompileError compile_unrolled_orbit(const std::shared_ptr<Node> &iterate,
+    const std::shared_ptr<Node> &bailout, asmjit::x86::Compiler &comp, EmitterState &state, int unroll,
+    asmjit::x86::Gp iteration, asmjit::x86::Gp max_iterations, asmjit::Label &single_step, asmjit::Label &done)
+{
+    OrbitEffects effects;
+    effects.add(iterate);
+    effects.add(bailout);
+    std::vector<std::pair<Complex *, asmjit::x86::Mem>> checkpoint;
+    for (const std::string &name : effects.written())
+    {
+        checkpoint.emplace_back(&get_symbol_storage(state, name), comp.newStack(sizeof(Complex), alignof(Complex)));
+    }
+    asmjit::x86::Gp remaining{comp.newInt32("remaining")};
+    asmjit::x86::Gp escaped_bits{comp.newInt32("escaped_bits")};
+    asmjit::x86::Xmm result{comp.newXmm()};
+    asmjit::x86::Xmm escaped{comp.newXmm()};
+    asmjit::x86::Xmm zero{comp.newXmm()};
+    asmjit::x86::Xmm value{comp.newXmm()};
+    asmjit::Label block{comp.newLabel()};
+    asmjit::Label rollback{comp.newLabel()};
+
+    ASMJIT_CHECK(comp.bind(block));
+    ASMJIT_CHECK(comp.mov(remaining, max_iterations));
+    ASMJIT_CHECK(comp.sub(remaining, iteration));
+    ASMJIT_CHECK(comp.cmp(remaining, asmjit::imm(unroll)));
+    ASMJIT_CHECK(comp.jl(single_step));
+    if (state.cancellation != nullptr)
+    {
+        if (const CompileError err = call_poll_cancellation(comp, state, iteration, unroll, done); err)
+        {
+            return err;
+        }
+    }
+    for (const auto &[symbol, slot] : checkpoint)
+    {
+        if (const CompileError err = load_complex(comp, value, *symbol); err)
+        {
+            return err;
+        }
+        ASMJIT_CHECK(comp.movupd(slot, value));
+    }
+    ASMJIT_CHECK(comp.xorpd(escaped, escaped));
+    ASMJIT_CHECK(comp.xorpd(zero, zero));
+    for (int step = 0; step < unroll; ++step)
+    {
+        if (const CompileError err = compile_orbit_step(iterate, bailout, comp, state, result); err)
+        {
+            return err;
+        }
+        // cmpeqsd is false for NaN, which keeps iterating as in the single-step loop.
+        ASMJIT_CHECK(comp.cmpsd(result, zero, asmjit::imm(0)));
+        ASMJIT_CHECK(comp.orpd(escaped, result));
+    }
+    ASMJIT_CHECK(comp.movmskpd(escaped_bits, escaped));
+    ASMJIT_CHECK(comp.test(escaped_bits, asmjit::imm(1)));
+    ASMJIT_CHECK(comp.jnz(rollback));
+    ASMJIT_CHECK(comp.add(iteration, asmjit::imm(unroll)));
+    ASMJIT_CHECK(comp.jmp(block));
+
+    ASMJIT_CHECK(comp.bind(rollback));
+    for (const auto &[symbol, slot] : checkpoint)
+    {
+        ASMJIT_CHECK(comp.movupd(value, slot));
+        if (const CompileError err = store_complex(comp, *symbol, value); err)
+        {
+            return err;
+        }
+    }
+    if (state.random != nullptr)
+    {
+        if (const CompileError err = call_rewind_random(comp, state, unroll); err)
+        {
+            return err;
+        }
+    }
+    ASMJIT_CHECK(comp.jmp(single_step));
+    return {};
+}
+
+CompileError compile_orbit(const std::shared_ptr<Node> &iterate, const std::shared_ptr<Node> &bailout,
+    asmjit::x86::Compiler &comp, EmitterState &state, asmjit::Label &label, int unroll)
+{
+    asmjit::FuncNode *func{comp.addFunc(asmjit::FuncSignature::build<int, int>())};
+    enable_instruction_set(*func, state);
+    label = func->label();
+    asmjit::x86::Gp max_iterations{comp.newInt32("max_iterations")};
+    func->setArg(0, max_iterations);
+    asmjit::x86::Gp iteration{comp.newInt32("iteration")};
+    asmjit::x86::Xmm result{comp.newXmm()};
+    asmjit::x86::Xmm zero{comp.newXmm()};
+    asmjit::Label loop{comp.newLabel()};
+    asmjit::Label next{comp.newLabel()};
+    asmjit::Label done{comp.newLabel()};
+
+    ASMJIT_CHECK(comp.xor_(iteration, iteration));
+    unroll = std::min(unroll, ORBIT_MAX_UNROLL);
+    // Without a bailout there is nothing to defer; srand and interpreter fallback errors can't be rolled back.
+    OrbitEffects effects;
+    effects.add(iterate);
+    effects.add(bailout);
+    if (unroll > 1 && bailout && !effects.reseeds() && !effects.interprets())
+    {
+        if (const CompileError err = compile_unrolled_orbit(
+                iterate, bailout, comp, state, unroll, iteration, max_iterations, loop, done);
+            err)
+        {
+            return err;
+        }
+    }
+    ASMJIT_CHECK(comp.bind(loop));
+    ASMJIT_CHECK(comp.cmp(iteration, max_iterations));
+    ASMJIT_CHECK(comp.jge(done));
+    if (state.cancellation != nullptr)
+    {
+        if (const CompileError err = call_poll_cancellation(comp, state, iteration, 1, done); err)
+        {
+            return err;
+        }
+    }
+    if (const CompileError err = compile_orbit_step(iterate, bailout, comp, state, result); err)
+    {
+        return err;
+    }
+    if (bailout)
+    {
+        // Escape only on a zero real part; a NaN bailout value keeps iterating, as in the interpreter.
+        ASMJIT_CHECK(comp.xorpd(zero, zero));
+        ASMJIT_CHECK(comp.ucomisd(result, zero));
+        ASMJIT_CHECK(comp.jp(next));
+        ASMJIT_CHECK(comp.jz(done));
+    }
+    ASMJIT_CHECK(comp.bind(next));
+    ASMJIT_CHECK(comp.inc(iteration));
+    ASMJIT_CHECK(comp.jmp(loop));
+    ASMJIT_CHECK(comp.bind(done));
+    ASMJIT_CHECK(comp.ret(iteration));
+    ASMJIT_CHECK(comp.endFunc());
+    return {};
+}
+
 } // namespace formula::ast
@@ -0,0 +1,316 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/compiler/JitSymbols.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+// The GDB JIT interface: gdb sets a breakpoint in __jit_debug_register_code and walks
+// __jit_debug_descriptor to find the symbol files of newly registered code.  Only one definition may
+// exist per process, so these are weak and yield to another JIT's (LLVM, LuaJIT, V8) when linked together.
+extern "C"
+{
+enum jit_actions_t : std::uint32_t
+{
+    JIT_NOACTION = 0,
+    JIT_REGISTER_FN,
+    JIT_UNREGISTER_FN
+};
+
+struct jit_code_entry
+{
+    jit_code_entry *next_entry;
+    jit_code_entry *prev_entry;
+    const char *symfile_addr;
+    std::uint64_t symfile_size;
+};
+
+struct jit_descriptor
+{
+    std::uint32_t version;
+    std::uint32_t action_flag;
+    jit_code_entry *relevant_entry;
+    jit_code_entry *first_entry;
+};
+
+__attribute__((noinline, used, weak)) void __jit_debug_register_code()
+{
+    // The empty asm keeps the call from being optimized away.
+    asm volatile("" ::: "memory");
+}
+
+__attribute__((used, weak)) jit_descriptor __jit_debug_descriptor{1, JIT_NOACTION, nullptr, nullptr};
+}
+#endif
+
+namespace formula
+{
+
+namespace
+{
+
+std::mutex g_jit_symbols_mutex;
+
+// Just enough of ELF64 to describe functions to a debugger.
+struct ElfHeader
+{
+    std::uint8_t ident[16];
+    std::uint16_t type;
+    std::uint16_t machine;
+    std::uint32_t version;
+    std::uint64_t entry;
+    std::uint64_t phoff;
+    std::uint64_t shoff;
+    std::uint32_t flags;
+    std::uint16_t ehsize;
+    std::uint16_t phentsize;
+    std::uint16_t phnum;
+    std::uint16_t shentsize;
+    std::uint16_t shnum;
+    std::uint16_t shstrndx;
+};
+
+struct ElfSectionHeader
+{
+    std::uint32_t name;
+    std::uint32_t type;
+    std::uint64_t flags;
+    std::uint64_t addr;
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint32_t link;
+    std::uint32_t info;
+    std::uint64_t addralign;
+    std::uint64_t entsize;
+};
+
+struct ElfSymbol
+{
+    std::uint32_t name;
+    std::uint8_t info;
+    std::uint8_t other;
+    std::uint16_t shndx;
+    std::uint64_t value;
+    std::uint64_t size;
+};
+
+static_assert(sizeof(ElfHeader) == 64);
+static_assert(sizeof(ElfSectionHeader) == 64);
+static_assert(sizeof(ElfSymbol) == 24);
+
+constexpr std::uint16_t ET_REL{1};
+constexpr std::uint16_t EM_X86_64{62};
+constexpr std::uint32_t SHT_SYMTAB{2};
+constexpr std::uint32_t SHT_STRTAB{3};
+constexpr std::uint32_t SHT_NOBITS{8};
+constexpr std::uint64_t SHF_ALLOC{2};
+constexpr std::uint64_t SHF_EXECINSTR{4};
+constexpr std::uint8_t STB_GLOBAL{1};
+constexpr std::uint8_t STT_FUNC{2};
+
+enum SectionIndex : std::uint16_t
+{
+    SECTION_NULL,
+    SECTION_TEXT,
+    SECTION_SYMTAB,
+    SECTION_STRTAB,
+    SECTION_SHSTRTAB,
+    NUM_ELF_SECTIONS
+};
+
+std::uint32_t add_string(std::string &table, const std::string &text)
+{
+    const auto offset{static_cast<std::uint32_t>(table.size())};
+    table += text;
+    table += '\0';
+    return offset;
+}
+
+template <typename T>
+std::uint64_t append(std::vector<std::uint8_t> &bytes, const T *data, std::size_t count)
+{
+    const std::uint64_t offset{bytes.size()};
+    const auto *begin{reinterpret_cast<const std::uint8_t *>(data)};
+    bytes.insert(bytes.end(), begin, begin + count * sizeof(T));
+    return offset;
+}
+
+void align(std::vector<std::uint8_t> &bytes, std::size_t alignment)
+{
+    bytes.resize((bytes.size() + alignment - 1) / alignment * alignment);
+}
+
+} // namespace
+
+std::string perf_map_path()
+{
+#if defined(__linux__)
+    return "/tmp/perf-" + std::to_string(::getpid()) + ".map";
+#else
+    return {};
+#endif
+}
+
+bool write_perf_map(const std::vector<JitSymbol> &symbols)
+{
+    const std::string path{perf_map_path()};
+    if (path.empty())
+    {
+        return false;
+    }
+    std::lock_guard lock{g_jit_symbols_mutex};
+    std::ofstream map{path, std::ios::app};
+    for (const JitSymbol &symbol : symbols)
+    {
+        map << std::hex << symbol.address << ' ' << symbol.size << std::dec << ' ' << symbol.name << '\n';
+    }
+    map.flush();
+    return static_cast<bool>(map);
+}
+
+std::vector<std::uint8_t> make_symbol_file(const std::vector<JitSymbol> &symbols)
+{
+    std::uintptr_t begin{UINTPTR_MAX};
+    std::uintptr_t end{};
+    for (const JitSymbol &symbol : symbols)
+    {
+        begin = std::min(begin, symbol.address);
+        end = std::max(end, symbol.address + symbol.size);
+    }
+    if (symbols.empty())
+    {
+        begin = 0;
+    }
+
+    std::string section_names(1, '\0');
+    std::string symbol_names(1, '\0');
+    std::vector<ElfSymbol> elf_symbols(1, ElfSymbol{});
+    for (const JitSymbol &symbol : symbols)
+    {
+        // In a relocatable object symbol values are offsets into their section.
+        elf_symbols.push_back(ElfSymbol{add_string(symbol_names, symbol.name),
+            static_cast<std::uint8_t>(STB_GLOBAL << 4 | STT_FUNC), 0, SECTION_TEXT, symbol.address - begin,
+            symbol.size});
+    }
+
+    std::vector<ElfSectionHeader> sections(NUM_ELF_SECTIONS, ElfSectionHeader{});
+    sections[SECTION_TEXT].name = add_string(section_names, ".text");
+    sections[SECTION_SYMTAB].name = add_string(section_names, ".symtab");
+    sections[SECTION_STRTAB].name = add_string(section_names, ".strtab");
+    sections[SECTION_SHSTRTAB].name = add_string(section_names, ".shstrtab");
+
+    std::vector<std::uint8_t> bytes(sizeof(ElfHeader));
+    sections[SECTION_SHSTRTAB].offset = append(bytes, section_names.data(), section_names.size());
+    sections[SECTION_STRTAB].offset = append(bytes, symbol_names.data(), symbol_names.size());
+    align(bytes, 8);
+    sections[SECTION_SYMTAB].offset = append(bytes, elf_symbols.data(), elf_symbols.size());
+    align(bytes, 8);
+
+    // The code stays where the JIT put it; NOBITS tells the debugger not to look for it in the file.
+    ElfSectionHeader &text{sections[SECTION_TEXT]};
+    text.type = SHT_NOBITS;
+    text.flags = SHF_ALLOC | SHF_EXECINSTR;
+    text.addr = begin;
+    text.offset = bytes.size();
+    text.size = end - begin;
+    text.addralign = 16;
+    ElfSectionHeader &symtab{sections[SECTION_SYMTAB]};
+    symtab.type = SHT_SYMTAB;
+    symtab.size = elf_symbols.size() * sizeof(ElfSymbol);
+    symtab.link = SECTION_STRTAB;
+    symtab.info = 1; // index of the first global symbol
+    symtab.addralign = 8;
+    symtab.entsize = sizeof(ElfSymbol);
+    ElfSectionHeader &strtab{sections[SECTION_STRTAB]};
+    strtab.type = SHT_STRTAB;
+    strtab.size = symbol_names.size();
+    strtab.addralign = 1;
+    ElfSectionHeader &shstrtab{sections[SECTION_SHSTRTAB]};
+    shstrtab.type = SHT_STRTAB;
+    shstrtab.size = section_names.size();
+    shstrtab.addralign = 1;
+
+    ElfHeader header{};
+    const std::uint8_t ident[]{0x7f, 'E', 'L', 'F', 2 /*64-bit*/, 1 /*little endian*/, 1 /*version*/};
+    std::memcpy(header.ident, ident, sizeof(ident));
+    header.type = ET_REL;
+    header.machine = EM_X86_64;
+    header.version = 1;
+    header.shoff = append(bytes, sections.data(), sections.size());
+    header.ehsize = sizeof(ElfHeader);
+    header.shentsize = sizeof(ElfSectionHeader);
+    header.shnum = NUM_ELF_SECTIONS;
+    header.shstrndx = SECTION_SHSTRTAB;
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    return bytes;
+}
+
+#if defined(__linux__)
+struct GdbJitRegistration::Entry
+{
+    std::vector<std::uint8_t> symbol_file;
+    jit_code_entry entry{};
+};
+
+GdbJitRegistration::GdbJitRegistration(const std::vector<JitSymbol> &symbols) :
+    m_entry(std::make_unique<Entry>())
+{
+    m_entry->symbol_file = make_symbol_file(symbols);
+    m_entry->entry.symfile_addr = reinterpret_cast<const char *>(m_entry->symbol_file.data());
+    m_entry->entry.symfile_size = m_entry->symbol_file.size();
+
+    std::lock_guard lock{g_jit_symbols_mutex};
+    m_entry->entry.next_entry = __jit_debug_descriptor.first_entry;
+    if (m_entry->entry.next_entry != nullptr)
+    {
+        m_entry->entry.next_entry->prev_entry = &m_entry->entry;
+    }
+    __jit_debug_descriptor.first_entry = &m_entry->entry;
+    __jit_debug_descriptor.relevant_entry = &m_entry->entry;
+    __jit_debug_descriptor.action_flag = JIT_REGISTER_FN;
+    __jit_debug_register_code();
+}
+
+GdbJitRegistration::~GdbJitRegistration()
+{
+    std::lock_guard lock{g_jit_symbols_mutex};
+    jit_code_entry &entry{m_entry->entry};
+    if (entry.prev_entry != nullptr)
+    {
+        entry.prev_entry->next_entry = entry.next_entry;
+    }
+    else
+    {
+        __jit_debug_descriptor.first_entry = entry.next_entry;
+    }
+    if (entry.next_entry != nullptr)
+    {
+        entry.next_entry->prev_entry = entry.prev_entry;
+    }
+    __jit_debug_descriptor.relevant_entry = &entry;
+    __jit_debug_descriptor.action_flag = JIT_UNREGISTER_FN;
+    __jit_debug_register_code();
+}
+#else
+struct GdbJitRegistration::Entry
+{
+};
+
+GdbJitRegistration::GdbJitRegistration(const std::vector<JitSymbol> &)
+{
+}
+
+GdbJitRegistration::~GdbJitRegistration() = default;
+#endif
+
+} // namespace formula
@@ -4,7 +4,11 @@
 //
 #pragma once
 
+#include <formula/core/Cancellation.h>
 #include <formula/core/Complex.h>
+#include <formula/core/InstructionSet.h>
+#include <formula/core/Random.h>
+#include <formula/semantics/RealAnalysis.h>
 
 #include <asmjit/core.h>
 #include <asmjit/x86.h>
@@ -13,7 +17,6 @@
 #include <map>
 #include <memory>
 #include <optional>
-#include <random>
 #include <string>
 
 #define ASMJIT_CHECK(expr_)                       \
@@ -49,17 +52,61 @@ struct DataSection
     SymbolBindings symbols;     // Map of symbols to labels
 };
 
+// Evaluates subtrees the compiler doesn't support, such as loops, by calling back into an interpreter that
+// works on the same symbols, so compiled and interpreted code see each other's assignments.
+struct InterpreterFallback
+{
+    bool (*supports)(const Node &node, const FunctionSelectors &functions){};
+    // Must not throw: generated code can't be unwound.
+    void (*evaluate)(void *context, const Node *node, Complex *result){};
+    void *context{};
+};
+
 struct EmitterState
 {
     SymbolTable symbols;
     FunctionSelectors functions;
     DataSection data;
-    std::mt19937 *random{};
+    RandomState *random{};
+    // Where the formula keeps its current cancellation token, or null; compiled orbits poll it.
+    const CancellationToken *const *cancellation{};
+    // Selects the emitted instruction sequences; it must not exceed what the CPU running the code supports.
+    InstructionSet instruction_set{InstructionSet::SSE2};
+    // Expressions known to have a zero imaginary part, which are computed with scalar instructions.
+    semantic::RealExpressions real_expressions;
+    // Without a fallback, unsupported subtrees make compilation fail.
+    InterpreterFallback fallback;
 };
 
 using CompileError = std::optional<asmjit::Error>;
 
+constexpr int ORBIT_CANCELLATION_INTERVAL{1024}; // a power of two
+constexpr int ORBIT_MAX_UNROLL{64};
+
+// The highest tier features supports.  AVX2 also requires FMA3, and AVX512 requires AVX512VL so that
+// 128-bit instructions can use the EVEX encodings.
+InstructionSet detect_instruction_set(const asmjit::CpuFeatures &features);
+
+// Lets func use the vector registers of state.instruction_set; call it on every function added to comp.
+void enable_instruction_set(asmjit::FuncNode &func, const EmitterState &state);
+
 CompileError compile(
     const std::shared_ptr<Node> &expr, asmjit::x86::Compiler &comp, EmitterState &state, asmjit::x86::Xmm result);
 
+// Adds the function int orbit(int max_iterations), which repeatedly advances rand, runs iterate and then
+// bailout, storing the bailout value in _result, until the bailout value is zero or max_iterations
+// iterations have passed.  It returns the iterations that passed the bailout test, so a result below
+// max_iterations means the orbit escaped.  Either section may be null; without a bailout section the
+// orbit never escapes.  When state.cancellation is set the loop polls the token every
+// ORBIT_CANCELLATION_INTERVAL iterations and returns early once it is cancelled; callers must check the
+// token to tell that apart from an escape.
+//
+// With unroll above 1 (at most ORBIT_MAX_UNROLL), the loop runs blocks of unroll iterations and branches
+// on the bailout once per block.  Every bailout value is still computed and the block is rolled back to a
+// checkpoint of the symbols it writes when any of them was zero, then replayed one iteration at a time, so
+// the results match the single-step loop exactly.  Orbits that call srand or evaluate any subtree through
+// state.fallback are not unrolled.
+CompileError compile_orbit(const std::shared_ptr<Node> &iterate, const std::shared_ptr<Node> &bailout,
+    asmjit::x86::Compiler &comp, EmitterState &state, asmjit::Label &label, int unroll = 1);
+
 } // namespace formula::ast
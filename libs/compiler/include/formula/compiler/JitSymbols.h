@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace formula
+{
+
+// A named range of generated machine code.
+struct JitSymbol
+{
+    std::string name;
+    std::uintptr_t address{};
+    std::size_t size{};
+};
+
+// Path of the perf symbol map for this process, /tmp/perf-<pid>.map.
+std::string perf_map_path();
+
+// Appends one "address size name" line per symbol to the perf map so perf report can name JIT code.
+// Returns false when the map can't be written or the platform has no perf support.
+bool write_perf_map(const std::vector<JitSymbol> &symbols);
+
+// An in-memory ELF object that describes symbols for a debugger; the code itself is not copied.
+std::vector<std::uint8_t> make_symbol_file(const std::vector<JitSymbol> &symbols);
+
+// Registers symbols with the GDB JIT interface for as long as the registration lives.
+// Registration must be destroyed before the code it describes is released.
+class GdbJitRegistration
+{
+public:
+    explicit GdbJitRegistration(const std::vector<JitSymbol> &symbols);
+    GdbJitRegistration(const GdbJitRegistration &rhs) = delete;
+    GdbJitRegistration(GdbJitRegistration &&rhs) = delete;
+    ~GdbJitRegistration();
+    GdbJitRegistration &operator=(const GdbJitRegistration &rhs) = delete;
+    GdbJitRegistration &operator=(GdbJitRegistration &&rhs) = delete;
+
+    bool registered() const
+    {
+        return m_entry != nullptr;
+    }
+
+private:
+    struct Entry;
+    std::unique_ptr<Entry> m_entry;
+};
+
+} // namespace formula
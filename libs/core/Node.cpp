@@ -6,6 +6,9 @@
 
 #include <formula/core/Visitor.h>
 
+#include <iterator>
+#include <unordered_set>
+
 //
 // An Xmm register is 128 bits wide, holding two 64-bit doubles,
 // bit enough to hold a complex double.
@@ -126,4 +129,157 @@ void WhileNode::visit(Visitor &visitor) const
     visitor.visit(*this);
 }
 
+namespace
+{
+
+class LiveNodes : public Visitor
+{
+public:
+    void add(const Expr &node)
+    {
+        if (node && m_nodes.insert(node.get()).second)
+        {
+            node->visit(*this);
+        }
+    }
+    void add(const std::vector<Expr> &nodes)
+    {
+        for (const Expr &node : nodes)
+        {
+            add(node);
+        }
+    }
+    bool contains(const Node *node) const
+    {
+        return m_nodes.count(node) != 0;
+    }
+
+    void visit(const AssignmentNode &node) override
+    {
+        add(node.target());
+        add(node.expression());
+    }
+    void visit(const BinaryOpNode &node) override
+    {
+        add(node.left());
+        add(node.right());
+    }
+    void visit(const ConstantRefNode &) override
+    {
+    }
+    void visit(const DeclarationNode &node) override
+    {
+        add(node.dimensions());
+        add(node.initializer());
+    }
+    void visit(const FunctionBlockNode &node) override
+    {
+        add(node.block());
+    }
+    void visit(const FunctionDeclNode &node) override
+    {
+        add(node.body());
+    }
+    void visit(const FunctionCallNode &node) override
+    {
+        if (node.has_target())
+        {
+            add(node.target());
+        }
+        add(node.args());
+    }
+    void visit(const HeadingBlockNode &node) override
+    {
+        add(node.block());
+    }
+    void visit(const IdentifierNode &) override
+    {
+    }
+    void visit(const IfStatementNode &node) override
+    {
+        add(node.condition());
+        if (node.has_then_block())
+        {
+            add(node.then_block());
+        }
+        if (node.has_else_block())
+        {
+            add(node.else_block());
+        }
+    }
+    void visit(const IndexNode &node) override
+    {
+        add(node.target());
+        add(node.indices());
+    }
+    void visit(const LiteralNode &) override
+    {
+    }
+    void visit(const MemberAccessNode &node) override
+    {
+        add(node.target());
+    }
+    void visit(const NewNode &node) override
+    {
+        add(node.args());
+    }
+    void visit(const ParamBlockNode &node) override
+    {
+        add(node.block());
+    }
+    void visit(const ParameterRefNode &) override
+    {
+    }
+    void visit(const RepeatUntilNode &node) override
+    {
+        add(node.body());
+        add(node.condition());
+    }
+    void visit(const ReturnNode &node) override
+    {
+        add(node.expression());
+    }
+    void visit(const SettingNode &) override
+    {
+    }
+    void visit(const StatementSeqNode &node) override
+    {
+        add(node.statements());
+    }
+    void visit(const UnaryOpNode &node) override
+    {
+        add(node.operand());
+    }
+    void visit(const WhileNode &node) override
+    {
+        add(node.condition());
+        add(node.body());
+    }
+
+private:
+    std::unordered_set<const Node *> m_nodes;
+};
+
+} // namespace
+
+void retain_live_locations(FormulaSections &sections)
+{
+    if (sections.locations.empty())
+    {
+        return;
+    }
+    LiveNodes live;
+    for (const Expr &section : {sections.per_image, sections.builtin, sections.initialize, sections.iterate,
+             sections.bailout, sections.perturb_initialize, sections.perturb_iterate, sections.defaults,
+             sections.type_switch, sections.final, sections.transform, sections.public_members,
+             sections.protected_members, sections.private_members})
+    {
+        live.add(section);
+    }
+    for (auto it = sections.locations.begin(); it != sections.locations.end();)
+    {
+        it = live.contains(it->first) ? std::next(it) : sections.locations.erase(it);
+    }
+}
+
 } // namespace formula::ast
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/core/Random.h>
+
+namespace formula
+{
+
+namespace
+{
+
+constexpr std::uint32_t PHILOX_M0{0xD2511F53U};
+constexpr std::uint32_t PHILOX_M1{0xCD9E8D57U};
+constexpr std::uint32_t PHILOX_W0{0x9E3779B9U};
+constexpr std::uint32_t PHILOX_W1{0xBB67AE85U};
+constexpr int PHILOX_ROUNDS{10};
+
+PhiloxCounter philox_round(const PhiloxCounter &counter, const PhiloxKey &key)
+{
+    const std::uint64_t product0{static_cast<std::uint64_t>(PHILOX_M0) * counter[0]};
+    const std::uint64_t product1{static_cast<std::uint64_t>(PHILOX_M1) * counter[2]};
+    const auto hi0{static_cast<std::uint32_t>(product0 >> 32)};
+    const auto lo0{static_cast<std::uint32_t>(product0)};
+    const auto hi1{static_cast<std::uint32_t>(product1 >> 32)};
+    const auto lo1{static_cast<std::uint32_t>(product1)};
+    return {hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0};
+}
+
+// 53 random bits from two words, as a double in [0, 1).
+double unit_double(std::uint32_t hi, std::uint32_t lo)
+{
+    return (static_cast<double>(hi >> 5) * 67108864.0 + static_cast<double>(lo >> 6)) / 9007199254740992.0;
+}
+
+} // namespace
+
+PhiloxCounter philox4x32(PhiloxCounter counter, PhiloxKey key)
+{
+    for (int round = 0; round < PHILOX_ROUNDS; ++round)
+    {
+        if (round > 0)
+        {
+            key[0] += PHILOX_W0;
+            key[1] += PHILOX_W1;
+        }
+        counter = philox_round(counter, key);
+    }
+    return counter;
+}
+
+Complex random_complex(std::uint32_t seed, std::uint64_t stream, std::uint32_t counter)
+{
+    const PhiloxCounter bits{philox4x32(
+        {static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32), counter, 0U}, {seed, 0U})};
+    return {unit_double(bits[0], bits[1]), unit_double(bits[2], bits[3])};
+}
+
+} // namespace formula
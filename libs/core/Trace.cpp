@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/core/Trace.h>
+
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace formula::trace
+{
+
+namespace detail
+{
+std::atomic<bool> g_enabled{};
+}
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Event
+{
+    const char *name;
+    const char *category;
+    Clock::time_point start;
+    Clock::duration duration;
+    int thread;
+};
+
+std::mutex g_mutex;
+std::vector<Event> g_events;
+Clock::time_point g_origin;
+std::atomic<int> g_next_thread{1};
+
+// Small sequential ids read better in a trace viewer than std::thread::id hashes.
+int thread_id()
+{
+    thread_local const int id{g_next_thread++};
+    return id;
+}
+
+void write_string(std::ostream &out, const char *text)
+{
+    out << '"';
+    for (const char *ch = text; *ch != '\0'; ++ch)
+    {
+        if (*ch == '"' || *ch == '\\')
+        {
+            out << '\\';
+        }
+        out << *ch;
+    }
+    out << '"';
+}
+
+double microseconds(Clock::duration duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+} // namespace
+
+void start()
+{
+    const std::lock_guard lock{g_mutex};
+    g_events.clear();
+    g_origin = Clock::now();
+    detail::g_enabled = true;
+}
+
+void stop()
+{
+    detail::g_enabled = false;
+}
+
+std::size_t event_count()
+{
+    const std::lock_guard lock{g_mutex};
+    return g_events.size();
+}
+
+void write_json(std::ostream &out)
+{
+    const std::lock_guard lock{g_mutex};
+    const std::ios_base::fmtflags flags{out.flags()};
+    const std::streamsize precision{out.precision()};
+    out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    bool first{true};
+    for (const Event &event : g_events)
+    {
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        write_string(out, event.name);
+        out << ",\"cat\":";
+        write_string(out, event.category);
+        out << ",\"ph\":\"X\",\"ts\":" << microseconds(event.start - g_origin)
+            << ",\"dur\":" << microseconds(event.duration) << ",\"pid\":1,\"tid\":" << event.thread << '}';
+        first = false;
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+Scope::~Scope()
+{
+    if (!m_active)
+    {
+        return;
+    }
+    const Clock::time_point end{Clock::now()};
+    const int thread{thread_id()};
+    const std::lock_guard lock{g_mutex};
+    g_events.push_back({m_name, m_category, m_start, end - m_start, thread});
+}
+
+} // namespace formula::trace
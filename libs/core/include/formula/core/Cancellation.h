@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+
+namespace formula
+{
+
+// Thrown when work stops because its CancellationToken was cancelled or its deadline passed.
+class CancelledError : public std::runtime_error
+{
+public:
+    CancelledError() :
+        std::runtime_error("cancelled")
+    {
+    }
+};
+
+// Shared by the thread that abandons work and the threads doing it.  Interpreters poll it at section
+// boundaries and loop back-edges, compiled orbits every thousand or so iterations and renderers between
+// rows and tiles.
+class CancellationToken
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CancellationToken() = default;
+    explicit CancellationToken(Clock::time_point deadline) :
+        m_deadline(deadline)
+    {
+    }
+    CancellationToken(const CancellationToken &rhs) = delete;
+    CancellationToken(CancellationToken &&rhs) = delete;
+    ~CancellationToken() = default;
+    CancellationToken &operator=(const CancellationToken &rhs) = delete;
+    CancellationToken &operator=(CancellationToken &&rhs) = delete;
+
+    void cancel()
+    {
+        m_cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    // True once cancel() was called or the deadline passed.
+    bool cancelled() const
+    {
+        if (m_cancelled.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+        if (m_deadline && Clock::now() >= *m_deadline)
+        {
+            m_cancelled.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void throw_if_cancelled() const
+    {
+        if (cancelled())
+        {
+            throw CancelledError();
+        }
+    }
+
+private:
+    mutable std::atomic<bool> m_cancelled{};
+    std::optional<Clock::time_point> m_deadline;
+};
+
+} // namespace formula
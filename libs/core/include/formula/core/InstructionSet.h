@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <string_view>
+
+namespace formula
+{
+
+// The x86-64 instruction set tiers the compiler emits code for, in increasing order.
+enum class InstructionSet
+{
+    SSE2,   // the x86-64 baseline
+    AVX2,   // VEX three-operand encodings and FMA3
+    AVX512, // AVX-512 F and VL: EVEX encodings and 32 vector registers
+};
+
+inline std::string_view to_string(InstructionSet value)
+{
+    switch (value)
+    {
+    case InstructionSet::SSE2:
+        return "sse2";
+    case InstructionSet::AVX2:
+        return "avx2";
+    case InstructionSet::AVX512:
+        return "avx512";
+    }
+    return "unknown";
+}
+
+} // namespace formula
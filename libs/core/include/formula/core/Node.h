@@ -12,6 +12,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -813,6 +814,10 @@ private:
     Expr m_block;
 };
 
+// Where each parsed node begins, recorded when parser::Options::record_locations is set; nodes created by
+// later transforms have no entry.
+using NodeLocations = std::unordered_map<const Node *, SourceLocation>;
+
 struct FormulaSections
 {
     Expr per_image;
@@ -832,8 +837,13 @@ struct FormulaSections
     std::vector<ImportDirective> imports;
     bool has_bailout_section{};
     bool has_final_section{};
+    NodeLocations locations;
 };
 
 using FormulaSectionsPtr = std::shared_ptr<FormulaSections>;
 
+// Erases locations of nodes no longer reachable from any section, so a freed node's address can't be
+// reported for a later allocation.
+void retain_live_locations(FormulaSections &sections);
+
 } // namespace formula::ast
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/core/Complex.h>
+
+#include <array>
+#include <cstdint>
+
+namespace formula
+{
+
+using PhiloxCounter = std::array<std::uint32_t, 4>;
+using PhiloxKey = std::array<std::uint32_t, 2>;
+
+// The Philox4x32-10 block function from Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3".
+PhiloxCounter philox4x32(PhiloxCounter counter, PhiloxKey key);
+
+// The value of rand for a seed, stream and counter; both components are in [0, 1).
+Complex random_complex(std::uint32_t seed, std::uint64_t stream, std::uint32_t counter);
+
+// Counter-based state behind rand.  Each value depends only on (seed, stream, counter), so a renderer
+// that selects the pixel index as the stream gets the same image in any evaluation order.
+class RandomState
+{
+public:
+    // Used by set_random_seed and srand; restarts the sequence of the current stream.
+    void seed(std::uint32_t seed)
+    {
+        m_seed = seed;
+        m_counter = 0;
+    }
+    void set_stream(std::uint64_t stream)
+    {
+        m_stream = stream;
+        m_counter = 0;
+    }
+    Complex next()
+    {
+        return random_complex(m_seed, m_stream, m_counter++);
+    }
+    // Undoes the last steps calls to next, for an unrolled orbit that rolls back to a checkpoint.
+    void rewind(std::uint32_t steps)
+    {
+        m_counter -= steps;
+    }
+
+    std::uint32_t seed() const
+    {
+        return m_seed;
+    }
+    std::uint64_t stream() const
+    {
+        return m_stream;
+    }
+    std::uint32_t counter() const
+    {
+        return m_counter;
+    }
+
+private:
+    std::uint32_t m_seed{};
+    std::uint64_t m_stream{};
+    std::uint32_t m_counter{};
+};
+
+} // namespace formula
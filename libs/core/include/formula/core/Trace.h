@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+
+namespace formula::trace
+{
+
+// A timeline of the formula pipeline for chrome://tracing and ui.perfetto.dev.  Recording is off until
+// start(); while it is off a Scope costs one atomic load.
+
+namespace detail
+{
+extern std::atomic<bool> g_enabled;
+}
+
+inline bool enabled()
+{
+    return detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+// Discards any recorded events and starts recording on every thread.
+void start();
+void stop();
+std::size_t event_count();
+
+// Writes the recorded events as Chrome trace event JSON, one complete event per scope with the
+// recording thread's id.
+void write_json(std::ostream &out);
+
+// Records the time from construction to destruction as a named event.  name and category must outlive
+// the recording, e.g. string literals.
+class Scope
+{
+public:
+    explicit Scope(const char *name, const char *category = "formula") :
+        m_name(name),
+        m_category(category),
+        m_active(enabled())
+    {
+        if (m_active)
+        {
+            m_start = Clock::now();
+        }
+    }
+    Scope(const Scope &rhs) = delete;
+    Scope(Scope &&rhs) = delete;
+    ~Scope();
+    Scope &operator=(const Scope &rhs) = delete;
+    Scope &operator=(Scope &&rhs) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const char *m_name;
+    const char *m_category;
+    bool m_active;
+    Clock::time_point m_start{};
+};
+
+} // namespace formula::trace
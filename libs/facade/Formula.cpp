@@ -5,20 +5,34 @@
 #include <formula/facade/Formula.h>
 
 #include <formula/compiler/Compiler.h>
+#include <formula/compiler/JitSymbols.h>
 #include <formula/interpreter/Interpreter.h>
+#include <formula/interpreter/Profiler.h>
 #include <formula/parser/ParseOptions.h>
 #include <formula/parser/Parser.h>
+#include <formula/semantics/Derivative.h>
+#include <formula/semantics/RealAnalysis.h>
 #include <formula/semantics/ReferenceCollector.h>
 
 #include <formula/core/functions.h>
+#include <formula/core/Trace.h>
 
 #include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
-#include <random>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 using namespace formula::ast;
 
@@ -28,6 +42,120 @@ namespace formula
 namespace
 {
 
+using Clock = std::chrono::steady_clock;
+
+// All formulas add their code to one runtime so small modules share executable pages.  It is never
+// destroyed, so formulas released during static destruction still find it.
+struct SharedRuntime
+{
+    asmjit::JitRuntime runtime;
+    std::mutex mutex;
+};
+
+SharedRuntime &shared_runtime()
+{
+    static SharedRuntime *const shared{new SharedRuntime};
+    return *shared;
+}
+
+asmjit::Error add_module(char **module, asmjit::CodeHolder &code)
+{
+    SharedRuntime &shared{shared_runtime()};
+    const std::lock_guard lock{shared.mutex};
+    return shared.runtime.add(module, &code);
+}
+
+void release_module(char *module)
+{
+    SharedRuntime &shared{shared_runtime()};
+    const std::lock_guard lock{shared.mutex};
+    shared.runtime.release(module);
+}
+
+// Worker threads that run compile_async requests in submission order.  One worker per hardware thread
+// starts with the pool and waits for requests until the pool is destroyed.
+class CompilePool
+{
+public:
+    CompilePool();
+    CompilePool(const CompilePool &rhs) = delete;
+    CompilePool(CompilePool &&rhs) = delete;
+    ~CompilePool();
+    CompilePool &operator=(const CompilePool &rhs) = delete;
+    CompilePool &operator=(CompilePool &&rhs) = delete;
+
+    std::future<bool> submit(std::packaged_task<bool()> task);
+
+private:
+    void work();
+
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<std::packaged_task<bool()>> m_tasks;
+    std::vector<std::thread> m_threads;
+    bool m_stop{};
+};
+
+CompilePool::CompilePool()
+{
+    const unsigned count{std::max(1U, std::thread::hardware_concurrency())};
+    m_threads.reserve(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        m_threads.emplace_back(&CompilePool::work, this);
+    }
+}
+
+CompilePool::~CompilePool()
+{
+    {
+        const std::lock_guard lock{m_mutex};
+        m_stop = true;
+    }
+    m_ready.notify_all();
+    for (std::thread &thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+std::future<bool> CompilePool::submit(std::packaged_task<bool()> task)
+{
+    std::future<bool> result{task.get_future()};
+    {
+        const std::lock_guard lock{m_mutex};
+        m_tasks.push_back(std::move(task));
+    }
+    m_ready.notify_one();
+    return result;
+}
+
+void CompilePool::work()
+{
+    for (;;)
+    {
+        std::packaged_task<bool()> task;
+        {
+            std::unique_lock lock{m_mutex};
+            m_ready.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+            // Requests submitted before destruction still run.
+            if (m_tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+CompilePool &compile_pool()
+{
+    static CompilePool pool;
+    return pool;
+}
+
 std::string normalize_identifier(std::string_view name)
 {
     std::string result{name};
@@ -39,53 +167,96 @@ std::string normalize_identifier(std::string_view name)
 class ParsedFormula : public Formula
 {
 public:
-    explicit ParsedFormula(FormulaSectionsPtr ast);
+    ParsedFormula(FormulaSectionsPtr ast, std::chrono::duration<double> parse);
     ~ParsedFormula() override;
 
     void set_value(std::string_view name, Complex value) override;
     Complex get_value(std::string_view name) const override;
+    SymbolHandle lookup_symbol(std::string_view name) override;
     bool set_function(std::string_view name, std::string_view function) override;
     std::string get_function(std::string_view name) const override;
     void set_random_seed(std::uint32_t seed) override;
+    void set_random_stream(std::uint64_t stream) override;
     const Expr &get_section(Section section) const override;
+    bool enable_derivative() override;
 
     Complex interpret(Section part) override;
+    void set_profile(ExecutionProfile *profile) override;
+    void set_cancellation(const CancellationToken *token) override
+    {
+        m_cancellation = token;
+    }
     bool compile() override;
+    bool compile(const CompileOptions &options) override;
+    const CompileStats &get_compile_stats() const override
+    {
+        return m_compile_stats;
+    }
     Complex run(Section part) override;
+    void interpret_batch(Section section, const BatchInputs &inputs, const BatchOutputs &outputs,
+        std::size_t count, int max_iterations) override;
+    void run_batch(Section section, const BatchInputs &inputs, const BatchOutputs &outputs, std::size_t count,
+        int max_iterations) override;
 
 private:
     using Function = double();
+    using OrbitFunction = int(int);
+
+    template <typename Evaluate, typename Orbit>
+    void batch(Section section, const BatchInputs &inputs, const BatchOutputs &outputs, std::size_t count,
+        int max_iterations, const Evaluate &evaluate, const Orbit &orbit);
 
-    CompileError init_code_holder(asmjit::CodeHolder &code);
+    CompileError init_code_holder(asmjit::CodeHolder &code, std::FILE *assembly_log);
     CompileError compile_part(asmjit::x86::Compiler &comp, Expr node, asmjit::Label &label);
     void advance_random();
+    void add_external_symbol(const std::string &name);
     void reset_compiled_state();
+    static void evaluate_fallback(void *context, const Node *node, Complex *result);
+    void rethrow_fallback_error();
 
     EmitterState m_state;
+    // Map nodes don't move, so the compiled code and these pointers address the symbols directly.
+    Complex *m_rand{};
+    Complex *m_result{};
     FormulaSectionsPtr m_ast;
-    std::mt19937 m_random;
+    // The compiled code calls the interpreter fallback with nodes of this tree, so keep it alive.
+    FormulaSectionsPtr m_compiled_ast;
+    std::exception_ptr m_fallback_error;
+    RandomState m_random;
+    bool m_derivative{};
+    // Symbols the host may have made complex, which compiled code must not keep in scalars, and the
+    // variables the last compile() kept real.
+    std::set<std::string> m_external_symbols;
+    std::set<std::string> m_real_symbols;
+    CompileOptions m_compile_options;
+    ExecutionProfile *m_profile{};
+    const CancellationToken *m_cancellation{};
     Function *m_per_image{};
     Function *m_initialize{};
     Function *m_iterate{};
     Function *m_bailout{};
     Function *m_perturb_initialize{};
     Function *m_perturb_iterate{};
-    asmjit::JitRuntime m_runtime;
+    OrbitFunction *m_orbit{};
     char *m_module{};
-    asmjit::FileLogger m_logger{stdout};
+    std::unique_ptr<GdbJitRegistration> m_gdb_registration;
+    asmjit::FileLogger m_logger;
+    CompileStats m_compile_stats;
 };
 
-ParsedFormula::ParsedFormula(FormulaSectionsPtr ast) :
-    m_ast(std::move(ast)),
-    m_random(0U)
+ParsedFormula::ParsedFormula(FormulaSectionsPtr ast, std::chrono::duration<double> parse) :
+    m_ast(std::move(ast))
 {
+    m_compile_stats.parse = parse;
     m_state.random = &m_random;
+    m_state.cancellation = &m_cancellation;
+    m_state.fallback = {ast::can_interpret, evaluate_fallback, this};
     m_state.symbols["e"] = {std::exp(1.0), 0.0};
     m_state.symbols["pi"] = {std::atan2(0.0, -1.0), 0.0};
     m_state.symbols["ismand"] = {1.0, 0.0};
     m_state.symbols["lastsqr"] = {0.0, 0.0};
-    m_state.symbols["rand"] = {0.0, 0.0};
-    m_state.symbols["_result"] = {0.0, 0.0};
+    m_rand = &m_state.symbols["rand"];
+    m_result = &m_state.symbols["_result"];
     m_state.functions["fn1"] = "sin";
     m_state.functions["fn2"] = "sqr";
     m_state.functions["fn3"] = "sinh";
@@ -94,15 +265,21 @@ ParsedFormula::ParsedFormula(FormulaSectionsPtr ast) :
 
 ParsedFormula::~ParsedFormula()
 {
+    m_gdb_registration.reset();
     if (m_module != nullptr)
     {
-        m_runtime.release(m_module);
+        release_module(m_module);
     }
 }
 
 void ParsedFormula::set_value(std::string_view name, Complex value)
 {
-    m_state.symbols[std::string{name}] = value;
+    std::string symbol{name};
+    if (value.im != 0.0)
+    {
+        add_external_symbol(symbol);
+    }
+    m_state.symbols[std::move(symbol)] = value;
 }
 
 Complex ParsedFormula::get_value(std::string_view name) const
@@ -114,6 +291,14 @@ Complex ParsedFormula::get_value(std::string_view name) const
     return {};
 }
 
+SymbolHandle ParsedFormula::lookup_symbol(std::string_view name)
+{
+    std::string symbol{name};
+    // Writes through the handle aren't seen, so assume they can be complex.
+    add_external_symbol(symbol);
+    return SymbolHandle{&m_state.symbols[std::move(symbol)]};
+}
+
 bool ParsedFormula::set_function(std::string_view name, std::string_view function)
 {
     const std::string selector{normalize_identifier(name)};
@@ -143,20 +328,35 @@ std::string ParsedFormula::get_function(std::string_view name) const
 void ParsedFormula::set_random_seed(std::uint32_t seed)
 {
     m_random.seed(seed);
-    m_state.symbols["rand"] = {0.0, 0.0};
+    *m_rand = {0.0, 0.0};
+}
+
+void ParsedFormula::set_random_stream(std::uint64_t stream)
+{
+    m_random.set_stream(stream);
+    *m_rand = {0.0, 0.0};
 }
 
 void ParsedFormula::advance_random()
 {
-    std::uniform_real_distribution<double> distribution{0.0, 1.0};
-    m_state.symbols["rand"] = {distribution(m_random), distribution(m_random)};
+    *m_rand = m_random.next();
+}
+
+// Code compiled while the symbol was assumed real would drop its imaginary part, so it is recompiled.
+void ParsedFormula::add_external_symbol(const std::string &name)
+{
+    if (m_external_symbols.insert(name).second && m_real_symbols.count(name) != 0)
+    {
+        compile(m_compile_options);
+    }
 }
 
 void ParsedFormula::reset_compiled_state()
 {
+    m_gdb_registration.reset();
     if (m_module != nullptr)
     {
-        m_runtime.release(m_module);
+        release_module(m_module);
         m_module = nullptr;
     }
     m_per_image = nullptr;
@@ -165,7 +365,43 @@ void ParsedFormula::reset_compiled_state()
     m_bailout = nullptr;
     m_perturb_initialize = nullptr;
     m_perturb_iterate = nullptr;
+    m_orbit = nullptr;
+    m_real_symbols.clear();
     m_state.data = {};
+    m_compiled_ast.reset();
+    m_fallback_error = nullptr;
+}
+
+void ParsedFormula::evaluate_fallback(void *context, const Node *node, Complex *result)
+{
+    auto *formula{static_cast<ParsedFormula *>(context)};
+    if (formula->m_fallback_error)
+    {
+        // A compiled orbit keeps going until its next cancellation poll; don't repeat the failing work.
+        *result = {};
+        return;
+    }
+    try
+    {
+        // m_compiled_ast owns node; the aliasing constructor makes a non-owning pointer to it.
+        const Expr expr{Expr{}, const_cast<Node *>(node)};
+        *result = ast::interpret(expr, formula->m_state.symbols, formula->m_state.functions, &formula->m_random,
+            formula->m_profile, formula->m_cancellation);
+    }
+    catch (...)
+    {
+        // Exceptions can't unwind through generated code; run and run_batch rethrow this afterwards.
+        formula->m_fallback_error = std::current_exception();
+        *result = {};
+    }
+}
+
+void ParsedFormula::rethrow_fallback_error()
+{
+    if (m_fallback_error)
+    {
+        std::rethrow_exception(std::exchange(m_fallback_error, nullptr));
+    }
 }
 
 const Expr &ParsedFormula::get_section(Section section) const
@@ -200,32 +436,71 @@ const Expr &ParsedFormula::get_section(Section section) const
     }
 }
 
+bool ParsedFormula::enable_derivative()
+{
+    if (!m_derivative)
+    {
+        FormulaSectionsPtr derived{semantic::differentiate(*m_ast, m_state.functions)};
+        if (!derived)
+        {
+            return false;
+        }
+        m_ast = std::move(derived);
+        m_derivative = true;
+    }
+    return true;
+}
+
 Complex ParsedFormula::interpret(Section part)
 {
+    if (m_cancellation != nullptr)
+    {
+        m_cancellation->throw_if_cancelled();
+    }
+    ProfileScope scope{m_profile, part};
+    const auto evaluate = [this](const Expr &section)
+    {
+        return ast::interpret(section, m_state.symbols, m_state.functions, &m_random, m_profile, m_cancellation);
+    };
     switch (part)
     {
     case Section::PER_IMAGE:
-        return ast::interpret(m_ast->per_image, m_state.symbols, m_state.functions, &m_random);
+        return evaluate(m_ast->per_image);
     case Section::INITIALIZE:
-        return ast::interpret(m_ast->initialize, m_state.symbols, m_state.functions, &m_random);
+        return evaluate(m_ast->initialize);
     case Section::ITERATE:
         advance_random();
-        return ast::interpret(m_ast->iterate, m_state.symbols, m_state.functions, &m_random);
+        return evaluate(m_ast->iterate);
     case Section::BAILOUT:
-        return ast::interpret(m_ast->bailout, m_state.symbols, m_state.functions, &m_random);
+        return evaluate(m_ast->bailout);
     case Section::PERTURB_INITIALIZE:
-        return ast::interpret(m_ast->perturb_initialize, m_state.symbols, m_state.functions, &m_random);
+        return evaluate(m_ast->perturb_initialize);
     case Section::PERTURB_ITERATE:
         advance_random();
-        return ast::interpret(m_ast->perturb_iterate, m_state.symbols, m_state.functions, &m_random);
+        return evaluate(m_ast->perturb_iterate);
     }
     throw std::runtime_error("Invalid part for interpreter");
 }
 
-CompileError ParsedFormula::init_code_holder(asmjit::CodeHolder &code)
+void ParsedFormula::set_profile(ExecutionProfile *profile)
 {
-    ASMJIT_CHECK(code.init(m_runtime.environment(), m_runtime.cpuFeatures()));
-    code.setLogger(&m_logger);
+    m_profile = profile;
+    if (m_profile)
+    {
+        m_profile->set_locations(m_ast->locations);
+    }
+}
+
+CompileError ParsedFormula::init_code_holder(asmjit::CodeHolder &code, std::FILE *assembly_log)
+{
+    const asmjit::JitRuntime &runtime{shared_runtime().runtime};
+    ASMJIT_CHECK(code.init(runtime.environment(), runtime.cpuFeatures()));
+    if (assembly_log != nullptr)
+    {
+        // Formatting the assembly costs more than generating it, so it is only done on request.
+        m_logger.setFile(assembly_log);
+        code.setLogger(&m_logger);
+    }
     if (asmjit::Error err =
             code.newSection(&m_state.data.data, ".data", SIZE_MAX, asmjit::SectionFlags::kNone, sizeof(double), 0))
     {
@@ -267,7 +542,9 @@ CompileError update_symbols(
 
 CompileError ParsedFormula::compile_part(asmjit::x86::Compiler &comp, Expr node, asmjit::Label &label)
 {
-    label = comp.addFunc(asmjit::FuncSignature::build<double>())->label();
+    asmjit::FuncNode *func{comp.addFunc(asmjit::FuncSignature::build<double>())};
+    ast::enable_instruction_set(*func, m_state);
+    label = func->label();
     asmjit::x86::Xmm result = comp.newXmm();  // Use full XMM register for complex numbers
     ASMJIT_CHECK(comp.xorpd(result, result)); // Initialize to zero {0.0, 0.0}
     if (const CompileError err = ast::compile(node, comp, m_state, result); err)
@@ -285,6 +562,37 @@ CompileError ParsedFormula::compile_part(asmjit::x86::Compiler &comp, Expr node,
     return {};
 }
 
+// Counts the instructions left after register allocation, and those addressing the stack frame, which
+// are nearly all spills and reloads.
+CompileStats count_instructions(const asmjit::x86::Compiler &comp)
+{
+    CompileStats stats;
+    for (const asmjit::BaseNode *node = comp.firstNode(); node != nullptr; node = node->next())
+    {
+        if (!node->isInst())
+        {
+            continue;
+        }
+        ++stats.instructions;
+        const asmjit::InstNode *inst{node->as<asmjit::InstNode>()};
+        for (std::uint32_t i = 0; i < inst->opCount(); ++i)
+        {
+            const asmjit::Operand &operand{inst->op(i)};
+            if (!operand.isMem())
+            {
+                continue;
+            }
+            const asmjit::BaseMem &mem{operand.as<asmjit::BaseMem>()};
+            if (mem.hasBaseReg() && (mem.baseId() == asmjit::x86::Gp::kIdSp || mem.baseId() == asmjit::x86::Gp::kIdBp))
+            {
+                ++stats.stack_accesses;
+                break;
+            }
+        }
+    }
+    return stats;
+}
+
 template <typename FunctionPtr>
 FunctionPtr function_cast(const asmjit::CodeHolder &code, char *module, const asmjit::Label label)
 {
@@ -331,16 +639,53 @@ CompileError emit_data_section(asmjit::x86::Compiler &comp, EmitterState &state)
     return {};
 }
 
+// Names each compiled section after the formula and section, sized up to the next function or the end of the code.
+std::vector<JitSymbol> section_symbols(const asmjit::CodeHolder &code, const char *module, const std::string &name,
+    const std::vector<std::pair<const char *, asmjit::Label>> &sections)
+{
+    std::vector<JitSymbol> symbols;
+    for (const auto &[section, label] : sections)
+    {
+        if (label.isValid())
+        {
+            const std::uintptr_t address{reinterpret_cast<std::uintptr_t>(module + code.labelOffsetFromBase(label))};
+            symbols.push_back(JitSymbol{(name.empty() ? "formula" : name) + "::" + section, address, 0});
+        }
+    }
+    std::sort(symbols.begin(), symbols.end(),
+        [](const JitSymbol &lhs, const JitSymbol &rhs) { return lhs.address < rhs.address; });
+    const std::uintptr_t text_end{reinterpret_cast<std::uintptr_t>(module) + code.textSection()->realSize()};
+    for (std::size_t i = 0; i < symbols.size(); ++i)
+    {
+        const std::uintptr_t end{i + 1 < symbols.size() ? symbols[i + 1].address : text_end};
+        symbols[i].size = end > symbols[i].address ? end - symbols[i].address : 0;
+    }
+    return symbols;
+}
+
 bool ParsedFormula::compile()
 {
+    return compile(CompileOptions{});
+}
+
+bool ParsedFormula::compile(const CompileOptions &options)
+{
+    const trace::Scope scope{"Formula::compile", "compiler"};
     reset_compiled_state();
+    const Clock::time_point start{Clock::now()};
     asmjit::CodeHolder code;
-    if (const CompileError err = init_code_holder(code); err)
+    if (const CompileError err = init_code_holder(code, options.assembly_log); err)
     {
         std::cerr << "Failed to initialize code holder:\n" << asmjit::DebugUtils::errorAsString(err.value()) << '\n';
         return false;
     }
     asmjit::x86::Compiler comp(&code);
+    const InstructionSet supported{ast::detect_instruction_set(shared_runtime().runtime.cpuFeatures())};
+    m_state.instruction_set = std::min(options.instruction_set.value_or(supported), supported);
+    m_compile_options = options;
+    m_real_symbols = semantic::find_real_variables(*m_ast, m_state.functions, m_external_symbols);
+    m_state.real_expressions = semantic::find_real_expressions(*m_ast, m_state.functions, m_real_symbols);
+    m_compiled_ast = m_ast;
 
     asmjit::Label per_image_label{};
     asmjit::Label init_label{};
@@ -348,6 +693,7 @@ bool ParsedFormula::compile()
     asmjit::Label bailout_label{};
     asmjit::Label perturb_init_label{};
     asmjit::Label perturb_iterate_label{};
+    asmjit::Label orbit_label{};
     const auto do_part = [&, this](const char *name, Expr part, asmjit::Label &label)
     {
         if (!part)
@@ -372,30 +718,79 @@ bool ParsedFormula::compile()
     {
         return false;
     }
+    if (const CompileError err =
+            ast::compile_orbit(m_ast->iterate, m_ast->bailout, comp, m_state, orbit_label, options.orbit_unroll);
+        err)
+    {
+        std::cerr << "Failed to compile orbit:\n" << asmjit::DebugUtils::errorAsString(err.value()) << '\n';
+        return false;
+    }
     if (const CompileError err = emit_data_section(comp, m_state); err)
     {
         std::cerr << "Failed to emit data section:\n" << asmjit::DebugUtils::errorAsString(err.value()) << '\n';
         return false;
     }
-    ASMJIT_CHECK(comp.finalize());
-
-    if (const asmjit::Error err = m_runtime.add(&m_module, &code); err || !m_module)
+    const Clock::time_point generated{Clock::now()};
+    if (const asmjit::Error err = comp.finalize(); err)
+    {
+        std::cerr << "Failed to finalize formula:\n" << asmjit::DebugUtils::errorAsString(err) << '\n';
+        return false;
+    }
+    const Clock::time_point assembled{Clock::now()};
+    if (const asmjit::Error err = add_module(&m_module, code); err || !m_module)
     {
         std::cerr << "Failed to add formula:\n" << asmjit::DebugUtils::errorAsString(err) << '\n';
         return false;
     }
+    const Clock::time_point relocated{Clock::now()};
+    CompileStats stats{count_instructions(comp)};
+    stats.parse = m_compile_stats.parse;
+    stats.generate = generated - start;
+    stats.assemble = assembled - generated;
+    stats.relocate = relocated - assembled;
+    stats.code_bytes = code.textSection()->realSize();
+    stats.data_bytes = m_state.data.data->realSize();
+    stats.instruction_set = m_state.instruction_set;
+    m_compile_stats = stats;
     m_per_image = function_cast<Function *>(code, m_module, per_image_label);
     m_initialize = function_cast<Function *>(code, m_module, init_label);
     m_iterate = function_cast<Function *>(code, m_module, iterate_label);
     m_bailout = function_cast<Function *>(code, m_module, bailout_label);
     m_perturb_initialize = function_cast<Function *>(code, m_module, perturb_init_label);
     m_perturb_iterate = function_cast<Function *>(code, m_module, perturb_iterate_label);
+    m_orbit = function_cast<OrbitFunction *>(code, m_module, orbit_label);
+
+    if (options.perf_map || options.gdb_jit)
+    {
+        const std::vector<JitSymbol> symbols{section_symbols(code, m_module, options.name,
+            {
+                {"global", per_image_label},
+                {"init", init_label},
+                {"loop", iterate_label},
+                {"bailout", bailout_label},
+                {"perturbinit", perturb_init_label},
+                {"perturbloop", perturb_iterate_label},
+                {"orbit", orbit_label},
+            })};
+        if (options.perf_map && !write_perf_map(symbols))
+        {
+            std::cerr << "Failed to write perf map " << perf_map_path() << '\n';
+        }
+        if (options.gdb_jit)
+        {
+            m_gdb_registration = std::make_unique<GdbJitRegistration>(symbols);
+        }
+    }
 
     return true;
 }
 
 Complex ParsedFormula::run(Section part)
 {
+    if (m_cancellation != nullptr)
+    {
+        m_cancellation->throw_if_cancelled();
+    }
     auto result = [this](Function *fn)
     {
         if (fn == nullptr)
@@ -403,7 +798,8 @@ Complex ParsedFormula::run(Section part)
             return Complex{0.0, 0.0};
         }
         fn();
-        return m_state.symbols["_result"];
+        rethrow_fallback_error();
+        return *m_result;
     };
     switch (part)
     {
@@ -425,6 +821,123 @@ Complex ParsedFormula::run(Section part)
     throw std::runtime_error("Invalid part for run");
 }
 
+// The real and imaginary arrays of a complex input or output must be given together.
+void check_batch_pair(const double *re, const double *im, const char *name)
+{
+    if ((re == nullptr) != (im == nullptr))
+    {
+        throw std::invalid_argument(std::string{"Batch "} + name + "_re and " + name + "_im must both be set");
+    }
+}
+
+template <typename Evaluate, typename Orbit>
+void ParsedFormula::batch(Section section, const BatchInputs &inputs, const BatchOutputs &outputs,
+    std::size_t count, int max_iterations, const Evaluate &evaluate, const Orbit &orbit)
+{
+    check_batch_pair(inputs.pixel_re, inputs.pixel_im, "pixel");
+    check_batch_pair(inputs.z_re, inputs.z_im, "z");
+    check_batch_pair(outputs.z_re, outputs.z_im, "z");
+    check_batch_pair(outputs.result_re, outputs.result_im, "result");
+    check_batch_pair(outputs.dz_re, outputs.dz_im, "dz");
+    Complex &pixel{m_state.symbols["pixel"]};
+    Complex &z{m_state.symbols["z"]};
+    const Complex *dz{outputs.dz_re != nullptr ? &m_state.symbols[semantic::derivative_name("z")] : nullptr};
+    const bool orbits{section == Section::ITERATE};
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (inputs.random_streams != nullptr)
+        {
+            set_random_stream(inputs.random_streams[i]);
+        }
+        if (inputs.pixel_re != nullptr)
+        {
+            pixel = {inputs.pixel_re[i], inputs.pixel_im[i]};
+        }
+        if (orbits && m_ast->initialize)
+        {
+            *m_result = evaluate(Section::INITIALIZE);
+        }
+        if (inputs.z_re != nullptr)
+        {
+            z = {inputs.z_re[i], inputs.z_im[i]};
+        }
+        if (orbits)
+        {
+            const int iterations{orbit(max_iterations)};
+            if (outputs.iterations != nullptr)
+            {
+                outputs.iterations[i] = iterations;
+            }
+            if (outputs.escaped != nullptr)
+            {
+                outputs.escaped[i] = iterations < max_iterations;
+            }
+        }
+        else
+        {
+            *m_result = evaluate(section);
+        }
+        if (outputs.z_re != nullptr)
+        {
+            outputs.z_re[i] = z.re;
+            outputs.z_im[i] = z.im;
+        }
+        if (dz != nullptr)
+        {
+            outputs.dz_re[i] = dz->re;
+            outputs.dz_im[i] = dz->im;
+        }
+        if (outputs.result_re != nullptr)
+        {
+            outputs.result_re[i] = m_result->re;
+            outputs.result_im[i] = m_result->im;
+        }
+        // A compiled orbit that saw the token cancelled returns early, so its outputs are discarded.
+        if (m_cancellation != nullptr)
+        {
+            m_cancellation->throw_if_cancelled();
+        }
+    }
+}
+
+void ParsedFormula::interpret_batch(Section section, const BatchInputs &inputs, const BatchOutputs &outputs,
+    std::size_t count, int max_iterations)
+{
+    const auto orbit = [this](int max)
+    {
+        for (int iteration = 0; iteration < max; ++iteration)
+        {
+            interpret(Section::ITERATE);
+            if (m_ast->bailout)
+            {
+                *m_result = interpret(Section::BAILOUT);
+                if (m_result->re == 0.0)
+                {
+                    return iteration;
+                }
+            }
+        }
+        return max;
+    };
+    batch(section, inputs, outputs, count, max_iterations, [this](Section part) { return interpret(part); }, orbit);
+}
+
+void ParsedFormula::run_batch(Section section, const BatchInputs &inputs, const BatchOutputs &outputs,
+    std::size_t count, int max_iterations)
+{
+    if (m_orbit == nullptr)
+    {
+        throw std::runtime_error("Formula must be compiled before run_batch");
+    }
+    batch(section, inputs, outputs, count, max_iterations, [this](Section part) { return run(part); },
+        [this](int max)
+        {
+            const int iterations{m_orbit(max)};
+            rethrow_fallback_error();
+            return iterations;
+        });
+}
+
 } // namespace
 
 #define SECTION_CASE(name_) \
@@ -454,11 +967,22 @@ std::string_view to_string(Section value)
 
 #undef SECTION_CASE
 
+std::future<bool> Formula::compile_async()
+{
+    return compile_async(CompileOptions{});
+}
+
+std::future<bool> Formula::compile_async(const CompileOptions &options)
+{
+    return compile_pool().submit(std::packaged_task<bool()>{[this, options] { return compile(options); }});
+}
+
 FormulaPtr create_formula(std::string_view text, const parser::Options &options)
 {
+    const Clock::time_point start{Clock::now()};
     if (FormulaSectionsPtr sections = parser::parse(text, options))
     {
-        return std::make_shared<ParsedFormula>(sections);
+        return std::make_shared<ParsedFormula>(sections, Clock::now() - start);
     }
     return {};
 }
@@ -4,11 +4,19 @@
 //
 #pragma once
 
+#include <formula/core/Cancellation.h>
 #include <formula/core/Complex.h>
+#include <formula/core/InstructionSet.h>
 #include <formula/parser/FormulaEntry.h>
 
+#include <cassert>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <future>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 
@@ -26,6 +34,8 @@ namespace parser
 struct Options;
 } // namespace parser
 
+class ExecutionProfile;
+
 enum class Section
 {
     NONE = 0,
@@ -50,6 +60,81 @@ inline int operator+(Section value)
 
 std::string_view to_string(Section value);
 
+struct CompileOptions
+{
+    std::string name;          // compiled sections are named <name>::<section>, e.g. Mandelbrot::loop
+    bool perf_map{};           // append the section symbols to /tmp/perf-<pid>.map for perf
+    bool gdb_jit{};            // register the section symbols with the GDB JIT interface
+    std::FILE *assembly_log{}; // when set, the generated assembly is written here, e.g. stdout
+    int orbit_unroll{1};       // orbit iterations per bailout branch, see ast::compile_orbit
+    // Emit code for at most this instruction set, e.g. SSE2 to compare against other machines; unset
+    // uses the best the CPU supports.  Tiers above what the CPU supports are lowered to it.
+    std::optional<InstructionSet> instruction_set;
+};
+
+// What creating and compiling a formula cost and produced, for tracking JIT latency.  The timings
+// and sizes other than parse describe the last successful compile().
+struct CompileStats
+{
+    std::chrono::duration<double> parse{};    // create_formula: parsing and validation
+    std::chrono::duration<double> generate{}; // emitting the sections as asmjit nodes
+    std::chrono::duration<double> assemble{}; // register allocation and encoding
+    std::chrono::duration<double> relocate{}; // copying into executable memory and resolving addresses
+    std::size_t instructions{};               // machine instructions after register allocation
+    std::size_t stack_accesses{};             // instructions addressing the stack frame: spills and reloads
+    std::size_t code_bytes{};                 // .text
+    std::size_t data_bytes{};                 // .data: constants and symbol bindings
+    InstructionSet instruction_set{};         // the tier the code was generated for
+};
+
+// Per-element inputs of a batch as separate arrays (structure of arrays).  Null arrays are not used.
+struct BatchInputs
+{
+    const double *pixel_re{};
+    const double *pixel_im{};
+    const double *z_re{}; // replaces the z the init section computed for ITERATE, or z before other sections
+    const double *z_im{};
+    const std::uint64_t *random_streams{}; // selects the rand stream of each element
+};
+
+// Per-element outputs of a batch; null arrays are not written.
+struct BatchOutputs
+{
+    double *z_re{};
+    double *z_im{};
+    double *result_re{}; // value of the last section run for the element
+    double *result_im{};
+    int *iterations{}; // ITERATE only: iterations that passed the bailout test
+    bool *escaped{};   // ITERATE only
+    double *dz_re{};   // after enable_derivative: dz/dpixel
+    double *dz_im{};
+};
+
+class Formula;
+
+// The storage of one formula symbol, found once by name with Formula::lookup_symbol and then read and
+// written without a lookup.  It stays valid for the lifetime of the formula, across compile(), and is
+// shared by interpret and run.
+class SymbolHandle
+{
+public:
+    SymbolHandle() = default;
+    explicit SymbolHandle(Complex *storage) :
+        m_storage(storage)
+    {
+    }
+
+    explicit operator bool() const
+    {
+        return m_storage != nullptr;
+    }
+
+private:
+    friend class Formula;
+
+    Complex *m_storage{};
+};
+
 class Formula
 {
 public:
@@ -57,13 +142,52 @@ public:
 
     virtual void set_value(std::string_view name, Complex value) = 0;
     virtual Complex get_value(std::string_view name) const = 0;
+    // Finds the symbol, creating it with the value zero when it doesn't exist yet.
+    virtual SymbolHandle lookup_symbol(std::string_view name) = 0;
+    void set(SymbolHandle symbol, Complex value)
+    {
+        assert(symbol);
+        *symbol.m_storage = value;
+    }
+    Complex get(SymbolHandle symbol) const
+    {
+        assert(symbol);
+        return *symbol.m_storage;
+    }
     virtual bool set_function(std::string_view name, std::string_view function) = 0;
     virtual std::string get_function(std::string_view name) const = 0;
     virtual void set_random_seed(std::uint32_t seed) = 0;
+    // Selects the sequence rand draws from, normally the pixel index, and restarts it.
+    virtual void set_random_stream(std::uint64_t stream) = 0;
     virtual const ast::Expr &get_section(Section section) const = 0;
+    // Makes the init and iterate sections also compute the derivative of every variable they assign with
+    // respect to pixel, e.g. __d_z for z, for distance estimation; see semantic::differentiate.  fn1-fn4
+    // are resolved through the current selections.  Call before compile().  Returns false, leaving the
+    // formula unchanged, when an assignment has no complex derivative.
+    virtual bool enable_derivative() = 0;
     virtual Complex interpret(Section part) = 0;
+    // Interpreted sections record counts and timings into profile until it is reset to nullptr.
+    virtual void set_profile(ExecutionProfile *profile) = 0;
+    // Sections and batches throw CancelledError once token is cancelled, until it is reset to nullptr.
+    // Compiled orbits poll the token, so a token set after compile() still stops them.
+    virtual void set_cancellation(const CancellationToken *token) = 0;
     virtual bool compile() = 0;
+    virtual bool compile(const CompileOptions &options) = 0;
+    // Compiles on the compilation thread pool shared by all formulas; the future holds the result of
+    // compile(options).  The formula must not be used or destroyed until the future is ready.
+    std::future<bool> compile_async();
+    std::future<bool> compile_async(const CompileOptions &options);
+    virtual const CompileStats &get_compile_stats() const = 0;
     virtual Complex run(Section part) = 0;
+    // Evaluates count elements without returning to the caller between them.  For Section::ITERATE each
+    // element is a whole orbit: the init section, then the loop and bailout sections until the bailout
+    // is false or max_iterations is reached.  Any other section runs once per element and ignores
+    // max_iterations.  interpret_batch uses the interpreter and run_batch the compiled code, whose orbit
+    // loop runs natively.  Throws std::invalid_argument when only one array of a _re/_im pair is set.
+    virtual void interpret_batch(Section section, const BatchInputs &inputs, const BatchOutputs &outputs,
+        std::size_t count, int max_iterations) = 0;
+    virtual void run_batch(Section section, const BatchInputs &inputs, const BatchOutputs &outputs,
+        std::size_t count, int max_iterations) = 0;
 };
 
 using FormulaPtr = std::shared_ptr<Formula>;
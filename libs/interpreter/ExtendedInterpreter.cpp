@@ -1550,7 +1550,8 @@ class ExpressionInterpreter : public ast::NullVisitor
 {
 public:
     ExpressionInterpreter(ExtendedRuntimeState &state, const FunctionMap &functions, const FormulaFileSet &files,
-        std::size_t max_loop_iterations);
+        std::size_t max_loop_iterations, ExecutionProfile *profile = nullptr,
+        const CancellationToken *cancellation = nullptr);
 
     Value interpret(const ast::Expr &node);
     void visit(const ast::AssignmentNode &node) override;
@@ -1605,16 +1606,21 @@ private:
     FunctionMap m_functions;
     const FormulaFileSet &m_files;
     std::size_t m_max_loop_iterations{};
+    ExecutionProfile *m_profile{};
+    const CancellationToken *m_cancellation{};
     Value m_result;
     bool m_returning{};
 };
 
 ExpressionInterpreter::ExpressionInterpreter(ExtendedRuntimeState &state, const FunctionMap &functions,
-    const FormulaFileSet &files, std::size_t max_loop_iterations) :
+    const FormulaFileSet &files, std::size_t max_loop_iterations, ExecutionProfile *profile,
+    const CancellationToken *cancellation) :
     m_state(state),
     m_functions(functions),
     m_files(files),
-    m_max_loop_iterations(max_loop_iterations)
+    m_max_loop_iterations(max_loop_iterations),
+    m_profile(profile),
+    m_cancellation(cancellation)
 {
 }
 
@@ -1624,6 +1630,12 @@ Value ExpressionInterpreter::interpret(const ast::Expr &node)
     {
         return {};
     }
+    if (m_profile == nullptr)
+    {
+        node->visit(*this);
+        return m_result;
+    }
+    ProfileScope scope{m_profile, node.get()};
     node->visit(*this);
     return m_result;
 }
@@ -2649,6 +2661,10 @@ void ExpressionInterpreter::check_loop_iterations(std::size_t iterations) const
     {
         throw std::runtime_error("loop iteration limit exceeded");
     }
+    if (m_cancellation != nullptr)
+    {
+        m_cancellation->throw_if_cancelled();
+    }
 }
 
 RuntimeLValue ExpressionInterpreter::lvalue(const ast::Expr &node)
@@ -2989,6 +3005,19 @@ void ExtendedInterpreter::set_value(std::string_view name, Value value)
     m_state.set_formula_value(name, std::move(value));
 }
 
+void ExtendedInterpreter::bind_predefined(std::string_view name, std::shared_ptr<Value> storage)
+{
+    std::string_view symbol{name};
+    if (!symbol.empty() && symbol.front() == '#')
+    {
+        symbol.remove_prefix(1);
+    }
+    const semantic::SemanticPredefinedSymbolDescriptor *descriptor{
+        builtins_or_default(m_options.builtins).find_predefined_symbol(symbol)};
+    m_state.bind_predefined_reference(
+        symbol, RuntimeLValue::variable(std::move(storage), descriptor == nullptr || descriptor->writable));
+}
+
 void ExtendedInterpreter::set_parameter(std::string_view name, Value value)
 {
     if (set_nonselectable_plugin_parameter_value(name, value))
@@ -3259,12 +3288,31 @@ Value ExtendedInterpreter::interpret(Section section)
     {
         return {};
     }
-    FunctionMap functions{collect_function_declarations(*m_ast)};
-    const Value result{ExpressionInterpreter{m_state, functions, m_files, m_options.max_loop_iterations}.interpret(
-        section_expr(*m_ast, section))};
+    if (m_cancellation != nullptr)
+    {
+        m_cancellation->throw_if_cancelled();
+    }
+    ProfileScope scope{m_profile, section};
+    const Value result{ExpressionInterpreter{
+        m_state, m_functions, m_files, m_options.max_loop_iterations, m_profile, m_cancellation}
+            .interpret(section_expr(*m_ast, section))};
     return section_result(section, result);
 }
 
+void ExtendedInterpreter::set_profile(ExecutionProfile *profile)
+{
+    m_profile = profile;
+    if (m_profile && m_ast)
+    {
+        m_profile->set_locations(m_ast->locations);
+    }
+}
+
+void ExtendedInterpreter::set_cancellation(const CancellationToken *token)
+{
+    m_cancellation = token;
+}
+
 void ExtendedInterpreter::parse()
 {
     const parser::ParserPtr parser{parser::create_parser(m_entry.body, m_options.parser)};
@@ -3337,8 +3385,8 @@ void ExtendedInterpreter::initialize_runtime_state()
         }
         m_state.set_predefined_value(symbol.name, std::move(value), symbol.writable);
     }
-    FunctionMap functions{collect_function_declarations(*m_ast)};
-    ParameterDefaultCollector{m_state, functions, m_files, m_options.max_loop_iterations}.collect(m_ast->defaults);
+    m_functions = collect_function_declarations(*m_ast);
+    ParameterDefaultCollector{m_state, m_functions, m_files, m_options.max_loop_iterations}.collect(m_ast->defaults);
     const RuntimeParameterMetadata metadata{collect_runtime_parameter_metadata(*m_ast)};
     for (const RuntimeParameterInfo &parameter : metadata.params)
     {
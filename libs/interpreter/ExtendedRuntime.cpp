@@ -272,6 +272,16 @@ RuntimeLValue ExtendedRuntimeState::predefined_lvalue(std::string_view name)
     return m_predefined[key].value;
 }
 
+void ExtendedRuntimeState::bind_predefined_reference(std::string_view name, RuntimeLValue value)
+{
+    if (!value.valid())
+    {
+        throw std::runtime_error("cannot bind invalid lvalue");
+    }
+    const std::string key{predefined_key(name)};
+    m_predefined[key] = RuntimeBinding{key, std::move(value)};
+}
+
 void ExtendedRuntimeState::add_message(std::string message)
 {
     m_messages.push_back(std::move(message));
@@ -5,11 +5,15 @@
 #include <formula/interpreter/Interpreter.h>
 
 #include <formula/core/Visitor.h>
+#include <formula/interpreter/Profiler.h>
 
 #include <formula/core/functions.h>
 #include <formula/core/Node.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -23,10 +27,14 @@ namespace
 class Interpreter : public NullVisitor
 {
 public:
-    explicit Interpreter(Dictionary symbols, std::map<std::string, std::string> functions, std::mt19937 *random) :
-        m_symbols(std::move(symbols)),
-        m_functions(std::move(functions)),
-        m_random(random)
+    // Works on the caller's symbols in place, so references to them stay valid across sections.
+    Interpreter(Dictionary &symbols, const std::map<std::string, std::string> &functions, RandomState *random,
+        ExecutionProfile *profile, const CancellationToken *cancellation) :
+        m_symbols(symbols),
+        m_functions(functions),
+        m_random(random),
+        m_profile(profile),
+        m_cancellation(cancellation)
     {
     }
     Interpreter(const Interpreter &rhs) = delete;
@@ -59,12 +67,19 @@ public:
         return m_result.back();
     }
 
-    const Dictionary &symbols() const
+    void visit_child(const Expr &node)
     {
-        return m_symbols;
+        if (m_profile == nullptr)
+        {
+            node->visit(*this);
+            return;
+        }
+        ProfileScope scope{m_profile, node.get()};
+        node->visit(*this);
     }
 
 private:
+    void check_loop_iterations(std::size_t iterations) const;
     Complex &back()
     {
         return m_result.back();
@@ -77,9 +92,11 @@ private:
     }
 
     std::vector<Complex> m_result{1};
-    Dictionary m_symbols;
-    std::map<std::string, std::string> m_functions;
-    std::mt19937 *m_random{};
+    Dictionary &m_symbols;
+    const std::map<std::string, std::string> &m_functions;
+    RandomState *m_random{};
+    ExecutionProfile *m_profile{};
+    const CancellationToken *m_cancellation{};
 };
 
 void unsupported_node(std::string_view name)
@@ -89,13 +106,13 @@ void unsupported_node(std::string_view name)
 
 void Interpreter::visit(const AssignmentNode &node)
 {
-    node.expression()->visit(*this);
+    visit_child(node.expression());
     m_symbols[node.variable()] = result();
 }
 
 void Interpreter::visit(const BinaryOpNode &node)
 {
-    node.left()->visit(*this);
+    visit_child(node.left());
     const std::string &op{node.op()};
     const auto bool_result = [](bool condition)
     {
@@ -108,7 +125,7 @@ void Interpreter::visit(const BinaryOpNode &node)
             back() = bool_result(false);
             return;
         }
-        node.right()->visit(*this);
+        visit_child(node.right());
         back() = bool_result(result().re != 0.0);
         return;
     }
@@ -119,13 +136,13 @@ void Interpreter::visit(const BinaryOpNode &node)
             back() = bool_result(true);
             return;
         }
-        node.right()->visit(*this);
+        visit_child(node.right());
         back() = bool_result(result().re != 0.0);
         return;
     }
 
     m_result.push_back(Complex{});
-    node.right()->visit(*this);
+    visit_child(node.right());
     const Complex right{pop()};
     const Complex &left{back()};
     if (op == "+")
@@ -195,13 +212,13 @@ void Interpreter::visit(const FunctionDeclNode &)
 
 void Interpreter::visit(const FunctionCallNode &node)
 {
-    node.arg()->visit(*this);
+    visit_child(node.arg());
     const std::string name{select_function(node.name(), m_functions)};
     if (name == "srand")
     {
         if (m_random != nullptr)
         {
-            m_random->seed(static_cast<std::mt19937::result_type>(back().re));
+            m_random->seed(static_cast<std::uint32_t>(back().re));
         }
         back() = {};
         return;
@@ -230,12 +247,12 @@ void Interpreter::visit(const IdentifierNode &node)
 
 void Interpreter::visit(const IfStatementNode &node)
 {
-    node.condition()->visit(*this);
+    visit_child(node.condition());
     if (result().re != 0.0) // Only check real part
     {
         if (node.has_then_block())
         {
-            node.then_block()->visit(*this);
+            visit_child(node.then_block());
         }
         else
         {
@@ -246,7 +263,7 @@ void Interpreter::visit(const IfStatementNode &node)
 
     if (node.has_else_block())
     {
-        node.else_block()->visit(*this);
+        visit_child(node.else_block());
     }
     else
     {
@@ -300,9 +317,32 @@ void Interpreter::visit(const ParameterRefNode &)
     unsupported_node("ParameterRefNode");
 }
 
-void Interpreter::visit(const RepeatUntilNode &)
+void Interpreter::check_loop_iterations(std::size_t iterations) const
 {
-    unsupported_node("RepeatUntilNode");
+    if (iterations > MAX_LOOP_ITERATIONS)
+    {
+        throw std::runtime_error("loop iteration limit exceeded");
+    }
+    if (m_cancellation != nullptr)
+    {
+        m_cancellation->throw_if_cancelled();
+    }
+}
+
+// Loops are statements, so like an if without an else they leave 0.
+void Interpreter::visit(const RepeatUntilNode &node)
+{
+    std::size_t iterations{};
+    do
+    {
+        check_loop_iterations(++iterations);
+        if (node.body())
+        {
+            visit_child(node.body());
+        }
+        visit_child(node.condition());
+    } while (result().re == 0.0);
+    back() = Complex{};
 }
 
 void Interpreter::visit(const ReturnNode &)
@@ -314,13 +354,13 @@ void Interpreter::visit(const StatementSeqNode &node)
 {
     for (const Expr &st : node.statements())
     {
-        st->visit(*this);
+        visit_child(st);
     }
 }
 
 void Interpreter::visit(const UnaryOpNode &node)
 {
-    node.operand()->visit(*this);
+    visit_child(node.operand());
     if (node.op() == '-')
     {
         back().re = -back().re;
@@ -335,11 +375,135 @@ void Interpreter::visit(const UnaryOpNode &node)
     // nothing to be done for unary + since it doesn't change the value
 }
 
-void Interpreter::visit(const WhileNode &)
+void Interpreter::visit(const WhileNode &node)
 {
-    unsupported_node("WhileNode");
+    visit_child(node.condition());
+    std::size_t iterations{};
+    while (result().re != 0.0)
+    {
+        check_loop_iterations(++iterations);
+        if (node.body())
+        {
+            visit_child(node.body());
+        }
+        visit_child(node.condition());
+    }
+    back() = Complex{};
 }
 
+// Rejects the nodes Interpreter throws on.
+class InterpretableChecker : public NullVisitor
+{
+public:
+    explicit InterpretableChecker(const std::map<std::string, std::string> &functions) :
+        m_functions(functions)
+    {
+    }
+    ~InterpretableChecker() override = default;
+
+    void check(const Expr &node)
+    {
+        if (node && m_supported)
+        {
+            node->visit(*this);
+        }
+    }
+    bool supported() const
+    {
+        return m_supported;
+    }
+
+    void visit(const AssignmentNode &node) override
+    {
+        check(node.expression());
+    }
+    void visit(const BinaryOpNode &node) override
+    {
+        check(node.left());
+        check(node.right());
+    }
+    void visit(const ConstantRefNode &) override
+    {
+        m_supported = false;
+    }
+    void visit(const DeclarationNode &) override
+    {
+        m_supported = false;
+    }
+    void visit(const FunctionDeclNode &) override
+    {
+        m_supported = false;
+    }
+    void visit(const FunctionCallNode &node) override
+    {
+        const std::string name{select_function(node.name(), m_functions)};
+        if (node.has_target() || node.args().size() != 1 ||
+            (lookup_complex(name) == nullptr && lookup_real(name) == nullptr))
+        {
+            m_supported = false;
+            return;
+        }
+        check(node.arg());
+    }
+    void visit(const IfStatementNode &node) override
+    {
+        check(node.condition());
+        if (node.has_then_block())
+        {
+            check(node.then_block());
+        }
+        if (node.has_else_block())
+        {
+            check(node.else_block());
+        }
+    }
+    void visit(const IndexNode &) override
+    {
+        m_supported = false;
+    }
+    void visit(const MemberAccessNode &) override
+    {
+        m_supported = false;
+    }
+    void visit(const NewNode &) override
+    {
+        m_supported = false;
+    }
+    void visit(const ParameterRefNode &) override
+    {
+        m_supported = false;
+    }
+    void visit(const RepeatUntilNode &node) override
+    {
+        check(node.body());
+        check(node.condition());
+    }
+    void visit(const ReturnNode &) override
+    {
+        m_supported = false;
+    }
+    void visit(const StatementSeqNode &node) override
+    {
+        for (const Expr &statement : node.statements())
+        {
+            check(statement);
+        }
+    }
+    void visit(const UnaryOpNode &node) override
+    {
+        check(node.operand());
+    }
+    void visit(const WhileNode &node) override
+    {
+        check(node.condition());
+        check(node.body());
+    }
+
+private:
+    const std::map<std::string, std::string> &m_functions;
+    bool m_supported{true};
+};
+
 } // namespace
 
 Complex interpret(const std::shared_ptr<Node> &expr, Dictionary &symbols)
@@ -354,12 +518,31 @@ Complex interpret(
 }
 
 Complex interpret(const std::shared_ptr<Node> &expr, Dictionary &symbols,
-    const std::map<std::string, std::string> &functions, std::mt19937 *random)
+    const std::map<std::string, std::string> &functions, RandomState *random)
 {
-    Interpreter interp(symbols, functions, random);
-    expr->visit(interp);
-    symbols = interp.symbols();
+    return interpret(expr, symbols, functions, random, nullptr);
+}
+
+Complex interpret(const std::shared_ptr<Node> &expr, Dictionary &symbols,
+    const std::map<std::string, std::string> &functions, RandomState *random, ExecutionProfile *profile)
+{
+    return interpret(expr, symbols, functions, random, profile, nullptr);
+}
+
+Complex interpret(const std::shared_ptr<Node> &expr, Dictionary &symbols,
+    const std::map<std::string, std::string> &functions, RandomState *random, ExecutionProfile *profile,
+    const CancellationToken *cancellation)
+{
+    Interpreter interp(symbols, functions, random, profile, cancellation);
+    interp.visit_child(expr);
     return interp.result();
 }
 
+bool can_interpret(const Node &expr, const std::map<std::string, std::string> &functions)
+{
+    InterpretableChecker checker{functions};
+    expr.visit(checker);
+    return checker.supported();
+}
+
 } // namespace formula::ast
@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/interpreter/LayerPipeline.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+
+namespace formula
+{
+
+namespace
+{
+
+using parameter::ParameterReferenceKind;
+
+Complex complex_of(const Value &value)
+{
+    if (const Complex *z = std::get_if<Complex>(&value.storage()))
+    {
+        return *z;
+    }
+    if (const double *re = std::get_if<double>(&value.storage()))
+    {
+        return {*re, 0.0};
+    }
+    if (const int *re = std::get_if<int>(&value.storage()))
+    {
+        return {static_cast<double>(*re), 0.0};
+    }
+    return {};
+}
+
+} // namespace
+
+LayerPipeline::LayerPipeline(PreparedParameterSet &prepared, std::size_t layer)
+{
+    if (!prepared.ok())
+    {
+        throw std::runtime_error("The parameter set has diagnostics");
+    }
+    std::vector<PreparedParameterFormula *> transforms;
+    for (PreparedParameterFormula &formula : prepared.formulas)
+    {
+        if (formula.site.layer_index != layer)
+        {
+            continue;
+        }
+        switch (formula.site.kind)
+        {
+        case ParameterReferenceKind::FRACTAL_FORMULA:
+            if (m_fractal == nullptr)
+            {
+                m_fractal = &formula.interpreter;
+            }
+            break;
+        case ParameterReferenceKind::INSIDE_COLORING:
+            m_inside = &formula.interpreter;
+            break;
+        case ParameterReferenceKind::OUTSIDE_COLORING:
+            m_outside = &formula.interpreter;
+            break;
+        case ParameterReferenceKind::TRANSFORM:
+            transforms.push_back(&formula);
+            break;
+        }
+    }
+    if (m_fractal == nullptr)
+    {
+        throw std::runtime_error("Layer " + std::to_string(layer) + " has no fractal formula");
+    }
+    std::stable_sort(transforms.begin(), transforms.end(),
+        [](const PreparedParameterFormula *lhs, const PreparedParameterFormula *rhs)
+        { return lhs->site.transform_index < rhs->site.transform_index; });
+    for (PreparedParameterFormula *transform : transforms)
+    {
+        m_transforms.push_back(&transform->interpreter);
+    }
+
+    for (ExtendedInterpreter *transform : m_transforms)
+    {
+        bind(*transform);
+    }
+    bind(*m_fractal);
+    for (ExtendedInterpreter *coloring : {m_inside, m_outside})
+    {
+        if (coloring != nullptr)
+        {
+            bind(*coloring);
+        }
+    }
+}
+
+void LayerPipeline::bind(ExtendedInterpreter &interpreter)
+{
+    interpreter.bind_predefined("#pixel", m_storage.pixel);
+    interpreter.bind_predefined("#z", m_storage.z);
+    interpreter.bind_predefined("#numiter", m_storage.numiter);
+    interpreter.bind_predefined("#maxiter", m_storage.maxiter);
+    interpreter.bind_predefined("#solid", m_storage.solid);
+    interpreter.bind_predefined("#index", m_storage.index);
+    interpreter.bind_predefined("#color", m_storage.color);
+}
+
+void LayerPipeline::set_cancellation(const CancellationToken *token)
+{
+    for (ExtendedInterpreter *transform : m_transforms)
+    {
+        transform->set_cancellation(token);
+    }
+    for (ExtendedInterpreter *interpreter : {m_fractal, m_inside, m_outside})
+    {
+        if (interpreter != nullptr)
+        {
+            interpreter->set_cancellation(token);
+        }
+    }
+}
+
+void LayerPipeline::set_max_iterations(int max_iterations)
+{
+    if (max_iterations == m_max_iterations)
+    {
+        return;
+    }
+    m_max_iterations = max_iterations;
+    *m_storage.maxiter = Value{max_iterations};
+    for (ExtendedInterpreter *transform : m_transforms)
+    {
+        transform->interpret(Section::PER_IMAGE);
+    }
+    for (ExtendedInterpreter *interpreter : {m_fractal, m_inside, m_outside})
+    {
+        if (interpreter != nullptr)
+        {
+            interpreter->interpret(Section::PER_IMAGE);
+        }
+    }
+}
+
+// A fractal that iterates its own z publishes it to the colorings; one that writes #z directly already has.
+void LayerPipeline::publish_z()
+{
+    Value z{m_fractal->value("z")};
+    if (z.kind() != ValueKind::EMPTY)
+    {
+        *m_storage.z = std::move(z);
+    }
+}
+
+LayerPixel LayerPipeline::evaluate(Complex pixel, int max_iterations)
+{
+    set_max_iterations(max_iterations);
+    *m_storage.pixel = Value{pixel};
+    *m_storage.z = Value{Complex{}};
+    *m_storage.numiter = Value{0};
+    *m_storage.solid = Value{false};
+    *m_storage.index = Value{0.0};
+    *m_storage.color = Value{ColorValue{}};
+
+    LayerPixel result;
+    for (ExtendedInterpreter *transform : m_transforms)
+    {
+        transform->interpret(Section::TRANSFORM);
+        if (is_truthy(*m_storage.solid))
+        {
+            result.solid = true;
+            return result;
+        }
+    }
+
+    m_fractal->interpret(Section::INITIALIZE);
+    publish_z();
+    ExtendedInterpreter *colorings[]{m_inside, m_outside};
+    for (ExtendedInterpreter *coloring : colorings)
+    {
+        if (coloring != nullptr)
+        {
+            coloring->interpret(Section::INITIALIZE);
+        }
+    }
+    while (result.iterations < max_iterations)
+    {
+        m_fractal->interpret(Section::ITERATE);
+        publish_z();
+        *m_storage.numiter = Value{++result.iterations};
+        for (ExtendedInterpreter *coloring : colorings)
+        {
+            if (coloring != nullptr)
+            {
+                coloring->interpret(Section::ITERATE);
+            }
+        }
+        if (!is_truthy(m_fractal->interpret(Section::BAILOUT)))
+        {
+            result.escaped = true;
+            break;
+        }
+    }
+
+    if (ExtendedInterpreter *coloring{result.escaped ? m_outside : m_inside})
+    {
+        coloring->interpret(Section::FINAL);
+    }
+    result.solid = is_truthy(*m_storage.solid);
+    result.z = complex_of(*m_storage.z);
+    result.index = *m_storage.index;
+    result.color = *m_storage.color;
+    return result;
+}
+
+} // namespace formula
@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/interpreter/Profiler.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace formula
+{
+
+namespace
+{
+
+// Section labels as they are written in formula source.
+const char *section_label(Section section)
+{
+    switch (section)
+    {
+    case Section::PER_IMAGE:
+        return "global";
+    case Section::BUILTIN:
+        return "builtin";
+    case Section::INITIALIZE:
+        return "init";
+    case Section::ITERATE:
+        return "loop";
+    case Section::BAILOUT:
+        return "bailout";
+    case Section::PERTURB_INITIALIZE:
+        return "perturbinit";
+    case Section::PERTURB_ITERATE:
+        return "perturbloop";
+    case Section::DEFAULT:
+        return "default";
+    case Section::SWITCH:
+        return "switch";
+    case Section::FINAL:
+        return "final";
+    case Section::TRANSFORM:
+        return "transform";
+    case Section::NONE:
+    case Section::NUM_SECTIONS:
+        break;
+    }
+    return "none";
+}
+
+// Nodes without a recorded location were synthesized from their parent, so report them on the parent's line.
+std::size_t node_line(const ExecutionProfile &profile, const ast::Node *node)
+{
+    while (node)
+    {
+        if (const auto it = profile.locations().find(node); it != profile.locations().end())
+        {
+            return it->second.line;
+        }
+        const auto parent = profile.nodes().find(node);
+        node = parent == profile.nodes().end() ? nullptr : parent->second.parent;
+    }
+    return 0;
+}
+
+double microseconds(std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+std::string_view source_line(std::string_view source, std::size_t line)
+{
+    if (line == 0)
+    {
+        return {};
+    }
+    std::size_t begin = 0;
+    for (std::size_t current = 1; current < line; ++current)
+    {
+        begin = source.find('\n', begin);
+        if (begin == std::string_view::npos)
+        {
+            return {};
+        }
+        ++begin;
+    }
+    std::string_view text{source.substr(begin, source.find('\n', begin) - begin)};
+    while (!text.empty() && (text.back() == '\r' || text.back() == ' ' || text.back() == '\t'))
+    {
+        text.remove_suffix(1);
+    }
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+    {
+        text.remove_prefix(1);
+    }
+    return text;
+}
+
+} // namespace
+
+void ExecutionProfile::set_locations(const ast::NodeLocations &locations)
+{
+    m_locations = locations;
+}
+
+void ExecutionProfile::clear()
+{
+    m_sections.fill({});
+    m_nodes.clear();
+    m_active.clear();
+    m_frames.clear();
+}
+
+void ExecutionProfile::begin_section(Section section)
+{
+    ProfileCounter &counter{m_sections[+section]};
+    ++counter.count;
+    m_frames.push_back({nullptr, &counter, nullptr, Clock::now()});
+}
+
+void ExecutionProfile::begin_node(const ast::Node *node)
+{
+    const ast::Node *parent = m_frames.empty() ? nullptr : m_frames.back().node;
+    const auto [it, inserted] = m_nodes.try_emplace(node);
+    if (inserted)
+    {
+        it->second.parent = parent;
+    }
+    ++it->second.count;
+    int &active{m_active[node]};
+    ++active;
+    m_frames.push_back({node, &it->second, &active, Clock::now()});
+}
+
+void ExecutionProfile::end()
+{
+    const Frame frame{m_frames.back()};
+    m_frames.pop_back();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frame.start);
+    frame.counter->self += elapsed - frame.children;
+    if (frame.active == nullptr || --*frame.active == 0)
+    {
+        frame.counter->inclusive += elapsed;
+    }
+    if (!m_frames.empty())
+    {
+        m_frames.back().children += elapsed;
+    }
+}
+
+std::vector<LineProfile> hottest_lines(const ExecutionProfile &profile, std::size_t limit)
+{
+    std::map<std::size_t, LineProfile> lines;
+    for (const auto &[node, counter] : profile.nodes())
+    {
+        const std::size_t line{node_line(profile, node)};
+        LineProfile &entry{lines[line]};
+        entry.line = line;
+        entry.self += counter.self;
+        // Only nodes entered from another line contribute executions and inclusive time;
+        // their descendants on the same line are already part of that time.
+        if (counter.parent == nullptr || node_line(profile, counter.parent) != line)
+        {
+            entry.count += counter.count;
+            entry.inclusive += counter.inclusive;
+        }
+    }
+
+    std::vector<LineProfile> result;
+    result.reserve(lines.size());
+    for (const auto &[line, entry] : lines)
+    {
+        result.push_back(entry);
+    }
+    std::stable_sort(result.begin(), result.end(),
+        [](const LineProfile &lhs, const LineProfile &rhs) { return lhs.self > rhs.self; });
+    if (limit != 0 && result.size() > limit)
+    {
+        result.resize(limit);
+    }
+    return result;
+}
+
+void write_profile_text(
+    std::ostream &out, const ExecutionProfile &profile, std::string_view source, std::size_t max_lines)
+{
+    const std::ios_base::fmtflags flags{out.flags()};
+    out << std::fixed << std::setprecision(3);
+    out << "Sections:\n";
+    for (int i = +Section::PER_IMAGE; i < +Section::NUM_SECTIONS; ++i)
+    {
+        const Section section{static_cast<Section>(i)};
+        const ProfileCounter &counter{profile.section(section)};
+        if (counter.count == 0)
+        {
+            continue;
+        }
+        out << "  " << std::left << std::setw(12) << section_label(section) << std::right  //
+            << std::setw(12) << counter.count << " calls"                                //
+            << std::setw(14) << microseconds(counter.inclusive) << " us inclusive"       //
+            << std::setw(12) << microseconds(counter.inclusive) / counter.count << " us/call\n";
+    }
+
+    out << "Hottest lines:\n";
+    for (const LineProfile &line : hottest_lines(profile, max_lines))
+    {
+        out << "  line " << std::left << std::setw(5);
+        if (line.line == 0)
+        {
+            out << '?';
+        }
+        else
+        {
+            out << line.line;
+        }
+        out << std::right                                                 //
+            << std::setw(12) << line.count << " runs"                     //
+            << std::setw(14) << microseconds(line.self) << " us self"     //
+            << std::setw(14) << microseconds(line.inclusive) << " us inclusive";
+        if (const std::string_view text{source_line(source, line.line)}; !text.empty())
+        {
+            out << "  | " << text;
+        }
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_profile_json(std::ostream &out, const ExecutionProfile &profile, std::size_t max_lines)
+{
+    const std::ios_base::fmtflags flags{out.flags()};
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"sections\": [";
+    bool first = true;
+    for (int i = +Section::PER_IMAGE; i < +Section::NUM_SECTIONS; ++i)
+    {
+        const Section section{static_cast<Section>(i)};
+        const ProfileCounter &counter{profile.section(section)};
+        if (counter.count == 0)
+        {
+            continue;
+        }
+        out << (first ? "\n" : ",\n") << "    {\"section\": \"" << section_label(section)
+            << "\", \"count\": " << counter.count << ", \"inclusive_us\": " << microseconds(counter.inclusive)
+            << '}';
+        first = false;
+    }
+    out << (first ? "],\n" : "\n  ],\n") << "  \"lines\": [";
+    first = true;
+    for (const LineProfile &line : hottest_lines(profile, max_lines))
+    {
+        out << (first ? "\n" : ",\n") << "    {\"line\": " << line.line << ", \"count\": " << line.count
+            << ", \"self_us\": " << microseconds(line.self) << ", \"inclusive_us\": " << microseconds(line.inclusive)
+            << '}';
+        first = false;
+    }
+    out << (first ? "]\n" : "\n  ]\n") << "}\n";
+    out.flags(flags);
+}
+
+} // namespace formula
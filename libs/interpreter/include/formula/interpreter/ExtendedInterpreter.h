@@ -5,6 +5,8 @@
 #pragma once
 
 #include <formula/interpreter/ExtendedRuntime.h>
+#include <formula/interpreter/Profiler.h>
+#include <formula/core/Cancellation.h>
 #include <formula/core/FileEntry.h>
 #include <formula/facade/Formula.h>
 #include <formula/parser/Parameter.h>
@@ -12,14 +14,21 @@
 #include <formula/semantics/SemanticAnalyzer.h>
 
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace formula
 {
 
+namespace ast
+{
+class FunctionDeclNode;
+} // namespace ast
+
 namespace parser
 {
 class Parser;
@@ -58,6 +67,9 @@ public:
     const std::vector<semantic::FormulaParameterInfo> &parameters() const;
 
     void set_value(std::string_view name, Value value);
+    // Binds the predefined symbol #name to storage, writable when the symbol is, so interpreters bound to the
+    // same storage see each other's writes without copying.  A later set_value of the symbol replaces the binding.
+    void bind_predefined(std::string_view name, std::shared_ptr<Value> storage);
     void set_parameter(std::string_view name, Value value);
     void set_function_parameter(std::string_view name, std::string_view target);
     void set_plugin_parameter(std::string_view name, std::string_view selector);
@@ -66,6 +78,10 @@ public:
     const std::vector<std::string> &messages() const;
 
     Value interpret(Section section);
+    // Sections interpreted after this record counts and timings into profile; nullptr stops profiling.
+    void set_profile(ExecutionProfile *profile);
+    // Sections, and the loops inside them, throw CancelledError once token is cancelled; nullptr stops checking.
+    void set_cancellation(const CancellationToken *token);
 
 private:
     void parse();
@@ -88,7 +104,11 @@ private:
     std::vector<std::pair<std::string, ExtendedInterpreterDiagnostic>> m_binding_diagnostics;
     std::vector<ExtendedInterpreterDiagnostic> m_diagnostics;
     std::vector<semantic::FormulaParameterInfo> m_parameters;
+    // Collected once, rather than on every interpret.
+    std::unordered_map<std::string, const ast::FunctionDeclNode *> m_functions;
     ExtendedRuntimeState m_state;
+    ExecutionProfile *m_profile{};
+    const CancellationToken *m_cancellation{};
 };
 
 struct PreparedParameterFormula
@@ -71,6 +71,8 @@ public:
     bool has_predefined_value(std::string_view name) const;
     Value predefined_value(std::string_view name) const;
     RuntimeLValue predefined_lvalue(std::string_view name);
+    // Binds a predefined symbol to storage owned elsewhere, so several runtimes can share it.
+    void bind_predefined_reference(std::string_view name, RuntimeLValue value);
 
     void add_message(std::string message);
     const std::vector<std::string> &messages() const;
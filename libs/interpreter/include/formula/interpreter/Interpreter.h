@@ -4,13 +4,20 @@
 //
 #pragma once
 
+#include <formula/core/Cancellation.h>
 #include <formula/core/Complex.h>
+#include <formula/core/Random.h>
 
+#include <cstddef>
 #include <map>
 #include <memory>
-#include <random>
 #include <string>
 
+namespace formula
+{
+class ExecutionProfile;
+} // namespace formula
+
 namespace formula::ast
 {
 
@@ -22,6 +29,20 @@ Complex interpret(const std::shared_ptr<Node> &expr, Dictionary &symbols);
 Complex interpret(
     const std::shared_ptr<Node> &expr, Dictionary &symbols, const std::map<std::string, std::string> &functions);
 Complex interpret(const std::shared_ptr<Node> &expr, Dictionary &symbols,
-    const std::map<std::string, std::string> &functions, std::mt19937 *random);
+    const std::map<std::string, std::string> &functions, RandomState *random);
+// Records per-node counts and timings into profile when it is non-null.
+Complex interpret(const std::shared_ptr<Node> &expr, Dictionary &symbols,
+    const std::map<std::string, std::string> &functions, RandomState *random, ExecutionProfile *profile);
+// Every pass of a while or repeat loop throws CancelledError once cancellation is cancelled, and
+// std::runtime_error after MAX_LOOP_ITERATIONS passes.
+Complex interpret(const std::shared_ptr<Node> &expr, Dictionary &symbols,
+    const std::map<std::string, std::string> &functions, RandomState *random, ExecutionProfile *profile,
+    const CancellationToken *cancellation);
+
+constexpr std::size_t MAX_LOOP_ITERATIONS{1000000};
+
+// True when interpret supports every node of expr, so the compiler can hand expr to it.  fn1-fn4 are
+// checked once resolved through functions.
+bool can_interpret(const Node &expr, const std::map<std::string, std::string> &functions);
 
 } // namespace formula::ast
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/interpreter/ExtendedInterpreter.h>
+#include <formula/core/Cancellation.h>
+#include <formula/core/Complex.h>
+#include <formula/core/Value.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace formula
+{
+
+struct LayerPixel
+{
+    bool escaped{};
+    bool solid{};     // #solid after the transforms or the applied coloring's final section
+    int iterations{}; // fractal loop sections run, the #numiter the colorings saw last
+    Complex z{};
+    Value index;      // #index after the applied coloring's final section
+    Value color;      // #color after the applied coloring's final section
+};
+
+// One layer of a prepared parameter set evaluated as a single per-pixel unit: the layer's transforms in order,
+// then the fractal formula with the loop sections of both colorings run inline after each of its iterations,
+// then the final section of the outside coloring for escaped pixels or the inside coloring for the rest.
+// #pixel, #z, #numiter, #maxiter, #solid, #index and #color are bound to storage the pipeline owns, so a value
+// one stage writes is the value the next stage reads; nothing is copied between interpreters per iteration
+// except the fractal's z, which is published to #z once after each of its loop sections.
+class LayerPipeline
+{
+public:
+    // Binds the interpreters of layer in prepared, which must outlive the pipeline.  Throws std::runtime_error
+    // when prepared has diagnostics or the layer has no fractal formula.
+    LayerPipeline(PreparedParameterSet &prepared, std::size_t layer);
+
+    void set_cancellation(const CancellationToken *token);
+    // Runs every stage's global section the first time and whenever max_iterations changes.
+    LayerPixel evaluate(Complex pixel, int max_iterations);
+
+private:
+    struct Storage
+    {
+        std::shared_ptr<Value> pixel{std::make_shared<Value>()};
+        std::shared_ptr<Value> z{std::make_shared<Value>()};
+        std::shared_ptr<Value> numiter{std::make_shared<Value>()};
+        std::shared_ptr<Value> maxiter{std::make_shared<Value>()};
+        std::shared_ptr<Value> solid{std::make_shared<Value>()};
+        std::shared_ptr<Value> index{std::make_shared<Value>()};
+        std::shared_ptr<Value> color{std::make_shared<Value>()};
+    };
+
+    void bind(ExtendedInterpreter &interpreter);
+    void set_max_iterations(int max_iterations);
+    void publish_z();
+
+    Storage m_storage;
+    std::vector<ExtendedInterpreter *> m_transforms;
+    ExtendedInterpreter *m_fractal{};
+    ExtendedInterpreter *m_inside{};
+    ExtendedInterpreter *m_outside{};
+    int m_max_iterations{-1};
+};
+
+} // namespace formula
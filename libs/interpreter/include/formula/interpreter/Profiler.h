@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/core/Node.h>
+#include <formula/facade/Formula.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace formula
+{
+
+struct ProfileCounter
+{
+    std::uint64_t count{};
+    std::chrono::nanoseconds inclusive{};
+    std::chrono::nanoseconds self{};
+};
+
+struct NodeProfile : ProfileCounter
+{
+    const ast::Node *parent{}; // enclosing node on first execution; nullptr for a section root
+};
+
+// Collects execution counts and wall time per formula section and per AST node.
+// Attach one to an interpreter to enable profiling; interpreters without a profile pay nothing.
+class ExecutionProfile
+{
+public:
+    void set_locations(const ast::NodeLocations &locations);
+    void clear();
+
+    void begin_section(Section section);
+    void begin_node(const ast::Node *node);
+    void end(); // closes the innermost open section or node
+
+    const ProfileCounter &section(Section section) const
+    {
+        return m_sections[+section];
+    }
+    const std::unordered_map<const ast::Node *, NodeProfile> &nodes() const
+    {
+        return m_nodes;
+    }
+    const ast::NodeLocations &locations() const
+    {
+        return m_locations;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Frame
+    {
+        const ast::Node *node;
+        ProfileCounter *counter;
+        int *active; // open frames for the node, so recursion doesn't double count inclusive time
+        Clock::time_point start;
+        std::chrono::nanoseconds children{};
+    };
+
+    std::array<ProfileCounter, static_cast<std::size_t>(Section::NUM_SECTIONS)> m_sections{};
+    std::unordered_map<const ast::Node *, NodeProfile> m_nodes;
+    std::unordered_map<const ast::Node *, int> m_active;
+    ast::NodeLocations m_locations;
+    std::vector<Frame> m_frames;
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(ExecutionProfile *profile, const ast::Node *node) :
+        m_profile(profile)
+    {
+        if (m_profile)
+        {
+            m_profile->begin_node(node);
+        }
+    }
+    ProfileScope(ExecutionProfile *profile, Section section) :
+        m_profile(profile)
+    {
+        if (m_profile)
+        {
+            m_profile->begin_section(section);
+        }
+    }
+    ProfileScope(const ProfileScope &rhs) = delete;
+    ProfileScope(ProfileScope &&rhs) = delete;
+    ~ProfileScope()
+    {
+        if (m_profile)
+        {
+            m_profile->end();
+        }
+    }
+    ProfileScope &operator=(const ProfileScope &rhs) = delete;
+    ProfileScope &operator=(ProfileScope &&rhs) = delete;
+
+private:
+    ExecutionProfile *m_profile;
+};
+
+struct LineProfile
+{
+    std::size_t line{}; // 0 when no node on the path has a recorded location
+    std::uint64_t count{};
+    std::chrono::nanoseconds inclusive{};
+    std::chrono::nanoseconds self{};
+};
+
+// Lines ordered by self time, hottest first; at most limit entries when limit is non-zero.
+std::vector<LineProfile> hottest_lines(const ExecutionProfile &profile, std::size_t limit = 0);
+
+void write_profile_text(
+    std::ostream &out, const ExecutionProfile &profile, std::string_view source = {}, std::size_t max_lines = 10);
+void write_profile_json(std::ostream &out, const ExecutionProfile &profile, std::size_t max_lines = 10);
+
+} // namespace formula
@@ -5,6 +5,7 @@
 #include <formula/parser/FormulaEntry.h>
 
 #include <formula/core/FileEntry.h>
+#include <formula/core/Trace.h>
 #include <formula/parser/ParseOptions.h>
 #include <formula/parser/Parser.h>
 #include <formula/parser/Preprocessor.h>
@@ -335,6 +336,7 @@ static void load_formula_file_tree(std::string_view filename, const FormulaFileI
 
 FormulaFileSet load_formula_file_tree(std::string_view root_filename, const FormulaFileImporter &importer)
 {
+    const trace::Scope scope{"load_formula_file_tree", "parser"};
     FormulaFileSet result;
     if (!importer)
     {
@@ -6,6 +6,7 @@
 
 #include <formula/parser/Lexer.h>
 #include <formula/core/NodeTyper.h>
+#include <formula/core/Trace.h>
 #include <formula/parser/ParseOptions.h>
 
 #include <algorithm>
@@ -189,6 +190,7 @@ public:
     }
 
 private:
+    FormulaSectionsPtr parse_formula();
     bool builtin_section();
     std::optional<double> signed_literal();
     Expr default_integer_setting(const std::string &name);
@@ -227,6 +229,7 @@ private:
     std::string type_name();
     std::vector<Expr> argument_list();
     Expr expression();
+    Expr located(Expr node, const SourceLocation &location);
     bool consume_import_statement();
     void consume_imports();
     Expr declaration_statement();
@@ -1766,10 +1769,27 @@ void FormulaParser::split_iterate_bailout(const Expr &expr)
         m_ast->iterate = std::make_shared<StatementSeqNode>(std::vector<Expr>{});
         m_ast->bailout = expr;
     }
+    // The synthesized loop sequence reports on the line where the statements began.
+    if (const auto it = m_ast->locations.find(expr.get()); it != m_ast->locations.end())
+    {
+        m_ast->locations.insert_or_assign(m_ast->iterate.get(), it->second);
+    }
 }
 
 // If parsing failed, return nullptr instead of partially constructed AST
 FormulaSectionsPtr FormulaParser::parse()
+{
+    const trace::Scope scope{"FormulaParser::parse", "parser"};
+    FormulaSectionsPtr result{parse_formula()};
+    if (result)
+    {
+        // Backtracking and rewrites discard nodes whose locations were already recorded.
+        retain_live_locations(*result);
+    }
+    return result;
+}
+
+FormulaSectionsPtr FormulaParser::parse_formula()
 {
     advance();
 
@@ -2142,6 +2162,16 @@ Expr FormulaParser::expression()
     return conjunctive();
 }
 
+// Records where a node starts so runtime tools like the profiler can map nodes back to source lines.
+Expr FormulaParser::located(Expr node, const SourceLocation &location)
+{
+    if (node && m_options.record_locations)
+    {
+        m_ast->locations.insert_or_assign(node.get(), location);
+    }
+    return node;
+}
+
 bool FormulaParser::consume_import_statement()
 {
     if (!check_context("import"))
@@ -2366,6 +2396,7 @@ Expr FormulaParser::sequence()
     }
 
     // Parse the first statement
+    const SourceLocation start{m_curr.location};
     Expr first = statement();
     if (!first)
     {
@@ -2404,7 +2435,7 @@ Expr FormulaParser::sequence()
 
     // Multiple newline-separated statements - return as a special StatementSeqNode
     // that will be split into iterate + bailout
-    return std::make_shared<StatementSeqNode>(std::move(seq));
+    return located(std::make_shared<StatementSeqNode>(std::move(seq)), start);
 }
 
 bool FormulaParser::is_builtin_var() const
@@ -2419,14 +2450,15 @@ bool FormulaParser::is_builtin_fn() const
 
 Expr FormulaParser::statement()
 {
+    const SourceLocation start{m_curr.location};
     if (is_extended() && check_context("static"))
     {
         advance();
-        return function_declaration(true);
+        return located(function_declaration(true), start);
     }
     if (is_extended() && check(TokenType::FUNC))
     {
-        return function_declaration();
+        return located(function_declaration(), start);
     }
     if (is_extended() && is_type_start())
     {
@@ -2438,24 +2470,24 @@ Expr FormulaParser::statement()
         m_curr = curr;
         if (typed_function)
         {
-            return function_declaration();
+            return located(function_declaration(), start);
         }
     }
     if (check(TokenType::IF))
     {
-        return if_statement();
+        return located(if_statement(), start);
     }
     if (is_extended() && check(TokenType::WHILE))
     {
-        return while_statement();
+        return located(while_statement(), start);
     }
     if (is_extended() && check(TokenType::REPEAT))
     {
-        return repeat_statement();
+        return located(repeat_statement(), start);
     }
     if (is_extended() && check_context("return"))
     {
-        return return_statement();
+        return located(return_statement(), start);
     }
     if (is_extended() && is_type_start())
     {
@@ -2473,10 +2505,10 @@ Expr FormulaParser::statement()
         m_curr = curr;
         if (declaration || type == "bool" || type == "int" || type == "float" || type == "complex" || type == "color")
         {
-            return declaration_statement();
+            return located(declaration_statement(), start);
         }
     }
-    return assignment_statement();
+    return located(assignment_statement(), start);
 }
 
 Expr FormulaParser::if_statement()
@@ -2651,6 +2683,7 @@ Expr FormulaParser::assignment_statement()
 
 Expr FormulaParser::conjunctive()
 {
+    const SourceLocation start{m_curr.location};
     Expr left = comparative();
 
     // Handle logical operators: && and ||
@@ -2666,7 +2699,7 @@ Expr FormulaParser::conjunctive()
             return nullptr;
         }
 
-        left = std::make_shared<BinaryOpNode>(left, op, right);
+        left = located(std::make_shared<BinaryOpNode>(left, op, right), start);
     }
 
     return left;
@@ -2675,6 +2708,7 @@ Expr FormulaParser::conjunctive()
 // Handle relational operators: <, <=, >, >=, ==, !=
 Expr FormulaParser::comparative()
 {
+    const SourceLocation start{m_curr.location};
     Expr left = additive();
 
     while (left &&
@@ -2711,7 +2745,7 @@ Expr FormulaParser::comparative()
         advance();
         if (Expr right = additive())
         {
-            left = std::make_shared<BinaryOpNode>(left, op, right);
+            left = located(std::make_shared<BinaryOpNode>(left, op, right), start);
             continue;
         }
 
@@ -2724,6 +2758,7 @@ Expr FormulaParser::comparative()
 
 Expr FormulaParser::additive()
 {
+    const SourceLocation start{m_curr.location};
     Expr left = term();
 
     while (left && check({TokenType::PLUS, TokenType::MINUS}))
@@ -2736,7 +2771,7 @@ Expr FormulaParser::additive()
             // term already recorded the error
             return nullptr;
         }
-        left = std::make_shared<BinaryOpNode>(left, op, right);
+        left = located(std::make_shared<BinaryOpNode>(left, op, right), start);
     }
 
     return left;
@@ -2744,6 +2779,7 @@ Expr FormulaParser::additive()
 
 Expr FormulaParser::term()
 {
+    const SourceLocation start{m_curr.location};
     Expr left = unary();
 
     while (left && check({TokenType::MULTIPLY, TokenType::DIVIDE, TokenType::PERCENT}))
@@ -2756,7 +2792,7 @@ Expr FormulaParser::term()
             // unary already recorded the error
             return nullptr;
         }
-        left = std::make_shared<BinaryOpNode>(left, op, right);
+        left = located(std::make_shared<BinaryOpNode>(left, op, right), start);
     }
 
     return left;
@@ -2764,6 +2800,7 @@ Expr FormulaParser::term()
 
 Expr FormulaParser::unary()
 {
+    const SourceLocation start{m_curr.location};
     if (check({TokenType::PLUS, TokenType::MINUS, TokenType::NOT}))
     {
         char op = check(TokenType::PLUS) ? '+' : (check(TokenType::MINUS) ? '-' : '!');
@@ -2774,7 +2811,7 @@ Expr FormulaParser::unary()
             // unary already recorded the error
             return nullptr;
         }
-        return std::make_shared<UnaryOpNode>(op, operand);
+        return located(std::make_shared<UnaryOpNode>(op, operand), start);
     }
 
     return power();
@@ -2782,6 +2819,7 @@ Expr FormulaParser::unary()
 
 Expr FormulaParser::power()
 {
+    const SourceLocation start{m_curr.location};
     Expr left = postfix();
 
     // Left-associative: parse from left to right using a loop
@@ -2794,7 +2832,7 @@ Expr FormulaParser::power()
             // primary already recorded the error
             return nullptr;
         }
-        left = std::make_shared<BinaryOpNode>(left, '^', right);
+        left = located(std::make_shared<BinaryOpNode>(left, '^', right), start);
     }
 
     return left;
@@ -2802,7 +2840,8 @@ Expr FormulaParser::power()
 
 Expr FormulaParser::postfix()
 {
-    Expr left = primary();
+    const SourceLocation start{m_curr.location};
+    Expr left = located(primary(), start);
     while (left)
     {
         if (check(TokenType::OPEN_PAREN))
@@ -2820,17 +2859,18 @@ Expr FormulaParser::postfix()
             }
             if (const auto *id = dynamic_cast<const IdentifierNode *>(left.get()); id)
             {
-                left = std::make_shared<FunctionCallNode>(id->name(), std::move(args));
+                left = located(std::make_shared<FunctionCallNode>(id->name(), std::move(args)), start);
                 continue;
             }
             if (const auto *parameter = dynamic_cast<const ParameterRefNode *>(left.get()); parameter)
             {
-                left = std::make_shared<FunctionCallNode>('@' + parameter->name(), std::move(args));
+                left = located(std::make_shared<FunctionCallNode>('@' + parameter->name(), std::move(args)), start);
                 continue;
             }
             if (const auto *member = dynamic_cast<const MemberAccessNode *>(left.get()); member)
             {
-                left = std::make_shared<FunctionCallNode>(member->target(), member->member(), std::move(args));
+                left = located(
+                    std::make_shared<FunctionCallNode>(member->target(), member->member(), std::move(args)), start);
                 continue;
             }
             error(ErrorCode::EXPECTED_IDENTIFIER);
@@ -2856,7 +2896,7 @@ Expr FormulaParser::postfix()
                 error(ErrorCode::EXPECTED_CLOSE_PAREN);
                 return nullptr;
             }
-            left = std::make_shared<IndexNode>(left, std::move(indices));
+            left = located(std::make_shared<IndexNode>(left, std::move(indices)), start);
             continue;
         }
         if (match(TokenType::DOT))
@@ -2868,7 +2908,7 @@ Expr FormulaParser::postfix()
             }
             const std::string member{str()};
             advance();
-            left = std::make_shared<MemberAccessNode>(left, member);
+            left = located(std::make_shared<MemberAccessNode>(left, member), start);
             continue;
         }
         break;
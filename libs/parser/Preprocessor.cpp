@@ -4,6 +4,8 @@
 //
 #include <formula/parser/Preprocessor.h>
 
+#include <formula/core/Trace.h>
+
 #include <algorithm>
 #include <cctype>
 #include <string>
@@ -219,6 +221,7 @@ Preprocessor::Preprocessor(UltraFractalMacros predefined, std::string source_fil
 
 std::string Preprocessor::process(std::string_view input)
 {
+    const trace::Scope scope{"Preprocessor::process", "parser"};
     m_macros = m_predefined;
     m_errors.clear();
     std::string output;
@@ -28,6 +28,8 @@ struct Options
     EntryKind entry_kind{EntryKind::FRACTAL};
     std::function<std::optional<std::string>(std::string_view)> file_importer;
     std::string source_filename;
+    // Fill FormulaSections::locations so an ExecutionProfile can report source lines.
+    bool record_locations{};
 };
 
 } // namespace formula::parser
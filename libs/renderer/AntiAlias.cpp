@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/AntiAlias.h>
+
+#include <formula/core/Random.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace formula::renderer
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Jitter streams are the pixel index with the top bit set, apart from the streams rand uses.
+constexpr std::uint64_t JITTER_STREAM{1ULL << 63};
+
+bool differs(const PixelResult &lhs, Color lhs_color, const PixelResult &rhs, Color rhs_color,
+    const AntiAliasOptions &options)
+{
+    if (lhs.escaped != rhs.escaped)
+    {
+        return true;
+    }
+    if (std::abs(lhs.iterations - rhs.iterations) > options.iteration_threshold)
+    {
+        return true;
+    }
+    const int channel{std::max({std::abs(lhs_color.red - rhs_color.red),
+        std::abs(lhs_color.green - rhs_color.green), std::abs(lhs_color.blue - rhs_color.blue)})};
+    return channel > options.color_threshold;
+}
+
+Color pixel_color(const Coloring &coloring, const PixelResult &pixel)
+{
+    return color_of(coloring, pixel.escaped, coloring.smooth ? smooth_iterations(pixel) : pixel.iterations);
+}
+
+std::uint64_t executed_iterations(const PixelResult &pixel)
+{
+    return static_cast<std::uint64_t>(pixel.iterations) + (pixel.escaped ? 1U : 0U);
+}
+
+} // namespace
+
+std::vector<bool> refined_pixels(const RenderResult &result, const Image &image, const AntiAliasOptions &options)
+{
+    std::vector<bool> refined(result.pixels.size());
+    for (int y = 0; y < result.height; ++y)
+    {
+        for (int x = 0; x < result.width; ++x)
+        {
+            const PixelResult &pixel{result.at(x, y)};
+            const Color color{image.at(x, y)};
+            // Each pair of neighbors is compared once and marks both pixels.
+            const int neighbors[][2]{{x + 1, y}, {x - 1, y + 1}, {x, y + 1}, {x + 1, y + 1}};
+            for (const auto &[nx, ny] : neighbors)
+            {
+                if (nx < 0 || nx >= result.width || ny >= result.height ||
+                    !differs(pixel, color, result.at(nx, ny), image.at(nx, ny), options))
+                {
+                    continue;
+                }
+                refined[static_cast<std::size_t>(y) * result.width + x] = true;
+                refined[static_cast<std::size_t>(ny) * result.width + nx] = true;
+            }
+        }
+    }
+    return refined;
+}
+
+AntiAliasResult render_antialiased(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const Coloring &coloring, const AntiAliasOptions &antialias)
+{
+    if (coloring.palette.empty())
+    {
+        throw std::runtime_error("Empty palette");
+    }
+    const Viewport &viewport{options.viewport};
+    RenderResult first;
+    first.width = viewport.pixel_width;
+    first.height = viewport.pixel_height;
+    first.pixels.resize(static_cast<std::size_t>(first.width) * first.height);
+
+    RegionRenderer renderer{formula, backend, options};
+    AntiAliasResult result;
+    result.stats.threads = renderer.threads();
+    result.stats.setup = renderer.setup();
+    const Clock::time_point start{Clock::now()};
+    result.stats.iterations = renderer.render(0, 0, first.width, first.height, first.pixels.data());
+    result.stats.pixels = first.pixels.size();
+    result.image = colorize(first, coloring);
+
+    const std::vector<bool> refine{refined_pixels(first, result.image, antialias)};
+    std::vector<int> targets;
+    for (std::size_t i = 0; i < refine.size(); ++i)
+    {
+        if (refine[i])
+        {
+            targets.push_back(static_cast<int>(i));
+        }
+    }
+    const int samples{std::max(1, antialias.samples)};
+    const std::uint32_t seed{formula.random_seed};
+    result.stats.iterations += renderer.run(static_cast<int>(targets.size()),
+        [&](PixelEvaluator &evaluator, int target)
+        {
+            const int index{targets[target]};
+            const int x{index % first.width};
+            const int y{index / first.width};
+            std::uint64_t iterations{};
+            int red{};
+            int green{};
+            int blue{};
+            for (int sample = 0; sample < samples * samples; ++sample)
+            {
+                const Complex jitter{random_complex(seed, JITTER_STREAM | static_cast<std::uint64_t>(index),
+                    static_cast<std::uint32_t>(sample))};
+                const double sample_x{x + (sample % samples + jitter.re) / samples};
+                const double sample_y{y + (sample / samples + jitter.im) / samples};
+                // Every sample sees the pixel's rand sequence, as in the first pass.
+                evaluator.set_random_stream(static_cast<std::uint64_t>(index));
+                const PixelResult pixel{
+                    evaluator.evaluate(pixel_location(viewport, sample_x, sample_y), options.max_iterations)};
+                iterations += executed_iterations(pixel);
+                const Color color{pixel_color(coloring, pixel)};
+                red += color.red;
+                green += color.green;
+                blue += color.blue;
+            }
+            const int count{samples * samples};
+            result.image.pixels[index] = {static_cast<std::uint8_t>((red + count / 2) / count),
+                static_cast<std::uint8_t>((green + count / 2) / count),
+                static_cast<std::uint8_t>((blue + count / 2) / count)};
+            return iterations;
+        });
+    result.refined = targets.size();
+    result.stats.pixels += result.refined;
+    result.stats.elapsed = Clock::now() - start;
+    return result;
+}
+
+} // namespace formula::renderer
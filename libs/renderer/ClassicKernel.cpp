@@ -0,0 +1,309 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/ClassicKernel.h>
+
+#include <formula/facade/Formula.h>
+#include <formula/parser/ParseOptions.h>
+
+#include <array>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace formula::renderer
+{
+
+namespace
+{
+
+// Pixels iterated side by side.  The step of every lane is computed in one loop the compiler can
+// vectorize; escape and period checks then run per lane.
+constexpr std::size_t LANES{4};
+
+// An orbit point closer than this, squared, to the saved point is taken as the start of a cycle.
+constexpr double PERIOD_TOLERANCE{1e-28};
+
+// v = v^2 + c, in the same order of operations as Complex, so results match the formula backends.
+struct SquareStep
+{
+    void operator()(double &re, double &im, double c_re, double c_im) const
+    {
+        const double next_re{re * re - im * im + c_re};
+        im = re * im + im * re + c_im;
+        re = next_re;
+    }
+};
+
+// v = abs(v)^2 + c, abs taking the absolute value of each part.
+struct BurningShipStep
+{
+    void operator()(double &re, double &im, double c_re, double c_im) const
+    {
+        const double x{std::abs(re)};
+        const double y{std::abs(im)};
+        re = x * x - y * y + c_re;
+        im = x * y + y * x + c_im;
+    }
+};
+
+// v = (v*v)*v + c.
+struct CubeStep
+{
+    void operator()(double &re, double &im, double c_re, double c_im) const
+    {
+        const double square_re{re * re - im * im};
+        const double square_im{re * im + im * re};
+        const double next_re{square_re * re - square_im * im + c_re};
+        im = square_re * im + square_im * re + c_im;
+        re = next_re;
+    }
+};
+
+// The main cardioid and the period-2 bulb hold most of the Mandelbrot set's area.
+bool in_cardioid_or_bulb(Complex c)
+{
+    const double shifted{c.re - 0.25};
+    const double q{shifted * shifted + c.im * c.im};
+    if (q * (q + shifted) <= 0.25 * c.im * c.im)
+    {
+        return true;
+    }
+    const double bulb{c.re + 1.0};
+    return bulb * bulb + c.im * c.im <= 0.0625;
+}
+
+template <typename Step>
+class ClassicEvaluator : public PixelEvaluator
+{
+public:
+    explicit ClassicEvaluator(const semantic::ClassicFormula &formula);
+    ~ClassicEvaluator() override = default;
+
+    void set_random_stream(std::uint64_t) override
+    {
+        // The classic formulas don't use rand.
+    }
+    void set_cancellation(const CancellationToken *token) override
+    {
+        m_cancellation = token;
+    }
+    PixelResult evaluate(Complex pixel, int max_iterations) override
+    {
+        PixelResult result;
+        evaluate_batch(&pixel, nullptr, &result, 1, max_iterations);
+        return result;
+    }
+    void evaluate_batch(const Complex *pixels, const std::uint64_t *streams, PixelResult *results,
+        std::size_t count, int max_iterations) override;
+    PixelResult evaluate_orbit(Complex pixel, int max_iterations, std::vector<Complex> &orbit) override;
+
+private:
+    bool escaped(double re, double im) const
+    {
+        const double modulus{re * re + im * im};
+        return m_inclusive ? !(modulus <= m_bailout) : !(modulus < m_bailout);
+    }
+
+    Step m_step;
+    bool m_start_at_pixel;
+    Complex m_start;
+    bool m_add_pixel;
+    Complex m_constant;
+    double m_bailout;
+    bool m_inclusive;
+    bool m_check_cardioid;
+    const CancellationToken *m_cancellation{};
+};
+
+template <typename Step>
+ClassicEvaluator<Step>::ClassicEvaluator(const semantic::ClassicFormula &formula) :
+    m_start_at_pixel(formula.start_at_pixel),
+    m_start(formula.start),
+    m_add_pixel(formula.kind != semantic::ClassicKind::JULIA),
+    m_constant(formula.constant),
+    m_bailout(formula.bailout),
+    m_inclusive(formula.inclusive),
+    // Orbits of points in the set stay within |v| <= 4, and starting at 0 or pixel gives the same orbit.
+    m_check_cardioid(formula.kind == semantic::ClassicKind::MANDELBROT && formula.bailout >= 4.0 &&
+        (formula.start_at_pixel || (formula.start.re == 0.0 && formula.start.im == 0.0)))
+{
+}
+
+template <typename Step>
+void ClassicEvaluator<Step>::evaluate_batch(const Complex *pixels, const std::uint64_t *, PixelResult *results,
+    std::size_t count, int max_iterations)
+{
+    if (m_cancellation != nullptr)
+    {
+        m_cancellation->throw_if_cancelled();
+    }
+    std::array<double, LANES> re{};
+    std::array<double, LANES> im{};
+    std::array<double, LANES> c_re{};
+    std::array<double, LANES> c_im{};
+    std::array<double, LANES> saved_re{};
+    std::array<double, LANES> saved_im{};
+    std::array<int, LANES> iterations{};
+    std::array<int, LANES> next_save{};
+    std::array<std::size_t, LANES> pixel{};
+    std::array<bool, LANES> active{};
+    std::size_t next{};
+    std::size_t busy{};
+
+    // Gives lane the next pixel that needs iterating, or leaves it idle with zeros that can't overflow.
+    const auto fill = [&](std::size_t lane)
+    {
+        while (next < count)
+        {
+            const std::size_t index{next++};
+            const Complex c{pixels[index]};
+            const Complex start{m_start_at_pixel ? c : m_start};
+            if (max_iterations <= 0 || (m_check_cardioid && in_cardioid_or_bulb(c)))
+            {
+                results[index] = {max_iterations, start, false};
+                continue;
+            }
+            const Complex addend{m_add_pixel ? c : m_constant};
+            re[lane] = start.re;
+            im[lane] = start.im;
+            c_re[lane] = addend.re;
+            c_im[lane] = addend.im;
+            saved_re[lane] = start.re;
+            saved_im[lane] = start.im;
+            iterations[lane] = 0;
+            next_save[lane] = 1;
+            pixel[lane] = index;
+            if (!active[lane])
+            {
+                active[lane] = true;
+                ++busy;
+            }
+            return;
+        }
+        if (active[lane])
+        {
+            active[lane] = false;
+            --busy;
+        }
+        re[lane] = 0.0;
+        im[lane] = 0.0;
+        c_re[lane] = 0.0;
+        c_im[lane] = 0.0;
+    };
+    for (std::size_t lane = 0; lane < LANES; ++lane)
+    {
+        fill(lane);
+    }
+
+    while (busy > 0)
+    {
+        for (std::size_t lane = 0; lane < LANES; ++lane)
+        {
+            m_step(re[lane], im[lane], c_re[lane], c_im[lane]);
+        }
+        for (std::size_t lane = 0; lane < LANES; ++lane)
+        {
+            if (!active[lane])
+            {
+                continue;
+            }
+            // iterations counts the steps that passed the bailout test, like the formula backends.
+            const Complex z{re[lane], im[lane]};
+            if (escaped(z.re, z.im))
+            {
+                results[pixel[lane]] = {iterations[lane], z, true};
+                fill(lane);
+                continue;
+            }
+            if (++iterations[lane] == max_iterations)
+            {
+                results[pixel[lane]] = {max_iterations, z, false};
+                fill(lane);
+                continue;
+            }
+            // Brent's cycle detection: compare with the point saved at the last power of two.
+            const double d_re{z.re - saved_re[lane]};
+            const double d_im{z.im - saved_im[lane]};
+            if (d_re * d_re + d_im * d_im < PERIOD_TOLERANCE)
+            {
+                results[pixel[lane]] = {max_iterations, z, false};
+                fill(lane);
+                continue;
+            }
+            if (iterations[lane] == next_save[lane])
+            {
+                saved_re[lane] = z.re;
+                saved_im[lane] = z.im;
+                next_save[lane] *= 2;
+            }
+        }
+    }
+}
+
+// One orbit at a time, without cycle detection: callers tracing orbits want every point of the orbits that
+// escape, and the cardioid check already skips most of those that don't.
+template <typename Step>
+PixelResult ClassicEvaluator<Step>::evaluate_orbit(Complex pixel, int max_iterations, std::vector<Complex> &orbit)
+{
+    orbit.clear();
+    if (m_cancellation != nullptr)
+    {
+        m_cancellation->throw_if_cancelled();
+    }
+    const Complex start{m_start_at_pixel ? pixel : m_start};
+    if (max_iterations <= 0 || (m_check_cardioid && in_cardioid_or_bulb(pixel)))
+    {
+        return {max_iterations, start, false};
+    }
+    const Complex addend{m_add_pixel ? pixel : m_constant};
+    double re{start.re};
+    double im{start.im};
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        m_step(re, im, addend.re, addend.im);
+        orbit.push_back({re, im});
+        if (escaped(re, im))
+        {
+            return {iteration, orbit.back(), true};
+        }
+    }
+    return {max_iterations, orbit.back(), false};
+}
+
+} // namespace
+
+std::optional<semantic::ClassicFormula> recognize_classic_formula(const RenderFormula &formula)
+{
+    if (formula.derivative || formula.dialect != Dialect::BASIC)
+    {
+        return std::nullopt;
+    }
+    parser::Options options;
+    options.dialect = formula.dialect;
+    const LoadedFormula loaded{load_formula(formula.body, options)};
+    if (!loaded.ast)
+    {
+        return std::nullopt;
+    }
+    return semantic::recognize_classic_formula(*loaded.ast, formula.values, formula.functions);
+}
+
+PixelEvaluatorPtr create_classic_evaluator(const semantic::ClassicFormula &formula)
+{
+    switch (formula.kind)
+    {
+    case semantic::ClassicKind::MANDELBROT:
+    case semantic::ClassicKind::JULIA:
+        return std::make_unique<ClassicEvaluator<SquareStep>>(formula);
+    case semantic::ClassicKind::BURNING_SHIP:
+        return std::make_unique<ClassicEvaluator<BurningShipStep>>(formula);
+    case semantic::ClassicKind::MANDEL3:
+        return std::make_unique<ClassicEvaluator<CubeStep>>(formula);
+    }
+    throw std::runtime_error("Unknown classic formula");
+}
+
+} // namespace formula::renderer
@@ -0,0 +1,450 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/Image.h>
+
+#include <formula/core/Trace.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace formula::renderer
+{
+
+namespace
+{
+
+struct PaletteStop
+{
+    int index;
+    Color color;
+};
+
+constexpr int GRADIENT_POSITIONS{400};
+
+std::uint8_t blend(std::uint8_t from, std::uint8_t to, int step, int steps)
+{
+    return static_cast<std::uint8_t>(from + (to - from) * step / steps);
+}
+
+std::uint8_t mix(std::uint8_t from, std::uint8_t to, double fraction)
+{
+    return static_cast<std::uint8_t>(std::lround(from + (to - from) * fraction));
+}
+
+Color mix(const Color &from, const Color &to, double fraction)
+{
+    return {mix(from.red, to.red, fraction), mix(from.green, to.green, fraction), mix(from.blue, to.blue, fraction)};
+}
+
+Color to_color(const gradient::RGBColor &color)
+{
+    return {color.red, color.green, color.blue};
+}
+
+int wrap(int index, int size)
+{
+    const int result{index % size};
+    return result < 0 ? result + size : result;
+}
+
+void put_u32(std::string &bytes, std::uint32_t value)
+{
+    bytes += static_cast<char>(value >> 24);
+    bytes += static_cast<char>(value >> 16);
+    bytes += static_cast<char>(value >> 8);
+    bytes += static_cast<char>(value);
+}
+
+// A chunk is its length, type, data and the CRC of type and data.
+void write_chunk(std::ostream &out, const char (&type)[5], const std::string &data)
+{
+    std::string chunk;
+    put_u32(chunk, static_cast<std::uint32_t>(data.size()));
+    chunk.append(type, 4);
+    chunk += data;
+    const auto *crc_begin{reinterpret_cast<const Bytef *>(chunk.data() + 4)};
+    put_u32(chunk, static_cast<std::uint32_t>(crc32(0L, crc_begin, static_cast<uInt>(data.size() + 4))));
+    out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+}
+
+std::string to_lower(std::string_view text)
+{
+    std::string result{text};
+    std::transform(result.begin(), result.end(), result.begin(),
+        [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+    return result;
+}
+
+// The equalization of a possibly fractional iteration count, clamped to the table.
+double equalized(const std::vector<double> &table, double value)
+{
+    if (!(value > 0.0))
+    {
+        return table.front();
+    }
+    const double last{static_cast<double>(table.size() - 1)};
+    if (value >= last)
+    {
+        return table.back();
+    }
+    const double floor{std::floor(value)};
+    const auto count{static_cast<std::size_t>(floor)};
+    return table[count] + (value - floor) * (table[count + 1] - table[count]);
+}
+
+} // namespace
+
+Palette default_palette()
+{
+    static const std::array<PaletteStop, 5> stops{{
+        {0, {0, 7, 100}},
+        {64, {32, 107, 203}},
+        {128, {237, 255, 255}},
+        {192, {255, 170, 0}},
+        {256, {0, 2, 0}},
+    }};
+    Palette result;
+    result.reserve(256);
+    for (std::size_t i = 0; i + 1 < stops.size(); ++i)
+    {
+        const PaletteStop &from{stops[i]};
+        const PaletteStop &to{stops[i + 1]};
+        const int steps{to.index - from.index};
+        for (int step = 0; step < steps; ++step)
+        {
+            result.push_back({blend(from.color.red, to.color.red, step, steps),
+                blend(from.color.green, to.color.green, step, steps),
+                blend(from.color.blue, to.color.blue, step, steps)});
+        }
+    }
+    return result;
+}
+
+Palette gradient_palette(const gradient::GradientSection &gradient, int size)
+{
+    if (gradient.points.empty())
+    {
+        throw std::runtime_error("Gradient " + gradient.title + " has no control points");
+    }
+    std::vector<gradient::ColorControlPoint> points{gradient.points};
+    for (gradient::ColorControlPoint &point : points)
+    {
+        point.index = wrap(point.index + gradient.rotation, GRADIENT_POSITIONS);
+    }
+    std::stable_sort(points.begin(), points.end(),
+        [](const gradient::ColorControlPoint &lhs, const gradient::ColorControlPoint &rhs)
+        { return lhs.index < rhs.index; });
+
+    Palette result;
+    result.reserve(static_cast<std::size_t>(size));
+    for (int i = 0; i < size; ++i)
+    {
+        const double position{static_cast<double>(i) * GRADIENT_POSITIONS / size};
+        // The control points before and after position, wrapping around the ends of the gradient.
+        auto after{std::upper_bound(points.begin(), points.end(), position,
+            [](double value, const gradient::ColorControlPoint &point) { return value < point.index; })};
+        const gradient::ColorControlPoint &next{after == points.end() ? points.front() : *after};
+        const gradient::ColorControlPoint &previous{after == points.begin() ? points.back() : *(after - 1)};
+        const int start{previous.index > position ? previous.index - GRADIENT_POSITIONS : previous.index};
+        const int end{next.index <= position ? next.index + GRADIENT_POSITIONS : next.index};
+        const Color from{to_color(previous.color)};
+        result.push_back(end > start ? mix(from, to_color(next.color), (position - start) / (end - start)) : from);
+    }
+    return result;
+}
+
+double smooth_iterations(const PixelResult &pixel)
+{
+    const double magnitude{std::hypot(pixel.z.re, pixel.z.im)};
+    if (!pixel.escaped || !(magnitude > 1.0) || std::isinf(magnitude))
+    {
+        return pixel.iterations;
+    }
+    return pixel.iterations + 1.0 - std::log2(std::log(magnitude));
+}
+
+double distance_estimate(const PixelResult &pixel)
+{
+    const double magnitude{std::hypot(pixel.z.re, pixel.z.im)};
+    if (!pixel.escaped || !(magnitude > 1.0))
+    {
+        return 0.0;
+    }
+    return magnitude * std::log(magnitude) / std::hypot(pixel.dz.re, pixel.dz.im);
+}
+
+std::vector<double> cumulative_distribution(const IterationHistogram &histogram)
+{
+    const std::uint64_t total{histogram.total()};
+    if (total == 0)
+    {
+        return {};
+    }
+    std::vector<double> result;
+    result.reserve(histogram.counts.size() + 1);
+    std::uint64_t below{};
+    result.push_back(0.0);
+    for (const std::uint64_t count : histogram.counts)
+    {
+        below += count;
+        result.push_back(static_cast<double>(below) / static_cast<double>(total));
+    }
+    return result;
+}
+
+Color color_of(const Coloring &coloring, bool escaped, double value)
+{
+    if (!escaped)
+    {
+        return coloring.inside;
+    }
+    const Palette &palette{coloring.palette};
+    const int size{static_cast<int>(palette.size())};
+    if (!coloring.equalization.empty())
+    {
+        value = equalized(coloring.equalization, value) * size;
+    }
+    const double index{value * coloring.density + coloring.offset};
+    if (!std::isfinite(index))
+    {
+        return palette.front();
+    }
+    const double floor{std::floor(index)};
+    const int first{wrap(static_cast<int>(std::fmod(floor, size)), size)};
+    if (!coloring.smooth)
+    {
+        return palette[first];
+    }
+    return mix(palette[first], palette[wrap(first + 1, size)], index - floor);
+}
+
+Image colorize(const RenderResult &result, const Palette &palette, Color inside)
+{
+    Coloring coloring;
+    coloring.palette = palette;
+    coloring.inside = inside;
+    return colorize(result, coloring);
+}
+
+Image colorize(const RenderResult &result, const Coloring &coloring)
+{
+    const trace::Scope scope{"colorize", "renderer"};
+    if (coloring.palette.empty())
+    {
+        throw std::runtime_error("Empty palette");
+    }
+    Image image;
+    image.width = result.width;
+    image.height = result.height;
+    image.pixels.reserve(result.pixels.size());
+    for (const PixelResult &pixel : result.pixels)
+    {
+        const double value{coloring.smooth ? smooth_iterations(pixel) : pixel.iterations};
+        image.pixels.push_back(color_of(coloring, pixel.escaped, value));
+    }
+    return image;
+}
+
+std::optional<ImageFormat> image_format(std::string_view filename)
+{
+    const std::size_t dot{filename.rfind('.')};
+    if (dot == std::string_view::npos)
+    {
+        return {};
+    }
+    const std::string extension{to_lower(filename.substr(dot + 1))};
+    if (extension == "png")
+    {
+        return ImageFormat::PNG;
+    }
+    if (extension == "ppm")
+    {
+        return ImageFormat::PPM;
+    }
+    return {};
+}
+
+struct ImageStreamWriter::Deflate
+{
+    z_stream stream{};
+    std::string output;
+};
+
+ImageStreamWriter::ImageStreamWriter(std::ostream &out, ImageFormat format, int width, int height) :
+    m_out(out),
+    m_format(format),
+    m_width(width),
+    m_height(height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        throw std::runtime_error("Can't write an empty image");
+    }
+    if (format == ImageFormat::PPM)
+    {
+        m_out << "P6\n" << width << ' ' << height << "\n255\n";
+        return;
+    }
+
+    m_deflate = std::make_unique<Deflate>();
+    if (deflateInit(&m_deflate->stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        throw std::runtime_error("Couldn't start PNG compression");
+    }
+    std::string header;
+    put_u32(header, static_cast<std::uint32_t>(width));
+    put_u32(header, static_cast<std::uint32_t>(height));
+    header += '\x08'; // bit depth
+    header += '\x02'; // truecolor
+    header += '\0';   // deflate
+    header += '\0';   // adaptive filtering
+    header += '\0';   // no interlace
+
+    static constexpr char signature[]{'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n'};
+    m_out.write(signature, sizeof(signature));
+    write_chunk(m_out, "IHDR", header);
+}
+
+ImageStreamWriter::~ImageStreamWriter()
+{
+    if (m_deflate)
+    {
+        deflateEnd(&m_deflate->stream);
+    }
+}
+
+void ImageStreamWriter::deflate_bytes(const std::string &bytes, bool last)
+{
+    // Compressed data is gathered into IDAT chunks of up to 64K.
+    constexpr std::size_t IDAT_SIZE{65536};
+    z_stream &stream{m_deflate->stream};
+    std::string &output{m_deflate->output};
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(bytes.data()));
+    stream.avail_in = static_cast<uInt>(bytes.size());
+    int status{Z_OK};
+    do
+    {
+        const std::size_t used{output.size()};
+        output.resize(IDAT_SIZE);
+        stream.next_out = reinterpret_cast<Bytef *>(&output[used]);
+        stream.avail_out = static_cast<uInt>(IDAT_SIZE - used);
+        status = deflate(&stream, last ? Z_FINISH : Z_NO_FLUSH);
+        if (status == Z_STREAM_ERROR)
+        {
+            throw std::runtime_error("Couldn't compress PNG image data");
+        }
+        output.resize(IDAT_SIZE - stream.avail_out);
+        if (output.size() == IDAT_SIZE)
+        {
+            write_chunk(m_out, "IDAT", output);
+            output.clear();
+        }
+    } while (stream.avail_in != 0 || (last && status != Z_STREAM_END));
+    if (last && !output.empty())
+    {
+        write_chunk(m_out, "IDAT", output);
+        output.clear();
+    }
+}
+
+void ImageStreamWriter::write_row(const Color *row)
+{
+    if (m_rows == m_height)
+    {
+        throw std::runtime_error("Too many image rows");
+    }
+    ++m_rows;
+    if (m_format == ImageFormat::PPM)
+    {
+        for (const Color *color = row; color != row + m_width; ++color)
+        {
+            m_out.put(static_cast<char>(color->red));
+            m_out.put(static_cast<char>(color->green));
+            m_out.put(static_cast<char>(color->blue));
+        }
+        return;
+    }
+
+    // Each scanline is prefixed with filter type 0, leaving the bytes unfiltered.
+    std::string scanline;
+    scanline.reserve(1 + 3 * static_cast<std::size_t>(m_width));
+    scanline += '\0';
+    for (const Color *color = row; color != row + m_width; ++color)
+    {
+        scanline += static_cast<char>(color->red);
+        scanline += static_cast<char>(color->green);
+        scanline += static_cast<char>(color->blue);
+    }
+    deflate_bytes(scanline, false);
+}
+
+void ImageStreamWriter::finish()
+{
+    if (m_rows != m_height)
+    {
+        throw std::runtime_error("Image is missing rows");
+    }
+    if (m_format == ImageFormat::PNG)
+    {
+        deflate_bytes({}, true);
+        write_chunk(m_out, "IEND", {});
+    }
+}
+
+void write_ppm(std::ostream &out, const Image &image)
+{
+    ImageStreamWriter writer{out, ImageFormat::PPM, image.width, image.height};
+    for (int y = 0; y < image.height; ++y)
+    {
+        writer.write_row(&image.at(0, y));
+    }
+    writer.finish();
+}
+
+void write_png(std::ostream &out, const Image &image)
+{
+    ImageStreamWriter writer{out, ImageFormat::PNG, image.width, image.height};
+    for (int y = 0; y < image.height; ++y)
+    {
+        writer.write_row(&image.at(0, y));
+    }
+    writer.finish();
+}
+
+void write_image(const std::string &filename, const Image &image)
+{
+    const trace::Scope scope{"write_image", "renderer"};
+    const std::optional<ImageFormat> format{image_format(filename)};
+    if (!format)
+    {
+        throw std::runtime_error("Unknown image format for " + filename + "; use .png or .ppm");
+    }
+    std::ofstream out{filename, std::ios::binary};
+    if (!out)
+    {
+        throw std::runtime_error("Couldn't open " + filename);
+    }
+    if (*format == ImageFormat::PNG)
+    {
+        write_png(out, image);
+    }
+    else
+    {
+        write_ppm(out, image);
+    }
+    out.flush();
+    if (!out)
+    {
+        throw std::runtime_error("Couldn't write " + filename);
+    }
+}
+
+} // namespace formula::renderer
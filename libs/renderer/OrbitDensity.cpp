@@ -0,0 +1,315 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/OrbitDensity.h>
+
+#include <formula/core/Random.h>
+#include <formula/core/Trace.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace formula::renderer
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Sample streams have the second highest bit set, apart from the streams of rand and anti-aliasing jitter;
+// probe streams of the importance map have both high bits set.
+constexpr std::uint64_t SAMPLE_STREAM{1ULL << 62};
+constexpr std::uint64_t PROBE_STREAM{3ULL << 62};
+
+// Samples handed to a thread at a time.
+constexpr std::uint64_t SAMPLES_PER_ITEM{1024};
+
+// Jittered probes along each axis of an importance map cell.
+constexpr int PROBES{2};
+
+// The share of the mean weight every importance map cell keeps, whatever its probes found.
+constexpr double IMPORTANCE_FLOOR{0.05};
+
+std::uint64_t executed_iterations(const PixelResult &pixel)
+{
+    return static_cast<std::uint64_t>(pixel.iterations) + (pixel.escaped ? 1U : 0U);
+}
+
+// The point at fractions x and y across the sample region, y increasing downward like image rows.
+Complex region_point(const OrbitDensityOptions &density, double x, double y)
+{
+    return {density.center.re + (x - 0.5) * density.width, density.center.im - (y - 0.5) * density.height};
+}
+
+// Adds weight to the image pixel of every orbit point inside the viewport; returns the points added.
+std::uint64_t splat(const Viewport &viewport, const std::vector<Complex> &orbit, double weight, double *density)
+{
+    const double pixels_per_unit{viewport.pixel_width / viewport.width};
+    std::uint64_t added{};
+    for (const Complex &z : orbit)
+    {
+        const double x{(z.re - viewport.center.re) * pixels_per_unit + viewport.pixel_width * 0.5};
+        const double y{(viewport.center.im - z.im) * pixels_per_unit + viewport.pixel_height * 0.5};
+        // Written so NaN coordinates fail the test.
+        if (!(x >= 0.0 && x < viewport.pixel_width && y >= 0.0 && y < viewport.pixel_height))
+        {
+            continue;
+        }
+        if (density != nullptr)
+        {
+            density[static_cast<std::size_t>(y) * viewport.pixel_width + static_cast<std::size_t>(x)] += weight;
+        }
+        ++added;
+    }
+    return added;
+}
+
+bool recorded(const PixelResult &result, const OrbitDensityOptions &density)
+{
+    return result.escaped && result.iterations >= density.min_iterations;
+}
+
+std::vector<double> importance_map(RegionRenderer &renderer, std::uint32_t seed, const OrbitDensityOptions &density)
+{
+    const int grid{density.importance_grid};
+    const RenderOptions &options{renderer.options()};
+    std::vector<double> weights(static_cast<std::size_t>(grid) * grid);
+    std::vector<std::vector<Complex>> orbits(static_cast<std::size_t>(renderer.threads()));
+    renderer.run_slots(static_cast<int>(weights.size()),
+        [&](std::size_t slot, int cell)
+        {
+            PixelEvaluator &evaluator{renderer.evaluator(slot)};
+            std::vector<Complex> &orbit{orbits[slot]};
+            std::uint64_t iterations{};
+            std::uint64_t points{};
+            for (int probe = 0; probe < PROBES * PROBES; ++probe)
+            {
+                const std::uint64_t stream{PROBE_STREAM | (static_cast<std::uint64_t>(cell) * PROBES * PROBES + probe)};
+                const Complex jitter{random_complex(seed, stream, 0)};
+                const double x{(cell % grid + (probe % PROBES + jitter.re) / PROBES) / grid};
+                const double y{(cell / grid + (probe / PROBES + jitter.im) / PROBES) / grid};
+                evaluator.set_random_stream(stream);
+                const PixelResult result{
+                    evaluator.evaluate_orbit(region_point(density, x, y), options.max_iterations, orbit)};
+                iterations += executed_iterations(result);
+                if (recorded(result, density))
+                {
+                    points += splat(options.viewport, orbit, 1.0, nullptr);
+                }
+            }
+            weights[static_cast<std::size_t>(cell)] = static_cast<double>(points);
+            return iterations;
+        });
+
+    double total{};
+    for (const double weight : weights)
+    {
+        total += weight;
+    }
+    const double mean{total / static_cast<double>(weights.size())};
+    for (double &weight : weights)
+    {
+        weight = mean > 0.0 ? (weight + IMPORTANCE_FLOOR * mean) / ((1.0 + IMPORTANCE_FLOOR) * mean) : 1.0;
+    }
+    return weights;
+}
+
+struct Sample
+{
+    Complex pixel;
+    double weight; // inverse of the sampling density relative to even sampling
+};
+
+class Sampler
+{
+public:
+    Sampler(const OrbitDensityOptions &density, std::uint32_t seed, std::vector<double> importance);
+
+    std::uint64_t count() const
+    {
+        return m_count;
+    }
+    Sample operator()(std::uint64_t index) const;
+
+private:
+    const OrbitDensityOptions &m_density;
+    std::uint32_t m_seed;
+    std::vector<double> m_importance;
+    std::vector<double> m_cumulative; // running sums of m_importance, normalized to end at 1
+    std::uint64_t m_grid{}; // cells along each axis of stratified samples without importance
+    std::uint64_t m_count{};
+};
+
+Sampler::Sampler(const OrbitDensityOptions &density, std::uint32_t seed, std::vector<double> importance) :
+    m_density(density),
+    m_seed(seed),
+    m_importance(std::move(importance)),
+    m_count(density.samples)
+{
+    if (!m_importance.empty())
+    {
+        double sum{};
+        for (const double weight : m_importance)
+        {
+            sum += weight;
+            m_cumulative.push_back(sum);
+        }
+        for (double &value : m_cumulative)
+        {
+            value /= sum;
+        }
+    }
+    else if (density.sampling == OrbitSampling::STRATIFIED)
+    {
+        // The largest square grid with no more cells than samples.
+        m_grid = static_cast<std::uint64_t>(std::sqrt(static_cast<double>(density.samples)));
+        while (m_grid * m_grid > density.samples)
+        {
+            --m_grid;
+        }
+        while ((m_grid + 1) * (m_grid + 1) <= density.samples)
+        {
+            ++m_grid;
+        }
+        m_count = m_grid * m_grid;
+    }
+}
+
+Sample Sampler::operator()(std::uint64_t index) const
+{
+    const std::uint64_t stream{SAMPLE_STREAM | index};
+    const Complex first{random_complex(m_seed, stream, 0)};
+    if (m_importance.empty())
+    {
+        if (m_grid == 0)
+        {
+            return {region_point(m_density, first.re, first.im), 1.0};
+        }
+        const double x{(static_cast<double>(index % m_grid) + first.re) / static_cast<double>(m_grid)};
+        const double y{(static_cast<double>(index / m_grid) + first.im) / static_cast<double>(m_grid)};
+        return {region_point(m_density, x, y), 1.0};
+    }
+
+    // The cell is found by inverting the cumulative weights; stratified samples spread the inverted values
+    // evenly, so each cell gets close to its share of the samples.
+    const double u{m_density.sampling == OrbitSampling::STRATIFIED
+            ? (static_cast<double>(index) + first.re) / static_cast<double>(m_count)
+            : first.re};
+    const auto found{std::upper_bound(m_cumulative.begin(), m_cumulative.end(), u)};
+    const std::size_t cell{std::min(static_cast<std::size_t>(found - m_cumulative.begin()), m_cumulative.size() - 1)};
+    const Complex within{random_complex(m_seed, stream, 1)};
+    const auto grid{static_cast<std::size_t>(m_density.importance_grid)};
+    const double x{(static_cast<double>(cell % grid) + within.re) / static_cast<double>(grid)};
+    const double y{(static_cast<double>(cell / grid) + within.im) / static_cast<double>(grid)};
+    return {region_point(m_density, x, y), 1.0 / m_importance[cell]};
+}
+
+// The orbit density grid and scratch orbit of one render thread.
+struct ThreadDensity
+{
+    std::vector<double> density;
+    std::vector<Complex> orbit;
+};
+
+} // namespace
+
+std::vector<double> orbit_importance(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const OrbitDensityOptions &density)
+{
+    if (density.importance_grid <= 0)
+    {
+        return {};
+    }
+    RegionRenderer renderer{formula, backend, options};
+    return importance_map(renderer, formula.random_seed, density);
+}
+
+OrbitDensityResult render_orbit_density(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const OrbitDensityOptions &density)
+{
+    const trace::Scope scope{"render orbit density", "renderer"};
+    const Viewport &viewport{options.viewport};
+    OrbitDensityResult result;
+    result.width = viewport.pixel_width;
+    result.height = viewport.pixel_height;
+    const std::size_t pixels{static_cast<std::size_t>(result.width) * result.height};
+
+    RegionRenderer renderer{formula, backend, options};
+    result.stats.threads = renderer.threads();
+    result.stats.setup = renderer.setup();
+    const Clock::time_point start{Clock::now()};
+    const Sampler sampler{density, formula.random_seed,
+        density.importance_grid > 0 ? importance_map(renderer, formula.random_seed, density) : std::vector<double>{}};
+
+    std::vector<ThreadDensity> threads(static_cast<std::size_t>(renderer.threads()));
+    const std::uint64_t items{(sampler.count() + SAMPLES_PER_ITEM - 1) / SAMPLES_PER_ITEM};
+    if (items > static_cast<std::uint64_t>(std::numeric_limits<int>::max()))
+    {
+        throw std::runtime_error("Too many orbit density samples");
+    }
+    result.stats.iterations = renderer.run_slots(static_cast<int>(items),
+        [&](std::size_t slot, int item)
+        {
+            ThreadDensity &thread{threads[slot]};
+            if (thread.density.empty())
+            {
+                thread.density.assign(pixels, 0.0);
+            }
+            PixelEvaluator &evaluator{renderer.evaluator(slot)};
+            const std::uint64_t first{static_cast<std::uint64_t>(item) * SAMPLES_PER_ITEM};
+            const std::uint64_t end{std::min(sampler.count(), first + SAMPLES_PER_ITEM)};
+            std::uint64_t iterations{};
+            for (std::uint64_t index = first; index < end; ++index)
+            {
+                const Sample sample{sampler(index)};
+                evaluator.set_random_stream(SAMPLE_STREAM | index);
+                const PixelResult pixel{evaluator.evaluate_orbit(sample.pixel, options.max_iterations, thread.orbit)};
+                iterations += executed_iterations(pixel);
+                if (recorded(pixel, density))
+                {
+                    splat(viewport, thread.orbit, sample.weight, thread.density.data());
+                }
+            }
+            return iterations;
+        });
+    result.stats.pixels = sampler.count();
+
+    // Each thread wrote only its own grid, so they are merged once every thread is done.
+    result.density.assign(pixels, 0.0);
+    for (const ThreadDensity &thread : threads)
+    {
+        for (std::size_t i = 0; i < thread.density.size(); ++i)
+        {
+            result.density[i] += thread.density[i];
+        }
+    }
+    result.stats.elapsed = Clock::now() - start;
+    return result;
+}
+
+Image colorize(const OrbitDensityResult &result, const Coloring &coloring)
+{
+    if (coloring.palette.empty())
+    {
+        throw std::runtime_error("Empty palette");
+    }
+    const double most{result.density.empty() ? 0.0 : *std::max_element(result.density.begin(), result.density.end())};
+    const double scale{static_cast<double>(coloring.palette.size() - 1)};
+    Image image;
+    image.width = result.width;
+    image.height = result.height;
+    image.pixels.reserve(result.density.size());
+    for (const double value : result.density)
+    {
+        image.pixels.push_back(
+            value > 0.0 ? color_of(coloring, true, std::sqrt(value / most) * scale) : coloring.inside);
+    }
+    return image;
+}
+
+} // namespace formula::renderer
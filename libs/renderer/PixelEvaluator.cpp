@@ -0,0 +1,470 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/PixelEvaluator.h>
+
+#include <formula/facade/Formula.h>
+#include <formula/renderer/ClassicKernel.h>
+#include <formula/interpreter/ExtendedInterpreter.h>
+#include <formula/parser/ParseOptions.h>
+#include <formula/semantics/Derivative.h>
+
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace formula::renderer
+{
+
+namespace
+{
+
+class FormulaEvaluator : public PixelEvaluator
+{
+public:
+    FormulaEvaluator(const RenderFormula &formula, const std::string &variable, bool compiled,
+        const CompileOptions &compile_options);
+    ~FormulaEvaluator() override;
+
+    // Waits for the compilation the constructor started; throws std::runtime_error when it failed.
+    void finish_compile();
+
+    void set_random_stream(std::uint64_t stream) override
+    {
+        m_formula->set_random_stream(stream);
+    }
+    void set_cancellation(const CancellationToken *token) override
+    {
+        m_formula->set_cancellation(token);
+    }
+    PixelResult evaluate(Complex pixel, int max_iterations) override;
+    void evaluate_batch(const Complex *pixels, const std::uint64_t *streams, PixelResult *results,
+        std::size_t count, int max_iterations) override;
+    PixelResult evaluate_orbit(Complex pixel, int max_iterations, std::vector<Complex> &orbit) override;
+
+private:
+    void set_max_iterations(int max_iterations);
+    Complex section(Section part)
+    {
+        return m_compiled ? m_formula->run(part) : m_formula->interpret(part);
+    }
+    bool bailout()
+    {
+        // Without a bailout section the orbit runs to the iteration limit.
+        return !m_has_bailout || section(Section::BAILOUT).re != 0.0;
+    }
+
+    FormulaPtr m_formula;
+    std::string m_name;
+    std::future<bool> m_compiling;
+    SymbolHandle m_pixel;
+    SymbolHandle m_z;
+    SymbolHandle m_maxit;
+    SymbolHandle m_dz;
+    bool m_batch_reports_z{}; // Formula batches report z, so other variables are evaluated pixel by pixel
+    bool m_compiled;
+    bool m_has_bailout{};
+    int m_max_iterations{-1};
+    // Scratch arrays for evaluate_batch, kept so batches don't allocate.
+    std::vector<double> m_pixel_re;
+    std::vector<double> m_pixel_im;
+    std::vector<double> m_z_re;
+    std::vector<double> m_z_im;
+    std::vector<double> m_dz_re;
+    std::vector<double> m_dz_im;
+    std::vector<int> m_iterations;
+    std::unique_ptr<bool[]> m_escaped;
+    std::size_t m_escaped_size{};
+};
+
+FormulaEvaluator::FormulaEvaluator(const RenderFormula &formula, const std::string &variable, bool compiled,
+    const CompileOptions &compile_options) :
+    m_name(formula.name),
+    m_batch_reports_z(variable == "z"),
+    m_compiled(compiled)
+{
+    parser::Options options;
+    options.dialect = formula.dialect;
+    m_formula = create_formula(formula.body, options);
+    if (!m_formula)
+    {
+        throw std::runtime_error("Couldn't parse formula " + formula.name);
+    }
+    m_formula->set_random_seed(formula.random_seed);
+    for (const auto &[name, value] : formula.values)
+    {
+        m_formula->set_value(name, value);
+    }
+    for (const auto &[selector, function] : formula.functions)
+    {
+        if (!m_formula->set_function(selector, function))
+        {
+            throw std::runtime_error("Invalid function " + selector + "=" + function + " for " + formula.name);
+        }
+    }
+    if (formula.derivative)
+    {
+        if (!m_formula->enable_derivative())
+        {
+            throw std::runtime_error("Formula " + formula.name + " has no derivative");
+        }
+        m_dz = m_formula->lookup_symbol(semantic::derivative_name("z"));
+    }
+    m_has_bailout = static_cast<bool>(m_formula->get_section(Section::BAILOUT));
+    m_pixel = m_formula->lookup_symbol("pixel");
+    m_z = m_formula->lookup_symbol(variable);
+    m_maxit = m_formula->lookup_symbol("maxit");
+    if (m_compiled)
+    {
+        // Compilation owns the formula until finish_compile.
+        CompileOptions named{compile_options};
+        if (named.name.empty())
+        {
+            named.name = formula.name;
+        }
+        m_compiling = m_formula->compile_async(named);
+    }
+}
+
+FormulaEvaluator::~FormulaEvaluator()
+{
+    // The formula can't be destroyed while the pool is still compiling it.
+    if (m_compiling.valid())
+    {
+        m_compiling.wait();
+    }
+}
+
+void FormulaEvaluator::finish_compile()
+{
+    if (m_compiling.valid() && !m_compiling.get())
+    {
+        throw std::runtime_error("Couldn't compile formula " + m_name);
+    }
+}
+
+void FormulaEvaluator::set_max_iterations(int max_iterations)
+{
+    if (max_iterations != m_max_iterations)
+    {
+        // The global section may depend on maxit, so it runs whenever the limit changes.
+        m_max_iterations = max_iterations;
+        m_formula->set(m_maxit, {static_cast<double>(max_iterations), 0.0});
+        if (m_formula->get_section(Section::PER_IMAGE))
+        {
+            section(Section::PER_IMAGE);
+        }
+    }
+}
+
+PixelResult FormulaEvaluator::evaluate(Complex pixel, int max_iterations)
+{
+    set_max_iterations(max_iterations);
+    m_formula->set(m_pixel, pixel);
+    section(Section::INITIALIZE);
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        section(Section::ITERATE);
+        if (!bailout())
+        {
+            return {iteration, m_formula->get(m_z), true, m_dz ? m_formula->get(m_dz) : Complex{}};
+        }
+    }
+    return {max_iterations, m_formula->get(m_z), false, m_dz ? m_formula->get(m_dz) : Complex{}};
+}
+
+PixelResult FormulaEvaluator::evaluate_orbit(Complex pixel, int max_iterations, std::vector<Complex> &orbit)
+{
+    orbit.clear();
+    set_max_iterations(max_iterations);
+    m_formula->set(m_pixel, pixel);
+    section(Section::INITIALIZE);
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        section(Section::ITERATE);
+        orbit.push_back(m_formula->get(m_z));
+        if (!bailout())
+        {
+            return {iteration, orbit.back(), true, m_dz ? m_formula->get(m_dz) : Complex{}};
+        }
+    }
+    return {max_iterations, m_formula->get(m_z), false, m_dz ? m_formula->get(m_dz) : Complex{}};
+}
+
+void FormulaEvaluator::evaluate_batch(const Complex *pixels, const std::uint64_t *streams, PixelResult *results,
+    std::size_t count, int max_iterations)
+{
+    if (!m_batch_reports_z)
+    {
+        PixelEvaluator::evaluate_batch(pixels, streams, results, count, max_iterations);
+        return;
+    }
+    set_max_iterations(max_iterations);
+    m_pixel_re.resize(count);
+    m_pixel_im.resize(count);
+    m_z_re.resize(count);
+    m_z_im.resize(count);
+    m_iterations.resize(count);
+    if (m_dz)
+    {
+        m_dz_re.resize(count);
+        m_dz_im.resize(count);
+    }
+    if (m_escaped_size < count)
+    {
+        m_escaped = std::make_unique<bool[]>(count);
+        m_escaped_size = count;
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        m_pixel_re[i] = pixels[i].re;
+        m_pixel_im[i] = pixels[i].im;
+    }
+
+    BatchInputs inputs;
+    inputs.pixel_re = m_pixel_re.data();
+    inputs.pixel_im = m_pixel_im.data();
+    inputs.random_streams = streams;
+    BatchOutputs outputs;
+    outputs.z_re = m_z_re.data();
+    outputs.z_im = m_z_im.data();
+    outputs.iterations = m_iterations.data();
+    outputs.escaped = m_escaped.get();
+    if (m_dz)
+    {
+        outputs.dz_re = m_dz_re.data();
+        outputs.dz_im = m_dz_im.data();
+    }
+    if (m_compiled)
+    {
+        m_formula->run_batch(Section::ITERATE, inputs, outputs, count, max_iterations);
+    }
+    else
+    {
+        m_formula->interpret_batch(Section::ITERATE, inputs, outputs, count, max_iterations);
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        results[i] = {m_iterations[i], {m_z_re[i], m_z_im[i]}, m_escaped[i]};
+        if (m_dz)
+        {
+            results[i].dz = {m_dz_re[i], m_dz_im[i]};
+        }
+    }
+}
+
+class ExtendedEvaluator : public PixelEvaluator
+{
+public:
+    explicit ExtendedEvaluator(const RenderFormula &formula);
+    ~ExtendedEvaluator() override = default;
+
+    void set_random_stream(std::uint64_t) override
+    {
+        // random() in the extended runtime is a pure function of its argument, so there is no stream.
+    }
+    void set_cancellation(const CancellationToken *token) override
+    {
+        m_interpreter.set_cancellation(token);
+    }
+    PixelResult evaluate(Complex pixel, int max_iterations) override;
+    PixelResult evaluate_orbit(Complex pixel, int max_iterations, std::vector<Complex> &orbit) override;
+
+private:
+    void set_max_iterations(int max_iterations);
+    Complex z() const;
+
+    ExtendedInterpreter m_interpreter;
+    int m_max_iterations{-1};
+};
+
+FileEntry file_entry(const RenderFormula &formula)
+{
+    FileEntry entry;
+    entry.name = formula.name;
+    entry.body = formula.body;
+    return entry;
+}
+
+ExtendedInterpreterOptions extended_options(const RenderFormula &formula)
+{
+    ExtendedInterpreterOptions options;
+    options.parser.dialect = formula.dialect;
+    return options;
+}
+
+ExtendedEvaluator::ExtendedEvaluator(const RenderFormula &formula) :
+    m_interpreter(file_entry(formula), extended_options(formula))
+{
+    if (formula.derivative)
+    {
+        throw std::runtime_error("The extended backend can't track the derivative of " + formula.name);
+    }
+    if (!m_interpreter.ok())
+    {
+        std::string message{"Couldn't prepare formula " + formula.name};
+        for (const ExtendedInterpreterDiagnostic &diagnostic : m_interpreter.diagnostics())
+        {
+            message += "\n" + diagnostic.message;
+        }
+        throw std::runtime_error(message);
+    }
+    for (const auto &[name, value] : formula.values)
+    {
+        m_interpreter.set_value(name, Value{value});
+    }
+    for (const auto &[selector, function] : formula.functions)
+    {
+        m_interpreter.set_function_parameter(selector, function);
+    }
+}
+
+Complex ExtendedEvaluator::z() const
+{
+    const Value value{m_interpreter.value("z")};
+    if (const Complex *z = std::get_if<Complex>(&value.storage()))
+    {
+        return *z;
+    }
+    if (const double *re = std::get_if<double>(&value.storage()))
+    {
+        return {*re, 0.0};
+    }
+    return {};
+}
+
+void ExtendedEvaluator::set_max_iterations(int max_iterations)
+{
+    if (max_iterations != m_max_iterations)
+    {
+        m_max_iterations = max_iterations;
+        m_interpreter.set_value("#maxiter", Value{max_iterations});
+        m_interpreter.interpret(Section::PER_IMAGE);
+    }
+}
+
+PixelResult ExtendedEvaluator::evaluate(Complex pixel, int max_iterations)
+{
+    set_max_iterations(max_iterations);
+    m_interpreter.set_value("#pixel", Value{pixel});
+    m_interpreter.interpret(Section::INITIALIZE);
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        m_interpreter.set_value("#numiter", Value{iteration});
+        m_interpreter.interpret(Section::ITERATE);
+        if (!is_truthy(m_interpreter.interpret(Section::BAILOUT)))
+        {
+            return {iteration, z(), true};
+        }
+    }
+    return {max_iterations, z(), false};
+}
+
+PixelResult ExtendedEvaluator::evaluate_orbit(Complex pixel, int max_iterations, std::vector<Complex> &orbit)
+{
+    orbit.clear();
+    set_max_iterations(max_iterations);
+    m_interpreter.set_value("#pixel", Value{pixel});
+    m_interpreter.interpret(Section::INITIALIZE);
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        m_interpreter.set_value("#numiter", Value{iteration});
+        m_interpreter.interpret(Section::ITERATE);
+        orbit.push_back(z());
+        if (!is_truthy(m_interpreter.interpret(Section::BAILOUT)))
+        {
+            return {iteration, orbit.back(), true};
+        }
+    }
+    return {max_iterations, z(), false};
+}
+
+} // namespace
+
+void PixelEvaluator::evaluate_batch(const Complex *pixels, const std::uint64_t *streams, PixelResult *results,
+    std::size_t count, int max_iterations)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        set_random_stream(streams[i]);
+        results[i] = evaluate(pixels[i], max_iterations);
+    }
+}
+
+std::string_view to_string(Backend value)
+{
+    switch (value)
+    {
+    case Backend::INTERPRETER:
+        return "interpreter";
+    case Backend::COMPILER:
+        return "compiler";
+    case Backend::EXTENDED:
+        return "extended";
+    case Backend::KERNEL:
+        return "kernel";
+    }
+    return "unknown";
+}
+
+PixelEvaluatorPtr create_evaluator(
+    const RenderFormula &formula, Backend backend, const CompileOptions &compile_options)
+{
+    std::vector<PixelEvaluatorPtr> evaluators{create_evaluators(formula, backend, 1, compile_options)};
+    return std::move(evaluators.front());
+}
+
+std::vector<PixelEvaluatorPtr> create_evaluators(
+    const RenderFormula &formula, Backend backend, int count, const CompileOptions &compile_options)
+{
+    std::vector<PixelEvaluatorPtr> result;
+    result.reserve(static_cast<std::size_t>(count));
+    if (backend == Backend::EXTENDED)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            result.push_back(std::make_unique<ExtendedEvaluator>(formula));
+        }
+        return result;
+    }
+    const std::optional<semantic::ClassicFormula> classic{recognize_classic_formula(formula)};
+    if (backend == Backend::KERNEL)
+    {
+        if (classic)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                result.push_back(create_classic_evaluator(*classic));
+            }
+            return result;
+        }
+        backend = Backend::COMPILER;
+    }
+    if (backend != Backend::INTERPRETER && backend != Backend::COMPILER)
+    {
+        throw std::runtime_error("Invalid render backend");
+    }
+    // Classic formulas report the variable they iterate, whatever it is called, like the classic kernels.
+    const std::string variable{classic ? classic->variable : "z"};
+    // Every compilation is started before waiting for the first, so they run concurrently.
+    std::vector<FormulaEvaluator *> evaluators;
+    for (int i = 0; i < count; ++i)
+    {
+        auto evaluator{
+            std::make_unique<FormulaEvaluator>(formula, variable, backend == Backend::COMPILER, compile_options)};
+        evaluators.push_back(evaluator.get());
+        result.push_back(std::move(evaluator));
+    }
+    for (FormulaEvaluator *evaluator : evaluators)
+    {
+        evaluator->finish_compile();
+    }
+    return result;
+}
+
+} // namespace formula::renderer
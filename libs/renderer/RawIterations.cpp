@@ -0,0 +1,462 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/RawIterations.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace formula::renderer
+{
+
+namespace
+{
+
+constexpr char RAW_MAGIC[4]{'F', 'R', 'I', 'T'};
+constexpr std::uint32_t RAW_BYTE_ORDER{0x01020304U};
+constexpr std::uint32_t RAW_VERSION{2};
+
+// Each pixel is stored as int32 iterations, uint8 escaped, double z.re, double z.im and float smooth,
+// with each field stored contiguously for the whole chunk.
+constexpr std::size_t RAW_PIXEL_BYTES{sizeof(std::int32_t) + sizeof(std::uint8_t) + 2 * sizeof(double) + sizeof(float)};
+
+struct CompressedChunk
+{
+    std::uint32_t x{};
+    std::uint32_t y{};
+    std::uint32_t width{};
+    std::uint32_t height{};
+    std::uint64_t raw_size{};
+    std::string bytes;
+};
+
+template <typename T>
+void write_value(std::ostream &out, T value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_value(std::istream &in, T &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+template <typename T>
+void append(std::string &bytes, const std::vector<T> &values)
+{
+    bytes.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+const char *extract(const char *bytes, std::vector<T> &values, std::size_t count)
+{
+    values.resize(count);
+    std::memcpy(values.data(), bytes, count * sizeof(T));
+    return bytes + count * sizeof(T);
+}
+
+[[noreturn]] void corrupt(const std::string &detail)
+{
+    throw std::runtime_error("Invalid raw iteration file: " + detail);
+}
+
+bool inside_image(const RawIterationHeader &header, std::int64_t x, std::int64_t y, std::int64_t width,
+    std::int64_t height)
+{
+    return x >= 0 && y >= 0 && width > 0 && height > 0 && x + width <= header.width && y + height <= header.height;
+}
+
+enum class ChunkHeader
+{
+    END,
+    TRUNCATED,
+    VALID,
+};
+
+// Reads the fields before a chunk's data into chunk, leaving its bytes empty.
+ChunkHeader read_chunk_header(
+    std::istream &in, const RawIterationHeader &header, CompressedChunk &chunk, std::uint64_t &compressed_size)
+{
+    if (!read_value(in, chunk.x))
+    {
+        return ChunkHeader::END;
+    }
+    if (!read_value(in, chunk.y) || !read_value(in, chunk.width) || !read_value(in, chunk.height) ||
+        !read_value(in, chunk.raw_size) || !read_value(in, compressed_size))
+    {
+        return ChunkHeader::TRUNCATED;
+    }
+    if (!inside_image(header, chunk.x, chunk.y, chunk.width, chunk.height) ||
+        chunk.raw_size != static_cast<std::uint64_t>(chunk.width) * chunk.height * RAW_PIXEL_BYTES)
+    {
+        corrupt("chunk outside the image");
+    }
+    if (compressed_size > compressBound(static_cast<uLong>(chunk.raw_size)))
+    {
+        corrupt("chunk data larger than its pixels compress to");
+    }
+    return ChunkHeader::VALID;
+}
+
+bool read_compressed(std::istream &in, const RawIterationHeader &header, CompressedChunk &chunk)
+{
+    std::uint64_t compressed_size{};
+    const ChunkHeader status{read_chunk_header(in, header, chunk, compressed_size)};
+    if (status == ChunkHeader::END)
+    {
+        return false;
+    }
+    if (status == ChunkHeader::TRUNCATED)
+    {
+        corrupt("truncated chunk header");
+    }
+    chunk.bytes.resize(compressed_size);
+    if (!in.read(chunk.bytes.data(), static_cast<std::streamsize>(compressed_size)))
+    {
+        corrupt("truncated chunk data");
+    }
+    return true;
+}
+
+RawIterationChunk decode(const CompressedChunk &compressed)
+{
+    std::string raw(compressed.raw_size, '\0');
+    uLongf raw_size{static_cast<uLongf>(raw.size())};
+    if (uncompress(reinterpret_cast<Bytef *>(raw.data()), &raw_size,
+            reinterpret_cast<const Bytef *>(compressed.bytes.data()), static_cast<uLong>(compressed.bytes.size())) !=
+            Z_OK ||
+        raw_size != raw.size())
+    {
+        corrupt("chunk doesn't decompress");
+    }
+
+    RawIterationChunk chunk;
+    chunk.x = static_cast<int>(compressed.x);
+    chunk.y = static_cast<int>(compressed.y);
+    chunk.width = static_cast<int>(compressed.width);
+    chunk.height = static_cast<int>(compressed.height);
+    const std::size_t count{static_cast<std::size_t>(chunk.width) * chunk.height};
+    std::vector<std::int32_t> iterations;
+    std::vector<std::uint8_t> escaped;
+    std::vector<double> re;
+    std::vector<double> im;
+    const char *bytes{raw.data()};
+    bytes = extract(bytes, iterations, count);
+    bytes = extract(bytes, escaped, count);
+    bytes = extract(bytes, re, count);
+    bytes = extract(bytes, im, count);
+    extract(bytes, chunk.smooth, count);
+    chunk.pixels.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        chunk.pixels[i] = {iterations[i], {re[i], im[i]}, escaped[i] != 0};
+    }
+    return chunk;
+}
+
+int thread_count(int threads, std::size_t chunks)
+{
+    const int available{threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency())};
+    return std::max(1, std::min(available, static_cast<int>(chunks)));
+}
+
+} // namespace
+
+RawIterationWriter::RawIterationWriter(std::ostream &out, const RawIterationHeader &header) :
+    RawIterationWriter(out, header, true)
+{
+}
+
+RawIterationWriter::RawIterationWriter(std::ostream &out, const RawIterationHeader &header, bool write_header) :
+    m_out(out),
+    m_header(header)
+{
+    if (header.width <= 0 || header.height <= 0)
+    {
+        throw std::runtime_error("Raw iteration files need a non-empty image");
+    }
+    if (!write_header)
+    {
+        return;
+    }
+    m_out.write(RAW_MAGIC, sizeof(RAW_MAGIC));
+    write_value(m_out, RAW_BYTE_ORDER);
+    write_value(m_out, RAW_VERSION);
+    write_value(m_out, static_cast<std::uint32_t>(header.width));
+    write_value(m_out, static_cast<std::uint32_t>(header.height));
+    write_value(m_out, static_cast<std::uint32_t>(header.max_iterations));
+    write_value(m_out, header.fingerprint);
+}
+
+void RawIterationWriter::write_chunk(int x, int y, int width, int height, const PixelResult *pixels, int stride)
+{
+    if (!inside_image(m_header, x, y, width, height))
+    {
+        throw std::runtime_error("Raw iteration chunk is outside the image");
+    }
+    const std::size_t count{static_cast<std::size_t>(width) * height};
+    std::vector<std::int32_t> iterations;
+    std::vector<std::uint8_t> escaped;
+    std::vector<double> re;
+    std::vector<double> im;
+    std::vector<float> smooth;
+    iterations.reserve(count);
+    escaped.reserve(count);
+    re.reserve(count);
+    im.reserve(count);
+    smooth.reserve(count);
+    for (int row = 0; row < height; ++row)
+    {
+        const PixelResult *begin{pixels + static_cast<std::size_t>(row) * stride};
+        for (const PixelResult *pixel = begin; pixel != begin + width; ++pixel)
+        {
+            iterations.push_back(pixel->iterations);
+            escaped.push_back(pixel->escaped ? 1U : 0U);
+            re.push_back(pixel->z.re);
+            im.push_back(pixel->z.im);
+            smooth.push_back(static_cast<float>(smooth_iterations(*pixel)));
+        }
+    }
+    std::string raw;
+    raw.reserve(count * RAW_PIXEL_BYTES);
+    append(raw, iterations);
+    append(raw, escaped);
+    append(raw, re);
+    append(raw, im);
+    append(raw, smooth);
+
+    uLongf compressed_size{compressBound(static_cast<uLong>(raw.size()))};
+    std::string compressed(compressed_size, '\0');
+    if (compress2(reinterpret_cast<Bytef *>(compressed.data()), &compressed_size,
+            reinterpret_cast<const Bytef *>(raw.data()), static_cast<uLong>(raw.size()), Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        throw std::runtime_error("Couldn't compress raw iteration chunk");
+    }
+    write_value(m_out, static_cast<std::uint32_t>(x));
+    write_value(m_out, static_cast<std::uint32_t>(y));
+    write_value(m_out, static_cast<std::uint32_t>(width));
+    write_value(m_out, static_cast<std::uint32_t>(height));
+    write_value(m_out, static_cast<std::uint64_t>(raw.size()));
+    write_value(m_out, static_cast<std::uint64_t>(compressed_size));
+    m_out.write(compressed.data(), static_cast<std::streamsize>(compressed_size));
+}
+
+RawIterationWriter RawIterationWriter::append_to(std::ostream &out, const RawIterationIndex &existing)
+{
+    return RawIterationWriter{out, existing.header, false};
+}
+
+RawIterationReader::RawIterationReader(std::istream &in) :
+    m_in(in)
+{
+    char magic[sizeof(RAW_MAGIC)]{};
+    std::uint32_t byte_order{};
+    std::uint32_t version{};
+    std::uint32_t width{};
+    std::uint32_t height{};
+    std::uint32_t max_iterations{};
+    if (!m_in.read(magic, sizeof(magic)) || std::memcmp(magic, RAW_MAGIC, sizeof(magic)) != 0)
+    {
+        corrupt("bad signature");
+    }
+    if (!read_value(m_in, byte_order) || byte_order != RAW_BYTE_ORDER)
+    {
+        corrupt("written with a different byte order");
+    }
+    if (!read_value(m_in, version) || version != RAW_VERSION)
+    {
+        corrupt("unsupported version");
+    }
+    if (!read_value(m_in, width) || !read_value(m_in, height) || !read_value(m_in, max_iterations) ||
+        !read_value(m_in, m_header.fingerprint))
+    {
+        corrupt("truncated header");
+    }
+    m_header.width = static_cast<int>(width);
+    m_header.height = static_cast<int>(height);
+    m_header.max_iterations = static_cast<int>(max_iterations);
+}
+
+bool RawIterationReader::next(RawIterationChunk &chunk)
+{
+    CompressedChunk compressed;
+    if (!read_compressed(m_in, m_header, compressed))
+    {
+        return false;
+    }
+    chunk = decode(compressed);
+    return true;
+}
+
+RawIterationIndex index_raw_iterations(std::istream &in)
+{
+    in.seekg(0, std::ios::end);
+    const std::streamoff size{in.tellg()};
+    in.seekg(0, std::ios::beg);
+    RawIterationIndex index;
+    index.header = RawIterationReader{in}.header();
+    index.end = in.tellg();
+    while (true)
+    {
+        CompressedChunk chunk;
+        std::uint64_t compressed_size{};
+        if (read_chunk_header(in, index.header, chunk, compressed_size) != ChunkHeader::VALID)
+        {
+            break;
+        }
+        const std::streamoff end{in.tellg() + static_cast<std::streamoff>(compressed_size)};
+        if (end > size)
+        {
+            break;
+        }
+        index.chunks.push_back({static_cast<int>(chunk.x), static_cast<int>(chunk.y), static_cast<int>(chunk.width),
+            static_cast<int>(chunk.height), index.end});
+        index.end = end;
+        in.seekg(end);
+    }
+    in.clear();
+    return index;
+}
+
+RawIterationChunk read_raw_chunk(std::istream &in, const RawIterationIndex &index, const RawIterationChunkInfo &chunk)
+{
+    in.clear();
+    in.seekg(chunk.offset);
+    CompressedChunk compressed;
+    if (!read_compressed(in, index.header, compressed))
+    {
+        corrupt("missing chunk");
+    }
+    return decode(compressed);
+}
+
+void write_raw_iterations(std::ostream &out, const RenderResult &result, int max_iterations, int rows_per_chunk)
+{
+    RawIterationWriter writer{out, {result.width, result.height, max_iterations}};
+    rows_per_chunk = std::max(1, rows_per_chunk);
+    for (int y = 0; y < result.height; y += rows_per_chunk)
+    {
+        const int rows{std::min(rows_per_chunk, result.height - y)};
+        writer.write_chunk(0, y, result.width, rows, &result.pixels[static_cast<std::size_t>(y) * result.width],
+            result.width);
+    }
+}
+
+RenderResult read_raw_iterations(std::istream &in)
+{
+    RawIterationReader reader{in};
+    RenderResult result;
+    result.width = reader.header().width;
+    result.height = reader.header().height;
+    result.pixels.resize(static_cast<std::size_t>(result.width) * result.height);
+    RawIterationChunk chunk;
+    while (reader.next(chunk))
+    {
+        for (int row = 0; row < chunk.height; ++row)
+        {
+            std::copy_n(&chunk.pixels[static_cast<std::size_t>(row) * chunk.width], chunk.width,
+                &result.pixels[static_cast<std::size_t>(chunk.y + row) * result.width + chunk.x]);
+        }
+    }
+    return result;
+}
+
+Image recolor(std::istream &in, const Coloring &coloring, int threads)
+{
+    if (coloring.palette.empty())
+    {
+        throw std::runtime_error("Empty palette");
+    }
+    RawIterationReader reader{in};
+    const RawIterationHeader &header{reader.header()};
+    Image image;
+    image.width = header.width;
+    image.height = header.height;
+    image.pixels.assign(static_cast<std::size_t>(image.width) * image.height, coloring.inside);
+
+    // Reading is sequential; decompression and coloring of whole chunks run in parallel.
+    std::vector<CompressedChunk> chunks;
+    for (CompressedChunk chunk; read_compressed(in, header, chunk);)
+    {
+        chunks.push_back(std::move(chunk));
+    }
+
+    std::atomic<std::size_t> next_chunk{};
+    std::exception_ptr error;
+    std::mutex error_lock;
+    const auto worker = [&]
+    {
+        try
+        {
+            for (std::size_t index = next_chunk++; index < chunks.size(); index = next_chunk++)
+            {
+                const RawIterationChunk chunk{decode(chunks[index])};
+                for (int row = 0; row < chunk.height; ++row)
+                {
+                    Color *target{&image.pixels[static_cast<std::size_t>(chunk.y + row) * image.width + chunk.x]};
+                    for (int x = 0; x < chunk.width; ++x)
+                    {
+                        const std::size_t i{static_cast<std::size_t>(row) * chunk.width + x};
+                        const PixelResult &pixel{chunk.pixels[i]};
+                        target[x] = color_of(coloring, pixel.escaped,
+                            coloring.smooth ? static_cast<double>(chunk.smooth[i]) : pixel.iterations);
+                    }
+                }
+            }
+        }
+        catch (...)
+        {
+            const std::lock_guard lock{error_lock};
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+            next_chunk = chunks.size();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const int count{thread_count(threads, chunks.size())};
+    for (int i = 1; i < count; ++i)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : workers)
+    {
+        thread.join();
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    return image;
+}
+
+IterationHistogram raw_histogram(std::istream &in)
+{
+    RawIterationReader reader{in};
+    IterationHistogram result;
+    result.counts.resize(static_cast<std::size_t>(std::max(reader.header().max_iterations, 0)) + 1);
+    for (RawIterationChunk chunk; reader.next(chunk);)
+    {
+        for (const PixelResult &pixel : chunk.pixels)
+        {
+            result.add(pixel);
+        }
+    }
+    return result;
+}
+
+} // namespace formula::renderer
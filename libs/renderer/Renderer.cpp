@@ -0,0 +1,317 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/Renderer.h>
+
+#include <formula/core/Trace.h>
+#include <formula/facade/Formula.h>
+#include <formula/parser/ParseOptions.h>
+#include <formula/semantics/Symmetry.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace formula::renderer
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+int thread_count(const RenderOptions &options)
+{
+    if (options.threads > 0)
+    {
+        return std::min(options.threads, std::max(options.viewport.pixel_height, 1));
+    }
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+std::uint64_t executed_iterations(const PixelResult &pixel)
+{
+    return static_cast<std::uint64_t>(pixel.iterations) + (pixel.escaped ? 1U : 0U);
+}
+
+bool conjugate_symmetric(const RenderFormula &formula)
+{
+    parser::Options options;
+    options.dialect = formula.dialect;
+    const LoadedFormula loaded{load_formula(formula.body, options)};
+    return loaded.ast && semantic::is_conjugate_symmetric(*loaded.ast, formula.values, formula.functions);
+}
+
+} // namespace
+
+Complex pixel_location(const Viewport &viewport, double x, double y)
+{
+    const double pixel_size{viewport.width / viewport.pixel_width};
+    return {viewport.center.re + (x - viewport.pixel_width * 0.5) * pixel_size,
+        viewport.center.im - (y - viewport.pixel_height * 0.5) * pixel_size};
+}
+
+void IterationHistogram::add(const PixelResult &pixel)
+{
+    if (!pixel.escaped || pixel.iterations < 0)
+    {
+        return;
+    }
+    const auto iterations{static_cast<std::size_t>(pixel.iterations)};
+    if (iterations >= counts.size())
+    {
+        counts.resize(iterations + 1);
+    }
+    ++counts[iterations];
+}
+
+void IterationHistogram::merge(const IterationHistogram &other)
+{
+    if (other.counts.size() > counts.size())
+    {
+        counts.resize(other.counts.size());
+    }
+    for (std::size_t i = 0; i < other.counts.size(); ++i)
+    {
+        counts[i] += other.counts[i];
+    }
+}
+
+std::uint64_t IterationHistogram::total() const
+{
+    std::uint64_t result{};
+    for (const std::uint64_t count : counts)
+    {
+        result += count;
+    }
+    return result;
+}
+
+double pixels_per_second(const RenderStats &stats)
+{
+    return stats.elapsed.count() > 0.0 ? static_cast<double>(stats.pixels) / stats.elapsed.count() : 0.0;
+}
+
+double iterations_per_second(const RenderStats &stats)
+{
+    return stats.elapsed.count() > 0.0 ? static_cast<double>(stats.iterations) / stats.elapsed.count() : 0.0;
+}
+
+RegionRenderer::RegionRenderer(const RenderFormula &formula, Backend backend, const RenderOptions &options) :
+    m_options(options)
+{
+    const trace::Scope scope{"RegionRenderer setup", "renderer"};
+    const Clock::time_point start{Clock::now()};
+    m_evaluators = create_evaluators(formula, backend, thread_count(options), options.compile);
+    for (const PixelEvaluatorPtr &evaluator : m_evaluators)
+    {
+        evaluator->set_cancellation(options.cancellation);
+    }
+    if (options.histogram)
+    {
+        // Sized for every iteration count up front so counting never reallocates.
+        IterationHistogram empty;
+        empty.counts.resize(static_cast<std::size_t>(std::max(options.max_iterations, 0)) + 1);
+        m_histograms.assign(m_evaluators.size(), empty);
+    }
+    m_setup = Clock::now() - start;
+}
+
+std::uint64_t RegionRenderer::run(int count, const std::function<std::uint64_t(PixelEvaluator &, int)> &item)
+{
+    return run_slots(count, [&](std::size_t slot, int index) { return item(*m_evaluators[slot], index); });
+}
+
+std::uint64_t RegionRenderer::run_slots(int count, const std::function<std::uint64_t(std::size_t, int)> &item)
+{
+    std::atomic<int> next{};
+    std::atomic<std::uint64_t> iterations{};
+    std::exception_ptr error;
+    std::mutex error_lock;
+    const auto worker = [&](std::size_t slot)
+    {
+        const trace::Scope scope{"render worker", "renderer"};
+        try
+        {
+            std::uint64_t local_iterations{};
+            for (int index = next++; index < count; index = next++)
+            {
+                if (m_options.cancellation != nullptr)
+                {
+                    m_options.cancellation->throw_if_cancelled();
+                }
+                local_iterations += item(slot, index);
+            }
+            iterations += local_iterations;
+        }
+        catch (...)
+        {
+            const std::lock_guard lock{error_lock};
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+            next = count;
+        }
+    };
+
+    // No more threads than items; the calling thread is one of them.
+    const std::size_t used{std::min(m_evaluators.size(), static_cast<std::size_t>(std::max(count, 1)))};
+    std::vector<std::thread> threads;
+    threads.reserve(used - 1);
+    for (std::size_t i = 1; i < used; ++i)
+    {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    return iterations;
+}
+
+std::uint64_t RegionRenderer::render(int x, int y, int width, int height, PixelResult *pixels)
+{
+    const Viewport &viewport{m_options.viewport};
+    return run_slots(height,
+        [&](std::size_t slot, int row)
+        {
+            std::vector<Complex> locations(static_cast<std::size_t>(width));
+            std::vector<std::uint64_t> streams(static_cast<std::size_t>(width));
+            const int pixel_y{y + row};
+            for (int column = 0; column < width; ++column)
+            {
+                // The stream is the pixel's index in the whole image, so regions match a full render.
+                const int pixel_x{x + column};
+                locations[column] = pixel_location(viewport, pixel_x + 0.5, pixel_y + 0.5);
+                streams[column] = static_cast<std::uint64_t>(pixel_y) * viewport.pixel_width + pixel_x;
+            }
+            PixelResult *target{&pixels[static_cast<std::size_t>(row) * width]};
+            m_evaluators[slot]->evaluate_batch(
+                locations.data(), streams.data(), target, static_cast<std::size_t>(width), m_options.max_iterations);
+            std::uint64_t iterations{};
+            for (int column = 0; column < width; ++column)
+            {
+                iterations += executed_iterations(target[column]);
+            }
+            if (!m_histograms.empty())
+            {
+                IterationHistogram &histogram{m_histograms[slot]};
+                for (int column = 0; column < width; ++column)
+                {
+                    histogram.add(target[column]);
+                }
+            }
+            return iterations;
+        });
+}
+
+IterationHistogram RegionRenderer::histogram() const
+{
+    IterationHistogram result;
+    for (const IterationHistogram &histogram : m_histograms)
+    {
+        result.merge(histogram);
+    }
+    return result;
+}
+
+std::optional<int> mirror_row_sum(const Viewport &viewport)
+{
+    // Row y is centered at im = center.im - (y + 0.5 - height/2) * pixel_size, so rows y and sum - y are
+    // conjugates when sum = height - 1 + 2 * center.im / pixel_size is an integer.
+    const double pixel_size{viewport.width / viewport.pixel_width};
+    const double offset{2.0 * viewport.center.im / pixel_size};
+    const double rounded{std::round(offset)};
+    if (std::abs(offset - rounded) > 1.0e-6 || std::abs(rounded) >= viewport.pixel_height)
+    {
+        return {};
+    }
+    return viewport.pixel_height - 1 + static_cast<int>(rounded);
+}
+
+RenderResult render(const RenderFormula &formula, Backend backend, const RenderOptions &options)
+{
+    const trace::Scope scope{"render", "renderer"};
+    RenderResult result;
+    result.width = options.viewport.pixel_width;
+    result.height = options.viewport.pixel_height;
+    result.pixels.resize(static_cast<std::size_t>(result.width) * result.height);
+
+    RegionRenderer renderer{formula, backend, options};
+    result.stats.threads = renderer.threads();
+    result.stats.setup = renderer.setup();
+    const Clock::time_point start{Clock::now()};
+    const std::optional<int> mirror{
+        options.symmetry && conjugate_symmetric(formula) ? mirror_row_sum(options.viewport) : std::nullopt};
+    if (!mirror)
+    {
+        result.stats.iterations = renderer.render(0, 0, result.width, result.height, result.pixels.data());
+        result.stats.pixels = result.pixels.size();
+        result.histogram = renderer.histogram();
+        result.stats.elapsed = Clock::now() - start;
+        return result;
+    }
+
+    // Evaluate each run of rows whose mirror is outside the image or not above it, then mirror the rest.
+    const auto evaluated = [&](int y)
+    {
+        const int other{*mirror - y};
+        return other < 0 || other >= result.height || other >= y;
+    };
+    for (int y = 0; y < result.height;)
+    {
+        if (!evaluated(y))
+        {
+            ++y;
+            continue;
+        }
+        int end{y + 1};
+        while (end < result.height && evaluated(end))
+        {
+            ++end;
+        }
+        PixelResult *rows{&result.pixels[static_cast<std::size_t>(y) * result.width]};
+        result.stats.iterations += renderer.render(0, y, result.width, end - y, rows);
+        result.stats.pixels += static_cast<std::uint64_t>(end - y) * result.width;
+        y = end;
+    }
+    result.histogram = renderer.histogram();
+    for (int y = 0; y < result.height; ++y)
+    {
+        if (evaluated(y))
+        {
+            continue;
+        }
+        const PixelResult *source{&result.pixels[static_cast<std::size_t>(*mirror - y) * result.width]};
+        PixelResult *target{&result.pixels[static_cast<std::size_t>(y) * result.width]};
+        for (int x = 0; x < result.width; ++x)
+        {
+            target[x] = {source[x].iterations, {source[x].z.re, -source[x].z.im}, source[x].escaped,
+                {source[x].dz.re, -source[x].dz.im}};
+        }
+        if (options.histogram)
+        {
+            for (int x = 0; x < result.width; ++x)
+            {
+                result.histogram.add(target[x]);
+            }
+        }
+        result.stats.mirrored += result.width;
+    }
+    result.stats.elapsed = Clock::now() - start;
+    return result;
+}
+
+} // namespace formula::renderer
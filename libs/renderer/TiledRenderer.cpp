@@ -0,0 +1,321 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/TiledRenderer.h>
+
+#include <formula/renderer/RawIterations.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace formula::renderer
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct TileGrid
+{
+    int columns;
+    int rows;
+    int tile_width;
+    int tile_height;
+};
+
+TileGrid tile_grid(const Viewport &viewport, const TileOptions &tiles)
+{
+    const int width{std::max(1, tiles.tile_width)};
+    const int height{std::max(1, tiles.tile_height)};
+    return {(viewport.pixel_width + width - 1) / width, (viewport.pixel_height + height - 1) / height, width, height};
+}
+
+// Marks the tiles that an earlier run completed; chunks that aren't whole tiles of this grid don't count.
+std::vector<bool> completed_tiles(const TileGrid &grid, const Viewport &viewport, const RawIterationIndex &index)
+{
+    std::vector<bool> result(static_cast<std::size_t>(grid.columns) * grid.rows);
+    for (const RawIterationChunkInfo &chunk : index.chunks)
+    {
+        if (chunk.x % grid.tile_width != 0 || chunk.y % grid.tile_height != 0)
+        {
+            continue;
+        }
+        const int column{chunk.x / grid.tile_width};
+        const int row{chunk.y / grid.tile_height};
+        if (chunk.width == std::min(grid.tile_width, viewport.pixel_width - chunk.x) &&
+            chunk.height == std::min(grid.tile_height, viewport.pixel_height - chunk.y))
+        {
+            result[static_cast<std::size_t>(row) * grid.columns + column] = true;
+        }
+    }
+    return result;
+}
+
+// 64-bit FNV-1a.
+class Fingerprint
+{
+public:
+    void add_bytes(const void *data, std::size_t size)
+    {
+        const unsigned char *bytes{static_cast<const unsigned char *>(data)};
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            m_hash = (m_hash ^ bytes[i]) * 0x100000001b3ULL;
+        }
+    }
+    template <typename T>
+    void add(T value)
+    {
+        add_bytes(&value, sizeof(value));
+    }
+    void add(const std::string &value)
+    {
+        add(static_cast<std::uint64_t>(value.size()));
+        add_bytes(value.data(), value.size());
+    }
+    void add(Complex value)
+    {
+        add(value.re);
+        add(value.im);
+    }
+
+    std::uint64_t value() const
+    {
+        return m_hash;
+    }
+
+private:
+    std::uint64_t m_hash{0xcbf29ce484222325ULL};
+};
+
+} // namespace
+
+std::uint64_t render_fingerprint(const RenderFormula &formula, Backend backend, const RenderOptions &options)
+{
+    Fingerprint result;
+    result.add(formula.body);
+    result.add(static_cast<int>(formula.dialect));
+    result.add(static_cast<std::uint64_t>(formula.values.size()));
+    for (const auto &[name, value] : formula.values)
+    {
+        result.add(name);
+        result.add(value);
+    }
+    result.add(static_cast<std::uint64_t>(formula.functions.size()));
+    for (const auto &[selector, function] : formula.functions)
+    {
+        result.add(selector);
+        result.add(function);
+    }
+    result.add(formula.random_seed);
+    result.add(formula.derivative);
+    const Viewport &viewport{options.viewport};
+    result.add(viewport.center);
+    result.add(viewport.width);
+    result.add(viewport.pixel_width);
+    result.add(viewport.pixel_height);
+    result.add(options.max_iterations);
+    result.add(static_cast<int>(backend));
+    return result.value();
+}
+
+TiledRenderStats render_tiled(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const TileOptions &tiles, const std::string &path)
+{
+    const Viewport &viewport{options.viewport};
+    const TileGrid grid{tile_grid(viewport, tiles)};
+    const RawIterationHeader header{viewport.pixel_width, viewport.pixel_height, options.max_iterations,
+        render_fingerprint(formula, backend, options)};
+    TiledRenderStats stats;
+    stats.tiles = grid.columns * grid.rows;
+
+    std::vector<bool> done(static_cast<std::size_t>(stats.tiles));
+    std::optional<RawIterationIndex> existing;
+    if (std::filesystem::exists(path))
+    {
+        std::ifstream in{path, std::ios::binary};
+        existing = index_raw_iterations(in);
+        const RawIterationHeader &previous{existing->header};
+        if (previous.width != header.width || previous.height != header.height ||
+            previous.max_iterations != header.max_iterations || previous.fingerprint != header.fingerprint)
+        {
+            throw std::runtime_error(path + " was written for a different render; remove it to start over");
+        }
+        done = completed_tiles(grid, viewport, *existing);
+    }
+    stats.resumed_tiles = static_cast<int>(std::count(done.begin(), done.end(), true));
+    if (stats.resumed_tiles == stats.tiles)
+    {
+        return stats;
+    }
+
+    // Create the evaluators before touching the file, so a backend that can't be used leaves no header
+    // behind for a different backend to trip over.
+    RegionRenderer renderer{formula, backend, options};
+    stats.render.threads = renderer.threads();
+    stats.render.setup = renderer.setup();
+    std::ofstream out;
+    if (existing)
+    {
+        std::filesystem::resize_file(path, static_cast<std::uintmax_t>(existing->end));
+        out.open(path, std::ios::binary | std::ios::app);
+    }
+    else
+    {
+        out.open(path, std::ios::binary);
+    }
+    if (!out)
+    {
+        throw std::runtime_error("Couldn't open " + path);
+    }
+    RawIterationWriter writer{
+        existing ? RawIterationWriter::append_to(out, *existing) : RawIterationWriter{out, header}};
+    const Clock::time_point start{Clock::now()};
+    std::vector<PixelResult> pixels;
+    for (int row = 0; row < grid.rows; ++row)
+    {
+        for (int column = 0; column < grid.columns; ++column)
+        {
+            if (done[static_cast<std::size_t>(row) * grid.columns + column])
+            {
+                continue;
+            }
+            const int x{column * grid.tile_width};
+            const int y{row * grid.tile_height};
+            const int width{std::min(grid.tile_width, viewport.pixel_width - x)};
+            const int height{std::min(grid.tile_height, viewport.pixel_height - y)};
+            pixels.resize(static_cast<std::size_t>(width) * height);
+            stats.render.iterations += renderer.render(x, y, width, height, pixels.data());
+            stats.render.pixels += pixels.size();
+            writer.write_chunk(x, y, width, height, pixels.data(), width);
+            if (!out.flush())
+            {
+                throw std::runtime_error("Couldn't write " + path);
+            }
+        }
+    }
+    stats.render.elapsed = Clock::now() - start;
+    return stats;
+}
+
+void write_streamed_image(std::istream &raw, std::ostream &out, ImageFormat format, const Coloring &coloring)
+{
+    if (coloring.palette.empty())
+    {
+        throw std::runtime_error("Empty palette");
+    }
+    const RawIterationIndex index{index_raw_iterations(raw)};
+    const RawIterationHeader &header{index.header};
+    std::vector<RawIterationChunkInfo> pending{index.chunks};
+    std::stable_sort(pending.begin(), pending.end(),
+        [](const RawIterationChunkInfo &lhs, const RawIterationChunkInfo &rhs) { return lhs.y < rhs.y; });
+
+    ImageStreamWriter writer{out, format, header.width, header.height};
+    std::list<RawIterationChunk> active;
+    auto next{pending.begin()};
+    std::vector<Color> row(static_cast<std::size_t>(header.width));
+    for (int y = 0; y < header.height; ++y)
+    {
+        active.remove_if([y](const RawIterationChunk &chunk) { return chunk.y + chunk.height <= y; });
+        for (; next != pending.end() && next->y <= y; ++next)
+        {
+            active.push_back(read_raw_chunk(raw, index, *next));
+        }
+        std::fill(row.begin(), row.end(), coloring.inside);
+        for (const RawIterationChunk &chunk : active)
+        {
+            const std::size_t first{static_cast<std::size_t>(y - chunk.y) * chunk.width};
+            for (int x = 0; x < chunk.width; ++x)
+            {
+                const PixelResult &pixel{chunk.pixels[first + x]};
+                row[static_cast<std::size_t>(chunk.x) + x] = color_of(coloring, pixel.escaped,
+                    coloring.smooth ? static_cast<double>(chunk.smooth[first + x]) : pixel.iterations);
+            }
+        }
+        writer.write_row(row.data());
+    }
+    writer.finish();
+}
+
+RenderStats render_streamed(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const Coloring &coloring, std::ostream &out, ImageFormat format, int band_height)
+{
+    if (coloring.palette.empty())
+    {
+        throw std::runtime_error("Empty palette");
+    }
+    const Viewport &viewport{options.viewport};
+    band_height = std::max(1, band_height);
+    ImageStreamWriter writer{out, format, viewport.pixel_width, viewport.pixel_height};
+    RegionRenderer renderer{formula, backend, options};
+    RenderStats stats;
+    stats.threads = renderer.threads();
+    stats.setup = renderer.setup();
+
+    const Clock::time_point start{Clock::now()};
+    std::vector<PixelResult> band;
+    std::vector<Color> row(static_cast<std::size_t>(viewport.pixel_width));
+    for (int y = 0; y < viewport.pixel_height; y += band_height)
+    {
+        const int rows{std::min(band_height, viewport.pixel_height - y)};
+        band.resize(static_cast<std::size_t>(viewport.pixel_width) * rows);
+        stats.iterations += renderer.render(0, y, viewport.pixel_width, rows, band.data());
+        stats.pixels += band.size();
+        for (int band_row = 0; band_row < rows; ++band_row)
+        {
+            const PixelResult *pixels{&band[static_cast<std::size_t>(band_row) * viewport.pixel_width]};
+            for (int x = 0; x < viewport.pixel_width; ++x)
+            {
+                const PixelResult &pixel{pixels[x]};
+                row[x] = color_of(
+                    coloring, pixel.escaped, coloring.smooth ? smooth_iterations(pixel) : pixel.iterations);
+            }
+            writer.write_row(row.data());
+        }
+    }
+    writer.finish();
+    stats.elapsed = Clock::now() - start;
+    return stats;
+}
+
+RenderStats render_equalized(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const Coloring &coloring, std::ostream &out, ImageFormat format)
+{
+    if (coloring.palette.empty())
+    {
+        throw std::runtime_error("Empty palette");
+    }
+    RenderOptions counted{options};
+    counted.histogram = true;
+    const RenderResult result{render(formula, backend, counted)};
+
+    const Clock::time_point start{Clock::now()};
+    Coloring equalized{coloring};
+    equalized.equalization = cumulative_distribution(result.histogram);
+    ImageStreamWriter writer{out, format, result.width, result.height};
+    std::vector<Color> row(static_cast<std::size_t>(result.width));
+    for (int y = 0; y < result.height; ++y)
+    {
+        for (int x = 0; x < result.width; ++x)
+        {
+            const PixelResult &pixel{result.at(x, y)};
+            row[x] = color_of(
+                equalized, pixel.escaped, equalized.smooth ? smooth_iterations(pixel) : pixel.iterations);
+        }
+        writer.write_row(row.data());
+    }
+    writer.finish();
+    RenderStats stats{result.stats};
+    stats.elapsed += Clock::now() - start;
+    return stats;
+}
+
+} // namespace formula::renderer
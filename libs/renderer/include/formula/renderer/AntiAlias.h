@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/renderer/Image.h>
+#include <formula/renderer/Renderer.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace formula::renderer
+{
+
+// Adaptive anti-aliasing: a pixel is supersampled only when it differs from one of its eight neighbors.
+struct AntiAliasOptions
+{
+    int samples{4};             // jittered samples along each axis of a refined pixel
+    int color_threshold{16};    // largest channel difference to a neighbor that doesn't refine a pixel
+    int iteration_threshold{8}; // largest iteration count difference that doesn't refine a pixel
+};
+
+struct AntiAliasResult
+{
+    Image image;
+    RenderStats stats;       // both passes; pixels adds the refined pixels to the first pass
+    std::uint64_t refined{}; // pixels that were supersampled
+};
+
+// Marks the pixels to supersample: those whose escape status differs from a neighbor, or whose color or
+// iteration count differs from a neighbor by more than the thresholds.
+std::vector<bool> refined_pixels(const RenderResult &result, const Image &image, const AntiAliasOptions &options);
+
+// Renders one sample per pixel, then replaces each refined pixel by the average color of samples x samples
+// stratified samples, each jittered within its cell.  The jitter is drawn from the counter-based generator
+// behind rand keyed by the formula's seed and the pixel, so the image doesn't depend on the thread count.
+// Throws std::runtime_error when an evaluator can't be created or the palette is empty.
+AntiAliasResult render_antialiased(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const Coloring &coloring, const AntiAliasOptions &antialias);
+
+} // namespace formula::renderer
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/renderer/PixelEvaluator.h>
+#include <formula/semantics/ClassicFormula.h>
+
+#include <optional>
+
+namespace formula::renderer
+{
+
+// The classic formula formula iterates, or nullopt when semantic::recognize_classic_formula doesn't
+// recognize it or the render needs something the kernels don't provide, such as the derivative.  The
+// kernels and the formula backends both report the iterated variable in PixelResult::z, whatever its name.
+std::optional<semantic::ClassicFormula> recognize_classic_formula(const RenderFormula &formula);
+
+// Creates an evaluator that iterates formula with hand-written code.  Several pixels are iterated side
+// by side, and a pixel that finishes hands its lane to the next one.  Results match the formula backends
+// except for pixels that never escape: the Mandelbrot kernel finds pixels in the main cardioid and the
+// period-2 bulb without iterating them, and every kernel stops an orbit that returns to an earlier point,
+// so those pixels report max_iterations with the last value computed rather than the value after
+// max_iterations.  A pixel skipped by the cardioid and bulb check reports its starting value.
+PixelEvaluatorPtr create_classic_evaluator(const semantic::ClassicFormula &formula);
+
+} // namespace formula::renderer
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/parser/Gradient.h>
+#include <formula/renderer/Renderer.h>
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace formula::renderer
+{
+
+struct Color
+{
+    std::uint8_t red{};
+    std::uint8_t green{};
+    std::uint8_t blue{};
+};
+
+inline bool operator==(const Color &lhs, const Color &rhs)
+{
+    return lhs.red == rhs.red && lhs.green == rhs.green && lhs.blue == rhs.blue;
+}
+
+inline bool operator!=(const Color &lhs, const Color &rhs)
+{
+    return !(lhs == rhs);
+}
+
+using Palette = std::vector<Color>;
+
+// A 256 entry palette that cycles smoothly through blue, white, orange and black.
+Palette default_palette();
+
+// Samples the 400 position Ultra Fractal gradient at size evenly spaced positions, interpolating linearly
+// between control points and wrapping around; rotation shifts the colors toward higher indices.
+// Throws std::runtime_error when the gradient has no control points.
+Palette gradient_palette(const gradient::GradientSection &gradient, int size = 400);
+
+// The continuous iteration count n + 1 - log2(ln |z|) of an escaped pixel, or the iteration count of
+// a pixel that didn't escape or stopped with |z| <= 1.
+double smooth_iterations(const PixelResult &pixel);
+
+// The exterior distance estimate |z| ln |z| / |dz| of an escaped pixel rendered with
+// RenderFormula::derivative, in the units of the complex plane; 0 for a pixel that didn't escape or
+// stopped with |z| <= 1, and infinity when dz is zero.
+double distance_estimate(const PixelResult &pixel);
+
+// How iteration data maps to colors.  The palette index is value * density + offset, where value is
+// the iteration count, or the smooth iteration count when smooth is set.  Histogram coloring replaces
+// value with its equalization entry times the palette size, so each palette entry covers about as many
+// escaped pixels as any other.
+struct Coloring
+{
+    Palette palette{default_palette()};
+    Color inside{};
+    bool smooth{};
+    double density{1.0};
+    double offset{};
+    std::vector<double> equalization; // cumulative_distribution of the image; empty colors linearly
+};
+
+// The equalization table of a histogram: entry n is the fraction of escaped pixels that escaped after
+// fewer than n iterations, so the last entry is 1.  Empty when no pixel escaped.
+std::vector<double> cumulative_distribution(const IterationHistogram &histogram);
+
+// The color of one pixel from its escape flag and iteration value; smooth colorings blend adjacent
+// palette entries by the fractional part of the palette index.  Equalized values between two iteration
+// counts interpolate between their table entries.
+Color color_of(const Coloring &coloring, bool escaped, double value);
+
+struct Image
+{
+    int width{};
+    int height{};
+    std::vector<Color> pixels; // row-major, row 0 at the top
+
+    const Color &at(int x, int y) const
+    {
+        return pixels[static_cast<std::size_t>(y) * width + x];
+    }
+};
+
+// Escaped pixels take palette[iterations % palette.size()]; pixels that never escaped take inside.
+Image colorize(const RenderResult &result, const Palette &palette, Color inside = {});
+Image colorize(const RenderResult &result, const Coloring &coloring);
+
+enum class ImageFormat
+{
+    PPM,
+    PNG,
+};
+
+// The format named by a file extension, .png or .ppm in any case.
+std::optional<ImageFormat> image_format(std::string_view filename);
+
+// Writes an image one row at a time, top to bottom, so only the current row has to be in memory.
+// PNG rows are deflated as they arrive and written out in IDAT chunks.
+class ImageStreamWriter
+{
+public:
+    // Writes the file header; throws std::runtime_error for an empty image.
+    ImageStreamWriter(std::ostream &out, ImageFormat format, int width, int height);
+    ImageStreamWriter(const ImageStreamWriter &rhs) = delete;
+    ImageStreamWriter(ImageStreamWriter &&rhs) = delete;
+    ~ImageStreamWriter();
+    ImageStreamWriter &operator=(const ImageStreamWriter &rhs) = delete;
+    ImageStreamWriter &operator=(ImageStreamWriter &&rhs) = delete;
+
+    // Appends the next row of width colors; throws std::runtime_error past the last row.
+    void write_row(const Color *row);
+
+    // Completes the file; throws std::runtime_error when rows are missing or compression fails.
+    void finish();
+
+    int rows_written() const
+    {
+        return m_rows;
+    }
+
+private:
+    struct Deflate;
+    void deflate_bytes(const std::string &bytes, bool last);
+
+    std::ostream &m_out;
+    ImageFormat m_format;
+    int m_width;
+    int m_height;
+    int m_rows{};
+    std::unique_ptr<Deflate> m_deflate;
+};
+
+// Binary (P6) portable pixmap; throws std::runtime_error for an empty image.
+void write_ppm(std::ostream &out, const Image &image);
+
+// 8-bit RGB PNG compressed with zlib; throws std::runtime_error for an empty image or when compression
+// fails.
+void write_png(std::ostream &out, const Image &image);
+
+// Writes the image in the format named by the file extension; throws std::runtime_error on failure.
+void write_image(const std::string &filename, const Image &image);
+
+} // namespace formula::renderer
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/core/Complex.h>
+#include <formula/renderer/Image.h>
+#include <formula/renderer/Renderer.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace formula::renderer
+{
+
+// Orbit density (Buddhabrot) rendering: instead of coloring each pixel by its own orbit, sample pixels are
+// drawn from a region of the plane and every point of each escaping orbit adds to the image pixel it lands in.
+
+enum class OrbitSampling
+{
+    RANDOM,     // independent uniform samples
+    STRATIFIED, // one jittered sample in each cell of an evenly divided region
+};
+
+struct OrbitDensityOptions
+{
+    Complex center{};    // center of the region samples are drawn from
+    double width{4.0};   // extent of the region's real axis
+    double height{4.0};  // extent of the region's imaginary axis
+    std::uint64_t samples{1000000};
+    OrbitSampling sampling{OrbitSampling::RANDOM};
+    int min_iterations{}; // orbits that escape after fewer iterations aren't recorded
+    // Cells along each axis of the importance map; 0 samples the region evenly.  Each cell is probed with a
+    // few orbits first, and cells whose probes put more points in the image are sampled more often.
+    int importance_grid{};
+};
+
+struct OrbitDensityResult
+{
+    int width{};
+    int height{};
+    // Orbit points per pixel, row-major.  With importance sampling each sample's points are weighted by the
+    // inverse of its relative sampling density, so the result estimates the evenly sampled one.
+    std::vector<double> density;
+    RenderStats stats; // pixels counts the samples, and iterations their loop sections
+};
+
+// The sampling weight of every cell of the importance map, row-major with row 0 at the top; the mean weight
+// is 1.  Every cell keeps a small share of the weight so no part of the region goes unsampled.
+std::vector<double> orbit_importance(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const OrbitDensityOptions &density);
+
+// Iterates the samples on options.threads threads, each adding the orbits it traces to a grid of its own;
+// the grids are merged when every sample is done.  Samples are drawn from the counter-based generator behind
+// rand keyed by the formula's seed and the sample index, so the result doesn't depend on the thread count.
+// Throws std::runtime_error when an evaluator can't be created.
+OrbitDensityResult render_orbit_density(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const OrbitDensityOptions &density);
+
+// Colors an orbit density: a pixel with density d takes palette index sqrt(d / max) * (palette size - 1),
+// scaled and offset like an iteration count, and pixels no orbit reached take the inside color.
+// Throws std::runtime_error for an empty palette.
+Image colorize(const OrbitDensityResult &result, const Coloring &coloring);
+
+} // namespace formula::renderer
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/core/Cancellation.h>
+#include <formula/core/Complex.h>
+#include <formula/core/Dialect.h>
+#include <formula/facade/Formula.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace formula::renderer
+{
+
+enum class Backend
+{
+    INTERPRETER, // ast::interpret through Formula::interpret
+    COMPILER,    // asmjit code through Formula::run
+    EXTENDED,    // ExtendedInterpreter
+    KERNEL,      // hand-written kernels for classic formulas, see ClassicKernel.h; otherwise COMPILER
+};
+
+std::string_view to_string(Backend value);
+
+// Everything needed to create an independent evaluator for a formula, so each render thread can own one.
+struct RenderFormula
+{
+    std::string name;
+    std::string body;
+    Dialect dialect{Dialect::BASIC};
+    std::map<std::string, Complex> values;         // symbol name -> value, e.g. p1
+    std::map<std::string, std::string> functions; // selector -> function, e.g. fn1 -> sin
+    std::uint32_t random_seed{};                  // client seed for rand
+    bool derivative{};                            // track dz/dpixel, see Formula::enable_derivative
+};
+
+// The outcome of iterating a single pixel.  iterations counts the loop iterations that passed the
+// bailout test, so a pixel that never escapes reports max_iterations.
+struct PixelResult
+{
+    int iterations{};
+    Complex z{};
+    bool escaped{};
+    Complex dz{}; // dz/dpixel when RenderFormula::derivative is set
+};
+
+class PixelEvaluator
+{
+public:
+    virtual ~PixelEvaluator() = default;
+
+    // Selects the rand stream for the following evaluations; the renderer uses the pixel index so
+    // images don't depend on which thread evaluates which pixel.
+    virtual void set_random_stream(std::uint64_t stream) = 0;
+
+    // Following evaluations throw CancelledError once token is cancelled; nullptr stops checking.
+    virtual void set_cancellation(const CancellationToken *token) = 0;
+
+    // Runs the init section and then the loop and bailout sections until escape or max_iterations.
+    virtual PixelResult evaluate(Complex pixel, int max_iterations) = 0;
+
+    // Evaluates count pixels, pixel i with rand stream streams[i].  Backends may override this to keep
+    // the whole batch, and each orbit, inside one call; the default evaluates the pixels one at a time.
+    virtual void evaluate_batch(const Complex *pixels, const std::uint64_t *streams, PixelResult *results,
+        std::size_t count, int max_iterations);
+
+    // Like evaluate, also storing z after every iteration in orbit, which is cleared first.  An orbit that
+    // escapes ends with the value that failed the bailout test.  Evaluators that stop orbits which provably
+    // never escape, such as the classic kernels, may store only part of those orbits.
+    virtual PixelResult evaluate_orbit(Complex pixel, int max_iterations, std::vector<Complex> &orbit) = 0;
+};
+
+using PixelEvaluatorPtr = std::unique_ptr<PixelEvaluator>;
+
+// Throws std::runtime_error when the formula can't be parsed or compiled for the backend, or has no
+// derivative when one is requested; the EXTENDED backend doesn't support derivatives.
+// The COMPILER backend names its JIT symbols after the formula unless compile_options names them.
+PixelEvaluatorPtr create_evaluator(
+    const RenderFormula &formula, Backend backend, const CompileOptions &compile_options = {});
+
+// Creates count independent evaluators.  The COMPILER backend compiles them concurrently with
+// Formula::compile_async and returns once all are ready.
+std::vector<PixelEvaluatorPtr> create_evaluators(
+    const RenderFormula &formula, Backend backend, int count, const CompileOptions &compile_options = {});
+
+} // namespace formula::renderer
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/renderer/Image.h>
+#include <formula/renderer/Renderer.h>
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace formula::renderer
+{
+
+// Raw iteration files keep the per-pixel results of a render so it can be recolored without iterating
+// again.  A file is a header followed by independently zlib-compressed chunks, each covering a rectangle
+// of the image in any order.  Values are stored in the writer's byte order, which the header records.
+struct RawIterationHeader
+{
+    int width{};
+    int height{};
+    int max_iterations{};
+    std::uint64_t fingerprint{}; // identifies the render inputs, see render_fingerprint; 0 when unknown
+};
+
+// The pixels of one rectangle, row-major within the rectangle.
+struct RawIterationChunk
+{
+    int x{};
+    int y{};
+    int width{};
+    int height{};
+    std::vector<PixelResult> pixels;
+    std::vector<float> smooth; // smooth_iterations of each pixel
+};
+
+// Where a chunk is stored in a raw iteration file, without its data.
+struct RawIterationChunkInfo
+{
+    int x{};
+    int y{};
+    int width{};
+    int height{};
+    std::streamoff offset{}; // start of the chunk header
+};
+
+struct RawIterationIndex
+{
+    RawIterationHeader header;
+    std::vector<RawIterationChunkInfo> chunks;
+    std::streamoff end{}; // end of the last complete chunk; anything after it is a partly written chunk
+};
+
+class RawIterationWriter
+{
+public:
+    // Writes the header; throws std::runtime_error for an empty image.
+    RawIterationWriter(std::ostream &out, const RawIterationHeader &header);
+
+    // Continues an existing file; out must be positioned at existing.end.
+    static RawIterationWriter append_to(std::ostream &out, const RawIterationIndex &existing);
+
+    // Compresses and appends a rectangle whose rows start stride pixels apart in pixels.
+    // Throws std::runtime_error when the rectangle is outside the image or compression fails.
+    void write_chunk(int x, int y, int width, int height, const PixelResult *pixels, int stride);
+
+private:
+    RawIterationWriter(std::ostream &out, const RawIterationHeader &header, bool write_header);
+
+    std::ostream &m_out;
+    RawIterationHeader m_header;
+};
+
+class RawIterationReader
+{
+public:
+    // Reads the header; throws std::runtime_error when the stream isn't a raw iteration file.
+    explicit RawIterationReader(std::istream &in);
+
+    const RawIterationHeader &header() const
+    {
+        return m_header;
+    }
+
+    // Reads and decompresses the next chunk; returns false at the end of the file.
+    // Throws std::runtime_error for a truncated or corrupt chunk.
+    bool next(RawIterationChunk &chunk);
+
+private:
+    std::istream &m_in;
+    RawIterationHeader m_header;
+};
+
+// Scans the chunk headers of a raw iteration file, skipping their data.  A truncated final chunk, as left by
+// an interrupted writer, ends the index instead of throwing; anything else invalid throws std::runtime_error.
+RawIterationIndex index_raw_iterations(std::istream &in);
+
+// Reads and decompresses the indexed chunk; throws std::runtime_error for a corrupt chunk.
+RawIterationChunk read_raw_chunk(std::istream &in, const RawIterationIndex &index, const RawIterationChunkInfo &chunk);
+
+// Writes every pixel of result in chunks of rows_per_chunk full rows.
+void write_raw_iterations(std::ostream &out, const RenderResult &result, int max_iterations, int rows_per_chunk = 64);
+
+// Reads a whole raw iteration file back into a render result without statistics.
+RenderResult read_raw_iterations(std::istream &in);
+
+// Colors a raw iteration file chunk by chunk on threads workers, or every hardware thread when threads
+// is 0, without rebuilding the pixel results.  Pixels no chunk covers take the inside color.
+Image recolor(std::istream &in, const Coloring &coloring, int threads = 0);
+
+// Counts the escaped pixels of a raw iteration file for histogram coloring, reading it chunk by chunk.
+IterationHistogram raw_histogram(std::istream &in);
+
+} // namespace formula::renderer
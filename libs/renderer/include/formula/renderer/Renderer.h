@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/core/Complex.h>
+#include <formula/renderer/PixelEvaluator.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace formula::renderer
+{
+
+// The region of the complex plane covered by an image.  Row 0 is the top of the image, so the
+// imaginary coordinate decreases as the row increases.
+struct Viewport
+{
+    Complex center{};
+    double width{4.0}; // extent of the real axis covered by the image
+    int pixel_width{640};
+    int pixel_height{480};
+};
+
+// The complex coordinate of image position (x, y); pixel centers are at half-integer positions.
+Complex pixel_location(const Viewport &viewport, double x, double y);
+
+struct RenderOptions
+{
+    Viewport viewport;
+    int max_iterations{256};
+    int threads{}; // 0 uses every hardware thread
+    CompileOptions compile; // JIT symbol output for the COMPILER backend
+    bool symmetry{};        // render mirrored rows of conjugate-symmetric formulas only once
+    const CancellationToken *cancellation{}; // stops rendering with CancelledError once cancelled
+    bool histogram{}; // count escaped pixels into RenderResult::histogram
+};
+
+// Escaped pixels counted by iteration count, the first pass of histogram coloring.
+struct IterationHistogram
+{
+    std::vector<std::uint64_t> counts; // counts[n] is the pixels that escaped after n iterations
+
+    void add(const PixelResult &pixel);
+    void merge(const IterationHistogram &other);
+    std::uint64_t total() const;
+};
+
+struct RenderStats
+{
+    int threads{};
+    std::uint64_t pixels{};   // pixels evaluated
+    std::uint64_t mirrored{}; // pixels copied from their mirror image instead of evaluated
+    std::uint64_t iterations{}; // loop sections executed, including each escaping iteration
+    std::chrono::duration<double> setup{};   // creating one evaluator per thread
+    std::chrono::duration<double> elapsed{}; // iterating pixels, excluding setup
+};
+
+double pixels_per_second(const RenderStats &stats);
+double iterations_per_second(const RenderStats &stats);
+
+struct RenderResult
+{
+    int width{};
+    int height{};
+    std::vector<PixelResult> pixels; // row-major
+    RenderStats stats;
+    IterationHistogram histogram; // every pixel when rendered with RenderOptions::histogram
+
+    const PixelResult &at(int x, int y) const
+    {
+        return pixels[static_cast<std::size_t>(y) * width + x];
+    }
+};
+
+// The evaluators of one render, one per thread, created once and reused for every region of the image.
+class RegionRenderer
+{
+public:
+    // Throws std::runtime_error when an evaluator can't be created.
+    RegionRenderer(const RenderFormula &formula, Backend backend, const RenderOptions &options);
+
+    // Renders a rectangle of the viewport into pixels, row-major with the rectangle's width, distributing
+    // rows across the threads.  Returns the loop sections executed.  An exception on any thread stops the
+    // region and is rethrown, including the CancelledError of a cancelled options.cancellation.  With
+    // options.histogram, each thread also counts the pixels it renders into a histogram of its own.
+    std::uint64_t render(int x, int y, int width, int height, PixelResult *pixels);
+
+    // Calls item(evaluator, index) for every index in [0, count), handing indices out dynamically to the
+    // threads.  item returns the loop sections it executed and the total is returned.  An exception on any
+    // thread stops the remaining items and is rethrown.
+    std::uint64_t run(int count, const std::function<std::uint64_t(PixelEvaluator &, int)> &item);
+
+    // run, with item given the slot of its thread in [0, threads()) instead of the evaluator, so per-thread
+    // state can be kept without locks.  The thread in a slot always uses evaluator(slot).
+    std::uint64_t run_slots(int count, const std::function<std::uint64_t(std::size_t, int)> &item);
+
+    PixelEvaluator &evaluator(std::size_t slot)
+    {
+        return *m_evaluators[slot];
+    }
+
+    const RenderOptions &options() const
+    {
+        return m_options;
+    }
+
+    int threads() const
+    {
+        return static_cast<int>(m_evaluators.size());
+    }
+    std::chrono::duration<double> setup() const
+    {
+        return m_setup;
+    }
+
+    // The per-thread histograms of every region rendered so far, merged; empty without options.histogram.
+    IterationHistogram histogram() const;
+
+private:
+    RenderOptions m_options;
+    std::vector<PixelEvaluatorPtr> m_evaluators;
+    std::vector<IterationHistogram> m_histograms; // one per evaluator, written only by its thread
+    std::chrono::duration<double> m_setup{};
+};
+
+// The sum of the two rows of every mirrored pair when the viewport's pixel rows lie symmetrically about
+// the real axis, i.e. row y shows the conjugates of row sum - y.  Empty when no row lines up.
+std::optional<int> mirror_row_sum(const Viewport &viewport);
+
+// Renders every pixel of the viewport, distributing rows across threads that each own an evaluator.
+// With options.symmetry, a formula that is provably symmetric about the real axis has only one row of
+// each mirrored pair evaluated; the other row gets the conjugate results.  With options.histogram, the
+// result's histogram counts every pixel, mirrored ones included.
+RenderResult render(const RenderFormula &formula, Backend backend, const RenderOptions &options);
+
+} // namespace formula::renderer
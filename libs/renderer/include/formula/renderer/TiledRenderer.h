@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/renderer/Image.h>
+#include <formula/renderer/Renderer.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace formula::renderer
+{
+
+// Out-of-core rendering for images larger than memory: only the tile or band being rendered is held.
+
+struct TileOptions
+{
+    int tile_width{256};
+    int tile_height{256};
+};
+
+struct TiledRenderStats
+{
+    RenderStats render;  // pixels and iterations cover the tiles rendered by this call
+    int tiles{};         // tiles in the image
+    int resumed_tiles{}; // tiles already complete in the file
+};
+
+// A hash of everything that decides the pixels of a render: the formula's body, dialect, values, functions,
+// random seed and derivative flag, the viewport, the iteration limit and the backend.
+std::uint64_t render_fingerprint(const RenderFormula &formula, Backend backend, const RenderOptions &options);
+
+// Renders the viewport tile by tile, appending each finished tile to the raw iteration file at path and
+// flushing it.  An existing file with the same render_fingerprint is resumed: its complete tiles are kept,
+// a partly written final tile is discarded and only the missing tiles are rendered.  Throws
+// std::runtime_error when the file belongs to a different render or can't be written.  Cancelling
+// options.cancellation throws CancelledError; the tiles flushed before it are resumed by the next call.
+TiledRenderStats render_tiled(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const TileOptions &tiles, const std::string &path);
+
+// Colors a raw iteration file into a streamed image in row order, decoding only the chunks that overlap
+// the current row.  Pixels no chunk covers take the inside color.
+void write_streamed_image(std::istream &raw, std::ostream &out, ImageFormat format, const Coloring &coloring);
+
+// Renders bands of band_height rows in order and streams each to the image as soon as it is complete.
+RenderStats render_streamed(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const Coloring &coloring, std::ostream &out, ImageFormat format, int band_height = 64);
+
+// Histogram coloring in two passes.  The first renders every pixel, each thread counting its pixels into a
+// histogram of its own; the second colors the pixels through the merged histogram's cumulative
+// distribution and streams them to the image row by row without building it in memory.
+RenderStats render_equalized(const RenderFormula &formula, Backend backend, const RenderOptions &options,
+    const Coloring &coloring, std::ostream &out, ImageFormat format);
+
+} // namespace formula::renderer
@@ -0,0 +1,354 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/semantics/ClassicFormula.h>
+
+#include <formula/semantics/Simplifier.h>
+
+#include <formula/core/functions.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <exception>
+#include <variant>
+
+using namespace formula::ast;
+
+namespace formula::semantic
+{
+
+namespace
+{
+
+// Built-in identifiers whose values change per pixel or per iteration, or that the renderer binds.
+constexpr std::array<std::string_view, 7> VARYING_IDENTIFIERS{
+    "lastsqr", "maxit", "pixel", "rand", "scrnmax", "scrnpix", "whitesq"};
+
+Expr single_statement(const Expr &section)
+{
+    if (const auto *seq = dynamic_cast<const StatementSeqNode *>(section.get()))
+    {
+        return seq->statements().size() == 1 ? seq->statements().front() : nullptr;
+    }
+    return section;
+}
+
+// The simplifier only handles double literals, so anything it can't fold is matched as written.
+Expr simplified(const Expr &expr)
+{
+    try
+    {
+        return simplify(expr);
+    }
+    catch (const std::exception &)
+    {
+        return expr;
+    }
+}
+
+std::optional<double> real_literal(const Node *node)
+{
+    const auto *literal{dynamic_cast<const LiteralNode *>(node)};
+    if (literal == nullptr)
+    {
+        return std::nullopt;
+    }
+    const LiteralNode::ValueType value{literal->value()};
+    if (const int *number = std::get_if<int>(&value))
+    {
+        return static_cast<double>(*number);
+    }
+    if (const double *number = std::get_if<double>(&value))
+    {
+        return *number;
+    }
+    return std::nullopt;
+}
+
+bool is_literal(const Node *node, double value)
+{
+    return real_literal(node) == value;
+}
+
+class Matcher
+{
+public:
+    Matcher(const std::map<std::string, Complex> &values, const std::map<std::string, std::string> &functions) :
+        m_values(values),
+        m_functions(functions)
+    {
+    }
+
+    void set_variable(const std::string &variable)
+    {
+        m_variable = variable;
+    }
+
+    bool is_identifier(const Node *node, std::string_view name) const
+    {
+        const auto *identifier{dynamic_cast<const IdentifierNode *>(node)};
+        return identifier != nullptr && identifier->name() == name;
+    }
+    bool is_variable(const Node *node) const
+    {
+        return is_identifier(node, m_variable);
+    }
+
+    // The function a one-argument call calls, after resolving fn1-fn4.
+    std::string called_function(const FunctionCallNode &call) const
+    {
+        return call.has_target() || call.args().size() != 1 ? std::string{} : select_function(call.name(), m_functions);
+    }
+    bool is_call_of_variable(const Node *node, std::string_view function) const
+    {
+        const auto *call{dynamic_cast<const FunctionCallNode *>(node)};
+        return call != nullptr && called_function(*call) == function && is_variable(call->arg().get());
+    }
+
+    std::optional<Complex> constant(const Node *node) const;
+
+    // Matches the squares of operand: x*x, sqr(x) and x^2.
+    template <typename Operand>
+    bool is_square(const Node *node, const Operand &operand) const;
+
+    bool is_cube(const Node *node) const;
+
+private:
+    const std::map<std::string, Complex> &m_values;
+    const std::map<std::string, std::string> &m_functions;
+    std::string m_variable;
+};
+
+std::optional<Complex> Matcher::constant(const Node *node) const
+{
+    if (const auto *literal = dynamic_cast<const LiteralNode *>(node))
+    {
+        if (const std::optional<double> number{real_literal(node)})
+        {
+            return Complex{*number, 0.0};
+        }
+        const LiteralNode::ValueType value{literal->value()};
+        if (const Complex *number = std::get_if<Complex>(&value))
+        {
+            return *number;
+        }
+        return std::nullopt;
+    }
+    if (const auto *unary = dynamic_cast<const UnaryOpNode *>(node); unary != nullptr && unary->op() == '-')
+    {
+        if (const std::optional<Complex> operand{constant(unary->operand().get())})
+        {
+            return Complex{-operand->re, -operand->im};
+        }
+        return std::nullopt;
+    }
+    const auto *identifier{dynamic_cast<const IdentifierNode *>(node)};
+    if (identifier == nullptr)
+    {
+        return std::nullopt;
+    }
+    const std::string &name{identifier->name()};
+    if (name == m_variable || std::find(VARYING_IDENTIFIERS.begin(), VARYING_IDENTIFIERS.end(), name) !=
+            VARYING_IDENTIFIERS.end())
+    {
+        return std::nullopt;
+    }
+    if (const auto it = m_values.find(name); it != m_values.end())
+    {
+        return it->second;
+    }
+    // The values every formula starts with; other unbound identifiers read as zero.
+    if (name == "e")
+    {
+        return Complex{std::exp(1.0), 0.0};
+    }
+    if (name == "pi")
+    {
+        return Complex{std::atan2(0.0, -1.0), 0.0};
+    }
+    if (name == "ismand")
+    {
+        return Complex{1.0, 0.0};
+    }
+    return Complex{};
+}
+
+template <typename Operand>
+bool Matcher::is_square(const Node *node, const Operand &operand) const
+{
+    if (const auto *call = dynamic_cast<const FunctionCallNode *>(node))
+    {
+        return called_function(*call) == "sqr" && operand(call->arg().get());
+    }
+    const auto *binary{dynamic_cast<const BinaryOpNode *>(node)};
+    if (binary == nullptr)
+    {
+        return false;
+    }
+    if (binary->op() == "*")
+    {
+        return operand(binary->left().get()) && operand(binary->right().get());
+    }
+    return binary->op() == "^" && operand(binary->left().get()) && is_literal(binary->right().get(), 2.0);
+}
+
+bool Matcher::is_cube(const Node *node) const
+{
+    const auto *binary{dynamic_cast<const BinaryOpNode *>(node)};
+    if (binary == nullptr)
+    {
+        return false;
+    }
+    if (binary->op() == "^")
+    {
+        return is_variable(binary->left().get()) && is_literal(binary->right().get(), 3.0);
+    }
+    const auto variable{[this](const Node *operand) { return is_variable(operand); }};
+    return binary->op() == "*" &&
+        ((is_square(binary->left().get(), variable) && is_variable(binary->right().get())) ||
+            (is_variable(binary->left().get()) && is_square(binary->right().get(), variable)));
+}
+
+const AssignmentNode *assignment(const Expr &statement)
+{
+    const auto *result{dynamic_cast<const AssignmentNode *>(statement.get())};
+    return result != nullptr && !result->variable().empty() ? result : nullptr;
+}
+
+bool match_step(const Matcher &matcher, const Node *step, const Node *addend, ClassicFormula &result)
+{
+    const bool pixel{matcher.is_identifier(addend, "pixel")};
+    const std::optional<Complex> constant{pixel ? std::nullopt : matcher.constant(addend)};
+    const auto variable{[&matcher](const Node *operand) { return matcher.is_variable(operand); }};
+    const auto absolute{[&matcher](const Node *operand) { return matcher.is_call_of_variable(operand, "abs"); }};
+    if (matcher.is_square(step, variable))
+    {
+        if (pixel)
+        {
+            result.kind = ClassicKind::MANDELBROT;
+            return true;
+        }
+        if (constant)
+        {
+            result.kind = ClassicKind::JULIA;
+            result.constant = *constant;
+            return true;
+        }
+        return false;
+    }
+    if (pixel && matcher.is_square(step, absolute))
+    {
+        result.kind = ClassicKind::BURNING_SHIP;
+        return true;
+    }
+    if (pixel && matcher.is_cube(step))
+    {
+        result.kind = ClassicKind::MANDEL3;
+        return true;
+    }
+    return false;
+}
+
+bool match_bailout(const Matcher &matcher, const Node *condition, ClassicFormula &result)
+{
+    const auto *binary{dynamic_cast<const BinaryOpNode *>(condition)};
+    if (binary == nullptr)
+    {
+        return false;
+    }
+    // |v| <= r and r >= |v| are the same test.
+    const bool reversed{binary->op() == ">" || binary->op() == ">="};
+    if (!reversed && binary->op() != "<" && binary->op() != "<=")
+    {
+        return false;
+    }
+    const Node *modulus{(reversed ? binary->right() : binary->left()).get()};
+    const Node *radius{(reversed ? binary->left() : binary->right()).get()};
+    const auto *unary{dynamic_cast<const UnaryOpNode *>(modulus)};
+    if (unary == nullptr || unary->op() != '|' || !matcher.is_variable(unary->operand().get()))
+    {
+        return false;
+    }
+    const std::optional<Complex> bailout{matcher.constant(radius)};
+    if (!bailout)
+    {
+        return false;
+    }
+    // Comparisons use real parts.
+    result.bailout = bailout->re;
+    result.inclusive = binary->op() == "<=" || binary->op() == ">=";
+    return true;
+}
+
+} // namespace
+
+std::string_view to_string(ClassicKind value)
+{
+    switch (value)
+    {
+    case ClassicKind::MANDELBROT:
+        return "mandelbrot";
+    case ClassicKind::JULIA:
+        return "julia";
+    case ClassicKind::BURNING_SHIP:
+        return "burning-ship";
+    case ClassicKind::MANDEL3:
+        return "mandel3";
+    }
+    return "unknown";
+}
+
+std::optional<ClassicFormula> recognize_classic_formula(const FormulaSections &formula,
+    const std::map<std::string, Complex> &values, const std::map<std::string, std::string> &functions)
+{
+    if (formula.per_image || formula.final || formula.transform || formula.type_switch ||
+        formula.public_members || formula.protected_members || formula.private_members || !formula.imports.empty())
+    {
+        return std::nullopt;
+    }
+    const AssignmentNode *init{assignment(single_statement(formula.initialize))};
+    const AssignmentNode *iterate{assignment(single_statement(formula.iterate))};
+    const Expr bailout{single_statement(formula.bailout)};
+    if (init == nullptr || iterate == nullptr || bailout == nullptr || init->variable() != iterate->variable())
+    {
+        return std::nullopt;
+    }
+
+    ClassicFormula result;
+    result.variable = iterate->variable();
+    Matcher matcher{values, functions};
+    matcher.set_variable(result.variable);
+
+    const Expr start{simplified(init->expression())};
+    if (matcher.is_identifier(start.get(), "pixel"))
+    {
+        result.start_at_pixel = true;
+    }
+    else if (const std::optional<Complex> value{matcher.constant(start.get())})
+    {
+        result.start = *value;
+    }
+    else
+    {
+        return std::nullopt;
+    }
+
+    const Expr step{simplified(iterate->expression())};
+    const auto *sum{dynamic_cast<const BinaryOpNode *>(step.get())};
+    if (sum == nullptr || sum->op() != "+" ||
+        (!match_step(matcher, sum->left().get(), sum->right().get(), result) &&
+            !match_step(matcher, sum->right().get(), sum->left().get(), result)))
+    {
+        return std::nullopt;
+    }
+
+    if (!match_bailout(matcher, simplified(bailout).get(), result))
+    {
+        return std::nullopt;
+    }
+    return result;
+}
+
+} // namespace formula::semantic
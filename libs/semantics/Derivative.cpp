@@ -0,0 +1,583 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/semantics/Derivative.h>
+
+#include <formula/core/functions.h>
+#include <formula/core/Visitor.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <optional>
+#include <set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace formula::ast;
+
+namespace formula::semantic
+{
+
+namespace
+{
+
+// Functions whose value depends on z and conj(z) separately, so they have no complex derivative.
+constexpr std::array<std::string_view, 11> NON_HOLOMORPHIC_FUNCTIONS{
+    "abs", "cabs", "ceil", "conj", "cosxx", "flip", "floor", "imag", "real", "round", "trunc"};
+
+// Operators whose result is piecewise constant, so their derivative is zero wherever it exists.
+constexpr std::array<std::string_view, 8> CONSTANT_OPERATORS{"<", "<=", ">", ">=", "==", "!=", "&&", "||"};
+
+template <std::size_t N>
+bool contains(const std::array<std::string_view, N> &names, std::string_view name)
+{
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+std::optional<double> real_literal(const Expr &node)
+{
+    const auto *literal = dynamic_cast<const LiteralNode *>(node.get());
+    if (literal == nullptr)
+    {
+        return std::nullopt;
+    }
+    const LiteralNode::ValueType value{literal->value()};
+    if (const int *integer = std::get_if<int>(&value); integer)
+    {
+        return *integer;
+    }
+    if (const double *real = std::get_if<double>(&value); real)
+    {
+        return *real;
+    }
+    if (const Complex *complex = std::get_if<Complex>(&value); complex && complex->im == 0.0)
+    {
+        return complex->re;
+    }
+    return std::nullopt;
+}
+
+// Derivatives are built with nullptr standing for zero, so constant subexpressions disappear instead of
+// being multiplied through.
+
+Expr literal(double value)
+{
+    return std::make_shared<LiteralNode>(value);
+}
+
+Expr zero_if_null(Expr node)
+{
+    return node ? std::move(node) : literal(0.0);
+}
+
+Expr binary(Expr lhs, char op, Expr rhs)
+{
+    return std::make_shared<BinaryOpNode>(std::move(lhs), op, std::move(rhs));
+}
+
+Expr call(const char *function, Expr arg)
+{
+    return std::make_shared<FunctionCallNode>(function, std::move(arg));
+}
+
+Expr negate(Expr node)
+{
+    return node ? std::make_shared<UnaryOpNode>('-', std::move(node)) : nullptr;
+}
+
+Expr add(Expr lhs, Expr rhs)
+{
+    if (!lhs)
+    {
+        return rhs;
+    }
+    return rhs ? binary(std::move(lhs), '+', std::move(rhs)) : lhs;
+}
+
+Expr subtract(Expr lhs, Expr rhs)
+{
+    if (!lhs)
+    {
+        return negate(std::move(rhs));
+    }
+    return rhs ? binary(std::move(lhs), '-', std::move(rhs)) : lhs;
+}
+
+Expr multiply(Expr lhs, Expr rhs)
+{
+    if (!lhs || !rhs)
+    {
+        return nullptr;
+    }
+    if (real_literal(lhs) == 1.0)
+    {
+        return rhs;
+    }
+    if (real_literal(rhs) == 1.0)
+    {
+        return lhs;
+    }
+    return binary(std::move(lhs), '*', std::move(rhs));
+}
+
+Expr divide(Expr lhs, Expr rhs)
+{
+    return lhs ? binary(std::move(lhs), '/', std::move(rhs)) : nullptr;
+}
+
+// A product rather than sqr(), which would also overwrite lastsqr.
+Expr square(const Expr &node)
+{
+    return binary(node, '*', node);
+}
+
+// d/du of the complex function at u, or nullptr when it isn't differentiable.
+Expr function_slope(std::string_view function, const Expr &u, bool &supported)
+{
+    const Expr one{literal(1.0)};
+    if (function == "ident")
+    {
+        return one;
+    }
+    if (function == "zero" || function == "one" || function == "srand")
+    {
+        return nullptr;
+    }
+    if (function == "sqr")
+    {
+        return multiply(literal(2.0), u);
+    }
+    if (function == "sqrt")
+    {
+        return divide(literal(0.5), call("sqrt", u));
+    }
+    if (function == "exp")
+    {
+        return call("exp", u);
+    }
+    if (function == "log")
+    {
+        return divide(one, u);
+    }
+    if (function == "sin")
+    {
+        return call("cos", u);
+    }
+    if (function == "cos")
+    {
+        return negate(call("sin", u));
+    }
+    if (function == "tan")
+    {
+        return divide(one, square(call("cos", u)));
+    }
+    if (function == "cotan")
+    {
+        return negate(divide(one, square(call("sin", u))));
+    }
+    if (function == "sinh")
+    {
+        return call("cosh", u);
+    }
+    if (function == "cosh")
+    {
+        return call("sinh", u);
+    }
+    if (function == "tanh")
+    {
+        return divide(one, square(call("cosh", u)));
+    }
+    if (function == "cotanh")
+    {
+        return negate(divide(one, square(call("sinh", u))));
+    }
+    if (function == "asin")
+    {
+        return divide(one, call("sqrt", subtract(one, square(u))));
+    }
+    if (function == "acos")
+    {
+        return negate(divide(one, call("sqrt", subtract(one, square(u)))));
+    }
+    if (function == "atan")
+    {
+        return divide(one, add(one, square(u)));
+    }
+    if (function == "asinh")
+    {
+        return divide(one, call("sqrt", add(square(u), one)));
+    }
+    if (function == "acosh")
+    {
+        return divide(one, multiply(call("sqrt", subtract(u, one)), call("sqrt", add(u, one))));
+    }
+    if (function == "atanh")
+    {
+        return divide(one, subtract(one, square(u)));
+    }
+    supported = false;
+    return nullptr;
+}
+
+class Differentiator : public Visitor
+{
+public:
+    Differentiator(const std::set<std::string> &variables, const std::map<std::string, std::string> &functions) :
+        m_variables(variables),
+        m_functions(functions)
+    {
+    }
+    ~Differentiator() override = default;
+
+    // The derivative of node with respect to pixel, nullptr when it is zero.
+    Expr derivative(const Expr &node)
+    {
+        m_result = nullptr;
+        if (node && m_supported)
+        {
+            node->visit(*this);
+        }
+        return std::move(m_result);
+    }
+    bool supported() const
+    {
+        return m_supported;
+    }
+
+    void visit(const AssignmentNode &node) override;
+    void visit(const BinaryOpNode &node) override;
+    void visit(const ConstantRefNode &) override
+    {
+        reject();
+    }
+    void visit(const DeclarationNode &) override
+    {
+        reject();
+    }
+    void visit(const FunctionBlockNode &) override
+    {
+        reject();
+    }
+    void visit(const FunctionDeclNode &) override
+    {
+        reject();
+    }
+    void visit(const FunctionCallNode &node) override;
+    void visit(const HeadingBlockNode &) override
+    {
+        reject();
+    }
+    void visit(const IdentifierNode &node) override;
+    void visit(const IfStatementNode &) override
+    {
+        reject();
+    }
+    void visit(const IndexNode &) override
+    {
+        reject();
+    }
+    void visit(const LiteralNode &) override
+    {
+    }
+    void visit(const MemberAccessNode &) override
+    {
+        reject();
+    }
+    void visit(const NewNode &) override
+    {
+        reject();
+    }
+    void visit(const ParamBlockNode &) override
+    {
+        reject();
+    }
+    void visit(const ParameterRefNode &) override
+    {
+        reject();
+    }
+    void visit(const RepeatUntilNode &) override
+    {
+        reject();
+    }
+    void visit(const ReturnNode &) override
+    {
+        reject();
+    }
+    void visit(const SettingNode &) override
+    {
+        reject();
+    }
+    void visit(const StatementSeqNode &) override
+    {
+        reject();
+    }
+    void visit(const UnaryOpNode &node) override;
+    void visit(const WhileNode &) override
+    {
+        reject();
+    }
+
+private:
+    void reject()
+    {
+        m_supported = false;
+    }
+
+    const std::set<std::string> &m_variables;
+    const std::map<std::string, std::string> &m_functions;
+    Expr m_result;
+    bool m_supported{true};
+};
+
+// v = e becomes __d_v = de; a chained assignment v = w = e becomes __d_v = __d_w = de.
+void Differentiator::visit(const AssignmentNode &node)
+{
+    if (node.variable().empty())
+    {
+        reject();
+        return;
+    }
+    m_result = std::make_shared<AssignmentNode>(
+        derivative_name(node.variable()), zero_if_null(derivative(node.expression())));
+}
+
+void Differentiator::visit(const BinaryOpNode &node)
+{
+    if (contains(CONSTANT_OPERATORS, node.op()))
+    {
+        return;
+    }
+    const Expr &left{node.left()};
+    const Expr &right{node.right()};
+    Expr d_left{derivative(left)};
+    Expr d_right{derivative(right)};
+    if (node.op() == "+")
+    {
+        m_result = add(d_left, d_right);
+    }
+    else if (node.op() == "-")
+    {
+        m_result = subtract(d_left, d_right);
+    }
+    else if (node.op() == "*")
+    {
+        m_result = add(multiply(d_left, right), multiply(left, d_right));
+    }
+    else if (node.op() == "/")
+    {
+        m_result = d_right ? divide(subtract(multiply(d_left, right), multiply(left, d_right)), square(right))
+                           : divide(d_left, right);
+    }
+    else if (node.op() == "^")
+    {
+        if (!d_right)
+        {
+            // d(u^n) = n u^(n-1) du
+            const std::optional<double> exponent{real_literal(right)};
+            Expr lowered{exponent ? literal(*exponent - 1.0) : binary(right, '-', literal(1.0))};
+            m_result = multiply(multiply(right, binary(left, '^', std::move(lowered))), d_left);
+        }
+        else
+        {
+            // d(u^v) = u^v (dv log(u) + v du / u)
+            m_result = multiply(binary(left, '^', right),
+                add(multiply(d_right, call("log", left)), divide(multiply(right, d_left), left)));
+        }
+    }
+    else
+    {
+        reject();
+    }
+}
+
+void Differentiator::visit(const FunctionCallNode &node)
+{
+    if (node.has_target() || node.args().size() != 1)
+    {
+        reject();
+        return;
+    }
+    const Expr &arg{node.arg()};
+    Expr d_arg{derivative(arg)};
+    if (!d_arg)
+    {
+        return;
+    }
+    const std::string function{select_function(node.name(), m_functions)};
+    if (contains(NON_HOLOMORPHIC_FUNCTIONS, function))
+    {
+        reject();
+        return;
+    }
+    m_result = multiply(function_slope(function, arg, m_supported), std::move(d_arg));
+}
+
+void Differentiator::visit(const IdentifierNode &node)
+{
+    if (node.name() == "pixel")
+    {
+        m_result = literal(1.0);
+    }
+    else if (node.name() == "lastsqr")
+    {
+        reject();
+    }
+    else if (m_variables.count(node.name()) != 0)
+    {
+        m_result = std::make_shared<IdentifierNode>(derivative_name(node.name()));
+    }
+    // Anything else is a parameter, a constant or rand, none of which depend on pixel.
+}
+
+void Differentiator::visit(const UnaryOpNode &node)
+{
+    switch (node.op())
+    {
+    case '+':
+        m_result = derivative(node.operand());
+        break;
+
+    case '-':
+        m_result = negate(derivative(node.operand()));
+        break;
+
+    case '!':
+        break;
+
+    default:
+        // |x| is real-valued, so only a constant operand has a derivative.
+        if (derivative(node.operand()))
+        {
+            reject();
+        }
+        break;
+    }
+}
+
+void collect_assigned(const Expr &node, std::set<std::string> &variables)
+{
+    if (const auto *assignment = dynamic_cast<const AssignmentNode *>(node.get()); assignment)
+    {
+        if (!assignment->variable().empty())
+        {
+            variables.insert(assignment->variable());
+        }
+        collect_assigned(assignment->expression(), variables);
+    }
+    else if (const auto *sequence = dynamic_cast<const StatementSeqNode *>(node.get()); sequence)
+    {
+        for (const Expr &statement : sequence->statements())
+        {
+            collect_assigned(statement, variables);
+        }
+    }
+    else if (const auto *branch = dynamic_cast<const IfStatementNode *>(node.get()); branch)
+    {
+        if (branch->has_then_block())
+        {
+            collect_assigned(branch->then_block(), variables);
+        }
+        if (branch->has_else_block())
+        {
+            collect_assigned(branch->else_block(), variables);
+        }
+    }
+    else if (const auto *loop = dynamic_cast<const WhileNode *>(node.get()); loop)
+    {
+        collect_assigned(loop->body(), variables);
+    }
+    else if (const auto *repeat = dynamic_cast<const RepeatUntilNode *>(node.get()); repeat)
+    {
+        collect_assigned(repeat->body(), variables);
+    }
+}
+
+Expr differentiate_block(Differentiator &differentiator, const Expr &block);
+
+// Appends statement to statements, preceded by the derivatives of the variables it assigns.
+void differentiate_statement(Differentiator &differentiator, const Expr &statement, std::vector<Expr> &statements)
+{
+    if (dynamic_cast<const AssignmentNode *>(statement.get()) != nullptr)
+    {
+        statements.push_back(differentiator.derivative(statement));
+    }
+    else if (const auto *sequence = dynamic_cast<const StatementSeqNode *>(statement.get()); sequence)
+    {
+        for (const Expr &child : sequence->statements())
+        {
+            differentiate_statement(differentiator, child, statements);
+        }
+        return;
+    }
+    else if (const auto *branch = dynamic_cast<const IfStatementNode *>(statement.get()); branch)
+    {
+        statements.push_back(std::make_shared<IfStatementNode>(branch->condition(),
+            branch->has_then_block() ? differentiate_block(differentiator, branch->then_block()) : nullptr,
+            branch->has_else_block() ? differentiate_block(differentiator, branch->else_block()) : nullptr));
+        return;
+    }
+    else if (const auto *loop = dynamic_cast<const WhileNode *>(statement.get()); loop)
+    {
+        statements.push_back(
+            std::make_shared<WhileNode>(loop->condition(), differentiate_block(differentiator, loop->body())));
+        return;
+    }
+    else if (const auto *repeat = dynamic_cast<const RepeatUntilNode *>(statement.get()); repeat)
+    {
+        statements.push_back(std::make_shared<RepeatUntilNode>(
+            differentiate_block(differentiator, repeat->body()), repeat->condition()));
+        return;
+    }
+    statements.push_back(statement);
+}
+
+Expr differentiate_block(Differentiator &differentiator, const Expr &block)
+{
+    std::vector<Expr> statements;
+    differentiate_statement(differentiator, block, statements);
+    return statements.size() == 1 ? statements.front() : std::make_shared<StatementSeqNode>(std::move(statements));
+}
+
+} // namespace
+
+std::string derivative_name(std::string_view variable)
+{
+    return "__d_" + std::string{variable};
+}
+
+FormulaSectionsPtr differentiate(const FormulaSections &formula, const std::map<std::string, std::string> &functions)
+{
+    std::set<std::string> variables;
+    collect_assigned(formula.initialize, variables);
+    collect_assigned(formula.iterate, variables);
+    Differentiator differentiator{variables, functions};
+
+    std::vector<Expr> initialize;
+    for (const std::string &variable : variables)
+    {
+        initialize.push_back(std::make_shared<AssignmentNode>(derivative_name(variable), literal(0.0)));
+    }
+    if (formula.initialize)
+    {
+        differentiate_statement(differentiator, formula.initialize, initialize);
+    }
+    Expr iterate{formula.iterate ? differentiate_block(differentiator, formula.iterate) : nullptr};
+    if (!differentiator.supported())
+    {
+        return nullptr;
+    }
+
+    auto result{std::make_shared<FormulaSections>(formula)};
+    if (!initialize.empty())
+    {
+        result->initialize = std::make_shared<StatementSeqNode>(std::move(initialize));
+    }
+    result->iterate = std::move(iterate);
+    retain_live_locations(*result);
+    return result;
+}
+
+} // namespace formula::semantic
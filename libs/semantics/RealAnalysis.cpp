@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/semantics/RealAnalysis.h>
+
+#include <formula/core/functions.h>
+#include <formula/core/Visitor.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+using namespace formula::ast;
+
+namespace formula::semantic
+{
+
+namespace
+{
+
+// Built-in identifiers whose values are always real.
+constexpr std::array<std::string_view, 6> REAL_IDENTIFIERS{"e", "ismand", "lastsqr", "maxit", "pi", "whitesq"};
+
+// Functions with a real result for any argument.
+constexpr std::array<std::string_view, 6> REAL_FUNCTIONS{"cabs", "imag", "one", "real", "srand", "zero"};
+
+// Functions with a real result for every real argument; log, sqrt and the inverse functions other than
+// atan and asinh leave the real line for some arguments.
+constexpr std::array<std::string_view, 20> REAL_PRESERVING_FUNCTIONS{"abs", "asinh", "atan", "ceil", "conj",
+    "cos", "cosh", "cosxx", "cotan", "cotanh", "exp", "floor", "ident", "round", "sin", "sinh", "sqr", "tan",
+    "tanh", "trunc"};
+
+constexpr std::array<std::string_view, 8> REAL_OPERATORS{"<", "<=", ">", ">=", "==", "!=", "&&", "||"};
+
+constexpr std::array<std::string_view, 3> REAL_PRESERVING_OPERATORS{"+", "-", "*"};
+
+// Variables renderers replace with complex values, see find_real_variables.
+constexpr std::array<std::string_view, 2> EXTERNAL_IDENTIFIERS{"pixel", "z"};
+
+template <std::size_t N>
+bool contains(const std::array<std::string_view, N> &names, std::string_view name)
+{
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+bool is_nonzero_literal(const Expr &node)
+{
+    const auto *literal{dynamic_cast<const LiteralNode *>(node.get())};
+    if (literal == nullptr)
+    {
+        return false;
+    }
+    const LiteralNode::ValueType value{literal->value()};
+    if (const int *integer = std::get_if<int>(&value))
+    {
+        return *integer != 0;
+    }
+    const double *real{std::get_if<double>(&value)};
+    return real != nullptr && *real != 0.0 && std::isfinite(*real);
+}
+
+// Marks the real expressions of a section, assuming the variables in real_variables are real, and
+// records the variables given a value that isn't.
+class RealMarker : public NullVisitor
+{
+public:
+    RealMarker(const std::set<std::string> &real_variables, const std::map<std::string, std::string> &functions,
+        RealExpressions &real) :
+        m_real_variables(real_variables),
+        m_functions(functions),
+        m_real(real)
+    {
+    }
+    ~RealMarker() override = default;
+
+    bool mark(const Expr &node)
+    {
+        if (!node)
+        {
+            return false;
+        }
+        m_is_real = false;
+        node->visit(*this);
+        if (m_is_real)
+        {
+            m_real.insert(node.get());
+        }
+        return m_is_real;
+    }
+    const std::set<std::string> &complex_assignments() const
+    {
+        return m_complex_assignments;
+    }
+
+    void visit(const AssignmentNode &node) override
+    {
+        const bool real{mark(node.expression())};
+        if (!real)
+        {
+            m_complex_assignments.insert(node.variable());
+        }
+        m_is_real = real;
+    }
+    void visit(const BinaryOpNode &node) override
+    {
+        const bool left{mark(node.left())};
+        const bool right{mark(node.right())};
+        m_is_real = contains(REAL_OPERATORS, node.op()) ||
+            (left && right &&
+                (contains(REAL_PRESERVING_OPERATORS, node.op()) ||
+                    (node.op() == "/" && is_nonzero_literal(node.right()))));
+    }
+    void visit(const FunctionCallNode &node) override
+    {
+        bool args{true};
+        for (const Expr &arg : node.args())
+        {
+            args = mark(arg) && args;
+        }
+        if (node.has_target() || node.args().size() != 1)
+        {
+            m_is_real = false;
+            return;
+        }
+        const std::string function{select_function(node.name(), m_functions)};
+        m_is_real = contains(REAL_FUNCTIONS, function) || (args && contains(REAL_PRESERVING_FUNCTIONS, function));
+    }
+    void visit(const IdentifierNode &node) override
+    {
+        m_is_real = m_real_variables.count(node.name()) != 0;
+    }
+    void visit(const IfStatementNode &node) override
+    {
+        mark(node.condition());
+        if (node.has_then_block())
+        {
+            mark(node.then_block());
+        }
+        if (node.has_else_block())
+        {
+            mark(node.else_block());
+        }
+        m_is_real = false;
+    }
+    void visit(const LiteralNode &node) override
+    {
+        const LiteralNode::ValueType value{node.value()};
+        const Complex *complex{std::get_if<Complex>(&value)};
+        m_is_real = complex == nullptr || complex->im == 0.0;
+    }
+    void visit(const RepeatUntilNode &node) override
+    {
+        mark(node.body());
+        mark(node.condition());
+        m_is_real = false;
+    }
+    void visit(const StatementSeqNode &node) override
+    {
+        for (const Expr &statement : node.statements())
+        {
+            mark(statement);
+        }
+        m_is_real = false;
+    }
+    void visit(const UnaryOpNode &node) override
+    {
+        const bool operand{mark(node.operand())};
+        m_is_real = node.op() == '|' || (operand && (node.op() == '+' || node.op() == '-'));
+    }
+    void visit(const WhileNode &node) override
+    {
+        mark(node.condition());
+        mark(node.body());
+        m_is_real = false;
+    }
+
+private:
+    const std::set<std::string> &m_real_variables;
+    const std::map<std::string, std::string> &m_functions;
+    RealExpressions &m_real;
+    std::set<std::string> m_complex_assignments;
+    bool m_is_real{};
+};
+
+// Variables assigned by a top-level statement of section, so they hold a value the section computed.
+void add_initialized(const Expr &section, std::set<std::string> &variables)
+{
+    const auto add = [&variables](const Expr &statement)
+    {
+        if (const auto *assignment = dynamic_cast<const AssignmentNode *>(statement.get()); assignment)
+        {
+            variables.insert(assignment->variable());
+        }
+    };
+    if (const auto *sequence = dynamic_cast<const StatementSeqNode *>(section.get()); sequence)
+    {
+        std::for_each(sequence->statements().begin(), sequence->statements().end(), add);
+    }
+    else
+    {
+        add(section);
+    }
+}
+
+std::vector<Expr> real_analysis_sections(const FormulaSections &formula)
+{
+    return {formula.per_image, formula.builtin, formula.initialize, formula.iterate, formula.bailout,
+        formula.perturb_initialize, formula.perturb_iterate, formula.final, formula.transform};
+}
+
+} // namespace
+
+std::set<std::string> find_real_variables(const FormulaSections &formula,
+    const std::map<std::string, std::string> &functions, const std::set<std::string> &external)
+{
+    const std::vector<Expr> sections{real_analysis_sections(formula)};
+    std::set<std::string> real_variables(REAL_IDENTIFIERS.begin(), REAL_IDENTIFIERS.end());
+    add_initialized(formula.per_image, real_variables);
+    add_initialized(formula.initialize, real_variables);
+    for (const std::string_view name : EXTERNAL_IDENTIFIERS)
+    {
+        real_variables.erase(std::string{name});
+    }
+    for (const std::string &name : external)
+    {
+        real_variables.erase(name);
+    }
+
+    // Assume every candidate is real and drop those given a complex value until none are.
+    while (true)
+    {
+        RealExpressions real;
+        RealMarker marker{real_variables, functions, real};
+        for (const Expr &section : sections)
+        {
+            marker.mark(section);
+        }
+        bool changed{};
+        for (const std::string &variable : marker.complex_assignments())
+        {
+            changed = real_variables.erase(variable) != 0 || changed;
+        }
+        if (!changed)
+        {
+            return real_variables;
+        }
+    }
+}
+
+RealExpressions find_real_expressions(const FormulaSections &formula,
+    const std::map<std::string, std::string> &functions, const std::set<std::string> &real_variables)
+{
+    RealExpressions real;
+    RealMarker marker{real_variables, functions, real};
+    for (const Expr &section : real_analysis_sections(formula))
+    {
+        marker.mark(section);
+    }
+    return real;
+}
+
+} // namespace formula::semantic
@@ -4,6 +4,7 @@
 //
 #include <formula/semantics/ReferenceCollector.h>
 
+#include <formula/core/Trace.h>
 #include <formula/core/Visitor.h>
 #include <formula/parser/ParseOptions.h>
 #include <formula/parser/Parser.h>
@@ -591,6 +592,7 @@ std::vector<FormulaResolvedReference> resolve_formula_entry_references(
 
 void resolve_formula_file_references(FormulaFileSet &files)
 {
+    const trace::Scope scope{"resolve_formula_file_references", "semantics"};
     files.resolved_references.clear();
     clear_unresolved_diagnostics(files);
     if (files.entry_references.empty())
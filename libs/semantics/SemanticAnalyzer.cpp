@@ -4,6 +4,7 @@
 //
 #include <formula/semantics/SemanticAnalyzer.h>
 
+#include <formula/core/Trace.h>
 #include <formula/core/Visitor.h>
 #include <formula/semantics/ReferenceCollector.h>
 
@@ -2953,6 +2954,7 @@ void FormulaSymbolCollector::report_unknown_symbol(const std::string &name)
 std::vector<SemanticDiagnostic> analyze_formula(
     const ast::FormulaSections &formula, const FormulaSemanticContext &context)
 {
+    const trace::Scope scope{"analyze_formula", "semantics"};
     const BuiltinRegistry &builtins{context.builtins ? *context.builtins : default_builtin_registry()};
     std::vector<SemanticDiagnostic> diagnostics{FormulaSymbolCollector{builtins, context}.collect(formula)};
     check_retained_class_bases(diagnostics, builtins, context);
@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/semantics/Symmetry.h>
+
+#include <formula/core/functions.h>
+#include <formula/core/Visitor.h>
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <variant>
+
+using namespace formula::ast;
+
+namespace formula::semantic
+{
+
+namespace
+{
+
+// Functions with f(conj(z)) = conj(f(z)); abs, flip, imag and the rounding functions treat the
+// imaginary part differently from the real part and srand reseeds rand.
+constexpr std::array<std::string_view, 29> CONJUGATE_FUNCTIONS{"acos", "acosh", "asin", "asinh", "atan",
+    "atanh", "cabs", "conj", "cos", "cosh", "cosxx", "cotan", "cotanh", "exp", "fn1", "fn2", "fn3", "fn4",
+    "ident", "log", "one", "real", "sin", "sinh", "sqr", "sqrt", "tan", "tanh", "zero"};
+
+// Built-in identifiers whose values aren't real or depend on the pixel's screen position.
+constexpr std::array<std::string_view, 7> ASYMMETRIC_IDENTIFIERS{
+    "rand", "scrnpix", "scrnmax", "whitesq", "center", "magxmag", "rotskew"};
+
+// Extended dialect built-ins (#name) are rejected unless listed here.
+constexpr std::array<std::string_view, 6> CONJUGATE_EXTENDED_IDENTIFIERS{
+    "#pixel", "#z", "#maxiter", "#numiter", "#pi", "#e"};
+
+constexpr std::array<std::string_view, 13> CONJUGATE_OPERATORS{
+    "+", "-", "*", "/", "^", "<", "<=", ">", ">=", "==", "!=", "&&", "||"};
+
+template <std::size_t N>
+bool contains(const std::array<std::string_view, N> &names, std::string_view name)
+{
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+class SymmetryChecker : public Visitor
+{
+public:
+    SymmetryChecker(const std::map<std::string, Complex> &values, const std::map<std::string, std::string> &functions) :
+        m_values(values),
+        m_functions(functions)
+    {
+    }
+    ~SymmetryChecker() override = default;
+
+    void check(const Expr &node)
+    {
+        if (node && m_symmetric)
+        {
+            node->visit(*this);
+        }
+    }
+    bool symmetric() const
+    {
+        return m_symmetric;
+    }
+
+    void visit(const AssignmentNode &node) override;
+    void visit(const BinaryOpNode &node) override;
+    void visit(const ConstantRefNode &) override
+    {
+        reject();
+    }
+    void visit(const DeclarationNode &) override
+    {
+        reject();
+    }
+    void visit(const FunctionBlockNode &) override
+    {
+        reject();
+    }
+    void visit(const FunctionDeclNode &) override
+    {
+        reject();
+    }
+    void visit(const FunctionCallNode &node) override;
+    void visit(const HeadingBlockNode &) override
+    {
+        reject();
+    }
+    void visit(const IdentifierNode &node) override;
+    void visit(const IfStatementNode &node) override;
+    void visit(const IndexNode &) override
+    {
+        reject();
+    }
+    void visit(const LiteralNode &node) override;
+    void visit(const MemberAccessNode &) override
+    {
+        reject();
+    }
+    void visit(const NewNode &) override
+    {
+        reject();
+    }
+    void visit(const ParamBlockNode &) override
+    {
+        reject();
+    }
+    void visit(const ParameterRefNode &) override
+    {
+        reject();
+    }
+    void visit(const RepeatUntilNode &node) override
+    {
+        check(node.body());
+        check(node.condition());
+    }
+    void visit(const ReturnNode &) override
+    {
+        reject();
+    }
+    void visit(const SettingNode &) override
+    {
+        reject();
+    }
+    void visit(const StatementSeqNode &node) override;
+    void visit(const UnaryOpNode &node) override;
+    void visit(const WhileNode &node) override
+    {
+        check(node.condition());
+        check(node.body());
+    }
+
+private:
+    void reject()
+    {
+        m_symmetric = false;
+    }
+
+    const std::map<std::string, Complex> &m_values;
+    const std::map<std::string, std::string> &m_functions;
+    bool m_symmetric{true};
+};
+
+void SymmetryChecker::visit(const AssignmentNode &node)
+{
+    if (node.variable().empty())
+    {
+        reject();
+        return;
+    }
+    check(node.expression());
+}
+
+void SymmetryChecker::visit(const BinaryOpNode &node)
+{
+    if (!contains(CONJUGATE_OPERATORS, node.op()))
+    {
+        reject();
+        return;
+    }
+    check(node.left());
+    check(node.right());
+}
+
+void SymmetryChecker::visit(const FunctionCallNode &node)
+{
+    const std::string function{select_function(node.name(), m_functions)};
+    if (node.has_target() || node.args().size() != 1 ||
+        !contains(CONJUGATE_FUNCTIONS, function))
+    {
+        reject();
+        return;
+    }
+    check(node.arg());
+}
+
+void SymmetryChecker::visit(const IdentifierNode &node)
+{
+    if (const auto it = m_values.find(node.name()); it != m_values.end())
+    {
+        if (it->second.im != 0.0)
+        {
+            reject();
+        }
+        return;
+    }
+    if (contains(ASYMMETRIC_IDENTIFIERS, node.name()) ||
+        (!node.name().empty() && node.name().front() == '#' && !contains(CONJUGATE_EXTENDED_IDENTIFIERS, node.name())))
+    {
+        reject();
+    }
+}
+
+void SymmetryChecker::visit(const IfStatementNode &node)
+{
+    check(node.condition());
+    if (node.has_then_block())
+    {
+        check(node.then_block());
+    }
+    if (node.has_else_block())
+    {
+        check(node.else_block());
+    }
+}
+
+void SymmetryChecker::visit(const LiteralNode &node)
+{
+    const LiteralNode::ValueType value{node.value()};
+    if (const Complex *complex = std::get_if<Complex>(&value); complex)
+    {
+        if (complex->im != 0.0)
+        {
+            reject();
+        }
+        return;
+    }
+    if (!std::holds_alternative<int>(value) && !std::holds_alternative<double>(value) &&
+        !std::holds_alternative<bool>(value))
+    {
+        reject();
+    }
+}
+
+void SymmetryChecker::visit(const StatementSeqNode &node)
+{
+    for (const Expr &statement : node.statements())
+    {
+        check(statement);
+    }
+}
+
+void SymmetryChecker::visit(const UnaryOpNode &node)
+{
+    if (node.op() != '+' && node.op() != '-' && node.op() != '!' && node.op() != '|')
+    {
+        reject();
+        return;
+    }
+    check(node.operand());
+}
+
+} // namespace
+
+bool is_conjugate_symmetric(const ast::FormulaSections &formula, const std::map<std::string, Complex> &values,
+    const std::map<std::string, std::string> &functions)
+{
+    // Sections that don't belong to a basic escape-time formula are rejected rather than analyzed.
+    if (formula.perturb_initialize || formula.perturb_iterate || formula.type_switch || formula.final ||
+        formula.transform || formula.public_members || formula.protected_members || formula.private_members ||
+        !formula.imports.empty())
+    {
+        return false;
+    }
+    SymmetryChecker checker{values, functions};
+    checker.check(formula.per_image);
+    checker.check(formula.builtin);
+    checker.check(formula.initialize);
+    checker.check(formula.iterate);
+    checker.check(formula.bailout);
+    return checker.symmetric();
+}
+
+} // namespace formula::semantic
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/core/Complex.h>
+#include <formula/core/Node.h>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace formula::semantic
+{
+
+enum class ClassicKind
+{
+    MANDELBROT,   // v = v^2 + pixel
+    JULIA,        // v = v^2 + c
+    BURNING_SHIP, // v = abs(v)^2 + pixel, abs taking the absolute value of each part
+    MANDEL3,      // v = v^3 + pixel
+};
+
+std::string_view to_string(ClassicKind value);
+
+// A formula that iterates a single variable with a constant escape radius:
+//   v = start: v = step(v) + addend; |v| <= bailout
+struct ClassicFormula
+{
+    ClassicKind kind{};
+    std::string variable; // the iterated variable, whatever the formula calls it
+    bool start_at_pixel{}; // v starts at pixel, otherwise at start
+    Complex start{};
+    Complex constant{}; // the addend of JULIA; the other kinds add pixel
+    double bailout{};   // compared with |v|, the modulus squared
+    bool inclusive{};   // the orbit continues while |v| <= bailout rather than |v| < bailout
+};
+
+// Recognizes the classic formulas structurally, after formula::simplify, whatever the iterated variable
+// is called: v*v, sqr(v) and v^2 all square v, and v*v*v, v*sqr(v) and v^3 cube it.  fn1-fn4 are resolved
+// through functions and identifiers other than v and pixel through values, so p1 and friends become
+// constants; unbound identifiers read as zero.  Returns nullopt for anything else, including formulas
+// with a global section, more than one statement in the init or loop section, or identifiers whose value
+// changes per pixel, such as rand or lastsqr.
+std::optional<ClassicFormula> recognize_classic_formula(const ast::FormulaSections &formula,
+    const std::map<std::string, Complex> &values, const std::map<std::string, std::string> &functions);
+
+} // namespace formula::semantic
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/core/Node.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace formula::semantic
+{
+
+// The variable that holds the derivative of variable with respect to pixel, e.g. __d_z for z.
+std::string derivative_name(std::string_view variable);
+
+// Forward-mode automatic differentiation for distance estimation.  Returns a copy of formula whose
+// initialize and iterate sections also compute d/dpixel of every variable they assign, in the variables
+// named by derivative_name.  Each assignment v = e is preceded by __d_v = de, evaluated with the values
+// from before the assignment, so any interpreter or compiler runs the derivative in the same loop.  The
+// initialize section first clears every derivative, so values left by an earlier pixel don't leak in.
+// Conditions are treated as locally constant, which holds everywhere except on their boundaries.
+//
+// fn1-fn4 are resolved through functions when the derivative is taken.  Returns nullptr when an assigned
+// expression depends on pixel through something without a complex derivative: |x|, lastsqr, abs, cabs,
+// conj, cosxx, flip, real, imag or the rounding functions, or when an assignment target isn't a variable.
+ast::FormulaSectionsPtr differentiate(
+    const ast::FormulaSections &formula, const std::map<std::string, std::string> &functions);
+
+} // namespace formula::semantic
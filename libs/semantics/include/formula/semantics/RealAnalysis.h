@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/core/Node.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+namespace formula::semantic
+{
+
+using RealExpressions = std::set<const ast::Node *>;
+
+// The variables of formula that only ever hold real values.  pi, e, maxit, whitesq, ismand and lastsqr are
+// real by definition.  Any other variable is real when it is assigned at the top level of the global or
+// initialize section and every assignment to it, in any section, is real.  Variables named in external
+// can be given complex values from outside the formula and are never real; pixel and z are always
+// external because renderers replace them.  fn1-fn4 are resolved through functions.
+std::set<std::string> find_real_variables(const ast::FormulaSections &formula,
+    const std::map<std::string, std::string> &functions, const std::set<std::string> &external);
+
+// The expressions of formula whose imaginary part is provably zero when real_variables, usually the
+// result of find_real_variables, are real, so a backend can compute them with scalar arithmetic.  Real
+// literals, comparisons, logical operators, |x| and functions like real, imag and cabs are real; +, -, *
+// and real-preserving functions such as sin or floor are real when their operands are.  A quotient is
+// only real when its divisor is a nonzero literal, since dividing by zero gives a NaN imaginary part.
+RealExpressions find_real_expressions(const ast::FormulaSections &formula,
+    const std::map<std::string, std::string> &functions, const std::set<std::string> &real_variables);
+
+} // namespace formula::semantic
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/core/Complex.h>
+#include <formula/core/Node.h>
+
+#include <map>
+#include <string>
+
+namespace formula::semantic
+{
+
+// True when the formula provably commutes with complex conjugation: iterating conj(pixel) gives the
+// conjugate of every value iterating pixel gives, so the image is symmetric about the real axis.
+//
+// The check is conservative.  Literals and bound values must be real, identifiers that depend on the
+// screen position or rand are rejected, and every called function, after resolving fn1-fn4 through
+// functions, must satisfy f(conj(z)) = conj(f(z)).  Statements other than assignments to variables,
+// if, while and repeat reject the formula.
+bool is_conjugate_symmetric(const ast::FormulaSections &formula, const std::map<std::string, Complex> &values,
+    const std::map<std::string, std::string> &functions);
+
+} // namespace formula::semantic
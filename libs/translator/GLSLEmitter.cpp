@@ -540,13 +540,30 @@ std::string GLSLEmitter::emit_complex_math_functions()
     out << "vec2 c_eq(vec2 a, vec2 b) { return c_bool(a.x == b.x && a.y == b.y); }\n";
     out << "vec2 c_ne(vec2 a, vec2 b) { return c_bool(a.x != b.x || a.y != b.y); }\n\n";
 
-    out << "float c_random_float(inout uint random_state) {\n";
-    out << "    random_state = random_state * 1664525u + 1013904223u;\n";
-    out << "    return float(random_state & 0x00ffffffu) / 16777216.0;\n";
+    // rand is Philox4x32-10 keyed on (seed, pixel index, iteration), matching formula::random_complex
+    // to the 24 bits a float holds.
+    out << "uint random_stream = 0u;\n";
+    out << "uint random_counter = 0u;\n\n";
+
+    out << "uvec4 c_philox(uvec4 counter, uvec2 key) {\n";
+    out << "    for (int round = 0; round < 10; ++round) {\n";
+    out << "        if (round > 0)\n";
+    out << "            key += uvec2(0x9E3779B9u, 0xBB67AE85u);\n";
+    out << "        uint hi0;\n";
+    out << "        uint lo0;\n";
+    out << "        uint hi1;\n";
+    out << "        uint lo1;\n";
+    out << "        umulExtended(0xD2511F53u, counter.x, hi0, lo0);\n";
+    out << "        umulExtended(0xCD9E8D57u, counter.z, hi1, lo1);\n";
+    out << "        counter = uvec4(hi1 ^ counter.y ^ key.x, lo1, hi0 ^ counter.w ^ key.y, lo0);\n";
+    out << "    }\n";
+    out << "    return counter;\n";
     out << "}\n\n";
 
     out << "vec2 c_next_rand(inout uint random_state) {\n";
-    out << "    return vec2(c_random_float(random_state), c_random_float(random_state));\n";
+    out << "    uvec4 bits = c_philox(uvec4(random_stream, 0u, random_counter, 0u), uvec2(random_state, 0u));\n";
+    out << "    random_counter += 1u;\n";
+    out << "    return vec2(float(bits.x >> 8u), float(bits.z >> 8u)) / 16777216.0;\n";
     out << "}\n\n";
 
     return out.str();
@@ -559,6 +576,7 @@ std::string GLSLEmitter::emit_builtin_functions()
     out << "// Additional builtin functions\n";
     out << "vec2 c_srand(vec2 z, inout uint random_state, inout vec2 rand) {\n";
     out << "    random_state = uint(z.x);\n";
+    out << "    random_counter = 0u;\n";
     out << "    rand = vec2(0.0, 0.0);\n";
     out << "    return vec2(0.0, 0.0);\n";
     out << "}\n\n";
@@ -650,7 +668,8 @@ std::string GLSLEmitter::emit_main_function(const ast::FormulaSections &formula)
     out << indent() << "vec2 scrnpix = vec2(pixel_coords);\n";
     out << indent() << "vec2 whitesq = vec2(float((pixel_coords.x + pixel_coords.y) & 1), 0.0);\n\n";
     out << indent() << "// Random state\n";
-    out << indent() << "uint random_state = random_seed ^ uint(pixel_coords.x) ^ (uint(pixel_coords.y) << 16u);\n";
+    out << indent() << "uint random_state = random_seed;\n";
+    out << indent() << "random_stream = pixel_index;\n";
     out << indent() << "vec2 rand = vec2(0.0, 0.0);\n\n";
 
     // Per-image initialization (GLOBAL section)
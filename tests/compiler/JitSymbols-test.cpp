@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/compiler/JitSymbols.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace formula::test
+{
+
+namespace
+{
+
+const std::vector<JitSymbol> &sample_symbols()
+{
+    static const std::vector<JitSymbol> symbols{
+        {"Mandelbrot::init", 0x10000, 0x40},
+        {"Mandelbrot::loop", 0x10040, 0x80},
+    };
+    return symbols;
+}
+
+template <typename T>
+T read(const std::vector<std::uint8_t> &bytes, std::size_t offset)
+{
+    T value{};
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return value;
+}
+
+bool contains(const std::vector<std::uint8_t> &bytes, const std::string &text)
+{
+    return std::search(bytes.begin(), bytes.end(), text.begin(), text.end()) != bytes.end();
+}
+
+} // namespace
+
+TEST(TestJitSymbols, symbolFileIsElfObject)
+{
+    const std::vector<std::uint8_t> file{make_symbol_file(sample_symbols())};
+
+    ASSERT_GE(file.size(), 64U);
+    EXPECT_EQ(0x7f, file[0]);
+    EXPECT_EQ('E', file[1]);
+    EXPECT_EQ('L', file[2]);
+    EXPECT_EQ('F', file[3]);
+    EXPECT_EQ(2, file[4]);                         // 64-bit
+    EXPECT_EQ(1U, read<std::uint16_t>(file, 16));  // relocatable
+    EXPECT_EQ(62U, read<std::uint16_t>(file, 18)); // x86-64
+    const auto section_headers{read<std::uint64_t>(file, 40)};
+    const auto section_count{read<std::uint16_t>(file, 60)};
+    EXPECT_EQ(file.size(), section_headers + section_count * 64U);
+}
+
+TEST(TestJitSymbols, symbolFileNamesEverySymbol)
+{
+    const std::vector<std::uint8_t> file{make_symbol_file(sample_symbols())};
+
+    EXPECT_TRUE(contains(file, "Mandelbrot::init"));
+    EXPECT_TRUE(contains(file, "Mandelbrot::loop"));
+    EXPECT_TRUE(contains(file, ".symtab"));
+}
+
+TEST(TestJitSymbols, textSectionCoversAllSymbols)
+{
+    const std::vector<std::uint8_t> file{make_symbol_file(sample_symbols())};
+
+    const auto section_headers{read<std::uint64_t>(file, 40)};
+    const std::size_t text{section_headers + 64}; // section 1 follows the null section
+    EXPECT_EQ(8U, read<std::uint32_t>(file, text + 4)); // no bits in the file
+    EXPECT_EQ(0x10000U, read<std::uint64_t>(file, text + 16));
+    EXPECT_EQ(0xC0U, read<std::uint64_t>(file, text + 32));
+}
+
+#if defined(__linux__)
+TEST(TestJitSymbols, perfMapAppendsSymbolLines)
+{
+    const std::string path{perf_map_path()};
+    std::remove(path.c_str());
+
+    ASSERT_TRUE(write_perf_map(sample_symbols()));
+
+    std::ifstream map{path};
+    std::string first;
+    std::string second;
+    std::getline(map, first);
+    std::getline(map, second);
+    EXPECT_EQ("10000 40 Mandelbrot::init", first);
+    EXPECT_EQ("10040 80 Mandelbrot::loop", second);
+    map.close();
+    std::remove(path.c_str());
+}
+
+TEST(TestJitSymbols, gdbRegistrationRegisters)
+{
+    const GdbJitRegistration registration{sample_symbols()};
+
+    EXPECT_TRUE(registration.registered());
+}
+#endif
+
+} // namespace formula::test
@@ -11,12 +11,15 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <cmath>
 #include <complex>
 #include <cstdint>
+#include <future>
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <vector>
 
 using namespace formula::parser;
 using namespace testing;
@@ -631,6 +634,421 @@ TEST(TestCompiledFormulaRun, settingClientSeedResetsRandUntilIteration)
     EXPECT_EQ((Complex{0.0, 0.0}), formula->get_value("rand"));
 }
 
+TEST(TestCompiledFormulaRun, symbolHandlesDriveCompiledCode)
+{
+    const FormulaPtr formula{create_formula("init:\n"
+                                            "z = a*2\n",
+        Options{})};
+    ASSERT_TRUE(formula) << "Formula should have parsed";
+    ASSERT_TRUE(formula->get_section(Section::INITIALIZE));
+    const SymbolHandle a{formula->lookup_symbol("a")};
+    ASSERT_TRUE(formula->compile());
+    const SymbolHandle z{formula->lookup_symbol("z")};
+
+    formula->set(a, {1.5, -1.0});
+    formula->run(Section::INITIALIZE);
+
+    EXPECT_EQ((Complex{3.0, -2.0}), formula->get(z));
+}
+
+TEST(TestCompiledFormulaRun, runBatchMatchesInterpretBatch)
+{
+    constexpr const char *text{"z = pixel:\n"
+                               "z = z*z + pixel + (rand - 0.5)*0.01\n"
+                               "|z| <= 4\n"};
+    const FormulaPtr compiled{create_formula(text, Options{})};
+    const FormulaPtr interpreted{create_formula(text, Options{})};
+    ASSERT_TRUE(compiled) << "Formula should have parsed";
+    ASSERT_TRUE(interpreted) << "Formula should have parsed";
+    ASSERT_TRUE(compiled->compile());
+    const double pixel_re[3]{-2.0, -0.5, 0.3};
+    const double pixel_im[3]{1.0, 0.0, 0.5};
+    const std::uint64_t streams[3]{1U, 2U, 3U};
+    BatchInputs inputs;
+    inputs.pixel_re = pixel_re;
+    inputs.pixel_im = pixel_im;
+    inputs.random_streams = streams;
+    int compiled_iterations[3]{};
+    double compiled_z[3]{};
+    BatchOutputs compiled_outputs;
+    compiled_outputs.iterations = compiled_iterations;
+    compiled_outputs.z_re = compiled_z;
+    int interpreted_iterations[3]{};
+    double interpreted_z[3]{};
+    BatchOutputs interpreted_outputs;
+    interpreted_outputs.iterations = interpreted_iterations;
+    interpreted_outputs.z_re = interpreted_z;
+
+    compiled->run_batch(Section::ITERATE, inputs, compiled_outputs, 3, 40);
+    interpreted->interpret_batch(Section::ITERATE, inputs, interpreted_outputs, 3, 40);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(interpreted_iterations[i], compiled_iterations[i]) << i;
+        EXPECT_NEAR(interpreted_z[i], compiled_z[i], 1e-12) << i;
+    }
+}
+
+TEST(TestCompiledFormulaRun, cancelledTokenStopsCompiledOrbit)
+{
+    // Without cancellation the orbit never escapes.
+    const FormulaPtr formula{create_formula("z = 0:\n"
+                                            "z = z + 1\n"
+                                            "1\n",
+        Options{})};
+    ASSERT_TRUE(formula) << "Formula should have parsed";
+    ASSERT_TRUE(formula->compile());
+    const double pixel_re[1]{};
+    const double pixel_im[1]{};
+    BatchInputs inputs;
+    inputs.pixel_re = pixel_re;
+    inputs.pixel_im = pixel_im;
+    int iterations[1]{};
+    BatchOutputs outputs;
+    outputs.iterations = iterations;
+    CancellationToken token;
+    formula->set_cancellation(&token);
+    token.cancel();
+
+    EXPECT_THROW(formula->run_batch(Section::ITERATE, inputs, outputs, 1, 1000000000), CancelledError);
+    EXPECT_EQ(0, iterations[0]);
+}
+
+TEST(TestCompiledFormulaRun, instructionSetsMatchInterpreter)
+{
+    constexpr const char *text{"z = (a*b)/c + |d| - -e*sqr(b) + lastsqr/(a - c)"};
+    const auto set_values = [](Formula &formula)
+    {
+        formula.set_value("a", {1.5, -2.25});
+        formula.set_value("b", {0.75, 3.0});
+        formula.set_value("c", {-2.0, 0.5});
+        formula.set_value("d", {3.0, -4.0});
+        formula.set_value("e", {0.25, 1.25});
+    };
+    const FormulaPtr interpreted{create_formula(text, Options{})};
+    ASSERT_TRUE(interpreted) << "Formula should have parsed";
+    set_values(*interpreted);
+    const Complex expected{interpreted->interpret(Section::ITERATE)};
+
+    for (const InstructionSet instruction_set : {InstructionSet::SSE2, InstructionSet::AVX2, InstructionSet::AVX512})
+    {
+        const FormulaPtr compiled{create_formula(text, Options{})};
+        ASSERT_TRUE(compiled) << "Formula should have parsed";
+        set_values(*compiled);
+        CompileOptions options;
+        options.instruction_set = instruction_set;
+        ASSERT_TRUE(compiled->compile(options)) << to_string(instruction_set);
+
+        const Complex actual{compiled->run(Section::ITERATE)};
+
+        EXPECT_GE(instruction_set, compiled->get_compile_stats().instruction_set) << to_string(instruction_set);
+        EXPECT_NEAR(expected.re, actual.re, 1e-12) << to_string(instruction_set);
+        EXPECT_NEAR(expected.im, actual.im, 1e-12) << to_string(instruction_set);
+    }
+}
+
+TEST(TestCompiledFormulaRun, realExpressionsMatchInterpreter)
+{
+    // n, scale and the bailout are real; the iterate mixes real and complex operands.
+    constexpr const char *text{"z = pixel, n = 0, scale = 0.5:\n"
+                               "n = n + 1, scale = scale*1.25/n\n"
+                               "z = z*scale + n*z/(n + 1) + sin(real(z))*pixel/scale + |n - 2|\n"
+                               "|z| + n <= 100\n"};
+    const FormulaPtr interpreted{create_formula(text, Options{})};
+    const FormulaPtr compiled{create_formula(text, Options{})};
+    ASSERT_TRUE(interpreted && compiled) << "Formula should have parsed";
+    ASSERT_TRUE(compiled->compile());
+    interpreted->set_value("pixel", {0.25, -0.5});
+    compiled->set_value("pixel", {0.25, -0.5});
+    interpreted->interpret(Section::INITIALIZE);
+    compiled->run(Section::INITIALIZE);
+
+    for (int i = 0; i < 5; ++i)
+    {
+        interpreted->interpret(Section::ITERATE);
+        compiled->run(Section::ITERATE);
+        const Complex expected{interpreted->get_value("z")};
+        const Complex actual{compiled->get_value("z")};
+
+        EXPECT_NEAR(expected.re, actual.re, 1e-12 * (1.0 + std::abs(expected.re))) << "iteration " << i;
+        EXPECT_NEAR(expected.im, actual.im, 1e-12 * (1.0 + std::abs(expected.im))) << "iteration " << i;
+        EXPECT_EQ(interpreted->interpret(Section::BAILOUT), compiled->run(Section::BAILOUT)) << "iteration " << i;
+    }
+}
+
+TEST(TestCompiledFormulaRun, complexHostValueInRealVariableMatchesInterpreter)
+{
+    // scale is assumed real until the host stores a complex value in it after compile().
+    constexpr const char *text{"z = pixel, scale = 0.5, d = 2:\n"
+                               "z = z*scale + pixel/d\n"
+                               "|z| <= 100\n"};
+    const FormulaPtr interpreted{create_formula(text, Options{})};
+    const FormulaPtr compiled{create_formula(text, Options{})};
+    ASSERT_TRUE(interpreted && compiled) << "Formula should have parsed";
+    ASSERT_TRUE(compiled->compile());
+    for (const FormulaPtr &formula : {interpreted, compiled})
+    {
+        formula->set_value("pixel", {0.25, -0.5});
+    }
+    interpreted->interpret(Section::INITIALIZE);
+    compiled->run(Section::INITIALIZE);
+    interpreted->set_value("scale", {0.5, 0.75});
+    compiled->set_value("scale", {0.5, 0.75});
+    const SymbolHandle interpreted_d{interpreted->lookup_symbol("d")};
+    const SymbolHandle compiled_d{compiled->lookup_symbol("d")};
+    interpreted->set(interpreted_d, {2.0, -1.0});
+    compiled->set(compiled_d, {2.0, -1.0});
+
+    for (int i = 0; i < 5; ++i)
+    {
+        interpreted->interpret(Section::ITERATE);
+        compiled->run(Section::ITERATE);
+        const Complex expected{interpreted->get_value("z")};
+        const Complex actual{compiled->get_value("z")};
+
+        EXPECT_NEAR(expected.re, actual.re, 1e-12 * (1.0 + std::abs(expected.re))) << "iteration " << i;
+        EXPECT_NEAR(expected.im, actual.im, 1e-12 * (1.0 + std::abs(expected.im))) << "iteration " << i;
+    }
+}
+
+TEST(TestCompiledFormulaRun, realDivisionByZeroMatchesInterpreter)
+{
+    constexpr const char *text{"z = pixel, n = 0:\n"
+                               "z = z/n + 1/n\n"
+                               "|z| <= 100\n"};
+    const FormulaPtr interpreted{create_formula(text, Options{})};
+    const FormulaPtr compiled{create_formula(text, Options{})};
+    ASSERT_TRUE(interpreted && compiled) << "Formula should have parsed";
+    ASSERT_TRUE(compiled->compile());
+    interpreted->set_value("pixel", {0.25, -0.5});
+    compiled->set_value("pixel", {0.25, -0.5});
+    interpreted->interpret(Section::INITIALIZE);
+    compiled->run(Section::INITIALIZE);
+
+    interpreted->interpret(Section::ITERATE);
+    compiled->run(Section::ITERATE);
+
+    const Complex expected{interpreted->get_value("z")};
+    const Complex actual{compiled->get_value("z")};
+    EXPECT_TRUE(std::isnan(expected.re));
+    EXPECT_EQ(std::isnan(expected.re), std::isnan(actual.re));
+    EXPECT_EQ(std::isnan(expected.im), std::isnan(actual.im));
+}
+
+TEST(TestCompiledFormulaRun, loopsFallBackToInterpreter)
+{
+    // The while loop runs in the interpreter; the assignments around it are compiled.
+    constexpr const char *text{"z = pixel, n = 0:\n"
+                               "while n < 3\n"
+                               "z = z*z + pixel\n"
+                               "n = n + 1\n"
+                               "endwhile\n"
+                               "n = 0\n"
+                               "z = z*z + pixel\n"
+                               "|z| <= 4\n"};
+    const FormulaPtr interpreted{create_formula(text, Options{})};
+    const FormulaPtr compiled{create_formula(text, Options{})};
+    ASSERT_TRUE(interpreted && compiled) << "Formula should have parsed";
+    ASSERT_TRUE(compiled->compile());
+    interpreted->set_value("pixel", {0.25, -0.5});
+    compiled->set_value("pixel", {0.25, -0.5});
+
+    interpreted->interpret(Section::INITIALIZE);
+    compiled->run(Section::INITIALIZE);
+    interpreted->interpret(Section::ITERATE);
+    compiled->run(Section::ITERATE);
+
+    EXPECT_EQ(interpreted->get_value("z"), compiled->get_value("z"));
+    EXPECT_EQ((Complex{0.0, 0.0}), compiled->get_value("n"));
+}
+
+TEST(TestCompiledFormulaRun, cancelledTokenStopsFallbackLoop)
+{
+    // The endless loop runs in the interpreter, called from the compiled orbit.
+    const FormulaPtr formula{create_formula("z = 0:\n"
+                                            "while 1\n"
+                                            "z = z + 1\n"
+                                            "endwhile\n"
+                                            "|z| <= 4\n",
+        Options{})};
+    ASSERT_TRUE(formula) << "Formula should have parsed";
+    ASSERT_TRUE(formula->compile());
+    const double pixel_re[1]{};
+    const double pixel_im[1]{};
+    BatchInputs inputs;
+    inputs.pixel_re = pixel_re;
+    inputs.pixel_im = pixel_im;
+    BatchOutputs outputs;
+    const CancellationToken token{CancellationToken::Clock::now() + std::chrono::milliseconds(20)};
+    formula->set_cancellation(&token);
+
+    EXPECT_THROW(formula->run_batch(Section::ITERATE, inputs, outputs, 1, 100), CancelledError);
+}
+
+TEST(TestCompiledFormulaRun, sse2InstructionSetIsAlwaysAvailable)
+{
+    const FormulaPtr formula{create_formula("z = z*z + pixel", Options{})};
+    ASSERT_TRUE(formula) << "Formula should have parsed";
+    CompileOptions options;
+    options.instruction_set = InstructionSet::SSE2;
+
+    ASSERT_TRUE(formula->compile(options));
+
+    EXPECT_EQ(InstructionSet::SSE2, formula->get_compile_stats().instruction_set);
+}
+
+TEST(TestCompiledFormulaRun, unrolledOrbitMatchesSingleStep)
+{
+    // rand and lastsqr are written by the step, so the rollback must restore them too.
+    constexpr const char *text{"z = pixel, w = 0:\n"
+                               "w = w + rand/8, z = sqr(z) + pixel + w/16\n"
+                               "|z| <= 4 && lastsqr < 8\n"};
+    const FormulaPtr single{create_formula(text, Options{})};
+    const FormulaPtr unrolled{create_formula(text, Options{})};
+    ASSERT_TRUE(single && unrolled) << "Formula should have parsed";
+    CompileOptions options;
+    options.orbit_unroll = 8;
+    ASSERT_TRUE(single->compile());
+    ASSERT_TRUE(unrolled->compile(options));
+    constexpr std::size_t COUNT{4};
+    const double pixel_re[COUNT]{0.0, 0.3, -0.75, 0.26};
+    const double pixel_im[COUNT]{0.0, 0.5, 0.1, 0.0};
+    BatchInputs inputs;
+    inputs.pixel_re = pixel_re;
+    inputs.pixel_im = pixel_im;
+
+    for (const int max_iterations : {0, 1, 7, 8, 9, 17, 100})
+    {
+        double expected_re[COUNT]{};
+        double expected_im[COUNT]{};
+        int expected_iterations[COUNT]{};
+        double actual_re[COUNT]{};
+        double actual_im[COUNT]{};
+        int actual_iterations[COUNT]{};
+        BatchOutputs expected;
+        expected.z_re = expected_re;
+        expected.z_im = expected_im;
+        expected.iterations = expected_iterations;
+        BatchOutputs actual;
+        actual.z_re = actual_re;
+        actual.z_im = actual_im;
+        actual.iterations = actual_iterations;
+        single->set_random_seed(3);
+        unrolled->set_random_seed(3);
+
+        single->run_batch(Section::ITERATE, inputs, expected, COUNT, max_iterations);
+        unrolled->run_batch(Section::ITERATE, inputs, actual, COUNT, max_iterations);
+
+        for (std::size_t i = 0; i < COUNT; ++i)
+        {
+            EXPECT_EQ(expected_iterations[i], actual_iterations[i]) << max_iterations << " iterations, pixel " << i;
+            EXPECT_EQ(expected_re[i], actual_re[i]) << max_iterations << " iterations, pixel " << i;
+            EXPECT_EQ(expected_im[i], actual_im[i]) << max_iterations << " iterations, pixel " << i;
+        }
+    }
+}
+
+TEST(TestCompiledFormulaRun, orbitWithFallbackIsNotUnrolled)
+{
+    // Once z has escaped, the next step's loop never ends; only a speculative step would run it.
+    constexpr const char *text{"z = pixel, e = 0:\n"
+                               "z = z*z + pixel\n"
+                               "e = e + (|z| > 4)\n"
+                               "while e > 1\n"
+                               "e = e\n"
+                               "endwhile\n"
+                               "|z| <= 4\n"};
+    const FormulaPtr formula{create_formula(text, Options{})};
+    ASSERT_TRUE(formula) << "Formula should have parsed";
+    CompileOptions options;
+    options.orbit_unroll = 4;
+    ASSERT_TRUE(formula->compile(options));
+    const double pixel_re[1]{1.0};
+    const double pixel_im[1]{};
+    BatchInputs inputs;
+    inputs.pixel_re = pixel_re;
+    inputs.pixel_im = pixel_im;
+    int iterations[1]{};
+    BatchOutputs outputs;
+    outputs.iterations = iterations;
+
+    EXPECT_NO_THROW(formula->run_batch(Section::ITERATE, inputs, outputs, 1, 100));
+    EXPECT_EQ(1, iterations[0]);
+}
+
+TEST(TestCompiledFormulaRun, compileAsyncCompilesFormulasConcurrently)
+{
+    std::vector<FormulaPtr> formulas;
+    for (int i = 0; i < 8; ++i)
+    {
+        formulas.push_back(create_formula("init:\nz = a*" + std::to_string(i) + "\n", Options{}));
+        ASSERT_TRUE(formulas.back()) << "Formula should have parsed";
+    }
+    std::vector<std::future<bool>> compiling;
+
+    for (const FormulaPtr &formula : formulas)
+    {
+        compiling.push_back(formula->compile_async());
+    }
+    std::vector<bool> compiled;
+    for (std::future<bool> &result : compiling)
+    {
+        compiled.push_back(result.get());
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+        ASSERT_TRUE(compiled[i]) << i;
+        formulas[i]->set_value("a", {1.0, 0.5});
+        formulas[i]->run(Section::INITIALIZE);
+        EXPECT_EQ((Complex{1.0 * i, 0.5 * i}), formulas[i]->get_value("z")) << i;
+    }
+}
+
+TEST(TestCompiledFormulaRun, formulasOutliveOtherFormulasCode)
+{
+    const FormulaPtr first{create_formula("init:\nz = 2\n", Options{})};
+    FormulaPtr second{create_formula("init:\nz = 3\n", Options{})};
+    ASSERT_TRUE(first->compile());
+    ASSERT_TRUE(second->compile());
+
+    second.reset();
+    first->run(Section::INITIALIZE);
+
+    EXPECT_EQ((Complex{2.0, 0.0}), first->get_value("z"));
+}
+
+TEST(TestCompiledFormulaRun, compileStatsRecordParseBeforeCompile)
+{
+    const FormulaPtr formula{create_formula("z = z*z + pixel", Options{})};
+    ASSERT_TRUE(formula) << "Formula should have parsed";
+
+    const CompileStats &stats{formula->get_compile_stats()};
+
+    EXPECT_GT(stats.parse.count(), 0.0);
+    EXPECT_EQ(0U, stats.instructions);
+    EXPECT_EQ(0U, stats.code_bytes);
+}
+
+TEST(TestCompiledFormulaRun, compileStatsDescribeGeneratedCode)
+{
+    const FormulaPtr formula{create_formula("z = pixel:\n"
+                                            "z = z*z + pixel + 1.5\n"
+                                            "|z| <= 4\n",
+        Options{})};
+    ASSERT_TRUE(formula) << "Formula should have parsed";
+
+    ASSERT_TRUE(formula->compile());
+
+    const CompileStats &stats{formula->get_compile_stats()};
+    EXPECT_GT(stats.parse.count(), 0.0);
+    EXPECT_GT(stats.generate.count(), 0.0);
+    EXPECT_GT(stats.assemble.count(), 0.0);
+    EXPECT_GT(stats.instructions, 0U);
+    EXPECT_GT(stats.code_bytes, 0U);
+    EXPECT_GE(stats.data_bytes, sizeof(double)); // at least the constant 1.5
+}
+
 struct CompiledRuntimeInputParam
 {
     std::string_view name;
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/core/Cancellation.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+namespace formula::test
+{
+
+TEST(TestCancellation, newTokenIsNotCancelled)
+{
+    const CancellationToken token;
+
+    EXPECT_FALSE(token.cancelled());
+    EXPECT_NO_THROW(token.throw_if_cancelled());
+}
+
+TEST(TestCancellation, cancelIsSticky)
+{
+    CancellationToken token;
+
+    token.cancel();
+
+    EXPECT_TRUE(token.cancelled());
+    EXPECT_TRUE(token.cancelled());
+    EXPECT_THROW(token.throw_if_cancelled(), CancelledError);
+}
+
+TEST(TestCancellation, passedDeadlineCancels)
+{
+    const CancellationToken token{CancellationToken::Clock::now() - std::chrono::seconds(1)};
+
+    EXPECT_TRUE(token.cancelled());
+    EXPECT_THROW(token.throw_if_cancelled(), CancelledError);
+}
+
+TEST(TestCancellation, futureDeadlineDoesNotCancel)
+{
+    const CancellationToken token{CancellationToken::Clock::now() + std::chrono::hours(1)};
+
+    EXPECT_FALSE(token.cancelled());
+}
+
+TEST(TestCancellation, cancelledErrorIsRuntimeError)
+{
+    CancellationToken token;
+    token.cancel();
+
+    EXPECT_THROW(token.throw_if_cancelled(), std::runtime_error);
+}
+
+} // namespace formula::test
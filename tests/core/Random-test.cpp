@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/core/Random.h>
+
+#include <gtest/gtest.h>
+
+namespace formula::test
+{
+
+TEST(TestRandom, philoxMatchesZeroKnownAnswer)
+{
+    const PhiloxCounter expected{0x6627e8d5U, 0xe169c58dU, 0xbc57ac4cU, 0x9b00dbd8U};
+
+    EXPECT_EQ(expected, philox4x32({0U, 0U, 0U, 0U}, {0U, 0U}));
+}
+
+TEST(TestRandom, philoxMatchesOnesKnownAnswer)
+{
+    const PhiloxCounter expected{0x408f276dU, 0x41c83b0eU, 0xa20bc7c6U, 0x6d5451fdU};
+
+    EXPECT_EQ(expected,
+        philox4x32({0xffffffffU, 0xffffffffU, 0xffffffffU, 0xffffffffU}, {0xffffffffU, 0xffffffffU}));
+}
+
+TEST(TestRandom, randomComplexIsInUnitSquare)
+{
+    for (std::uint32_t counter = 0; counter < 1000; ++counter)
+    {
+        const Complex value{random_complex(1234U, 56U, counter)};
+
+        ASSERT_GE(value.re, 0.0);
+        ASSERT_LT(value.re, 1.0);
+        ASSERT_GE(value.im, 0.0);
+        ASSERT_LT(value.im, 1.0);
+    }
+}
+
+TEST(TestRandom, valueDependsOnlyOnSeedStreamAndCounter)
+{
+    RandomState first;
+    first.seed(7U);
+    first.set_stream(100U);
+    first.next();
+    RandomState second;
+    second.seed(7U);
+    second.set_stream(100U);
+    second.next();
+
+    EXPECT_EQ(first.next(), second.next());
+    EXPECT_EQ(random_complex(7U, 100U, 2U), first.next());
+}
+
+TEST(TestRandom, streamsAreIndependent)
+{
+    EXPECT_NE(random_complex(7U, 0U, 0U), random_complex(7U, 1U, 0U));
+    EXPECT_NE(random_complex(7U, 0U, 0U), random_complex(8U, 0U, 0U));
+    EXPECT_NE(random_complex(7U, 0U, 0U), random_complex(7U, 0U, 1U));
+    EXPECT_NE(random_complex(7U, 0U, 0U), random_complex(7U, 1ULL << 32, 0U));
+}
+
+TEST(TestRandom, selectingStreamRestartsCounter)
+{
+    RandomState state;
+    state.seed(3U);
+    state.next();
+
+    state.set_stream(9U);
+
+    EXPECT_EQ(0U, state.counter());
+    EXPECT_EQ(random_complex(3U, 9U, 0U), state.next());
+}
+
+} // namespace formula::test
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/core/Trace.h>
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace formula::test
+{
+
+namespace
+{
+
+std::string trace_json()
+{
+    std::ostringstream json;
+    trace::write_json(json);
+    return json.str();
+}
+
+std::set<std::string> thread_ids(const std::string &json)
+{
+    std::set<std::string> result;
+    const std::string key{"\"tid\":"};
+    for (std::size_t pos = json.find(key); pos != std::string::npos; pos = json.find(key, pos + 1))
+    {
+        const std::size_t begin{pos + key.size()};
+        result.insert(json.substr(begin, json.find('}', begin) - begin));
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(TestTrace, disabledScopeRecordsNothing)
+{
+    trace::start();
+    trace::stop();
+
+    {
+        const trace::Scope scope{"ignored"};
+    }
+
+    EXPECT_FALSE(trace::enabled());
+    EXPECT_EQ(0U, trace::event_count());
+}
+
+TEST(TestTrace, scopeRecordsCompleteEvent)
+{
+    trace::start();
+
+    {
+        const trace::Scope scope{"work", "test"};
+    }
+    trace::stop();
+
+    const std::string json{trace_json()};
+    EXPECT_EQ(1U, trace::event_count());
+    EXPECT_NE(std::string::npos, json.find("{\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"work\",\"cat\":\"test\",\"ph\":\"X\",\"ts\":"));
+    EXPECT_NE(std::string::npos, json.find("\"dur\":"));
+}
+
+TEST(TestTrace, startDiscardsEarlierEvents)
+{
+    trace::start();
+    {
+        const trace::Scope scope{"first"};
+    }
+
+    trace::start();
+    {
+        const trace::Scope scope{"second"};
+    }
+    trace::stop();
+
+    const std::string json{trace_json()};
+    EXPECT_EQ(std::string::npos, json.find("first"));
+    EXPECT_NE(std::string::npos, json.find("second"));
+}
+
+TEST(TestTrace, threadsHaveTheirOwnIds)
+{
+    trace::start();
+
+    {
+        const trace::Scope scope{"main"};
+    }
+    std::thread worker{[] { const trace::Scope scope{"worker"}; }};
+    worker.join();
+    trace::stop();
+
+    EXPECT_EQ(2U, trace::event_count());
+    EXPECT_EQ(2U, thread_ids(trace_json()).size());
+}
+
+TEST(TestTrace, namesAreEscaped)
+{
+    trace::start();
+
+    {
+        const trace::Scope scope{"say \"hi\"\\"};
+    }
+    trace::stop();
+
+    EXPECT_NE(std::string::npos, trace_json().find("\"name\":\"say \\\"hi\\\"\\\\\""));
+}
+
+} // namespace formula::test
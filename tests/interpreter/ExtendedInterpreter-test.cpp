@@ -7,6 +7,8 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -2447,6 +2449,24 @@ TEST(TestExtendedInterpreter, transformationWritesPixelAndSolid)
     EXPECT_EQ(Value{true}, interpreter.value("#solid"));
 }
 
+TEST(TestExtendedInterpreter, boundPredefinedIsSharedBetweenInterpreters)
+{
+    ExtendedInterpreter transform{formula_entry("transform:\n"
+                                                "#pixel=#pixel*2"),
+        options(parser::EntryKind::TRANSFORMATION)};
+    ExtendedInterpreter fractal{formula_entry("init:\n"
+                                              "#pixel"),
+        options(parser::EntryKind::FRACTAL)};
+    const auto pixel{std::make_shared<Value>(Value{Complex{1.0, 2.0}})};
+    transform.bind_predefined("#pixel", pixel);
+    fractal.bind_predefined("#pixel", pixel);
+
+    transform.interpret(Section::TRANSFORM);
+
+    EXPECT_EQ((Value{Complex{2.0, 4.0}}), *pixel);
+    EXPECT_EQ((Value{Complex{2.0, 4.0}}), fractal.interpret(Section::INITIALIZE));
+}
+
 TEST(TestExtendedInterpreter, coloringWritesIndexAndSolid)
 {
     ExtendedInterpreter interpreter{formula_entry("final:\n"
@@ -2981,6 +3001,19 @@ TEST(TestExtendedInterpreter, loopGuardRejectsRunawayLoops)
     EXPECT_THROW(interpreter.interpret(Section::INITIALIZE), std::runtime_error);
 }
 
+TEST(TestExtendedInterpreter, cancellationStopsRunningLoops)
+{
+    ExtendedInterpreter interpreter{formula_entry("init:\n"
+                                                  "while true\n"
+                                                  "endwhile"),
+        options()};
+    ASSERT_TRUE(interpreter.ok());
+    const CancellationToken deadline{CancellationToken::Clock::now() + std::chrono::milliseconds(20)};
+    interpreter.set_cancellation(&deadline);
+
+    EXPECT_THROW(interpreter.interpret(Section::INITIALIZE), CancelledError);
+}
+
 TEST(TestExtendedInterpreter, interpretsForwardFunctionCalls)
 {
     EXPECT_EQ(Value{3},
@@ -153,6 +153,20 @@ TEST(TestExtendedRuntime, parameterAndPredefinedNamesUseSigilFreeKeys)
     EXPECT_EQ((Value{Complex{1.0, 2.0}}), state.predefined_value("#pixel"));
 }
 
+TEST(TestExtendedRuntime, boundPredefinedSharesStorage)
+{
+    ExtendedRuntimeState first;
+    ExtendedRuntimeState second;
+    const auto storage{std::make_shared<Value>(Value{1})};
+    first.bind_predefined_reference("#numiter", RuntimeLValue::variable(storage));
+    second.bind_predefined_reference("numiter", RuntimeLValue::variable(storage));
+
+    first.predefined_lvalue("numiter").set(Value{4});
+
+    EXPECT_EQ(Value{4}, *storage);
+    EXPECT_EQ(Value{4}, second.predefined_value("#numiter"));
+}
+
 TEST(TestExtendedRuntime, readOnlyLvalueRejectsAssignment)
 {
     ExtendedRuntimeState state;
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/interpreter/LayerPipeline.h>
+
+#include <formula/parser/Parser.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace formula::test
+{
+
+namespace
+{
+
+using parameter::ParameterReferenceKind;
+
+constexpr const char *MANDELBROT{"init:\n"
+                                 "z = #pixel\n"
+                                 "loop:\n"
+                                 "z = z*z + #pixel\n"
+                                 "bailout:\n"
+                                 "|z| < 4\n"};
+
+// Sums the iterates, and adds the iteration count to the angle of the sum at the end.
+constexpr const char *SUM_ANGLE{"init:\n"
+                                "complex sum = 0\n"
+                                "loop:\n"
+                                "sum = sum + #z\n"
+                                "final:\n"
+                                "#index = atan2(sum) + #numiter\n"
+                                "#index\n"};
+
+constexpr const char *GREEN{"final:\n"
+                            "#color = rgb(0,1,0)\n"
+                            "#color\n"};
+
+parser::EntryKind entry_kind(ParameterReferenceKind kind)
+{
+    switch (kind)
+    {
+    case ParameterReferenceKind::FRACTAL_FORMULA:
+        return parser::EntryKind::FRACTAL;
+    case ParameterReferenceKind::INSIDE_COLORING:
+    case ParameterReferenceKind::OUTSIDE_COLORING:
+        return parser::EntryKind::COLORING;
+    case ParameterReferenceKind::TRANSFORM:
+        return parser::EntryKind::TRANSFORMATION;
+    }
+    return parser::EntryKind::FRACTAL;
+}
+
+void add_reference(parameter::ParameterReferenceSet &references, ParameterReferenceKind kind, std::string body,
+    std::size_t layer = 0, std::size_t transform = 0)
+{
+    parser::Options parser_options;
+    parser_options.dialect = Dialect::EXTENDED;
+    parser_options.entry_kind = entry_kind(kind);
+    const parser::ParserPtr parser{parser::create_parser(body, parser_options)};
+    ast::FormulaSectionsPtr ast{parser->parse()};
+    EXPECT_TRUE(parser->get_errors().empty()) << body;
+
+    parameter::ParameterReference reference;
+    reference.filename = "layer.ufm";
+    reference.entry = "Entry" + std::to_string(references.resolved.size());
+    reference.site = {kind, layer, transform};
+    FileEntry entry;
+    entry.name = reference.entry;
+    entry.body = std::move(body);
+    references.resolved.push_back({std::move(reference), std::move(entry), std::move(ast), parser_options.entry_kind});
+}
+
+PreparedParameterSet prepare(const parameter::ParameterReferenceSet &references)
+{
+    ExtendedInterpreterOptions options;
+    options.parser.dialect = Dialect::EXTENDED;
+    PreparedParameterSet result{prepare_parameter_interpreters(references, options)};
+    EXPECT_TRUE(result.ok()) << (result.ok() ? std::string{} : result.diagnostics.front().message);
+    return result;
+}
+
+} // namespace
+
+TEST(TestLayerPipeline, outsideColoringSeesEveryIterate)
+{
+    parameter::ParameterReferenceSet references;
+    add_reference(references, ParameterReferenceKind::FRACTAL_FORMULA, MANDELBROT);
+    add_reference(references, ParameterReferenceKind::OUTSIDE_COLORING, SUM_ANGLE);
+    PreparedParameterSet prepared{prepare(references)};
+    LayerPipeline pipeline{prepared, 0};
+
+    // 2i iterates to -4+2i, whose squared modulus fails the bailout.
+    const LayerPixel result{pipeline.evaluate({0.0, 2.0}, 10)};
+
+    EXPECT_TRUE(result.escaped);
+    EXPECT_EQ(1, result.iterations);
+    EXPECT_EQ((Complex{-4.0, 2.0}), result.z);
+    EXPECT_EQ(Value{std::atan2(2.0, -4.0) + 1.0}, result.index);
+}
+
+TEST(TestLayerPipeline, insideColoringFinishesTrappedPixels)
+{
+    parameter::ParameterReferenceSet references;
+    add_reference(references, ParameterReferenceKind::FRACTAL_FORMULA, MANDELBROT);
+    add_reference(references, ParameterReferenceKind::INSIDE_COLORING, GREEN);
+    add_reference(references, ParameterReferenceKind::OUTSIDE_COLORING, SUM_ANGLE);
+    PreparedParameterSet prepared{prepare(references)};
+    LayerPipeline pipeline{prepared, 0};
+
+    const LayerPixel result{pipeline.evaluate({0.0, 0.0}, 5)};
+
+    EXPECT_FALSE(result.escaped);
+    EXPECT_EQ(5, result.iterations);
+    EXPECT_EQ((Value{ColorValue{0.0, 1.0, 0.0, 1.0}}), result.color);
+    EXPECT_EQ(Value{0.0}, result.index);
+}
+
+TEST(TestLayerPipeline, pixelsDontLeakColoringState)
+{
+    parameter::ParameterReferenceSet references;
+    add_reference(references, ParameterReferenceKind::FRACTAL_FORMULA, MANDELBROT);
+    add_reference(references, ParameterReferenceKind::OUTSIDE_COLORING, SUM_ANGLE);
+    PreparedParameterSet prepared{prepare(references)};
+    LayerPipeline pipeline{prepared, 0};
+
+    const LayerPixel first{pipeline.evaluate({0.0, 2.0}, 10)};
+    const LayerPixel second{pipeline.evaluate({0.0, 2.0}, 10)};
+
+    EXPECT_EQ(first.index, second.index);
+}
+
+TEST(TestLayerPipeline, transformsRunInDeclaredOrder)
+{
+    parameter::ParameterReferenceSet references;
+    add_reference(references, ParameterReferenceKind::TRANSFORM,
+        "transform:\n"
+        "#pixel = #pixel + 1\n",
+        0, 1);
+    add_reference(references, ParameterReferenceKind::TRANSFORM,
+        "transform:\n"
+        "#pixel = #pixel * 2\n",
+        0, 0);
+    add_reference(references, ParameterReferenceKind::FRACTAL_FORMULA, MANDELBROT);
+    PreparedParameterSet prepared{prepare(references)};
+    LayerPipeline pipeline{prepared, 0};
+
+    // 0 doubles to 0 and moves to 1, which iterates to 2.
+    const LayerPixel result{pipeline.evaluate({0.0, 0.0}, 10)};
+
+    EXPECT_TRUE(result.escaped);
+    EXPECT_EQ((Complex{2.0, 0.0}), result.z);
+}
+
+TEST(TestLayerPipeline, solidTransformSkipsTheFractal)
+{
+    parameter::ParameterReferenceSet references;
+    add_reference(references, ParameterReferenceKind::TRANSFORM,
+        "transform:\n"
+        "#solid = true\n");
+    add_reference(references, ParameterReferenceKind::FRACTAL_FORMULA, MANDELBROT);
+    PreparedParameterSet prepared{prepare(references)};
+    LayerPipeline pipeline{prepared, 0};
+
+    const LayerPixel result{pipeline.evaluate({1.0, 0.0}, 10)};
+
+    EXPECT_TRUE(result.solid);
+    EXPECT_FALSE(result.escaped);
+    EXPECT_EQ(0, result.iterations);
+}
+
+TEST(TestLayerPipeline, pipelineUsesOnlyItsLayer)
+{
+    parameter::ParameterReferenceSet references;
+    add_reference(references, ParameterReferenceKind::FRACTAL_FORMULA, MANDELBROT, 0);
+    add_reference(references, ParameterReferenceKind::TRANSFORM,
+        "transform:\n"
+        "#solid = true\n",
+        1);
+    add_reference(references, ParameterReferenceKind::FRACTAL_FORMULA, MANDELBROT, 1);
+    PreparedParameterSet prepared{prepare(references)};
+    LayerPipeline pipeline{prepared, 0};
+
+    const LayerPixel result{pipeline.evaluate({1.0, 0.0}, 10)};
+
+    EXPECT_FALSE(result.solid);
+    EXPECT_TRUE(result.escaped);
+}
+
+TEST(TestLayerPipeline, layerWithoutFractalIsRejected)
+{
+    parameter::ParameterReferenceSet references;
+    add_reference(references, ParameterReferenceKind::FRACTAL_FORMULA, MANDELBROT, 0);
+    PreparedParameterSet prepared{prepare(references)};
+
+    EXPECT_THROW((LayerPipeline{prepared, 1}), std::runtime_error);
+}
+
+} // namespace formula::test
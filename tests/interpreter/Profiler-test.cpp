@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/interpreter/Profiler.h>
+
+#include <formula/facade/Formula.h>
+#include <formula/interpreter/ExtendedInterpreter.h>
+#include <formula/parser/ParseOptions.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+using namespace formula::parser;
+
+namespace formula::test
+{
+
+namespace
+{
+
+constexpr const char *MANDELBROT{"z = pixel:\n"
+                                 "z = z*z + pixel\n"
+                                 "|z| < 4"};
+
+Options basic_options()
+{
+    Options options;
+    options.dialect = Dialect::BASIC;
+    options.record_locations = true;
+    return options;
+}
+
+const LineProfile *find_line(const std::vector<LineProfile> &lines, std::size_t line)
+{
+    const auto it = std::find_if(
+        lines.begin(), lines.end(), [line](const LineProfile &entry) { return entry.line == line; });
+    return it == lines.end() ? nullptr : &*it;
+}
+
+} // namespace
+
+TEST(TestExecutionProfile, nestedNodesSplitSelfAndInclusiveTime)
+{
+    ExecutionProfile profile;
+    const ast::IdentifierNode outer{"outer"};
+    const ast::IdentifierNode inner{"inner"};
+    const ast::Node *outer_node{&outer};
+    const ast::Node *inner_node{&inner};
+
+    profile.begin_section(Section::ITERATE);
+    profile.begin_node(outer_node);
+    profile.begin_node(inner_node);
+    profile.end();
+    profile.end();
+    profile.end();
+
+    EXPECT_EQ(1U, profile.section(Section::ITERATE).count);
+    ASSERT_EQ(2U, profile.nodes().size());
+    const NodeProfile &outer_profile{profile.nodes().at(outer_node)};
+    const NodeProfile &inner_profile{profile.nodes().at(inner_node)};
+    EXPECT_EQ(nullptr, outer_profile.parent);
+    EXPECT_EQ(outer_node, inner_profile.parent);
+    EXPECT_EQ(outer_profile.inclusive, outer_profile.self + inner_profile.inclusive);
+    EXPECT_LE(outer_profile.inclusive, profile.section(Section::ITERATE).inclusive);
+}
+
+TEST(TestExecutionProfile, recursionCountsInclusiveTimeOnce)
+{
+    ExecutionProfile profile;
+    const ast::IdentifierNode identifier{"f"};
+    const ast::Node *node{&identifier};
+
+    profile.begin_node(node);
+    profile.begin_node(node);
+    profile.end();
+    profile.end();
+
+    const NodeProfile &counter{profile.nodes().at(node)};
+    EXPECT_EQ(2U, counter.count);
+    EXPECT_EQ(counter.inclusive, counter.self);
+}
+
+TEST(TestExecutionProfile, interpreterCountsSectionsAndLines)
+{
+    const FormulaPtr formula{create_formula(MANDELBROT, basic_options())};
+    ASSERT_TRUE(formula);
+    ExecutionProfile profile;
+    formula->set_profile(&profile);
+    formula->set_value("pixel", {0.1, 0.1});
+
+    formula->interpret(Section::INITIALIZE);
+    for (int i = 0; i < 5; ++i)
+    {
+        formula->interpret(Section::ITERATE);
+        formula->interpret(Section::BAILOUT);
+    }
+
+    EXPECT_EQ(1U, profile.section(Section::INITIALIZE).count);
+    EXPECT_EQ(5U, profile.section(Section::ITERATE).count);
+    EXPECT_EQ(5U, profile.section(Section::BAILOUT).count);
+    const std::vector<LineProfile> lines{hottest_lines(profile)};
+    const LineProfile *init{find_line(lines, 1)};
+    const LineProfile *loop{find_line(lines, 2)};
+    const LineProfile *bailout{find_line(lines, 3)};
+    ASSERT_NE(nullptr, init);
+    ASSERT_NE(nullptr, loop);
+    ASSERT_NE(nullptr, bailout);
+    EXPECT_EQ(1U, init->count);
+    EXPECT_EQ(5U, loop->count);
+    EXPECT_EQ(5U, bailout->count);
+    EXPECT_EQ(nullptr, find_line(lines, 0));
+}
+
+TEST(TestExecutionProfile, detachedProfileStopsRecording)
+{
+    const FormulaPtr formula{create_formula(MANDELBROT, basic_options())};
+    ASSERT_TRUE(formula);
+    ExecutionProfile profile;
+    formula->set_profile(&profile);
+    formula->interpret(Section::INITIALIZE);
+
+    formula->set_profile(nullptr);
+    formula->interpret(Section::INITIALIZE);
+
+    EXPECT_EQ(1U, profile.section(Section::INITIALIZE).count);
+}
+
+TEST(TestExecutionProfile, hottestLinesHonorsLimit)
+{
+    const FormulaPtr formula{create_formula(MANDELBROT, basic_options())};
+    ASSERT_TRUE(formula);
+    ExecutionProfile profile;
+    formula->set_profile(&profile);
+    formula->interpret(Section::INITIALIZE);
+    formula->interpret(Section::ITERATE);
+    formula->interpret(Section::BAILOUT);
+
+    const std::vector<LineProfile> lines{hottest_lines(profile, 2)};
+
+    ASSERT_EQ(2U, lines.size());
+    EXPECT_GE(lines[0].self, lines[1].self);
+}
+
+TEST(TestExecutionProfile, extendedInterpreterRecordsLines)
+{
+    FileEntry entry;
+    entry.name = "Formula";
+    entry.body = "init:\n"
+                 "complex z = 0\n"
+                 "loop:\n"
+                 "z = z*z + #pixel\n";
+    ExtendedInterpreterOptions options;
+    options.parser.dialect = Dialect::EXTENDED;
+    options.parser.record_locations = true;
+    ExtendedInterpreter interpreter{entry, options};
+    ASSERT_TRUE(interpreter.ok());
+    ExecutionProfile profile;
+    interpreter.set_profile(&profile);
+
+    interpreter.interpret(Section::INITIALIZE);
+    interpreter.interpret(Section::ITERATE);
+    interpreter.interpret(Section::ITERATE);
+
+    EXPECT_EQ(1U, profile.section(Section::INITIALIZE).count);
+    EXPECT_EQ(2U, profile.section(Section::ITERATE).count);
+    const std::vector<LineProfile> lines{hottest_lines(profile)};
+    const LineProfile *loop{find_line(lines, 4)};
+    ASSERT_NE(nullptr, loop);
+    EXPECT_EQ(2U, loop->count);
+}
+
+TEST(TestExecutionProfile, textReportShowsSectionsAndSource)
+{
+    const FormulaPtr formula{create_formula(MANDELBROT, basic_options())};
+    ASSERT_TRUE(formula);
+    ExecutionProfile profile;
+    formula->set_profile(&profile);
+    formula->interpret(Section::INITIALIZE);
+    formula->interpret(Section::ITERATE);
+    std::ostringstream out;
+
+    write_profile_text(out, profile, MANDELBROT);
+
+    const std::string text{out.str()};
+    EXPECT_NE(std::string::npos, text.find("init"));
+    EXPECT_NE(std::string::npos, text.find("loop"));
+    EXPECT_NE(std::string::npos, text.find("| z = z*z + pixel"));
+    EXPECT_EQ(std::string::npos, text.find("bailout"));
+}
+
+TEST(TestExecutionProfile, jsonReportListsSectionsAndLines)
+{
+    const FormulaPtr formula{create_formula(MANDELBROT, basic_options())};
+    ASSERT_TRUE(formula);
+    ExecutionProfile profile;
+    formula->set_profile(&profile);
+    formula->interpret(Section::BAILOUT);
+    std::ostringstream out;
+
+    write_profile_json(out, profile);
+
+    const std::string json{out.str()};
+    EXPECT_NE(std::string::npos, json.find("{\"section\": \"bailout\", \"count\": 1"));
+    EXPECT_NE(std::string::npos, json.find("{\"line\": 3, \"count\": 1"));
+}
+
+} // namespace formula::test
@@ -14,9 +14,12 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <stdexcept>
 #include <string_view>
 
 using namespace formula::parser;
@@ -97,6 +100,215 @@ TEST(TestFormulaInterpreter, getValueUnknown)
     EXPECT_EQ(0.0, a.im);
 }
 
+TEST(TestFormulaInterpreter, lookupSymbolCreatesZeroValue)
+{
+    const FormulaPtr formula{create_formula("1", Options{})};
+    ASSERT_TRUE(formula);
+
+    const SymbolHandle a{formula->lookup_symbol("a")};
+
+    ASSERT_TRUE(a);
+    EXPECT_EQ((Complex{0.0, 0.0}), formula->get(a));
+}
+
+TEST(TestFormulaInterpreter, symbolHandleMatchesNamedAccess)
+{
+    const FormulaPtr formula{create_formula("1", Options{})};
+    ASSERT_TRUE(formula);
+    const SymbolHandle a{formula->lookup_symbol("a")};
+
+    formula->set(a, {1.0, 2.0});
+    formula->set_value("b", {3.0, 4.0});
+
+    EXPECT_EQ((Complex{1.0, 2.0}), formula->get_value("a"));
+    EXPECT_EQ((Complex{3.0, 4.0}), formula->get(formula->lookup_symbol("b")));
+}
+
+TEST(TestFormulaInterpreter, symbolHandlesStayValidAcrossInterpret)
+{
+    const FormulaPtr formula{create_formula("init:\n"
+                                            "z = a*2\n"
+                                            "w = z + 1\n",
+        Options{})};
+    ASSERT_TRUE(formula);
+    ASSERT_TRUE(formula->get_section(Section::INITIALIZE));
+    const SymbolHandle a{formula->lookup_symbol("a")};
+    const SymbolHandle z{formula->lookup_symbol("z")};
+
+    formula->set(a, {1.0, 1.0});
+    formula->interpret(Section::INITIALIZE);
+    const Complex first{formula->get(z)};
+    formula->set(a, {3.0, 0.0});
+    formula->interpret(Section::INITIALIZE);
+
+    EXPECT_EQ((Complex{2.0, 2.0}), first);
+    EXPECT_EQ((Complex{6.0, 0.0}), formula->get(z));
+    EXPECT_EQ((Complex{7.0, 0.0}), formula->get_value("w"));
+}
+
+namespace
+{
+
+// Interprets one pixel the way a renderer would, for comparison with interpret_batch.
+int interpret_orbit(Formula &formula, Complex pixel, std::uint64_t stream, int max_iterations)
+{
+    formula.set_random_stream(stream);
+    formula.set_value("pixel", pixel);
+    formula.interpret(Section::INITIALIZE);
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        formula.interpret(Section::ITERATE);
+        if (formula.interpret(Section::BAILOUT).re == 0.0)
+        {
+            return iteration;
+        }
+    }
+    return max_iterations;
+}
+
+constexpr const char *BATCH_FORMULA{"z = pixel:\n"
+                                    "z = z*z + pixel + (rand - 0.5)*0.01\n"
+                                    "|z| <= 4\n"};
+
+} // namespace
+
+TEST(TestFormulaInterpreter, interpretBatchMatchesSinglePixels)
+{
+    const FormulaPtr batch{create_formula(BATCH_FORMULA, Options{})};
+    const FormulaPtr single{create_formula(BATCH_FORMULA, Options{})};
+    ASSERT_TRUE(batch);
+    ASSERT_TRUE(single);
+    const std::array<double, 4> pixel_re{-2.0, -0.5, 0.3, 0.26};
+    const std::array<double, 4> pixel_im{1.0, 0.0, 0.5, 0.0};
+    const std::array<std::uint64_t, 4> streams{7U, 8U, 9U, 10U};
+    std::array<double, 4> z_re{};
+    std::array<double, 4> z_im{};
+    std::array<int, 4> iterations{};
+    bool escaped[4]{};
+    BatchInputs inputs;
+    inputs.pixel_re = pixel_re.data();
+    inputs.pixel_im = pixel_im.data();
+    inputs.random_streams = streams.data();
+    BatchOutputs outputs;
+    outputs.z_re = z_re.data();
+    outputs.z_im = z_im.data();
+    outputs.iterations = iterations.data();
+    outputs.escaped = escaped;
+
+    batch->interpret_batch(Section::ITERATE, inputs, outputs, 4, 50);
+
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        const int expected{interpret_orbit(*single, {pixel_re[i], pixel_im[i]}, streams[i], 50)};
+        EXPECT_EQ(expected, iterations[i]) << i;
+        EXPECT_EQ(expected < 50, escaped[i]) << i;
+        EXPECT_EQ(single->get_value("z"), (Complex{z_re[i], z_im[i]})) << i;
+    }
+    EXPECT_TRUE(escaped[0]);
+    EXPECT_FALSE(escaped[1]);
+}
+
+TEST(TestFormulaInterpreter, interpretBatchOverridesInitialZ)
+{
+    const FormulaPtr formula{create_formula("z = 0:\n"
+                                            "z = z + 1\n"
+                                            "|z| <= 25\n",
+        Options{})};
+    ASSERT_TRUE(formula);
+    const std::array<double, 2> z_re{0.0, 3.0};
+    const std::array<double, 2> z_im{0.0, 0.0};
+    std::array<int, 2> iterations{};
+    std::array<double, 2> result_re{};
+    std::array<double, 2> result_im{};
+    BatchInputs inputs;
+    inputs.z_re = z_re.data();
+    inputs.z_im = z_im.data();
+    BatchOutputs outputs;
+    outputs.iterations = iterations.data();
+    outputs.result_re = result_re.data();
+    outputs.result_im = result_im.data();
+
+    formula->interpret_batch(Section::ITERATE, inputs, outputs, 2, 10);
+
+    EXPECT_EQ(5, iterations[0]); // z reaches 6 on the sixth iteration
+    EXPECT_EQ(2, iterations[1]);
+    EXPECT_EQ(0.0, result_re[0]); // the failed bailout test
+}
+
+TEST(TestFormulaInterpreter, interpretBatchEvaluatesOtherSectionsOnce)
+{
+    const FormulaPtr formula{create_formula("init:\n"
+                                            "w = pixel*2\n",
+        Options{})};
+    ASSERT_TRUE(formula);
+    const std::array<double, 3> pixel_re{1.0, 2.0, 3.0};
+    const std::array<double, 3> pixel_im{0.0, 1.0, -1.0};
+    std::array<double, 3> result_re{};
+    std::array<double, 3> result_im{};
+    BatchInputs inputs;
+    inputs.pixel_re = pixel_re.data();
+    inputs.pixel_im = pixel_im.data();
+    BatchOutputs outputs;
+    outputs.result_re = result_re.data();
+    outputs.result_im = result_im.data();
+
+    formula->interpret_batch(Section::INITIALIZE, inputs, outputs, 3, 0);
+
+    EXPECT_EQ(4.0, result_re[1]);
+    EXPECT_EQ(2.0, result_im[1]);
+    EXPECT_EQ(6.0, result_re[2]);
+    EXPECT_EQ(-2.0, result_im[2]);
+}
+
+TEST(TestFormulaInterpreter, interpretBatchRejectsHalfSetPairs)
+{
+    const FormulaPtr formula{create_formula(BATCH_FORMULA, Options{})};
+    ASSERT_TRUE(formula);
+    const std::array<double, 1> values{0.5};
+    BatchInputs pixel_only;
+    pixel_only.pixel_re = values.data();
+    BatchInputs z_only;
+    z_only.z_im = values.data();
+    std::array<double, 1> out{};
+    BatchOutputs result_only;
+    result_only.result_re = out.data();
+
+    EXPECT_THROW(formula->interpret_batch(Section::ITERATE, pixel_only, {}, 1, 10), std::invalid_argument);
+    EXPECT_THROW(formula->interpret_batch(Section::ITERATE, z_only, {}, 1, 10), std::invalid_argument);
+    EXPECT_THROW(formula->interpret_batch(Section::ITERATE, {}, result_only, 1, 10), std::invalid_argument);
+}
+
+TEST(TestFormulaInterpreter, cancelledTokenStopsInterpret)
+{
+    const FormulaPtr formula{create_formula("z = z + 1", Options{})};
+    ASSERT_TRUE(formula);
+    CancellationToken token;
+    formula->set_cancellation(&token);
+    token.cancel();
+
+    EXPECT_THROW(formula->interpret(Section::BAILOUT), CancelledError);
+    formula->set_cancellation(nullptr);
+    EXPECT_EQ(1.0, formula->interpret(Section::BAILOUT).re);
+}
+
+TEST(TestFormulaInterpreter, cancelledTokenStopsInterpretBatch)
+{
+    const FormulaPtr formula{create_formula(BATCH_FORMULA, Options{})};
+    ASSERT_TRUE(formula);
+    const std::array<double, 2> pixel_re{-2.0, -0.5};
+    const std::array<double, 2> pixel_im{1.0, 0.0};
+    std::array<int, 2> iterations{};
+    BatchInputs inputs;
+    inputs.pixel_re = pixel_re.data();
+    inputs.pixel_im = pixel_im.data();
+    BatchOutputs outputs;
+    outputs.iterations = iterations.data();
+    const CancellationToken token{CancellationToken::Clock::now()};
+    formula->set_cancellation(&token);
+
+    EXPECT_THROW(formula->interpret_batch(Section::ITERATE, inputs, outputs, 2, 50), CancelledError);
+}
+
 TEST(TestFormulaInterpreter, basicUnknownVariableInterpretsAsZero)
 {
     const FormulaPtr formula{create_formula("missing + 1", Options{})};
@@ -1013,4 +1225,61 @@ TEST(TestFormulaInterpreter, ifMultipleElseIfStatementBodyFalse)
     EXPECT_EQ(0.0, z.im);
 }
 
+TEST(TestFormulaInterpreter, whileLoopRepeatsBodyWhileConditionHolds)
+{
+    const FormulaPtr formula{create_formula("while n<3\n"
+                                            "n=n+1\n"
+                                            "endwhile",
+        Options{})};
+    ASSERT_TRUE(formula) << "formula should have parsed";
+    ASSERT_TRUE(formula->get_section(Section::BAILOUT));
+
+    const Complex result{formula->interpret(Section::BAILOUT)};
+
+    EXPECT_EQ((Complex{0.0, 0.0}), result);
+    EXPECT_EQ((Complex{3.0, 0.0}), formula->get_value("n"));
+}
+
+TEST(TestFormulaInterpreter, repeatLoopRunsBodyBeforeCondition)
+{
+    const FormulaPtr formula{create_formula("repeat\n"
+                                            "n=n+1\n"
+                                            "until n>0",
+        Options{})};
+    ASSERT_TRUE(formula) << "formula should have parsed";
+    ASSERT_TRUE(formula->get_section(Section::BAILOUT));
+    formula->set_value("n", {5.0, 0.0});
+
+    const Complex result{formula->interpret(Section::BAILOUT)};
+
+    EXPECT_EQ((Complex{0.0, 0.0}), result);
+    EXPECT_EQ((Complex{6.0, 0.0}), formula->get_value("n"));
+}
+
+TEST(TestFormulaInterpreter, cancelledTokenStopsEndlessLoop)
+{
+    const FormulaPtr formula{create_formula("while 1\n"
+                                            "n=n+1\n"
+                                            "endwhile",
+        Options{})};
+    ASSERT_TRUE(formula) << "formula should have parsed";
+    const CancellationToken token{CancellationToken::Clock::now() + std::chrono::milliseconds(20)};
+    formula->set_cancellation(&token);
+
+    EXPECT_THROW(formula->interpret(Section::BAILOUT), CancelledError);
+    EXPECT_LT(0.0, formula->get_value("n").re);
+}
+
+TEST(TestFormulaInterpreter, endlessLoopStopsAtIterationLimit)
+{
+    const FormulaPtr formula{create_formula("repeat\n"
+                                            "n=n+1\n"
+                                            "until 0",
+        Options{})};
+    ASSERT_TRUE(formula) << "formula should have parsed";
+
+    EXPECT_THROW(formula->interpret(Section::BAILOUT), std::runtime_error);
+    EXPECT_EQ(static_cast<double>(ast::MAX_LOOP_ITERATIONS), formula->get_value("n").re);
+}
+
 } // namespace formula::test
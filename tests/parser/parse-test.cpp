@@ -15,6 +15,7 @@
 
 #include <cctype>
 #include <cmath>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -563,6 +564,110 @@ TEST(TestFormulaParse, builtinVariableSourceSpellingIsPreserved)
     EXPECT_EQ("identifier:Maxit", trim_ws(to_string(result->bailout)));
 }
 
+static Options located_options()
+{
+    Options options{basic_options()};
+    options.record_locations = true;
+    return options;
+}
+
+// Collects the nodes reachable from expr, for the node kinds a classic formula uses.
+static void collect_nodes(const ast::Expr &expr, std::set<const ast::Node *> &nodes)
+{
+    if (!expr)
+    {
+        return;
+    }
+    nodes.insert(expr.get());
+    if (const auto *seq = dynamic_cast<const ast::StatementSeqNode *>(expr.get()))
+    {
+        for (const ast::Expr &statement : seq->statements())
+        {
+            collect_nodes(statement, nodes);
+        }
+    }
+    else if (const auto *assign = dynamic_cast<const ast::AssignmentNode *>(expr.get()))
+    {
+        collect_nodes(assign->target(), nodes);
+        collect_nodes(assign->expression(), nodes);
+    }
+    else if (const auto *call = dynamic_cast<const ast::FunctionCallNode *>(expr.get()))
+    {
+        for (const ast::Expr &arg : call->args())
+        {
+            collect_nodes(arg, nodes);
+        }
+    }
+    else if (const auto *binary = dynamic_cast<const ast::BinaryOpNode *>(expr.get()))
+    {
+        collect_nodes(binary->left(), nodes);
+        collect_nodes(binary->right(), nodes);
+    }
+    else if (const auto *unary = dynamic_cast<const ast::UnaryOpNode *>(expr.get()))
+    {
+        collect_nodes(unary->operand(), nodes);
+    }
+}
+
+TEST(TestFormulaParse, locationsAreNotRecordedByDefault)
+{
+    const ast::FormulaSectionsPtr result{parse("z = pixel:\n"
+                                               "z = z*z + c\n"
+                                               "|z| < 4",
+        basic_options())};
+
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(result->locations.empty());
+}
+
+TEST(TestFormulaParse, locationsOnlyCoverLiveNodes)
+{
+    const ast::FormulaSectionsPtr result{parse("z = pixel:\n"
+                                               "z = fn1(z)\n"
+                                               "|z| < 4",
+        located_options())};
+
+    ASSERT_TRUE(result);
+    std::set<const ast::Node *> live;
+    collect_nodes(result->initialize, live);
+    collect_nodes(result->iterate, live);
+    collect_nodes(result->bailout, live);
+    for (const auto &[node, location] : result->locations)
+    {
+        EXPECT_EQ(1U, live.count(node)) << "line " << location.line << " column " << location.column;
+    }
+    const auto *iterate{dynamic_cast<const ast::StatementSeqNode *>(result->iterate.get())};
+    ASSERT_NE(nullptr, iterate);
+    ASSERT_EQ(1U, iterate->statements().size());
+    const auto *assign{dynamic_cast<const ast::AssignmentNode *>(iterate->statements().front().get())};
+    ASSERT_NE(nullptr, assign);
+    ASSERT_NE(nullptr, dynamic_cast<const ast::FunctionCallNode *>(assign->expression().get()));
+    EXPECT_EQ(5U, result->locations.at(assign->expression().get()).column);
+}
+
+TEST(TestFormulaParse, nodesRecordSourceLocations)
+{
+    const ast::FormulaSectionsPtr result{parse("z = pixel:\n"
+                                               "z = z*z + c\n"
+                                               "|z| < 4",
+        located_options())};
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result->iterate);
+    ASSERT_TRUE(result->bailout);
+    const auto *iterate{dynamic_cast<const ast::StatementSeqNode *>(result->iterate.get())};
+    ASSERT_NE(nullptr, iterate);
+    ASSERT_EQ(1U, iterate->statements().size());
+    const auto *assign{dynamic_cast<const ast::AssignmentNode *>(iterate->statements().front().get())};
+    ASSERT_NE(nullptr, assign);
+    EXPECT_EQ(2U, result->locations.at(iterate).line);
+    EXPECT_EQ(2U, result->locations.at(assign).line);
+    EXPECT_EQ(1U, result->locations.at(assign).column);
+    EXPECT_EQ(2U, result->locations.at(assign->expression().get()).line);
+    EXPECT_EQ(5U, result->locations.at(assign->expression().get()).column);
+    EXPECT_EQ(3U, result->locations.at(result->bailout.get()).line);
+}
+
 static std::vector<std::string> s_functions{
     "sin", "cos", "sinh", "cosh", "cosxx",      //
     "tan", "cotan", "tanh", "cotanh", "sqr",    //
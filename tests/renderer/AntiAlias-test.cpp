@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/AntiAlias.h>
+
+#include <formula/test/render-formulas.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace formula::renderer;
+
+namespace formula::test
+{
+
+namespace
+{
+
+RenderOptions small_options()
+{
+    RenderOptions result;
+    result.viewport.center = {-0.5, 0.0};
+    result.viewport.width = 3.0;
+    result.viewport.pixel_width = 16;
+    result.viewport.pixel_height = 12;
+    result.max_iterations = 32;
+    result.threads = 1;
+    return result;
+}
+
+RenderResult row_of(std::initializer_list<PixelResult> pixels)
+{
+    RenderResult result;
+    result.width = static_cast<int>(pixels.size());
+    result.height = 1;
+    result.pixels = pixels;
+    return result;
+}
+
+} // namespace
+
+TEST(TestAntiAlias, flatImageIsNotRefined)
+{
+    const RenderResult result{row_of({{3, {}, true}, {3, {}, true}, {3, {}, true}})};
+    const Coloring coloring;
+
+    const std::vector<bool> refined{refined_pixels(result, colorize(result, coloring), {})};
+
+    EXPECT_EQ(0, std::count(refined.begin(), refined.end(), true));
+}
+
+TEST(TestAntiAlias, escapeEdgeRefinesBothSides)
+{
+    const RenderResult result{row_of({{3, {}, true}, {3, {}, true}, {32, {}, false}, {32, {}, false}})};
+    const Coloring coloring;
+
+    const std::vector<bool> refined{refined_pixels(result, colorize(result, coloring), {})};
+
+    EXPECT_EQ((std::vector<bool>{false, true, true, false}), refined);
+}
+
+TEST(TestAntiAlias, colorThresholdControlsRefinement)
+{
+    const RenderResult result{row_of({{3, {}, true}, {4, {}, true}})};
+    Coloring coloring;
+    coloring.palette = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {100, 0, 0}, {120, 0, 0}};
+    const Image image{colorize(result, coloring)};
+    AntiAliasOptions options;
+    options.color_threshold = 20;
+
+    const std::vector<bool> loose{refined_pixels(result, image, options)};
+    options.color_threshold = 19;
+    const std::vector<bool> strict{refined_pixels(result, image, options)};
+
+    EXPECT_EQ((std::vector<bool>{false, false}), loose);
+    EXPECT_EQ((std::vector<bool>{true, true}), strict);
+}
+
+TEST(TestAntiAlias, onlyEdgePixelsAreSupersampled)
+{
+    const Coloring coloring;
+    const Image single{colorize(render(mandelbrot(), Backend::INTERPRETER, small_options()), coloring)};
+
+    const AntiAliasResult result{
+        render_antialiased(mandelbrot(), Backend::INTERPRETER, small_options(), coloring, {})};
+
+    EXPECT_GT(result.refined, 0U);
+    EXPECT_LT(result.refined, single.pixels.size());
+    EXPECT_EQ(single.pixels.size() + result.refined, result.stats.pixels);
+    std::size_t changed{};
+    for (std::size_t i = 0; i < single.pixels.size(); ++i)
+    {
+        changed += single.pixels[i] != result.image.pixels[i] ? 1U : 0U;
+    }
+    EXPECT_GT(changed, 0U);
+    EXPECT_LE(changed, result.refined);
+}
+
+TEST(TestAntiAlias, imageDoesNotDependOnThreadCount)
+{
+    const Coloring coloring;
+    RenderOptions options{small_options()};
+    const AntiAliasResult single{render_antialiased(mandelbrot(), Backend::INTERPRETER, options, coloring, {})};
+    options.threads = 3;
+
+    const AntiAliasResult threaded{render_antialiased(mandelbrot(), Backend::INTERPRETER, options, coloring, {})};
+
+    EXPECT_EQ(3, threaded.stats.threads);
+    EXPECT_EQ(single.refined, threaded.refined);
+    EXPECT_TRUE(single.image.pixels == threaded.image.pixels);
+}
+
+TEST(TestAntiAlias, highThresholdsMatchSingleSample)
+{
+    const Coloring coloring;
+    AntiAliasOptions antialias;
+    antialias.color_threshold = 255;
+    antialias.iteration_threshold = 1000;
+    RenderFormula formula{mandelbrot()};
+    formula.body = "z = 0:\n"
+                   "z = z*z + 0.1\n"
+                   "|z| <= 4\n";
+
+    const AntiAliasResult result{
+        render_antialiased(formula, Backend::INTERPRETER, small_options(), coloring, antialias)};
+
+    EXPECT_EQ(0U, result.refined);
+    EXPECT_TRUE(colorize(render(formula, Backend::INTERPRETER, small_options()), coloring).pixels ==
+        result.image.pixels);
+}
+
+TEST(TestAntiAlias, rejectsEmptyPalette)
+{
+    Coloring coloring;
+    coloring.palette.clear();
+
+    EXPECT_THROW(render_antialiased(mandelbrot(), Backend::INTERPRETER, small_options(), coloring, {}),
+        std::runtime_error);
+}
+
+} // namespace formula::test
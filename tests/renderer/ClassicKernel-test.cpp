@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/ClassicKernel.h>
+
+#include <formula/renderer/Renderer.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+using namespace formula::renderer;
+
+namespace formula::test
+{
+
+namespace
+{
+
+RenderFormula classic(std::string body)
+{
+    RenderFormula result;
+    result.name = "Classic";
+    result.body = std::move(body);
+    return result;
+}
+
+// Renders the formula with the kernel and the interpreter and compares every pixel.
+void expect_matches_interpreter(const RenderFormula &formula)
+{
+    ASSERT_TRUE(recognize_classic_formula(formula)) << formula.body;
+    RenderOptions options;
+    options.viewport.center = {-0.5, 0.0};
+    options.viewport.width = 3.0;
+    options.viewport.pixel_width = 48;
+    options.viewport.pixel_height = 36;
+    options.max_iterations = 64;
+    options.threads = 2;
+
+    const RenderResult expected{render(formula, Backend::INTERPRETER, options)};
+    const RenderResult actual{render(formula, Backend::KERNEL, options)};
+
+    for (std::size_t i = 0; i < expected.pixels.size(); ++i)
+    {
+        const PixelResult &want{expected.pixels[i]};
+        const PixelResult &got{actual.pixels[i]};
+        ASSERT_EQ(want.escaped, got.escaped) << formula.body << " pixel " << i;
+        ASSERT_EQ(want.iterations, got.iterations) << formula.body << " pixel " << i;
+        if (want.escaped)
+        {
+            EXPECT_NEAR(want.z.re, got.z.re, 1e-9 * (1.0 + std::abs(want.z.re))) << formula.body << " pixel " << i;
+            EXPECT_NEAR(want.z.im, got.z.im, 1e-9 * (1.0 + std::abs(want.z.im))) << formula.body << " pixel " << i;
+        }
+    }
+}
+
+} // namespace
+
+TEST(TestClassicKernel, backendName)
+{
+    EXPECT_EQ("kernel", to_string(Backend::KERNEL));
+}
+
+TEST(TestClassicKernel, mandelbrotMatchesInterpreter)
+{
+    expect_matches_interpreter(classic("z = pixel:\n"
+                                       "z = z*z + pixel\n"
+                                       "|z| <= 4\n"));
+}
+
+TEST(TestClassicKernel, juliaMatchesInterpreter)
+{
+    RenderFormula formula{classic("z = pixel:\n"
+                                  "z = sqr(z) + p1\n"
+                                  "|z| < 4\n")};
+    formula.values["p1"] = {-0.8, 0.156};
+
+    expect_matches_interpreter(formula);
+}
+
+TEST(TestClassicKernel, burningShipMatchesInterpreter)
+{
+    expect_matches_interpreter(classic("z = 0:\n"
+                                       "z = abs(z)*abs(z) + pixel\n"
+                                       "|z| <= 4\n"));
+}
+
+TEST(TestClassicKernel, mandel3MatchesInterpreter)
+{
+    expect_matches_interpreter(classic("z = pixel:\n"
+                                       "z = z*z*z + pixel\n"
+                                       "|z| <= 4\n"));
+}
+
+TEST(TestClassicKernel, renamedVariableMatchesInterpreter)
+{
+    // Both paths report the iterated variable w.
+    expect_matches_interpreter(classic("w = pixel:\n"
+                                       "w = w*w + pixel\n"
+                                       "|w| <= 4\n"));
+}
+
+TEST(TestClassicKernel, cardioidPixelIsNotIterated)
+{
+    const std::optional<semantic::ClassicFormula> formula{recognize_classic_formula(classic("z = pixel:\n"
+                                                                                            "z = z*z + pixel\n"
+                                                                                            "|z| <= 4\n"))};
+    ASSERT_TRUE(formula);
+    const PixelEvaluatorPtr evaluator{create_classic_evaluator(*formula)};
+
+    const PixelResult result{evaluator->evaluate({-0.1, 0.1}, 1000)};
+
+    EXPECT_EQ(1000, result.iterations);
+    EXPECT_FALSE(result.escaped);
+    EXPECT_EQ((Complex{-0.1, 0.1}), result.z);
+}
+
+TEST(TestClassicKernel, derivativeIsNotRecognized)
+{
+    RenderFormula formula{classic("z = pixel:\n"
+                                  "z = z*z + pixel\n"
+                                  "|z| <= 4\n")};
+    formula.derivative = true;
+
+    EXPECT_FALSE(recognize_classic_formula(formula));
+}
+
+} // namespace formula::test
@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/Image.h>
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace formula::renderer;
+
+namespace formula::test
+{
+
+namespace
+{
+
+Image two_by_one()
+{
+    Image result;
+    result.width = 2;
+    result.height = 1;
+    result.pixels = {{255, 0, 0}, {0, 0, 255}};
+    return result;
+}
+
+std::uint32_t read_u32(const std::string &bytes, std::size_t offset)
+{
+    std::uint32_t result{};
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        result = result << 8 | static_cast<std::uint8_t>(bytes[offset + i]);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(TestImage, defaultPaletteHas256Entries)
+{
+    const Palette palette{default_palette()};
+
+    ASSERT_EQ(256U, palette.size());
+    EXPECT_EQ((Color{0, 7, 100}), palette[0]);
+    EXPECT_EQ((Color{237, 255, 255}), palette[128]);
+}
+
+TEST(TestImage, colorizeUsesPaletteForEscapedAndInsideColorOtherwise)
+{
+    RenderResult result;
+    result.width = 3;
+    result.height = 1;
+    result.pixels = {{1, {}, true}, {4, {}, true}, {8, {}, false}};
+    const Palette palette{{10, 10, 10}, {20, 20, 20}, {30, 30, 30}};
+
+    const Image image{colorize(result, palette, {1, 2, 3})};
+
+    ASSERT_EQ(3, image.width);
+    ASSERT_EQ(1, image.height);
+    EXPECT_EQ((Color{20, 20, 20}), image.at(0, 0));
+    EXPECT_EQ((Color{20, 20, 20}), image.at(1, 0));
+    EXPECT_EQ((Color{1, 2, 3}), image.at(2, 0));
+}
+
+TEST(TestImage, colorizeRejectsEmptyPalette)
+{
+    const RenderResult result;
+
+    EXPECT_THROW(colorize(result, Palette{}), std::runtime_error);
+}
+
+TEST(TestImage, gradientPaletteInterpolatesBetweenControlPoints)
+{
+    gradient::GradientSection gradient;
+    gradient.points = {{0, {0, 0, 0}}, {200, {200, 100, 0}}};
+
+    const Palette palette{gradient_palette(gradient)};
+
+    ASSERT_EQ(400U, palette.size());
+    EXPECT_EQ((Color{0, 0, 0}), palette[0]);
+    EXPECT_EQ((Color{100, 50, 0}), palette[100]);
+    EXPECT_EQ((Color{200, 100, 0}), palette[200]);
+    EXPECT_EQ((Color{100, 50, 0}), palette[300]); // wraps back to the first point
+}
+
+TEST(TestImage, gradientPaletteAppliesRotationAndWrapsIndices)
+{
+    gradient::GradientSection gradient;
+    gradient.points = {{-10, {40, 40, 40}}};
+    gradient.rotation = 20;
+
+    const Palette palette{gradient_palette(gradient, 4)};
+
+    ASSERT_EQ(4U, palette.size());
+    EXPECT_EQ((Color{40, 40, 40}), palette[3]);
+}
+
+TEST(TestImage, gradientPaletteRejectsEmptyGradient)
+{
+    const gradient::GradientSection gradient;
+
+    EXPECT_THROW(gradient_palette(gradient), std::runtime_error);
+}
+
+TEST(TestImage, smoothIterationsOfEscapedPixel)
+{
+    const PixelResult pixel{3, {std::exp(2.0), 0.0}, true};
+
+    EXPECT_DOUBLE_EQ(3.0, smooth_iterations(pixel));
+}
+
+TEST(TestImage, distanceEstimateOfEscapedPixel)
+{
+    const PixelResult pixel{3, {std::exp(2.0), 0.0}, true, {0.0, 4.0}};
+
+    EXPECT_DOUBLE_EQ(std::exp(2.0) * 2.0 / 4.0, distance_estimate(pixel));
+}
+
+TEST(TestImage, distanceEstimateOfInsidePixelIsZero)
+{
+    const PixelResult pixel{64, {100.0, 0.0}, false, {1.0, 0.0}};
+
+    EXPECT_EQ(0.0, distance_estimate(pixel));
+}
+
+TEST(TestImage, smoothIterationsOfInsidePixelIsIterationCount)
+{
+    const PixelResult pixel{64, {100.0, 0.0}, false};
+
+    EXPECT_EQ(64.0, smooth_iterations(pixel));
+}
+
+TEST(TestImage, smoothColoringBlendsAdjacentEntries)
+{
+    Coloring coloring;
+    coloring.palette = {{0, 0, 0}, {100, 200, 50}};
+    coloring.smooth = true;
+
+    EXPECT_EQ((Color{50, 100, 25}), color_of(coloring, true, 0.5));
+    EXPECT_EQ((Color{50, 100, 25}), color_of(coloring, true, 1.5)); // wraps to entry 0
+}
+
+TEST(TestImage, coloringDensityAndOffsetScaleIndex)
+{
+    Coloring coloring;
+    coloring.palette = {{0, 0, 0}, {1, 1, 1}, {2, 2, 2}, {3, 3, 3}};
+    coloring.density = 2.0;
+    coloring.offset = 1.0;
+
+    EXPECT_EQ((Color{3, 3, 3}), color_of(coloring, true, 1.0));
+    EXPECT_EQ((Color{1, 1, 1}), color_of(coloring, true, 2.0));
+}
+
+TEST(TestImage, cumulativeDistributionCountsPixelsBelowEachIteration)
+{
+    IterationHistogram histogram;
+    histogram.counts = {0, 1, 3, 0};
+
+    EXPECT_EQ((std::vector<double>{0.0, 0.0, 0.25, 1.0, 1.0}), cumulative_distribution(histogram));
+    EXPECT_TRUE(cumulative_distribution(IterationHistogram{}).empty());
+}
+
+TEST(TestImage, equalizedColoringIndexesByCumulativeDistribution)
+{
+    Coloring coloring;
+    coloring.palette = {{0, 0, 0}, {1, 1, 1}, {2, 2, 2}, {3, 3, 3}};
+    coloring.equalization = {0.0, 0.0, 0.25, 1.0, 1.0};
+
+    EXPECT_EQ((Color{0, 0, 0}), color_of(coloring, true, 1.0));
+    EXPECT_EQ((Color{1, 1, 1}), color_of(coloring, true, 2.0));
+    EXPECT_EQ((Color{2, 2, 2}), color_of(coloring, true, 2.5)); // halfway between 0.25 and 1
+    EXPECT_EQ((Color{0, 0, 0}), color_of(coloring, true, 50.0)); // clamped to 1, wrapping to entry 0
+    EXPECT_EQ((Color{0, 0, 0}), color_of(coloring, true, -1.0));
+}
+
+TEST(TestImage, formatFromExtension)
+{
+    EXPECT_EQ(ImageFormat::PNG, image_format("out.png"));
+    EXPECT_EQ(ImageFormat::PNG, image_format("dir.v2/OUT.PNG"));
+    EXPECT_EQ(ImageFormat::PPM, image_format("out.ppm"));
+    EXPECT_FALSE(image_format("out.jpg"));
+    EXPECT_FALSE(image_format("out"));
+}
+
+TEST(TestImage, ppmIsBinaryPixmap)
+{
+    std::ostringstream out;
+
+    write_ppm(out, two_by_one());
+
+    EXPECT_EQ(std::string("P6\n2 1\n255\n\xff\x00\x00\x00\x00\xff", 17), out.str());
+}
+
+TEST(TestImage, pngHasSignatureAndHeader)
+{
+    std::ostringstream out;
+
+    write_png(out, two_by_one());
+
+    const std::string png{out.str()};
+    ASSERT_GT(png.size(), 33U);
+    EXPECT_EQ(std::string("\x89PNG\r\n\x1a\n"), png.substr(0, 8));
+    EXPECT_EQ(13U, read_u32(png, 8));
+    EXPECT_EQ("IHDR", png.substr(12, 4));
+    EXPECT_EQ(2U, read_u32(png, 16));
+    EXPECT_EQ(1U, read_u32(png, 20));
+    EXPECT_EQ(8, png[24]);
+    EXPECT_EQ(2, png[25]);
+    EXPECT_EQ(std::string("IEND\xae\x42\x60\x82"), png.substr(png.size() - 8));
+}
+
+TEST(TestImage, pngDataDecompressesToFilteredRows)
+{
+    std::ostringstream out;
+    write_png(out, two_by_one());
+    const std::string png{out.str()};
+    const std::size_t idat{33};
+    ASSERT_EQ("IDAT", png.substr(idat + 4, 4));
+    const std::uint32_t length{read_u32(png, idat)};
+
+    std::string raw(7, '\0');
+    uLongf raw_size{static_cast<uLongf>(raw.size())};
+    const int status{uncompress(reinterpret_cast<Bytef *>(raw.data()), &raw_size,
+        reinterpret_cast<const Bytef *>(png.data() + idat + 8), length)};
+
+    ASSERT_EQ(Z_OK, status);
+    EXPECT_EQ(std::string("\x00\xff\x00\x00\x00\x00\xff", 7), raw);
+    EXPECT_EQ(crc32(0L, reinterpret_cast<const Bytef *>(png.data() + idat + 4), length + 4),
+        read_u32(png, idat + 8 + length));
+}
+
+TEST(TestImage, largePngSplitsDataAcrossChunks)
+{
+    Image image;
+    image.width = 256;
+    image.height = 256;
+    std::uint32_t state{1U};
+    for (int i = 0; i < image.width * image.height; ++i)
+    {
+        state = state * 1664525U + 1013904223U; // incompressible noise
+        image.pixels.push_back({static_cast<std::uint8_t>(state >> 24), static_cast<std::uint8_t>(state >> 16),
+            static_cast<std::uint8_t>(state >> 8)});
+    }
+    std::ostringstream out;
+
+    write_png(out, image);
+
+    const std::string png{out.str()};
+    std::string compressed;
+    int idat_chunks{};
+    for (std::size_t offset = 8; offset < png.size();)
+    {
+        const std::uint32_t length{read_u32(png, offset)};
+        if (png.substr(offset + 4, 4) == "IDAT")
+        {
+            compressed += png.substr(offset + 8, length);
+            ++idat_chunks;
+        }
+        offset += 12 + length;
+    }
+    EXPECT_GT(idat_chunks, 1);
+    std::string raw(static_cast<std::size_t>(image.height) * (1 + 3 * image.width), '\0');
+    uLongf raw_size{static_cast<uLongf>(raw.size())};
+    ASSERT_EQ(Z_OK, uncompress(reinterpret_cast<Bytef *>(raw.data()), &raw_size,
+                        reinterpret_cast<const Bytef *>(compressed.data()), static_cast<uLong>(compressed.size())));
+    EXPECT_EQ(raw.size(), raw_size);
+    EXPECT_EQ(static_cast<char>(image.at(1, 1).green), raw[1 + 3 * image.width + 1 + 3 + 1]);
+}
+
+TEST(TestImage, streamWriterRejectsMissingAndExtraRows)
+{
+    const Image image{two_by_one()};
+    std::ostringstream out;
+    ImageStreamWriter writer{out, ImageFormat::PNG, image.width, image.height};
+
+    EXPECT_THROW(writer.finish(), std::runtime_error);
+    writer.write_row(image.pixels.data());
+    EXPECT_THROW(writer.write_row(image.pixels.data()), std::runtime_error);
+}
+
+TEST(TestImage, streamWriterRejectsEmptyImage)
+{
+    std::ostringstream out;
+
+    EXPECT_THROW((ImageStreamWriter{out, ImageFormat::PPM, 0, 1}), std::runtime_error);
+}
+
+} // namespace formula::test
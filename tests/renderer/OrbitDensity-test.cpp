@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/OrbitDensity.h>
+
+#include <formula/test/render-formulas.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+using namespace formula::renderer;
+
+namespace formula::test
+{
+
+namespace
+{
+
+RenderOptions whole_set(int threads)
+{
+    RenderOptions result;
+    result.viewport.center = {-0.5, 0.0};
+    result.viewport.width = 3.0;
+    result.viewport.pixel_width = 16;
+    result.viewport.pixel_height = 16;
+    result.max_iterations = 32;
+    result.threads = threads;
+    return result;
+}
+
+// Samples around 1.1, whose orbit escapes at 2.31 on the first iteration.
+OrbitDensityOptions escaping_at_once(std::uint64_t samples)
+{
+    OrbitDensityOptions result;
+    result.center = {1.1, 0.0};
+    result.width = 1e-9;
+    result.height = 1e-9;
+    result.samples = samples;
+    return result;
+}
+
+// A 3x3 image whose center pixel holds 2.31.
+RenderOptions around_two()
+{
+    RenderOptions result;
+    result.viewport.center = {2.0, 0.0};
+    result.viewport.width = 3.0;
+    result.viewport.pixel_width = 3;
+    result.viewport.pixel_height = 3;
+    result.max_iterations = 16;
+    result.threads = 2;
+    return result;
+}
+
+double total(const OrbitDensityResult &result)
+{
+    double sum{};
+    for (const double value : result.density)
+    {
+        sum += value;
+    }
+    return sum;
+}
+
+} // namespace
+
+TEST(TestOrbitDensity, orbitPointsLandInTheirPixels)
+{
+    const OrbitDensityResult result{
+        render_orbit_density(mandelbrot(), Backend::INTERPRETER, around_two(), escaping_at_once(3000))};
+
+    ASSERT_EQ(9U, result.density.size());
+    for (std::size_t i = 0; i < result.density.size(); ++i)
+    {
+        EXPECT_EQ(i == 4 ? 3000.0 : 0.0, result.density[i]) << i;
+    }
+    EXPECT_EQ(3000U, result.stats.pixels);
+    EXPECT_EQ(3000U, result.stats.iterations);
+}
+
+TEST(TestOrbitDensity, shortOrbitsAreNotRecorded)
+{
+    OrbitDensityOptions density{escaping_at_once(100)};
+    density.min_iterations = 1;
+
+    const OrbitDensityResult result{render_orbit_density(mandelbrot(), Backend::INTERPRETER, around_two(), density)};
+
+    EXPECT_EQ(0.0, total(result));
+}
+
+TEST(TestOrbitDensity, resultDoesNotDependOnThreadCount)
+{
+    OrbitDensityOptions density;
+    density.samples = 3000;
+
+    const OrbitDensityResult one{render_orbit_density(mandelbrot(), Backend::KERNEL, whole_set(1), density)};
+    const OrbitDensityResult three{render_orbit_density(mandelbrot(), Backend::KERNEL, whole_set(3), density)};
+
+    EXPECT_LT(0.0, total(one));
+    EXPECT_EQ(one.density, three.density);
+}
+
+TEST(TestOrbitDensity, kernelMatchesInterpreter)
+{
+    OrbitDensityOptions density;
+    density.samples = 2000;
+    density.sampling = OrbitSampling::STRATIFIED;
+
+    const OrbitDensityResult expected{render_orbit_density(mandelbrot(), Backend::INTERPRETER, whole_set(2), density)};
+    const OrbitDensityResult actual{render_orbit_density(mandelbrot(), Backend::KERNEL, whole_set(2), density)};
+
+    EXPECT_EQ(expected.density, actual.density);
+}
+
+TEST(TestOrbitDensity, stratifiedSamplingUsesSquareGrid)
+{
+    OrbitDensityOptions density;
+    density.samples = 1000;
+    density.sampling = OrbitSampling::STRATIFIED;
+
+    const OrbitDensityResult result{render_orbit_density(mandelbrot(), Backend::KERNEL, whole_set(2), density)};
+
+    EXPECT_EQ(961U, result.stats.pixels);
+}
+
+TEST(TestOrbitDensity, importanceWeightsAverageOneAndStayPositive)
+{
+    OrbitDensityOptions density;
+    density.importance_grid = 8;
+
+    const std::vector<double> weights{orbit_importance(mandelbrot(), Backend::KERNEL, whole_set(2), density)};
+
+    ASSERT_EQ(64U, weights.size());
+    double sum{};
+    for (const double weight : weights)
+    {
+        EXPECT_LT(0.0, weight);
+        sum += weight;
+    }
+    EXPECT_NEAR(64.0, sum, 1e-9);
+}
+
+TEST(TestOrbitDensity, importanceSamplingEstimatesEvenSampling)
+{
+    OrbitDensityOptions density;
+    density.samples = 40000;
+    const OrbitDensityResult even{render_orbit_density(mandelbrot(), Backend::KERNEL, whole_set(2), density)};
+    density.importance_grid = 16;
+    density.sampling = OrbitSampling::STRATIFIED;
+
+    const OrbitDensityResult weighted{render_orbit_density(mandelbrot(), Backend::KERNEL, whole_set(2), density)};
+
+    EXPECT_NEAR(total(even), total(weighted), 0.1 * total(even));
+}
+
+TEST(TestOrbitDensity, colorizeScalesBySquareRootOfMaximum)
+{
+    OrbitDensityResult result;
+    result.width = 3;
+    result.height = 1;
+    result.density = {0.0, 4.0, 16.0};
+    Coloring coloring;
+    coloring.palette = {{0, 0, 0}, {10, 10, 10}, {20, 20, 20}};
+    coloring.inside = {1, 2, 3};
+
+    const Image image{colorize(result, coloring)};
+
+    EXPECT_EQ((Color{1, 2, 3}), image.pixels[0]);
+    EXPECT_EQ((Color{10, 10, 10}), image.pixels[1]);
+    EXPECT_EQ((Color{20, 20, 20}), image.pixels[2]);
+}
+
+} // namespace formula::test
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/PixelEvaluator.h>
+
+#include <formula/test/render-formulas.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace formula::renderer;
+
+namespace formula::test
+{
+
+namespace
+{
+
+RenderFormula extended_mandelbrot()
+{
+    RenderFormula result;
+    result.name = "Mandelbrot";
+    result.body = "init:\n"
+                  "  z = #pixel\n"
+                  "loop:\n"
+                  "  z = z*z + #pixel\n"
+                  "bailout:\n"
+                  "  |z| <= 4\n";
+    result.dialect = Dialect::EXTENDED;
+    return result;
+}
+
+} // namespace
+
+TEST(TestPixelEvaluator, backendNames)
+{
+    EXPECT_EQ("interpreter", to_string(Backend::INTERPRETER));
+    EXPECT_EQ("compiler", to_string(Backend::COMPILER));
+    EXPECT_EQ("extended", to_string(Backend::EXTENDED));
+}
+
+TEST(TestPixelEvaluator, pointInsideSetNeverEscapes)
+{
+    const PixelEvaluatorPtr evaluator{create_evaluator(mandelbrot(), Backend::INTERPRETER)};
+
+    const PixelResult result{evaluator->evaluate({0.0, 0.0}, 50)};
+
+    EXPECT_EQ(50, result.iterations);
+    EXPECT_FALSE(result.escaped);
+    EXPECT_EQ((Complex{0.0, 0.0}), result.z);
+}
+
+TEST(TestPixelEvaluator, pointOutsideSetEscapesOnFirstIteration)
+{
+    const PixelEvaluatorPtr evaluator{create_evaluator(mandelbrot(), Backend::INTERPRETER)};
+
+    const PixelResult result{evaluator->evaluate({2.0, 2.0}, 50)};
+
+    EXPECT_EQ(0, result.iterations);
+    EXPECT_TRUE(result.escaped);
+    EXPECT_EQ((Complex{2.0, 10.0}), result.z);
+}
+
+TEST(TestPixelEvaluator, valuesAndFunctionsAreApplied)
+{
+    RenderFormula formula;
+    formula.name = "Counter";
+    formula.body = "z = p1:\n"
+                   "z = fn1(z) + 1\n"
+                   "|z| <= 9\n";
+    formula.values["p1"] = {-1.0, 0.0};
+    formula.functions["fn1"] = "ident";
+    const PixelEvaluatorPtr evaluator{create_evaluator(formula, Backend::INTERPRETER)};
+
+    const PixelResult result{evaluator->evaluate({0.0, 0.0}, 50)};
+
+    EXPECT_EQ(4, result.iterations);
+    EXPECT_TRUE(result.escaped);
+    EXPECT_EQ((Complex{4.0, 0.0}), result.z);
+}
+
+TEST(TestPixelEvaluator, invalidFunctionThrows)
+{
+    RenderFormula formula{mandelbrot()};
+    formula.functions["fn1"] = "bogus";
+
+    EXPECT_THROW(create_evaluator(formula, Backend::INTERPRETER), std::runtime_error);
+}
+
+TEST(TestPixelEvaluator, invalidFormulaThrows)
+{
+    RenderFormula formula;
+    formula.name = "Invalid";
+    formula.body = "z = (:\n";
+
+    EXPECT_THROW(create_evaluator(formula, Backend::INTERPRETER), std::runtime_error);
+}
+
+TEST(TestPixelEvaluator, extendedMatchesInterpreter)
+{
+    const PixelEvaluatorPtr basic{create_evaluator(mandelbrot(), Backend::INTERPRETER)};
+    const PixelEvaluatorPtr extended{create_evaluator(extended_mandelbrot(), Backend::EXTENDED)};
+
+    for (const Complex pixel : {Complex{0.0, 0.0}, Complex{-0.75, 0.1}, Complex{0.3, 0.5}, Complex{1.0, 1.0}})
+    {
+        const PixelResult expected{basic->evaluate(pixel, 100)};
+        const PixelResult result{extended->evaluate(pixel, 100)};
+
+        EXPECT_EQ(expected.iterations, result.iterations);
+        EXPECT_EQ(expected.escaped, result.escaped);
+        EXPECT_NEAR(expected.z.re, result.z.re, 1e-12);
+        EXPECT_NEAR(expected.z.im, result.z.im, 1e-12);
+    }
+}
+
+TEST(TestPixelEvaluator, orbitEndsWithEvaluatedPixel)
+{
+    for (const auto &[formula, backend] : {std::pair{mandelbrot(), Backend::INTERPRETER},
+             std::pair{extended_mandelbrot(), Backend::EXTENDED}, std::pair{mandelbrot(), Backend::KERNEL}})
+    {
+        const PixelEvaluatorPtr evaluator{create_evaluator(formula, backend)};
+        const PixelResult expected{evaluator->evaluate({0.5, 0.5}, 50)};
+        std::vector<Complex> orbit{{9.0, 9.0}};
+
+        const PixelResult result{evaluator->evaluate_orbit({0.5, 0.5}, 50, orbit)};
+
+        ASSERT_TRUE(expected.escaped) << to_string(backend);
+        EXPECT_EQ(expected.iterations, result.iterations) << to_string(backend);
+        EXPECT_TRUE(result.escaped) << to_string(backend);
+        ASSERT_EQ(static_cast<std::size_t>(expected.iterations) + 1, orbit.size()) << to_string(backend);
+        EXPECT_EQ((Complex{0.5, 1.0}), orbit.front()) << to_string(backend);
+        EXPECT_EQ(expected.z, orbit.back()) << to_string(backend);
+    }
+}
+
+TEST(TestPixelEvaluator, compilerMatchesInterpreter)
+{
+    const PixelEvaluatorPtr interpreted{create_evaluator(mandelbrot(), Backend::INTERPRETER)};
+    const PixelEvaluatorPtr compiled{create_evaluator(mandelbrot(), Backend::COMPILER)};
+
+    for (const Complex pixel : {Complex{0.0, 0.0}, Complex{-0.75, 0.1}, Complex{0.3, 0.5}, Complex{1.0, 1.0}})
+    {
+        const PixelResult expected{interpreted->evaluate(pixel, 100)};
+        const PixelResult result{compiled->evaluate(pixel, 100)};
+
+        EXPECT_EQ(expected.iterations, result.iterations);
+        EXPECT_EQ(expected.escaped, result.escaped);
+        EXPECT_NEAR(expected.z.re, result.z.re, 1e-12);
+        EXPECT_NEAR(expected.z.im, result.z.im, 1e-12);
+    }
+}
+
+TEST(TestPixelEvaluator, derivativeTracksDzDpixel)
+{
+    RenderFormula formula{mandelbrot()};
+    formula.derivative = true;
+    const PixelEvaluatorPtr evaluator{create_evaluator(formula, Backend::INTERPRETER)};
+
+    // z1 = pixel^2 + pixel escapes at once, so dz1 = 2 pixel + 1.
+    const PixelResult result{evaluator->evaluate({2.0, 1.0}, 100)};
+
+    EXPECT_TRUE(result.escaped);
+    EXPECT_EQ(0, result.iterations);
+    EXPECT_EQ((Complex{5.0, 2.0}), result.dz);
+}
+
+TEST(TestPixelEvaluator, derivativeBatchMatchesSinglePixels)
+{
+    RenderFormula formula{mandelbrot()};
+    formula.derivative = true;
+    const PixelEvaluatorPtr single{create_evaluator(formula, Backend::INTERPRETER)};
+    const PixelEvaluatorPtr batch{create_evaluator(formula, Backend::INTERPRETER)};
+    const Complex pixels[3]{{-0.75, 0.1}, {0.3, 0.5}, {1.0, 1.0}};
+    const std::uint64_t streams[3]{};
+    PixelResult results[3]{};
+
+    batch->evaluate_batch(pixels, streams, results, 3, 100);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(single->evaluate(pixels[i], 100).dz, results[i].dz) << i;
+    }
+}
+
+TEST(TestPixelEvaluator, unsupportedDerivativeThrows)
+{
+    RenderFormula formula{mandelbrot()};
+    formula.body = "z = pixel:\n"
+                   "z = conj(z)*z + pixel\n"
+                   "|z| <= 4\n";
+    formula.derivative = true;
+    RenderFormula extended{extended_mandelbrot()};
+    extended.derivative = true;
+
+    EXPECT_THROW(create_evaluator(formula, Backend::INTERPRETER), std::runtime_error);
+    EXPECT_THROW(create_evaluator(extended, Backend::EXTENDED), std::runtime_error);
+}
+
+TEST(TestPixelEvaluator, compiledDerivativeMatchesInterpreter)
+{
+    RenderFormula formula{mandelbrot()};
+    formula.derivative = true;
+    const PixelEvaluatorPtr interpreted{create_evaluator(formula, Backend::INTERPRETER)};
+    const PixelEvaluatorPtr compiled{create_evaluator(formula, Backend::COMPILER)};
+
+    for (const Complex pixel : {Complex{-0.75, 0.1}, Complex{0.3, 0.5}, Complex{1.0, 1.0}})
+    {
+        const PixelResult expected{interpreted->evaluate(pixel, 100)};
+        const PixelResult result{compiled->evaluate(pixel, 100)};
+
+        EXPECT_NEAR(expected.dz.re, result.dz.re, 1e-9 * (1.0 + std::abs(expected.dz.re)));
+        EXPECT_NEAR(expected.dz.im, result.dz.im, 1e-9 * (1.0 + std::abs(expected.dz.im)));
+    }
+}
+
+} // namespace formula::test
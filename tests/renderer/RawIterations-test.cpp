@@ -0,0 +1,256 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/RawIterations.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace formula::renderer;
+
+namespace formula::test
+{
+
+namespace
+{
+
+RenderResult sample_result()
+{
+    RenderResult result;
+    result.width = 4;
+    result.height = 3;
+    for (int y = 0; y < result.height; ++y)
+    {
+        for (int x = 0; x < result.width; ++x)
+        {
+            const bool escaped{(x + y) % 3 != 0};
+            result.pixels.push_back({x * 7 + y, {x + 2.5, -y - 3.25}, escaped});
+        }
+    }
+    return result;
+}
+
+void expect_same_pixels(const RenderResult &expected, const RenderResult &actual)
+{
+    ASSERT_EQ(expected.width, actual.width);
+    ASSERT_EQ(expected.height, actual.height);
+    ASSERT_EQ(expected.pixels.size(), actual.pixels.size());
+    for (std::size_t i = 0; i < expected.pixels.size(); ++i)
+    {
+        EXPECT_EQ(expected.pixels[i].iterations, actual.pixels[i].iterations) << i;
+        EXPECT_EQ(expected.pixels[i].z, actual.pixels[i].z) << i;
+        EXPECT_EQ(expected.pixels[i].escaped, actual.pixels[i].escaped) << i;
+    }
+}
+
+} // namespace
+
+TEST(TestRawIterations, roundTripPreservesPixels)
+{
+    const RenderResult result{sample_result()};
+    std::stringstream file;
+
+    write_raw_iterations(file, result, 64, 2);
+    const RenderResult read{read_raw_iterations(file)};
+
+    expect_same_pixels(result, read);
+}
+
+TEST(TestRawIterations, headerRecordsImage)
+{
+    std::stringstream file;
+    write_raw_iterations(file, sample_result(), 64);
+
+    const RawIterationReader reader{file};
+
+    EXPECT_EQ(4, reader.header().width);
+    EXPECT_EQ(3, reader.header().height);
+    EXPECT_EQ(64, reader.header().max_iterations);
+}
+
+TEST(TestRawIterations, chunksCoverRectanglesInAnyOrder)
+{
+    const RenderResult result{sample_result()};
+    std::stringstream file;
+    RawIterationWriter writer{file, {result.width, result.height, 64}};
+
+    writer.write_chunk(2, 0, 2, 3, &result.pixels[2], result.width);
+    writer.write_chunk(0, 0, 2, 3, &result.pixels[0], result.width);
+    const RenderResult read{read_raw_iterations(file)};
+
+    expect_same_pixels(result, read);
+}
+
+TEST(TestRawIterations, chunkStoresSmoothIterations)
+{
+    const RenderResult result{sample_result()};
+    std::stringstream file;
+    write_raw_iterations(file, result, 64);
+    RawIterationReader reader{file};
+    RawIterationChunk chunk;
+
+    ASSERT_TRUE(reader.next(chunk));
+
+    ASSERT_EQ(result.pixels.size(), chunk.smooth.size());
+    for (std::size_t i = 0; i < result.pixels.size(); ++i)
+    {
+        EXPECT_FLOAT_EQ(static_cast<float>(smooth_iterations(result.pixels[i])), chunk.smooth[i]) << i;
+    }
+    EXPECT_FALSE(reader.next(chunk));
+}
+
+TEST(TestRawIterations, recolorMatchesColorize)
+{
+    const RenderResult result{sample_result()};
+    std::stringstream file;
+    write_raw_iterations(file, result, 64, 1);
+    Coloring coloring;
+    coloring.palette = {{10, 0, 0}, {20, 0, 0}, {30, 0, 0}, {40, 0, 0}, {50, 0, 0}};
+    coloring.inside = {1, 2, 3};
+    coloring.offset = 2.0;
+
+    const Image image{recolor(file, coloring, 2)};
+
+    const Image expected{colorize(result, coloring)};
+    ASSERT_EQ(expected.width, image.width);
+    ASSERT_EQ(expected.height, image.height);
+    for (std::size_t i = 0; i < expected.pixels.size(); ++i)
+    {
+        EXPECT_EQ(expected.pixels[i], image.pixels[i]) << i;
+    }
+}
+
+TEST(TestRawIterations, rawHistogramCountsEscapedPixels)
+{
+    const RenderResult result{sample_result()};
+    std::stringstream file;
+    write_raw_iterations(file, result, 64, 1);
+
+    const IterationHistogram histogram{raw_histogram(file)};
+
+    IterationHistogram expected;
+    for (const PixelResult &pixel : result.pixels)
+    {
+        expected.add(pixel);
+    }
+    EXPECT_EQ(65U, histogram.counts.size());
+    EXPECT_EQ(expected.total(), histogram.total());
+    for (std::size_t i = 0; i < expected.counts.size(); ++i)
+    {
+        EXPECT_EQ(expected.counts[i], histogram.counts[i]) << i;
+    }
+}
+
+TEST(TestRawIterations, recolorLeavesUncoveredPixelsInside)
+{
+    const RenderResult result{sample_result()};
+    std::stringstream file;
+    RawIterationWriter writer{file, {result.width, result.height, 64}};
+    writer.write_chunk(0, 0, result.width, 1, result.pixels.data(), result.width);
+    Coloring coloring;
+    coloring.inside = {9, 9, 9};
+
+    const Image image{recolor(file, coloring)};
+
+    EXPECT_EQ((Color{9, 9, 9}), image.at(1, 2));
+}
+
+TEST(TestRawIterations, writerRejectsChunkOutsideImage)
+{
+    const RenderResult result{sample_result()};
+    std::stringstream file;
+    RawIterationWriter writer{file, {result.width, result.height, 64}};
+
+    EXPECT_THROW(writer.write_chunk(3, 0, 2, 1, result.pixels.data(), result.width), std::runtime_error);
+}
+
+TEST(TestRawIterations, readerRejectsOtherFiles)
+{
+    std::stringstream file{"P6\n2 1\n255\n"};
+
+    EXPECT_THROW(RawIterationReader{file}, std::runtime_error);
+}
+
+TEST(TestRawIterations, readerRejectsTruncatedChunk)
+{
+    std::stringstream file;
+    write_raw_iterations(file, sample_result(), 64);
+    const std::string bytes{file.str()};
+    std::stringstream truncated{bytes.substr(0, bytes.size() - 4)};
+    RawIterationReader reader{truncated};
+    RawIterationChunk chunk;
+
+    EXPECT_THROW(reader.next(chunk), std::runtime_error);
+}
+
+TEST(TestRawIterations, readerRejectsCorruptChunkSize)
+{
+    std::stringstream file;
+    write_raw_iterations(file, sample_result(), 64);
+    const RawIterationIndex index{index_raw_iterations(file)};
+    std::string bytes{file.str()};
+    // The compressed size follows the chunk's x, y, width, height and raw size.
+    const std::uint64_t huge{~std::uint64_t{}};
+    bytes.replace(static_cast<std::size_t>(index.chunks[0].offset) + 4 * sizeof(std::uint32_t) + sizeof(std::uint64_t),
+        sizeof(huge), reinterpret_cast<const char *>(&huge), sizeof(huge));
+    std::stringstream corrupt{bytes};
+    RawIterationReader reader{corrupt};
+    RawIterationChunk chunk;
+
+    EXPECT_THROW(reader.next(chunk), std::runtime_error);
+    corrupt.clear();
+    corrupt.seekg(0);
+    EXPECT_THROW(index_raw_iterations(corrupt), std::runtime_error);
+}
+
+TEST(TestRawIterations, indexStopsBeforePartlyWrittenChunk)
+{
+    std::stringstream file;
+    write_raw_iterations(file, sample_result(), 64, 1);
+    const std::string bytes{file.str()};
+    std::stringstream truncated{bytes.substr(0, bytes.size() - 4)};
+
+    const RawIterationIndex index{index_raw_iterations(truncated)};
+
+    ASSERT_EQ(2U, index.chunks.size());
+    EXPECT_EQ(1, index.chunks[1].y);
+    EXPECT_EQ(4, index.chunks[1].width);
+    EXPECT_LT(index.end, static_cast<std::streamoff>(bytes.size() - 4));
+}
+
+TEST(TestRawIterations, readChunkAtIndexedOffset)
+{
+    const RenderResult result{sample_result()};
+    std::stringstream file;
+    write_raw_iterations(file, result, 64, 1);
+    const RawIterationIndex index{index_raw_iterations(file)};
+
+    const RawIterationChunk chunk{read_raw_chunk(file, index, index.chunks[2])};
+
+    EXPECT_EQ(2, chunk.y);
+    ASSERT_EQ(4U, chunk.pixels.size());
+    EXPECT_EQ(result.at(3, 2).iterations, chunk.pixels[3].iterations);
+}
+
+TEST(TestRawIterations, writerContinuesIndexedFile)
+{
+    const RenderResult result{sample_result()};
+    std::stringstream file;
+    RawIterationWriter first{file, {result.width, result.height, 64}};
+    first.write_chunk(0, 0, result.width, 2, result.pixels.data(), result.width);
+    const RawIterationIndex index{index_raw_iterations(file)};
+    file.seekp(index.end);
+
+    RawIterationWriter second{RawIterationWriter::append_to(file, index)};
+    second.write_chunk(0, 2, result.width, 1, &result.pixels[8], result.width);
+
+    file.seekg(0);
+    expect_same_pixels(result, read_raw_iterations(file));
+}
+
+} // namespace formula::test
@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/Renderer.h>
+
+#include <formula/test/render-formulas.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace formula::renderer;
+
+namespace formula::test
+{
+
+namespace
+{
+
+RenderFormula noisy_mandelbrot()
+{
+    RenderFormula result{mandelbrot()};
+    result.name = "NoisyMandelbrot";
+    result.body = "z = pixel:\n"
+                  "z = z*z + pixel + (rand - 0.5)*0.05\n"
+                  "|z| <= 4\n";
+    result.random_seed = 1234U;
+    return result;
+}
+
+RenderOptions small_options(int threads)
+{
+    RenderOptions result;
+    result.viewport.center = {-0.5, 0.0};
+    result.viewport.width = 3.0;
+    result.viewport.pixel_width = 12;
+    result.viewport.pixel_height = 9;
+    result.max_iterations = 64;
+    result.threads = threads;
+    return result;
+}
+
+} // namespace
+
+TEST(TestRenderer, pixelLocationUsesPixelCenters)
+{
+    Viewport viewport;
+    viewport.center = {1.0, -1.0};
+    viewport.width = 4.0;
+    viewport.pixel_width = 4;
+    viewport.pixel_height = 2;
+
+    EXPECT_EQ((Complex{-0.5, -0.5}), pixel_location(viewport, 0.5, 0.5));
+    EXPECT_EQ((Complex{2.5, -1.5}), pixel_location(viewport, 3.5, 1.5));
+    EXPECT_EQ((Complex{1.0, -1.0}), pixel_location(viewport, 2.0, 1.0));
+}
+
+TEST(TestRenderer, rendersEveryPixelWithEvaluator)
+{
+    const RenderOptions options{small_options(1)};
+    const PixelEvaluatorPtr evaluator{create_evaluator(mandelbrot(), Backend::INTERPRETER)};
+
+    const RenderResult result{render(mandelbrot(), Backend::INTERPRETER, options)};
+
+    ASSERT_EQ(12, result.width);
+    ASSERT_EQ(9, result.height);
+    ASSERT_EQ(108U, result.pixels.size());
+    for (int y = 0; y < result.height; ++y)
+    {
+        for (int x = 0; x < result.width; ++x)
+        {
+            const PixelResult expected{
+                evaluator->evaluate(pixel_location(options.viewport, x + 0.5, y + 0.5), options.max_iterations)};
+            EXPECT_EQ(expected.iterations, result.at(x, y).iterations) << x << ',' << y;
+            EXPECT_EQ(expected.escaped, result.at(x, y).escaped) << x << ',' << y;
+        }
+    }
+}
+
+TEST(TestRenderer, multipleThreadsMatchSingleThread)
+{
+    const RenderResult single{render(mandelbrot(), Backend::INTERPRETER, small_options(1))};
+
+    const RenderResult multiple{render(mandelbrot(), Backend::INTERPRETER, small_options(4))};
+
+    EXPECT_EQ(4, multiple.stats.threads);
+    ASSERT_EQ(single.pixels.size(), multiple.pixels.size());
+    for (std::size_t i = 0; i < single.pixels.size(); ++i)
+    {
+        EXPECT_EQ(single.pixels[i].iterations, multiple.pixels[i].iterations) << i;
+        EXPECT_EQ(single.pixels[i].escaped, multiple.pixels[i].escaped) << i;
+        EXPECT_EQ(single.pixels[i].z, multiple.pixels[i].z) << i;
+    }
+}
+
+TEST(TestRenderer, randomFormulaMatchesAcrossThreadCounts)
+{
+    const RenderResult single{render(noisy_mandelbrot(), Backend::INTERPRETER, small_options(1))};
+
+    const RenderResult multiple{render(noisy_mandelbrot(), Backend::INTERPRETER, small_options(4))};
+
+    ASSERT_EQ(single.pixels.size(), multiple.pixels.size());
+    for (std::size_t i = 0; i < single.pixels.size(); ++i)
+    {
+        EXPECT_EQ(single.pixels[i].iterations, multiple.pixels[i].iterations) << i;
+        EXPECT_EQ(single.pixels[i].z, multiple.pixels[i].z) << i;
+    }
+}
+
+TEST(TestRenderer, randomPixelDoesNotDependOnEvaluationOrder)
+{
+    const RenderOptions options{small_options(1)};
+    const RenderResult image{render(noisy_mandelbrot(), Backend::INTERPRETER, options)};
+    const PixelEvaluatorPtr evaluator{create_evaluator(noisy_mandelbrot(), Backend::INTERPRETER)};
+    const int x{7};
+    const int y{4};
+
+    evaluator->set_random_stream(static_cast<std::uint64_t>(y) * options.viewport.pixel_width + x);
+    const PixelResult result{
+        evaluator->evaluate(pixel_location(options.viewport, x + 0.5, y + 0.5), options.max_iterations)};
+
+    EXPECT_EQ(image.at(x, y).iterations, result.iterations);
+    EXPECT_EQ(image.at(x, y).z, result.z);
+}
+
+TEST(TestRenderer, statsCountPixelsAndIterations)
+{
+    const RenderResult result{render(mandelbrot(), Backend::INTERPRETER, small_options(2))};
+
+    std::uint64_t iterations{};
+    for (const PixelResult &pixel : result.pixels)
+    {
+        iterations += pixel.iterations + (pixel.escaped ? 1 : 0);
+    }
+    EXPECT_EQ(2, result.stats.threads);
+    EXPECT_EQ(108U, result.stats.pixels);
+    EXPECT_EQ(iterations, result.stats.iterations);
+    EXPECT_GT(pixels_per_second(result.stats), 0.0);
+    EXPECT_GT(iterations_per_second(result.stats), 0.0);
+}
+
+TEST(TestRenderer, cancelledRenderThrows)
+{
+    CancellationToken token;
+    token.cancel();
+    RenderOptions options{small_options(2)};
+    options.cancellation = &token;
+
+    EXPECT_THROW(render(mandelbrot(), Backend::INTERPRETER, options), CancelledError);
+    EXPECT_THROW(render(mandelbrot(), Backend::EXTENDED, options), CancelledError);
+}
+
+TEST(TestRenderer, invalidFormulaThrows)
+{
+    RenderFormula formula;
+    formula.name = "Invalid";
+    formula.body = "z = (:\n";
+
+    EXPECT_THROW(render(formula, Backend::INTERPRETER, small_options(2)), std::runtime_error);
+}
+
+TEST(TestRenderer, mirrorRowSumFollowsCenter)
+{
+    Viewport viewport{small_options(1).viewport};
+    EXPECT_EQ(8, mirror_row_sum(viewport)); // the real axis runs through the middle row
+
+    viewport.center.im = 0.25; // one pixel
+    EXPECT_EQ(10, mirror_row_sum(viewport));
+
+    viewport.center.im = 0.1;
+    EXPECT_FALSE(mirror_row_sum(viewport));
+
+    viewport.center.im = 3.0; // the real axis is outside the image
+    EXPECT_FALSE(mirror_row_sum(viewport));
+}
+
+TEST(TestRenderer, symmetricFormulaMirrorsRows)
+{
+    const RenderResult full{render(mandelbrot(), Backend::INTERPRETER, small_options(2))};
+    RenderOptions options{small_options(2)};
+    options.symmetry = true;
+
+    const RenderResult result{render(mandelbrot(), Backend::INTERPRETER, options)};
+
+    EXPECT_EQ(48U, result.stats.mirrored); // rows 5-8 mirror rows 3-0
+    EXPECT_EQ(60U, result.stats.pixels);
+    for (std::size_t i = 0; i < full.pixels.size(); ++i)
+    {
+        EXPECT_EQ(full.pixels[i].iterations, result.pixels[i].iterations) << i;
+        EXPECT_EQ(full.pixels[i].z, result.pixels[i].z) << i;
+        EXPECT_EQ(full.pixels[i].escaped, result.pixels[i].escaped) << i;
+    }
+}
+
+TEST(TestRenderer, offCenterAxisMirrorsOverlappingRows)
+{
+    RenderOptions options{small_options(1)};
+    options.viewport.center.im = 0.5; // two pixels above the real axis
+    const RenderResult full{render(mandelbrot(), Backend::INTERPRETER, options)};
+    options.symmetry = true;
+
+    const RenderResult result{render(mandelbrot(), Backend::INTERPRETER, options)};
+
+    EXPECT_EQ(24U, result.stats.mirrored); // rows 7-8 mirror rows 5-4
+    for (std::size_t i = 0; i < full.pixels.size(); ++i)
+    {
+        EXPECT_EQ(full.pixels[i].iterations, result.pixels[i].iterations) << i;
+        EXPECT_EQ(full.pixels[i].z, result.pixels[i].z) << i;
+    }
+}
+
+TEST(TestRenderer, asymmetricFormulaIsNotMirrored)
+{
+    RenderFormula formula{mandelbrot()};
+    formula.body = "z = pixel:\n"
+                   "z = z*z + pixel + p1\n"
+                   "|z| <= 4\n";
+    formula.values["p1"] = {0.0, 0.1};
+    RenderOptions options{small_options(1)};
+    options.symmetry = true;
+
+    const RenderResult result{render(formula, Backend::INTERPRETER, options)};
+
+    EXPECT_EQ(0U, result.stats.mirrored);
+    EXPECT_EQ(108U, result.stats.pixels);
+}
+
+TEST(TestRenderer, histogramCountsEscapedPixelsOfEveryThread)
+{
+    RenderOptions options{small_options(3)};
+    options.histogram = true;
+
+    const RenderResult result{render(mandelbrot(), Backend::INTERPRETER, options)};
+
+    IterationHistogram expected;
+    for (const PixelResult &pixel : result.pixels)
+    {
+        expected.add(pixel);
+    }
+    EXPECT_LT(0U, result.histogram.total());
+    EXPECT_EQ(expected.total(), result.histogram.total());
+    ASSERT_LE(expected.counts.size(), result.histogram.counts.size());
+    for (std::size_t i = 0; i < expected.counts.size(); ++i)
+    {
+        EXPECT_EQ(expected.counts[i], result.histogram.counts[i]) << i;
+    }
+}
+
+TEST(TestRenderer, histogramCountsMirroredPixels)
+{
+    RenderOptions options{small_options(2)};
+    options.histogram = true;
+    const RenderResult full{render(mandelbrot(), Backend::INTERPRETER, options)};
+    options.symmetry = true;
+
+    const RenderResult result{render(mandelbrot(), Backend::INTERPRETER, options)};
+
+    EXPECT_EQ(48U, result.stats.mirrored);
+    EXPECT_EQ(full.histogram.counts, result.histogram.counts);
+}
+
+TEST(TestRenderer, histogramIsEmptyUnlessRequested)
+{
+    const RenderResult result{render(mandelbrot(), Backend::INTERPRETER, small_options(2))};
+
+    EXPECT_TRUE(result.histogram.counts.empty());
+}
+
+TEST(TestRenderer, histogramMergeAddsCounts)
+{
+    IterationHistogram histogram;
+    histogram.add({2, {3.0, 0.0}, true});
+    histogram.add({5, {0.0, 0.0}, false});
+    IterationHistogram other;
+    other.add({2, {3.0, 0.0}, true});
+    other.add({4, {3.0, 0.0}, true});
+
+    histogram.merge(other);
+
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 0, 2, 0, 1}), histogram.counts);
+    EXPECT_EQ(3U, histogram.total());
+}
+
+} // namespace formula::test
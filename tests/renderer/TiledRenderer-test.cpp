@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/renderer/TiledRenderer.h>
+
+#include <formula/renderer/RawIterations.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace formula::renderer;
+
+namespace formula::test
+{
+
+namespace
+{
+
+RenderFormula mandelbrot()
+{
+    RenderFormula result;
+    result.name = "Mandelbrot";
+    result.body = "z = pixel:\n"
+                  "z = z*z + pixel + (rand - 0.5)*0.01\n"
+                  "|z| <= 4\n";
+    result.random_seed = 99U;
+    return result;
+}
+
+RenderOptions small_options()
+{
+    RenderOptions result;
+    result.viewport.center = {-0.5, 0.0};
+    result.viewport.width = 3.0;
+    result.viewport.pixel_width = 12;
+    result.viewport.pixel_height = 9;
+    result.max_iterations = 32;
+    result.threads = 2;
+    return result;
+}
+
+TileOptions small_tiles()
+{
+    TileOptions result;
+    result.tile_width = 5;
+    result.tile_height = 4;
+    return result;
+}
+
+// A raw iteration file path that is removed when the test ends.
+class TempFile
+{
+public:
+    explicit TempFile(const std::string &name) :
+        m_path((std::filesystem::path{testing::TempDir()} / name).string())
+    {
+        std::filesystem::remove(m_path);
+    }
+    TempFile(const TempFile &rhs) = delete;
+    TempFile(TempFile &&rhs) = delete;
+    ~TempFile()
+    {
+        std::filesystem::remove(m_path);
+    }
+    TempFile &operator=(const TempFile &rhs) = delete;
+    TempFile &operator=(TempFile &&rhs) = delete;
+
+    const std::string &path() const
+    {
+        return m_path;
+    }
+
+private:
+    std::string m_path;
+};
+
+RenderResult read_file(const std::string &path)
+{
+    std::ifstream in{path, std::ios::binary};
+    return read_raw_iterations(in);
+}
+
+void expect_same_pixels(const RenderResult &expected, const RenderResult &actual)
+{
+    ASSERT_EQ(expected.width, actual.width);
+    ASSERT_EQ(expected.height, actual.height);
+    for (std::size_t i = 0; i < expected.pixels.size(); ++i)
+    {
+        EXPECT_EQ(expected.pixels[i].iterations, actual.pixels[i].iterations) << i;
+        EXPECT_EQ(expected.pixels[i].z, actual.pixels[i].z) << i;
+        EXPECT_EQ(expected.pixels[i].escaped, actual.pixels[i].escaped) << i;
+    }
+}
+
+} // namespace
+
+TEST(TestTiledRenderer, tilesMatchSingleRender)
+{
+    const TempFile file{"tiles-match.frit"};
+
+    const TiledRenderStats stats{
+        render_tiled(mandelbrot(), Backend::INTERPRETER, small_options(), small_tiles(), file.path())};
+
+    EXPECT_EQ(9, stats.tiles); // 3 columns of 5, 5 and 2; 3 rows of 4, 4 and 1
+    EXPECT_EQ(0, stats.resumed_tiles);
+    EXPECT_EQ(108U, stats.render.pixels);
+    expect_same_pixels(render(mandelbrot(), Backend::INTERPRETER, small_options()), read_file(file.path()));
+}
+
+TEST(TestTiledRenderer, resumeRendersOnlyMissingTiles)
+{
+    const TempFile file{"tiles-resume.frit"};
+    render_tiled(mandelbrot(), Backend::INTERPRETER, small_options(), small_tiles(), file.path());
+    // Simulate a crash while the last tile was being written.
+    std::filesystem::resize_file(file.path(), std::filesystem::file_size(file.path()) - 3);
+
+    const TiledRenderStats stats{
+        render_tiled(mandelbrot(), Backend::INTERPRETER, small_options(), small_tiles(), file.path())};
+
+    EXPECT_EQ(8, stats.resumed_tiles);
+    EXPECT_EQ(2U, stats.render.pixels); // the 2x1 corner tile
+    expect_same_pixels(render(mandelbrot(), Backend::INTERPRETER, small_options()), read_file(file.path()));
+}
+
+TEST(TestTiledRenderer, completeFileIsNotRenderedAgain)
+{
+    const TempFile file{"tiles-complete.frit"};
+    render_tiled(mandelbrot(), Backend::INTERPRETER, small_options(), small_tiles(), file.path());
+
+    const TiledRenderStats stats{
+        render_tiled(mandelbrot(), Backend::INTERPRETER, small_options(), small_tiles(), file.path())};
+
+    EXPECT_EQ(9, stats.resumed_tiles);
+    EXPECT_EQ(0U, stats.render.pixels);
+}
+
+TEST(TestTiledRenderer, resumeRejectsDifferentImage)
+{
+    const TempFile file{"tiles-different.frit"};
+    render_tiled(mandelbrot(), Backend::INTERPRETER, small_options(), small_tiles(), file.path());
+    RenderOptions options{small_options()};
+    options.max_iterations = 64;
+
+    EXPECT_THROW(render_tiled(mandelbrot(), Backend::INTERPRETER, options, small_tiles(), file.path()),
+        std::runtime_error);
+}
+
+TEST(TestTiledRenderer, resumeRejectsDifferentViewport)
+{
+    const TempFile file{"tiles-panned.frit"};
+    render_tiled(mandelbrot(), Backend::INTERPRETER, small_options(), small_tiles(), file.path());
+    // Simulate a crash while the last tile was being written.
+    std::filesystem::resize_file(file.path(), std::filesystem::file_size(file.path()) - 3);
+    RenderOptions options{small_options()};
+    options.viewport.center = {-0.25, 0.5};
+
+    EXPECT_THROW(render_tiled(mandelbrot(), Backend::INTERPRETER, options, small_tiles(), file.path()),
+        std::runtime_error);
+}
+
+TEST(TestTiledRenderer, resumeRejectsDifferentFormulaInputs)
+{
+    const TempFile file{"tiles-inputs.frit"};
+    render_tiled(mandelbrot(), Backend::INTERPRETER, small_options(), small_tiles(), file.path());
+    RenderFormula reseeded{mandelbrot()};
+    reseeded.random_seed = 100U;
+
+    EXPECT_THROW(render_tiled(reseeded, Backend::INTERPRETER, small_options(), small_tiles(), file.path()),
+        std::runtime_error);
+}
+
+TEST(TestTiledRenderer, fingerprintCoversRenderInputs)
+{
+    const std::uint64_t base{render_fingerprint(mandelbrot(), Backend::INTERPRETER, small_options())};
+    RenderFormula formula{mandelbrot()};
+    formula.values["p1"] = {1.0, 0.0};
+    RenderFormula selected{mandelbrot()};
+    selected.functions["fn1"] = "sin";
+    RenderOptions zoomed{small_options()};
+    zoomed.viewport.width = 1.5;
+
+    EXPECT_EQ(base, render_fingerprint(mandelbrot(), Backend::INTERPRETER, small_options()));
+    EXPECT_NE(base, render_fingerprint(formula, Backend::INTERPRETER, small_options()));
+    EXPECT_NE(base, render_fingerprint(selected, Backend::INTERPRETER, small_options()));
+    EXPECT_NE(base, render_fingerprint(mandelbrot(), Backend::INTERPRETER, zoomed));
+    EXPECT_NE(base, render_fingerprint(mandelbrot(), Backend::COMPILER, small_options()));
+}
+
+TEST(TestTiledRenderer, streamedImageFromTilesMatchesColorize)
+{
+    const TempFile file{"tiles-stream.frit"};
+    render_tiled(mandelbrot(), Backend::INTERPRETER, small_options(), small_tiles(), file.path());
+    const Coloring coloring;
+    std::ifstream raw{file.path(), std::ios::binary};
+    std::ostringstream streamed;
+
+    write_streamed_image(raw, streamed, ImageFormat::PPM, coloring);
+
+    std::ostringstream expected;
+    write_ppm(expected, colorize(render(mandelbrot(), Backend::INTERPRETER, small_options()), coloring));
+    EXPECT_EQ(expected.str(), streamed.str());
+}
+
+TEST(TestTiledRenderer, streamedRenderMatchesColorize)
+{
+    Coloring coloring;
+    coloring.smooth = true;
+    std::ostringstream streamed;
+
+    const RenderStats stats{
+        render_streamed(mandelbrot(), Backend::INTERPRETER, small_options(), coloring, streamed, ImageFormat::PNG, 4)};
+
+    std::ostringstream expected;
+    write_png(expected, colorize(render(mandelbrot(), Backend::INTERPRETER, small_options()), coloring));
+    EXPECT_EQ(expected.str(), streamed.str());
+    EXPECT_EQ(108U, stats.pixels);
+}
+
+TEST(TestTiledRenderer, equalizedRenderMatchesEqualizedColorize)
+{
+    Coloring coloring;
+    coloring.smooth = true;
+    std::ostringstream streamed;
+
+    const RenderStats stats{
+        render_equalized(mandelbrot(), Backend::INTERPRETER, small_options(), coloring, streamed, ImageFormat::PPM)};
+
+    RenderOptions options{small_options()};
+    options.histogram = true;
+    const RenderResult result{render(mandelbrot(), Backend::INTERPRETER, options)};
+    coloring.equalization = cumulative_distribution(result.histogram);
+    std::ostringstream expected;
+    write_ppm(expected, colorize(result, coloring));
+    EXPECT_EQ(expected.str(), streamed.str());
+    EXPECT_EQ(108U, stats.pixels);
+}
+
+TEST(TestTiledRenderer, tiledHistogramMatchesRender)
+{
+    const TempFile file{"tiles-histogram.frit"};
+    render_tiled(mandelbrot(), Backend::INTERPRETER, small_options(), small_tiles(), file.path());
+    std::ifstream raw{file.path(), std::ios::binary};
+
+    const IterationHistogram histogram{raw_histogram(raw)};
+
+    RenderOptions options{small_options()};
+    options.histogram = true;
+    EXPECT_EQ(render(mandelbrot(), Backend::INTERPRETER, options).histogram.counts, histogram.counts);
+}
+
+} // namespace formula::test
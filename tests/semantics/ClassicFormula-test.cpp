@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/semantics/ClassicFormula.h>
+
+#include <formula/facade/Formula.h>
+#include <formula/parser/ParseOptions.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+using namespace formula::semantic;
+
+namespace formula::test
+{
+
+namespace
+{
+
+std::optional<ClassicFormula> recognize(std::string_view text, const std::map<std::string, Complex> &values = {},
+    const std::map<std::string, std::string> &functions = {})
+{
+    // The renderer parses classic formulas as BASIC, whose literals the simplifier folds.
+    parser::Options options;
+    options.dialect = Dialect::BASIC;
+    const LoadedFormula loaded{load_formula(text, options)};
+    EXPECT_TRUE(loaded.ast);
+    return loaded.ast ? recognize_classic_formula(*loaded.ast, values, functions) : std::nullopt;
+}
+
+} // namespace
+
+TEST(TestClassicFormula, kindNames)
+{
+    EXPECT_EQ("mandelbrot", to_string(ClassicKind::MANDELBROT));
+    EXPECT_EQ("julia", to_string(ClassicKind::JULIA));
+    EXPECT_EQ("burning-ship", to_string(ClassicKind::BURNING_SHIP));
+    EXPECT_EQ("mandel3", to_string(ClassicKind::MANDEL3));
+}
+
+TEST(TestClassicFormula, mandelbrotIsRecognized)
+{
+    const std::optional<ClassicFormula> classic{recognize("z = pixel:\n"
+                                                          "z = z*z + pixel\n"
+                                                          "|z| <= 4\n")};
+
+    ASSERT_TRUE(classic);
+    EXPECT_EQ(ClassicKind::MANDELBROT, classic->kind);
+    EXPECT_EQ("z", classic->variable);
+    EXPECT_TRUE(classic->start_at_pixel);
+    EXPECT_EQ(4.0, classic->bailout);
+    EXPECT_TRUE(classic->inclusive);
+}
+
+TEST(TestClassicFormula, variableNameAndSquareSpellingDontMatter)
+{
+    for (const char *step : {"w = w*w + pixel\n", "w = sqr(w) + pixel\n", "w = pixel + w^2\n"})
+    {
+        const std::optional<ClassicFormula> classic{recognize(std::string{"w = 0:\n"} + step + "|w| < 2.0*2.0\n")};
+
+        ASSERT_TRUE(classic) << step;
+        EXPECT_EQ(ClassicKind::MANDELBROT, classic->kind) << step;
+        EXPECT_EQ("w", classic->variable) << step;
+        EXPECT_FALSE(classic->start_at_pixel) << step;
+        EXPECT_EQ((Complex{0.0, 0.0}), classic->start) << step;
+        EXPECT_EQ(4.0, classic->bailout) << step;
+        EXPECT_FALSE(classic->inclusive) << step;
+    }
+}
+
+TEST(TestClassicFormula, juliaConstantComesFromBoundValue)
+{
+    const std::optional<ClassicFormula> classic{recognize("z = pixel:\n"
+                                                          "z = z*z + p1\n"
+                                                          "4 >= |z|\n",
+        {{"p1", {-0.4, 0.6}}})};
+
+    ASSERT_TRUE(classic);
+    EXPECT_EQ(ClassicKind::JULIA, classic->kind);
+    EXPECT_EQ((Complex{-0.4, 0.6}), classic->constant);
+    EXPECT_TRUE(classic->inclusive);
+}
+
+TEST(TestClassicFormula, burningShipIsRecognized)
+{
+    const std::optional<ClassicFormula> classic{recognize("z = pixel:\n"
+                                                          "z = fn1(z)*abs(z) + pixel\n"
+                                                          "|z| <= 4\n",
+        {}, {{"fn1", "abs"}})};
+
+    ASSERT_TRUE(classic);
+    EXPECT_EQ(ClassicKind::BURNING_SHIP, classic->kind);
+}
+
+TEST(TestClassicFormula, mandel3IsRecognized)
+{
+    for (const char *step : {"z = z*z*z + pixel\n", "z = z*sqr(z) + pixel\n", "z = z^3 + pixel\n"})
+    {
+        const std::optional<ClassicFormula> classic{recognize(std::string{"z = pixel:\n"} + step + "|z| <= 4\n")};
+
+        ASSERT_TRUE(classic) << step;
+        EXPECT_EQ(ClassicKind::MANDEL3, classic->kind) << step;
+    }
+}
+
+TEST(TestClassicFormula, otherFormulasAreNotRecognized)
+{
+    EXPECT_FALSE(recognize("z = pixel:\n"
+                           "z = z*z + rand\n"
+                           "|z| <= 4\n"));
+    EXPECT_FALSE(recognize("z = pixel:\n"
+                           "z = z*z + pixel, c = z\n"
+                           "|z| <= 4\n"));
+    EXPECT_FALSE(recognize("z = pixel:\n"
+                           "z = z*z*z*z + pixel\n"
+                           "|z| <= 4\n"));
+    EXPECT_FALSE(recognize("z = pixel:\n"
+                           "z = z*z + pixel\n"
+                           "|z| <= lastsqr\n"));
+    EXPECT_FALSE(recognize("z = pixel:\n"
+                           "z = sin(z) + pixel\n"
+                           "|z| <= 4\n"));
+    EXPECT_FALSE(recognize("w = pixel:\n"
+                           "z = z*z + pixel\n"
+                           "|z| <= 4\n"));
+}
+
+} // namespace formula::test
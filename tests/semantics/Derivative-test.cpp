@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/semantics/Derivative.h>
+
+#include <formula/facade/Formula.h>
+#include <formula/parser/ParseOptions.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <string_view>
+
+using namespace formula::semantic;
+
+namespace formula::test
+{
+
+namespace
+{
+
+Complex iterate(Formula &formula, Complex pixel, int iterations)
+{
+    formula.set_value("pixel", pixel);
+    formula.interpret(Section::INITIALIZE);
+    for (int i = 0; i < iterations; ++i)
+    {
+        formula.interpret(Section::ITERATE);
+    }
+    return formula.get_value("z");
+}
+
+Complex derivative(std::string_view text, Complex pixel, int iterations)
+{
+    const FormulaPtr formula{create_formula(text, parser::Options{})};
+    EXPECT_TRUE(formula);
+    EXPECT_TRUE(formula->enable_derivative());
+    iterate(*formula, pixel, iterations);
+    return formula->get_value(derivative_name("z"));
+}
+
+// Central difference along the real axis, which equals the complex derivative of a holomorphic formula.
+Complex finite_difference(std::string_view text, Complex pixel, int iterations)
+{
+    constexpr double h{1e-6};
+    const FormulaPtr formula{create_formula(text, parser::Options{})};
+    EXPECT_TRUE(formula);
+    const Complex above{iterate(*formula, pixel + Complex{h, 0.0}, iterations)};
+    const Complex below{iterate(*formula, pixel - Complex{h, 0.0}, iterations)};
+    return (above - below) / Complex{2.0 * h, 0.0};
+}
+
+void expect_near(Complex expected, Complex actual)
+{
+    EXPECT_NEAR(expected.re, actual.re, 1e-5 * (1.0 + std::abs(expected.re)));
+    EXPECT_NEAR(expected.im, actual.im, 1e-5 * (1.0 + std::abs(expected.im)));
+}
+
+bool differentiable(std::string_view text, const std::map<std::string, std::string> &functions = {})
+{
+    const LoadedFormula loaded{load_formula(text, parser::Options{})};
+    EXPECT_TRUE(loaded.ast);
+    return loaded.ast && differentiate(*loaded.ast, functions) != nullptr;
+}
+
+} // namespace
+
+TEST(TestDerivative, derivativeNameIsPrefixed)
+{
+    EXPECT_EQ("__d_z", derivative_name("z"));
+}
+
+TEST(TestDerivative, mandelbrotMatchesFiniteDifference)
+{
+    constexpr const char *text{"z = pixel:\n"
+                               "z = z*z + pixel\n"
+                               "|z| <= 4\n"};
+
+    const Complex actual{derivative(text, {-0.2, 0.3}, 6)};
+
+    expect_near(finite_difference(text, {-0.2, 0.3}, 6), actual);
+}
+
+TEST(TestDerivative, firstIterationIsExact)
+{
+    // z1 = pixel^2 + pixel, so dz1 = 2 pixel + 1.
+    const Complex actual{derivative("z = pixel:\n"
+                                    "z = z*z + pixel\n"
+                                    "|z| <= 4\n",
+        {0.5, 1.0}, 1)};
+
+    EXPECT_EQ((Complex{2.0, 2.0}), actual);
+}
+
+TEST(TestDerivative, operatorsMatchFiniteDifference)
+{
+    constexpr const char *text{"z = pixel, w = 1/pixel:\n"
+                               "w = -w/(z + 2) - 3\n"
+                               "z = z^3 - w*z + z^pixel + 0.5*z/pixel\n"
+                               "|z| <= 100\n"};
+
+    const Complex actual{derivative(text, {0.4, 0.2}, 3)};
+
+    expect_near(finite_difference(text, {0.4, 0.2}, 3), actual);
+}
+
+TEST(TestDerivative, functionsMatchFiniteDifference)
+{
+    constexpr const char *text{"z = pixel:\n"
+                               "z = sin(z) + cos(z) + tan(z) + sinh(z) + cosh(z) + tanh(z) + exp(z)/4\n"
+                               "z = z/8 + log(z) + sqrt(z) + sqr(z) + cotan(z) + cotanh(z) + ident(z)\n"
+                               "z = atan(z/9) + asin(z/9) + acos(z/9) + asinh(z) + acosh(z + 2) + atanh(z/9)\n"
+                               "|z| <= 100\n"};
+
+    const Complex actual{derivative(text, {0.3, 0.4}, 1)};
+
+    expect_near(finite_difference(text, {0.3, 0.4}, 1), actual);
+}
+
+TEST(TestDerivative, selectedFunctionIsDifferentiated)
+{
+    constexpr const char *text{"z = pixel:\n"
+                               "z = fn1(z) + pixel\n"
+                               "|z| <= 4\n"};
+
+    // fn1 defaults to sin.
+    const Complex actual{derivative(text, {0.3, 0.4}, 3)};
+
+    expect_near(finite_difference(text, {0.3, 0.4}, 3), actual);
+}
+
+TEST(TestDerivative, branchesAreDifferentiated)
+{
+    constexpr const char *text{"z = pixel:\n"
+                               "if real(z) > 0\n"
+                               "  z = z*z + pixel\n"
+                               "else\n"
+                               "  z = z*z*z + pixel\n"
+                               "endif\n"
+                               "|z| <= 4\n"};
+
+    const Complex actual{derivative(text, {0.1, 0.6}, 4)};
+
+    expect_near(finite_difference(text, {0.1, 0.6}, 4), actual);
+}
+
+TEST(TestDerivative, initializeClearsDerivatives)
+{
+    const FormulaPtr formula{create_formula("z = pixel:\n"
+                                            "w = z\n"
+                                            "z = w*w + pixel\n"
+                                            "|z| <= 4\n",
+        parser::Options{})};
+    ASSERT_TRUE(formula);
+    ASSERT_TRUE(formula->enable_derivative());
+    formula->set_value(derivative_name("w"), {5.0, 0.0});
+
+    formula->interpret(Section::INITIALIZE);
+
+    EXPECT_EQ((Complex{0.0, 0.0}), formula->get_value(derivative_name("w")));
+    EXPECT_EQ((Complex{1.0, 0.0}), formula->get_value(derivative_name("z")));
+}
+
+TEST(TestDerivative, nonHolomorphicFunctionIsRejected)
+{
+    EXPECT_FALSE(differentiable("z = pixel:\n"
+                                "z = real(z)*z + pixel\n"
+                                "|z| <= 4\n"));
+    EXPECT_FALSE(differentiable("z = pixel:\n"
+                                "z = |z| + pixel\n"
+                                "|z| <= 4\n"));
+    EXPECT_FALSE(differentiable("z = pixel:\n"
+                                "z = fn1(z) + pixel\n"
+                                "|z| <= 4\n",
+        {{"fn1", "conj"}}));
+}
+
+TEST(TestDerivative, constantNonHolomorphicExpressionIsAccepted)
+{
+    EXPECT_TRUE(differentiable("z = pixel:\n"
+                               "z = z*z + real(p1) + |p2|\n"
+                               "|z| <= 4\n"));
+}
+
+TEST(TestDerivative, enableDerivativeLeavesRejectedFormulaUnchanged)
+{
+    const FormulaPtr formula{create_formula("z = pixel:\n"
+                                            "z = conj(z) + pixel\n"
+                                            "|z| <= 4\n",
+        parser::Options{})};
+    ASSERT_TRUE(formula);
+    const ast::Expr iterate{formula->get_section(Section::ITERATE)};
+
+    EXPECT_FALSE(formula->enable_derivative());
+    EXPECT_EQ(iterate, formula->get_section(Section::ITERATE));
+}
+
+} // namespace formula::test
@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/semantics/RealAnalysis.h>
+
+#include <formula/facade/Formula.h>
+#include <formula/parser/ParseOptions.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+
+using namespace formula::semantic;
+
+namespace formula::test
+{
+
+namespace
+{
+
+// Whether the bailout expression, the last line of text, is real.
+bool real_bailout(std::string_view text, const std::map<std::string, std::string> &functions = {},
+    const std::set<std::string> &external = {})
+{
+    const LoadedFormula loaded{load_formula(text, parser::Options{})};
+    EXPECT_TRUE(loaded.ast);
+    if (!loaded.ast || !loaded.ast->bailout)
+    {
+        return false;
+    }
+    const ast::Node *bailout{loaded.ast->bailout.get()};
+    if (const auto *sequence = dynamic_cast<const ast::StatementSeqNode *>(bailout); sequence)
+    {
+        bailout = sequence->statements().back().get();
+    }
+    const std::set<std::string> variables{find_real_variables(*loaded.ast, functions, external)};
+    return find_real_expressions(*loaded.ast, functions, variables).count(bailout) != 0;
+}
+
+} // namespace
+
+TEST(TestRealAnalysis, comparisonsAndModulusAreReal)
+{
+    EXPECT_TRUE(real_bailout("z = pixel:\n"
+                             "z = z*z + pixel\n"
+                             "|z| <= 4 && real(z) > -2\n"));
+}
+
+TEST(TestRealAnalysis, complexExpressionIsNotReal)
+{
+    EXPECT_FALSE(real_bailout("z = pixel:\n"
+                              "z = z*z + pixel\n"
+                              "z + 1\n"));
+    EXPECT_FALSE(real_bailout("z = pixel:\n"
+                              "z = z*z + pixel\n"
+                              "|z| + (1,2)\n"));
+}
+
+TEST(TestRealAnalysis, counterIsReal)
+{
+    EXPECT_TRUE(real_bailout("z = pixel, n = 0:\n"
+                             "z = z*z + pixel, n = n + 1\n"
+                             "|z| + n*2 - n/3\n"));
+}
+
+TEST(TestRealAnalysis, variableGivenComplexValueIsNotReal)
+{
+    EXPECT_FALSE(real_bailout("z = pixel, n = 0:\n"
+                              "z = z*z + pixel, n = n + pixel\n"
+                              "|z| + n\n"));
+}
+
+TEST(TestRealAnalysis, complexValuesPropagateThroughVariables)
+{
+    EXPECT_FALSE(real_bailout("z = pixel, a = 0, b = 0:\n"
+                              "a = b + 1, b = a*pixel\n"
+                              "|z| + a\n"));
+}
+
+TEST(TestRealAnalysis, variableNotInitializedIsNotReal)
+{
+    EXPECT_FALSE(real_bailout("z = pixel:\n"
+                              "n = 1, z = z*z + pixel\n"
+                              "|z| + n\n"));
+}
+
+TEST(TestRealAnalysis, externalVariableIsNotReal)
+{
+    constexpr const char *text{"z = pixel, n = 0:\n"
+                               "z = z*z + pixel, n = n + 1\n"
+                               "|z| + n\n"};
+
+    EXPECT_TRUE(real_bailout(text));
+    EXPECT_FALSE(real_bailout(text, {}, {"n"}));
+    EXPECT_FALSE(real_bailout("z = pixel:\n"
+                              "z = z*z + pixel\n"
+                              "|z| + maxit\n",
+        {}, {"maxit"}));
+}
+
+TEST(TestRealAnalysis, quotientIsOnlyRealForNonzeroLiteralDivisor)
+{
+    EXPECT_TRUE(real_bailout("z = pixel, n = 1:\n"
+                             "z = z*z + pixel, n = n + 1\n"
+                             "n/2\n"));
+    EXPECT_FALSE(real_bailout("z = pixel, n = 1:\n"
+                              "z = z*z + pixel, n = n + 1\n"
+                              "1/n\n"));
+    EXPECT_FALSE(real_bailout("z = pixel, n = 1:\n"
+                              "z = z*z + pixel, n = n + 1\n"
+                              "n/0\n"));
+}
+
+TEST(TestRealAnalysis, zIsNotReal)
+{
+    EXPECT_FALSE(real_bailout("z = 0:\n"
+                              "z = z + 1\n"
+                              "z\n"));
+}
+
+TEST(TestRealAnalysis, builtinsAreRealOrComplex)
+{
+    EXPECT_TRUE(real_bailout("z = pixel:\n"
+                             "z = z*z + pixel\n"
+                             "pi*e + maxit + lastsqr + whitesq\n"));
+    EXPECT_FALSE(real_bailout("z = pixel:\n"
+                              "z = z*z + pixel\n"
+                              "|z| + p1\n"));
+    EXPECT_FALSE(real_bailout("z = pixel:\n"
+                              "z = z*z + pixel\n"
+                              "|z| + rand\n"));
+}
+
+TEST(TestRealAnalysis, functionsOfRealArgumentsAreReal)
+{
+    EXPECT_TRUE(real_bailout("z = pixel:\n"
+                             "z = z*z + pixel\n"
+                             "sin(real(z)) + floor(imag(z)) + cabs(z) + exp(|z|)\n"));
+}
+
+TEST(TestRealAnalysis, functionsLeavingTheRealLineAreNotReal)
+{
+    EXPECT_FALSE(real_bailout("z = pixel:\n"
+                              "z = z*z + pixel\n"
+                              "sqrt(real(z))\n"));
+    EXPECT_FALSE(real_bailout("z = pixel:\n"
+                              "z = z*z + pixel\n"
+                              "log(real(z))\n"));
+    EXPECT_FALSE(real_bailout("z = pixel:\n"
+                              "z = z*z + pixel\n"
+                              "real(z)^0.5\n"));
+}
+
+TEST(TestRealAnalysis, selectedFunctionIsResolved)
+{
+    constexpr const char *text{"z = pixel:\n"
+                               "z = z*z + pixel\n"
+                               "fn1(real(z))\n"};
+
+    EXPECT_TRUE(real_bailout(text, {{"fn1", "cos"}}));
+    EXPECT_FALSE(real_bailout(text, {{"fn1", "sqrt"}}));
+}
+
+} // namespace formula::test
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/semantics/Symmetry.h>
+
+#include <formula/facade/Formula.h>
+#include <formula/parser/ParseOptions.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+
+using namespace formula::semantic;
+
+namespace formula::test
+{
+
+namespace
+{
+
+bool symmetric(std::string_view text, const std::map<std::string, Complex> &values = {},
+    const std::map<std::string, std::string> &functions = {})
+{
+    const parser::Options options;
+    const LoadedFormula loaded{load_formula(text, options)};
+    EXPECT_TRUE(loaded.ast);
+    return loaded.ast && is_conjugate_symmetric(*loaded.ast, values, functions);
+}
+
+} // namespace
+
+TEST(TestSymmetry, mandelbrotIsSymmetric)
+{
+    EXPECT_TRUE(symmetric("z = pixel:\n"
+                          "z = z*z + pixel\n"
+                          "|z| <= 4\n"));
+}
+
+TEST(TestSymmetry, realLiteralsAreSymmetric)
+{
+    EXPECT_TRUE(symmetric("z = 0:\n"
+                          "z = z^2.5 - (0.25,0) + pixel/3\n"
+                          "|z| <= 4\n"));
+}
+
+TEST(TestSymmetry, complexLiteralIsNotSymmetric)
+{
+    EXPECT_FALSE(symmetric("z = pixel:\n"
+                           "z = z*z + (0.3,0.5)\n"
+                           "|z| <= 4\n"));
+}
+
+TEST(TestSymmetry, realParameterIsSymmetric)
+{
+    EXPECT_TRUE(symmetric("z = pixel:\n"
+                          "z = z*z + p1\n"
+                          "|z| <= 4\n",
+        {{"p1", {-0.75, 0.0}}}));
+}
+
+TEST(TestSymmetry, complexParameterIsNotSymmetric)
+{
+    EXPECT_FALSE(symmetric("z = pixel:\n"
+                           "z = z*z + p1\n"
+                           "|z| <= 4\n",
+        {{"p1", {-0.75, 0.1}}}));
+}
+
+TEST(TestSymmetry, functionsThatCommuteWithConjugationAreSymmetric)
+{
+    EXPECT_TRUE(symmetric("z = pixel:\n"
+                          "z = sin(z) + exp(sqr(z)) + log(cabs(z)) + conj(pixel)\n"
+                          "real(z) <= 4\n"));
+}
+
+TEST(TestSymmetry, functionsThatTreatPartsDifferentlyAreNotSymmetric)
+{
+    EXPECT_FALSE(symmetric("z = pixel:\n"
+                           "z = abs(z)*z + pixel\n"
+                           "|z| <= 4\n"));
+    EXPECT_FALSE(symmetric("z = pixel:\n"
+                           "z = flip(z) + pixel\n"
+                           "|z| <= 4\n"));
+    EXPECT_FALSE(symmetric("z = pixel:\n"
+                           "z = z*z + imag(pixel)\n"
+                           "|z| <= 4\n"));
+}
+
+TEST(TestSymmetry, selectedFunctionDecides)
+{
+    const std::string_view text{"z = pixel:\n"
+                                "z = fn1(z) + pixel\n"
+                                "|z| <= 4\n"};
+
+    EXPECT_TRUE(symmetric(text));
+    EXPECT_TRUE(symmetric(text, {}, {{"fn1", "cosh"}}));
+    EXPECT_FALSE(symmetric(text, {}, {{"fn1", "flip"}}));
+}
+
+TEST(TestSymmetry, screenDependentIdentifiersAreNotSymmetric)
+{
+    EXPECT_FALSE(symmetric("z = pixel:\n"
+                           "z = z*z + pixel + rand*0.01\n"
+                           "|z| <= 4\n"));
+    EXPECT_FALSE(symmetric("z = pixel + scrnpix:\n"
+                           "z = z*z + pixel\n"
+                           "|z| <= 4\n"));
+}
+
+TEST(TestSymmetry, conditionalsAreSymmetric)
+{
+    EXPECT_TRUE(symmetric("z = pixel:\n"
+                          "IF (real(z) > 0)\n"
+                          "  z = z*z + pixel\n"
+                          "ELSE\n"
+                          "  z = z*z*z + pixel\n"
+                          "ENDIF\n"
+                          "|z| <= 4\n"));
+}
+
+} // namespace formula::test
@@ -399,22 +399,26 @@ TEST(TestGLSLEmitter, emitsRandomStateAndSrandReset)
                                                "  z = rand\n")};
 
     expect_contains(shader,
-        "float c_random_float(inout uint random_state) {\n"
-        "    random_state = random_state * 1664525u + 1013904223u;\n"
-        "    return float(random_state & 0x00ffffffu) / 16777216.0;\n"
-        "}\n");
+        "uint random_stream = 0u;\n"
+        "uint random_counter = 0u;\n");
+    expect_contains(shader, "uvec4 c_philox(uvec4 counter, uvec2 key) {\n");
+    expect_contains(shader, "        umulExtended(0xD2511F53u, counter.x, hi0, lo0);\n");
     expect_contains(shader,
         "vec2 c_next_rand(inout uint random_state) {\n"
-        "    return vec2(c_random_float(random_state), c_random_float(random_state));\n"
+        "    uvec4 bits = c_philox(uvec4(random_stream, 0u, random_counter, 0u), uvec2(random_state, 0u));\n"
+        "    random_counter += 1u;\n"
+        "    return vec2(float(bits.x >> 8u), float(bits.z >> 8u)) / 16777216.0;\n"
         "}\n");
     expect_contains(shader,
         "vec2 c_srand(vec2 z, inout uint random_state, inout vec2 rand) {\n"
         "    random_state = uint(z.x);\n"
+        "    random_counter = 0u;\n"
         "    rand = vec2(0.0, 0.0);\n"
         "    return vec2(0.0, 0.0);\n"
         "}\n");
-    expect_contains(
-        shader, "    uint random_state = random_seed ^ uint(pixel_coords.x) ^ (uint(pixel_coords.y) << 16u);\n");
+    expect_contains(shader,
+        "    uint random_state = random_seed;\n"
+        "    random_stream = pixel_index;\n");
     expect_contains(shader, "    vec2 rand = vec2(0.0, 0.0);\n");
     expect_contains(shader, "    z = c_srand(vec2(1234.0, 0.0), random_state, rand);\n");
     expect_contains(shader,
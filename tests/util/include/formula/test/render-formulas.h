@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#pragma once
+
+#include <formula/renderer/PixelEvaluator.h>
+
+namespace formula::test
+{
+
+// The classic z = z*z + pixel escape-time formula.
+inline renderer::RenderFormula mandelbrot()
+{
+    renderer::RenderFormula result;
+    result.name = "Mandelbrot";
+    result.body = "z = pixel:\n"
+                  "z = z*z + pixel\n"
+                  "|z| <= 4\n";
+    return result;
+}
+
+} // namespace formula::test
@@ -2,11 +2,13 @@
 //
 // Copyright 2025 Richard Thomson
 //
+#include <formula/core/InstructionSet.h>
 #include <formula/facade/Formula.h>
 #include <formula/parser/ParseOptions.h>
 
 #include <iostream>
 #include <map>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -17,9 +19,23 @@ using namespace formula::parser;
 namespace
 {
 
+std::optional<InstructionSet> parse_instruction_set(std::string_view text)
+{
+    for (const InstructionSet value : {InstructionSet::SSE2, InstructionSet::AVX2, InstructionSet::AVX512})
+    {
+        if (text == to_string(value))
+        {
+            return value;
+        }
+    }
+    return {};
+}
+
 int main(const std::vector<std::string_view> &args)
 {
     bool compile{};
+    bool stats{};
+    CompileOptions options;
     std::map<std::string, Complex> values;
     for (size_t i = 1; i < args.size(); ++i)
     {
@@ -27,6 +43,25 @@ int main(const std::vector<std::string_view> &args)
         {
             compile = true;
         }
+        else if (args[i] == "--assemble")
+        {
+            compile = true;
+            options.assembly_log = stdout;
+        }
+        else if (args[i] == "--stats")
+        {
+            compile = true;
+            stats = true;
+        }
+        else if (args[i] == "--isa" && i + 1 < args.size())
+        {
+            options.instruction_set = parse_instruction_set(args[++i]);
+            if (!options.instruction_set)
+            {
+                std::cerr << "Error: Unknown instruction set " << args[i] << '\n';
+                return 1;
+            }
+        }
         else if (auto pos = args[i].find('='); pos != std::string_view::npos)
         {
             const std::string name{args[i].substr(0, pos)};
@@ -41,7 +76,8 @@ int main(const std::vector<std::string_view> &args)
         }
         else
         {
-            std::cerr << "Usage: " << args[0] << " [--assemble | --compile] [name=value] ... [name=value]\n";
+            std::cerr << "Usage: " << args[0] << " [--assemble | --compile] [--stats] [--isa sse2|avx2|avx512]"
+                         " [name=value] ... [name=value]\n";
             return 1;
         }
     }
@@ -60,11 +96,24 @@ int main(const std::vector<std::string_view> &args)
         formula->set_value(name, value);
     }
 
-    if (compile && !formula->compile())
+    if (compile && !formula->compile(options))
     {
         std::cerr << "Error: Failed to compile formula\n";
         return 1;
     }
+    if (stats)
+    {
+        const CompileStats &compiled{formula->get_compile_stats()};
+        const auto ms = [](std::chrono::duration<double> time) { return time.count() * 1000.0; };
+        std::cout << "Parse: " << ms(compiled.parse) << " ms\n"
+                  << "Generate: " << ms(compiled.generate) << " ms\n"
+                  << "Assemble: " << ms(compiled.assemble) << " ms\n"
+                  << "Relocate: " << ms(compiled.relocate) << " ms\n"
+                  << "Instructions: " << compiled.instructions << " (" << compiled.stack_accesses
+                  << " stack accesses)\n"
+                  << "Code: " << compiled.code_bytes << " bytes, data: " << compiled.data_bytes << " bytes\n"
+                  << "Instruction set: " << to_string(compiled.instruction_set) << '\n';
+    }
 
     std::cout << "Evaluated: " << (compile ? formula->run((Section::ITERATE)) : formula->interpret((Section::ITERATE))) << '\n';
     return 0;
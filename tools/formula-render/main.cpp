@@ -0,0 +1,901 @@
+// SPDX-License-Identifier: GPL-3.0-only
+//
+// Copyright 2026 Richard Thomson
+//
+#include <formula/core/FileEntry.h>
+#include <formula/core/InstructionSet.h>
+#include <formula/core/Trace.h>
+#include <formula/parser/FormulaEntry.h>
+#include <formula/parser/Gradient.h>
+#include <formula/parser/Parameter.h>
+#include <formula/renderer/AntiAlias.h>
+#include <formula/renderer/Image.h>
+#include <formula/renderer/OrbitDensity.h>
+#include <formula/renderer/RawIterations.h>
+#include <formula/renderer/Renderer.h>
+#include <formula/renderer/TiledRenderer.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace formula;
+using namespace formula::renderer;
+
+namespace
+{
+
+struct CommandLine
+{
+    std::filesystem::path file;
+    std::string entry;
+    std::optional<std::filesystem::path> formula_file;
+    std::optional<Complex> center;
+    std::optional<double> width;
+    std::optional<int> pixel_width;
+    std::optional<int> pixel_height;
+    std::optional<int> max_iterations;
+    int threads{};
+    Backend backend{Backend::COMPILER};
+    std::vector<std::pair<std::string, Complex>> values;
+    std::vector<std::pair<std::string, std::string>> functions;
+    std::optional<std::uint32_t> seed;
+    std::string output;
+    std::string raw;     // raw iteration file written alongside the image
+    std::string recolor; // raw iteration file colored instead of rendering
+    std::optional<std::filesystem::path> gradient;
+    std::string gradient_entry;
+    bool smooth{};
+    bool equalize{}; // histogram coloring
+    double density{1.0};
+    double offset{};
+    int tile_size{}; // out-of-core rendering when positive
+    int antialias{}; // samples along each axis of supersampled pixels; 0 disables anti-aliasing
+    std::uint64_t orbit_samples{}; // orbit density rendering when positive
+    bool stratified{};
+    int importance{}; // importance map cells along each axis of the orbit density sample region
+    bool perf_map{};
+    int unroll{1}; // compiled orbit iterations per bailout branch
+    std::optional<InstructionSet> instruction_set;
+    bool symmetry{true};
+    std::string trace; // Chrome trace event file
+};
+
+// Records a trace of the run when the command line asks for one and writes it when the run ends.
+class TraceFile
+{
+public:
+    explicit TraceFile(std::string path) :
+        m_path(std::move(path))
+    {
+        if (!m_path.empty())
+        {
+            trace::start();
+        }
+    }
+    TraceFile(const TraceFile &rhs) = delete;
+    TraceFile(TraceFile &&rhs) = delete;
+    ~TraceFile()
+    {
+        if (m_path.empty())
+        {
+            return;
+        }
+        trace::stop();
+        std::ofstream out{m_path};
+        trace::write_json(out);
+        if (!out)
+        {
+            std::cerr << "Error: couldn't write trace " << m_path << '\n';
+        }
+    }
+    TraceFile &operator=(const TraceFile &rhs) = delete;
+    TraceFile &operator=(TraceFile &&rhs) = delete;
+
+private:
+    std::string m_path;
+};
+
+std::string to_lower(std::string_view text)
+{
+    std::string result{text};
+    std::transform(result.begin(), result.end(), result.begin(),
+        [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+    return result;
+}
+
+std::vector<std::string> split(std::string_view text, char separator)
+{
+    std::vector<std::string> result;
+    std::size_t begin{};
+    while (true)
+    {
+        const std::size_t end{text.find(separator, begin)};
+        result.emplace_back(text.substr(begin, end - begin));
+        if (end == std::string_view::npos)
+        {
+            return result;
+        }
+        begin = end + 1;
+    }
+}
+
+double parse_double(std::string_view text)
+{
+    std::size_t used{};
+    const double result{std::stod(std::string{text}, &used)};
+    if (used != text.size())
+    {
+        throw std::runtime_error("Invalid number '" + std::string{text} + "'");
+    }
+    return result;
+}
+
+int parse_int(std::string_view text)
+{
+    std::size_t used{};
+    const int result{std::stoi(std::string{text}, &used)};
+    if (used != text.size())
+    {
+        throw std::runtime_error("Invalid integer '" + std::string{text} + "'");
+    }
+    return result;
+}
+
+// RE or RE,IM; a missing imaginary part is zero.
+Complex parse_complex(std::string_view text)
+{
+    const std::size_t comma{text.find(',')};
+    if (comma == std::string_view::npos)
+    {
+        return {parse_double(text), 0.0};
+    }
+    return {parse_double(text.substr(0, comma)), parse_double(text.substr(comma + 1))};
+}
+
+void parse_size(std::string_view text, CommandLine &command)
+{
+    const std::size_t x{text.find('x')};
+    if (x == std::string_view::npos)
+    {
+        throw std::runtime_error("Invalid size '" + std::string{text} + "'; expected WxH");
+    }
+    command.pixel_width = parse_int(text.substr(0, x));
+    command.pixel_height = parse_int(text.substr(x + 1));
+    if (*command.pixel_width <= 0 || *command.pixel_height <= 0)
+    {
+        throw std::runtime_error("Image size must be positive");
+    }
+}
+
+Backend parse_backend(std::string_view text)
+{
+    for (const Backend backend : {Backend::INTERPRETER, Backend::COMPILER, Backend::EXTENDED, Backend::KERNEL})
+    {
+        if (text == to_string(backend))
+        {
+            return backend;
+        }
+    }
+    throw std::runtime_error("Unknown backend '" + std::string{text} + "'");
+}
+
+InstructionSet parse_instruction_set(std::string_view text)
+{
+    for (const InstructionSet value : {InstructionSet::SSE2, InstructionSet::AVX2, InstructionSet::AVX512})
+    {
+        if (text == to_string(value))
+        {
+            return value;
+        }
+    }
+    throw std::runtime_error("Unknown instruction set '" + std::string{text} + "'");
+}
+
+// NAME=VALUE as used by --param and --function.
+std::pair<std::string, std::string> parse_assignment(std::string_view text)
+{
+    const std::size_t equals{text.find('=')};
+    if (equals == std::string_view::npos || equals == 0)
+    {
+        throw std::runtime_error("Invalid assignment '" + std::string{text} + "'; expected NAME=VALUE");
+    }
+    return {std::string{text.substr(0, equals)}, std::string{text.substr(equals + 1)}};
+}
+
+bool is_parameter_file(const std::filesystem::path &file)
+{
+    return to_lower(file.extension().string()) == ".par";
+}
+
+FileEntry find_entry(const std::filesystem::path &file, std::string_view name)
+{
+    std::ifstream in{file};
+    if (!in)
+    {
+        throw std::runtime_error("Couldn't open " + file.string());
+    }
+    const std::string wanted{to_lower(name)};
+    for (FileEntry &entry : load_file_entries(in, file.string()))
+    {
+        if (to_lower(entry.name) == wanted)
+        {
+            return std::move(entry);
+        }
+    }
+    throw std::runtime_error("No entry " + std::string{name} + " in " + file.string());
+}
+
+// A formula file named by a parameter set is looked up next to the parameter file first.
+std::filesystem::path resolve_formula_file(const std::filesystem::path &parameter_file, const std::string &name)
+{
+    const std::filesystem::path sibling{parameter_file.parent_path() / name};
+    return std::filesystem::exists(sibling) ? sibling : std::filesystem::path{name};
+}
+
+// Applies the Fractint parameter set keys that describe a formula image; others, such as colors, are ignored.
+void apply_parameter_set(
+    const CommandLine &command, RenderFormula &formula, RenderOptions &options, std::filesystem::path &formula_file)
+{
+    const parameter::BasicParameterEntry parameters{
+        parameter::parse_basic_parameters(find_entry(command.file, command.entry))};
+    if (!parameters.diagnostics.empty())
+    {
+        throw std::runtime_error("Couldn't parse parameter set " + command.entry + ": " +
+            parameter::to_string(parameters.diagnostics.front().code));
+    }
+    std::optional<double> magnification;
+    double x_magnification{1.0};
+    for (const parameter::Parameter &parameter : parameters.assignments)
+    {
+        const std::string key{to_lower(parameter.key)};
+        const std::vector<std::string> fields{split(parameter.value, '/')};
+        if (key == "type" && to_lower(parameter.value) != "formula")
+        {
+            throw std::runtime_error("Parameter set " + command.entry + " has type " + parameter.value +
+                "; only type=formula can be rendered");
+        }
+        if (key == "formulafile")
+        {
+            formula_file = resolve_formula_file(command.file, parameter.value);
+        }
+        else if (key == "formulaname")
+        {
+            formula.name = parameter.value;
+        }
+        else if (key == "center-mag" && fields.size() >= 3)
+        {
+            options.viewport.center = {parse_double(fields[0]), parse_double(fields[1])};
+            magnification = parse_double(fields[2]);
+            if (fields.size() >= 4)
+            {
+                x_magnification = parse_double(fields[3]);
+            }
+        }
+        else if (key == "corners" && fields.size() >= 4)
+        {
+            const double x_min{parse_double(fields[0])};
+            const double x_max{parse_double(fields[1])};
+            const double y_min{parse_double(fields[2])};
+            const double y_max{parse_double(fields[3])};
+            options.viewport.center = {(x_min + x_max) / 2.0, (y_min + y_max) / 2.0};
+            options.viewport.width = x_max - x_min;
+        }
+        else if (key == "params")
+        {
+            for (std::size_t i = 0; i < fields.size(); i += 2)
+            {
+                const double im{i + 1 < fields.size() ? parse_double(fields[i + 1]) : 0.0};
+                formula.values["p" + std::to_string(i / 2 + 1)] = {parse_double(fields[i]), im};
+            }
+        }
+        else if (key == "function")
+        {
+            for (std::size_t i = 0; i < fields.size(); ++i)
+            {
+                formula.functions["fn" + std::to_string(i + 1)] = to_lower(fields[i]);
+            }
+        }
+        else if (key == "maxiter")
+        {
+            options.max_iterations = parse_int(parameter.value);
+        }
+    }
+    if (magnification)
+    {
+        // Fractint's magnification spans 2/mag vertically; the image aspect ratio and x magnification
+        // widen it to the real axis extent.
+        options.viewport.width = 2.0 / *magnification * x_magnification * options.viewport.pixel_width /
+            options.viewport.pixel_height;
+    }
+}
+
+void load(const CommandLine &command, RenderFormula &formula, RenderOptions &options)
+{
+    const trace::Scope scope{"load", "formula-render"};
+    options.viewport.pixel_width = command.pixel_width.value_or(options.viewport.pixel_width);
+    options.viewport.pixel_height = command.pixel_height.value_or(options.viewport.pixel_height);
+    std::filesystem::path formula_file{command.file};
+    formula.name = command.entry;
+    if (is_parameter_file(command.file))
+    {
+        formula_file.clear();
+        apply_parameter_set(command, formula, options, formula_file);
+    }
+    if (command.formula_file)
+    {
+        formula_file = *command.formula_file;
+    }
+    if (formula_file.empty())
+    {
+        throw std::runtime_error("Parameter set " + command.entry + " names no formula file; use --formula-file");
+    }
+    formula.body = find_entry(formula_file, formula.name).body;
+    formula.dialect = command.backend == Backend::EXTENDED ? Dialect::EXTENDED : Dialect::BASIC;
+
+    options.viewport.center = command.center.value_or(options.viewport.center);
+    options.viewport.width = command.width.value_or(options.viewport.width);
+    options.max_iterations = command.max_iterations.value_or(options.max_iterations);
+    options.threads = command.threads;
+    options.compile.perf_map = command.perf_map;
+    options.compile.orbit_unroll = command.unroll;
+    options.compile.instruction_set = command.instruction_set;
+    options.symmetry = command.symmetry;
+    for (const auto &[name, value] : command.values)
+    {
+        formula.values[name] = value;
+    }
+    for (const auto &[selector, function] : command.functions)
+    {
+        formula.functions[selector] = function;
+    }
+    formula.random_seed = command.seed.value_or(formula.random_seed);
+}
+
+Coloring load_coloring(const CommandLine &command)
+{
+    Coloring result;
+    result.smooth = command.smooth;
+    result.density = command.density;
+    result.offset = command.offset;
+    if (!command.gradient)
+    {
+        return result;
+    }
+    if (command.gradient_entry.empty())
+    {
+        std::ifstream in{*command.gradient};
+        const std::vector<FileEntry> entries{load_file_entries(in, command.gradient->string())};
+        if (entries.empty())
+        {
+            throw std::runtime_error("No gradients in " + command.gradient->string());
+        }
+        result.palette = gradient_palette(gradient::parse_gradient(entries.front()).gradient);
+    }
+    else
+    {
+        result.palette =
+            gradient_palette(gradient::parse_gradient(find_entry(*command.gradient, command.gradient_entry)).gradient);
+    }
+    return result;
+}
+
+int usage(std::string_view program)
+{
+    std::cerr << "Usage: " << program << " [options] FILE ENTRY\n"
+              << "       " << program << " --recolor RAW [coloring options] [--output FILE]\n"
+              << "\n"
+                 "Renders ENTRY of a formula file, or of a Fractint parameter file (.par) that names a formula.\n"
+                 "With --recolor, colors a raw iteration file written by --raw without iterating again.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --output FILE          image to write, .png or .ppm (default ENTRY.png)\n"
+                 "  --center RE,IM         center of the image\n"
+                 "  --width W              extent of the real axis\n"
+                 "  --size WxH             image size in pixels (default 640x480)\n"
+                 "  --max-iterations N     iteration limit (default 256)\n"
+                 "  --threads N            render threads; 0 uses every hardware thread (default)\n"
+                 "  --backend NAME         compiler (default, falls back to interpreter), interpreter, extended\n"
+                 "                         or kernel (classic formula kernels, otherwise compiler)\n"
+                 "  --param NAME=RE[,IM]   sets a formula parameter, e.g. p1=0.4,0.3\n"
+                 "  --function FN=NAME     selects a function parameter, e.g. fn1=sin\n"
+                 "  --seed N               seed for rand\n"
+                 "  --formula-file FILE    formula file for a parameter set\n"
+                 "  --perf-map             write JIT symbols to the perf map\n"
+                 "  --unroll N             compiled orbits branch on the bailout every N iterations (default 1)\n"
+                 "  --isa NAME             compile for at most sse2, avx2 or avx512 (default the CPU's best)\n"
+                 "  --no-symmetry          evaluate both halves of images symmetric about the real axis\n"
+                 "  --raw FILE             also write the per-pixel iteration data for --recolor\n"
+                 "  --tile-size N          render out of core in N pixel tiles into the --raw file, resuming an\n"
+                 "                         interrupted render, or in N row bands straight to the image without --raw\n"
+                 "  --antialias N          supersample pixels on edges with N x N jittered samples\n"
+                 "  --orbit-density N      render the density of N sampled escaping orbits (Buddhabrot)\n"
+                 "  --stratified           spread orbit density samples over a grid instead of at random\n"
+                 "  --importance N         sample orbits by an N x N map of where they reach the image\n"
+                 "  --trace FILE           write a Chrome trace of loading, compiling and rendering\n"
+                 "\n"
+                 "Coloring options:\n"
+                 "  --gradient FILE        color with an Ultra Fractal gradient (.ugr) instead of the default palette\n"
+                 "  --gradient-entry NAME  gradient entry to use (default the first)\n"
+                 "  --smooth               color by the continuous iteration count\n"
+                 "  --equalize             spread the palette evenly over the image's escaped pixels; with\n"
+                 "                         --tile-size, needs --raw\n"
+                 "  --density D            palette entries per iteration (default 1)\n"
+                 "  --offset N             palette index of iteration 0 (default 0)\n";
+    return 1;
+}
+
+std::optional<CommandLine> parse_command_line(const std::vector<std::string_view> &args)
+{
+    CommandLine command;
+    std::vector<std::string_view> positional;
+    for (std::size_t i = 1; i < args.size(); ++i)
+    {
+        const std::string_view arg{args[i]};
+        const bool has_value{i + 1 < args.size()};
+        if (arg.substr(0, 2) != "--")
+        {
+            positional.push_back(arg);
+        }
+        else if (arg == "--perf-map")
+        {
+            command.perf_map = true;
+        }
+        else if (arg == "--no-symmetry")
+        {
+            command.symmetry = false;
+        }
+        else if (arg == "--smooth")
+        {
+            command.smooth = true;
+        }
+        else if (arg == "--equalize")
+        {
+            command.equalize = true;
+        }
+        else if (arg == "--stratified")
+        {
+            command.stratified = true;
+        }
+        else if (!has_value)
+        {
+            return {};
+        }
+        else if (arg == "--output")
+        {
+            command.output = std::string{args[++i]};
+        }
+        else if (arg == "--center")
+        {
+            command.center = parse_complex(args[++i]);
+        }
+        else if (arg == "--width")
+        {
+            command.width = parse_double(args[++i]);
+        }
+        else if (arg == "--size")
+        {
+            parse_size(args[++i], command);
+        }
+        else if (arg == "--max-iterations")
+        {
+            command.max_iterations = parse_int(args[++i]);
+        }
+        else if (arg == "--threads")
+        {
+            command.threads = std::max(0, parse_int(args[++i]));
+        }
+        else if (arg == "--backend")
+        {
+            command.backend = parse_backend(args[++i]);
+        }
+        else if (arg == "--param")
+        {
+            const auto [name, value]{parse_assignment(args[++i])};
+            command.values.emplace_back(name, parse_complex(value));
+        }
+        else if (arg == "--function")
+        {
+            command.functions.push_back(parse_assignment(args[++i]));
+        }
+        else if (arg == "--seed")
+        {
+            command.seed = static_cast<std::uint32_t>(std::stoul(std::string{args[++i]}));
+        }
+        else if (arg == "--formula-file")
+        {
+            command.formula_file = std::filesystem::path{args[++i]};
+        }
+        else if (arg == "--raw")
+        {
+            command.raw = std::string{args[++i]};
+        }
+        else if (arg == "--trace")
+        {
+            command.trace = std::string{args[++i]};
+        }
+        else if (arg == "--recolor")
+        {
+            command.recolor = std::string{args[++i]};
+        }
+        else if (arg == "--gradient")
+        {
+            command.gradient = std::filesystem::path{args[++i]};
+        }
+        else if (arg == "--gradient-entry")
+        {
+            command.gradient_entry = std::string{args[++i]};
+        }
+        else if (arg == "--tile-size")
+        {
+            command.tile_size = parse_int(args[++i]);
+            if (command.tile_size <= 0)
+            {
+                throw std::runtime_error("Tile size must be positive");
+            }
+        }
+        else if (arg == "--orbit-density")
+        {
+            const int samples{parse_int(args[++i])};
+            if (samples <= 0)
+            {
+                throw std::runtime_error("--orbit-density needs a positive sample count");
+            }
+            command.orbit_samples = static_cast<std::uint64_t>(samples);
+        }
+        else if (arg == "--importance")
+        {
+            command.importance = parse_int(args[++i]);
+            if (command.importance <= 0)
+            {
+                throw std::runtime_error("--importance needs a positive grid size");
+            }
+        }
+        else if (arg == "--antialias")
+        {
+            command.antialias = parse_int(args[++i]);
+            if (command.antialias <= 0)
+            {
+                throw std::runtime_error("Anti-aliasing samples must be positive");
+            }
+        }
+        else if (arg == "--isa")
+        {
+            command.instruction_set = parse_instruction_set(args[++i]);
+        }
+        else if (arg == "--unroll")
+        {
+            command.unroll = parse_int(args[++i]);
+            if (command.unroll <= 0)
+            {
+                throw std::runtime_error("Unroll count must be positive");
+            }
+        }
+        else if (arg == "--density")
+        {
+            command.density = parse_double(args[++i]);
+        }
+        else if (arg == "--offset")
+        {
+            command.offset = parse_double(args[++i]);
+        }
+        else
+        {
+            return {};
+        }
+    }
+    if (!command.recolor.empty())
+    {
+        if (!positional.empty())
+        {
+            return {};
+        }
+        if (command.output.empty())
+        {
+            command.output = std::filesystem::path{command.recolor}.replace_extension(".png").string();
+        }
+        return command;
+    }
+    if (positional.size() != 2)
+    {
+        return {};
+    }
+    if (command.antialias > 0 && (command.tile_size > 0 || !command.raw.empty()))
+    {
+        throw std::runtime_error("--antialias can't be combined with --raw or --tile-size");
+    }
+    if (command.equalize && (command.antialias > 0 || (command.tile_size > 0 && command.raw.empty())))
+    {
+        throw std::runtime_error("--equalize can't be combined with --antialias, or with --tile-size without --raw");
+    }
+    if (command.orbit_samples > 0 &&
+        (command.antialias > 0 || command.tile_size > 0 || !command.raw.empty() || command.equalize))
+    {
+        throw std::runtime_error(
+            "--orbit-density can't be combined with --antialias, --equalize, --raw or --tile-size");
+    }
+    command.file = std::filesystem::path{positional[0]};
+    command.entry = std::string{positional[1]};
+    if (command.output.empty())
+    {
+        command.output = command.entry + ".png";
+    }
+    return command;
+}
+
+// The compiler and kernel backends fall back to the interpreter when the formula can't be compiled.  Only
+// creating an evaluator is tried here; errors while rendering or writing are reported as they are.
+Backend usable_backend(const RenderFormula &formula, Backend backend, const CompileOptions &compile)
+{
+    if (backend != Backend::COMPILER && backend != Backend::KERNEL)
+    {
+        return backend;
+    }
+    try
+    {
+        create_evaluator(formula, backend, compile);
+    }
+    catch (const std::runtime_error &error)
+    {
+        std::cerr << "Warning: " << error.what() << "; using the interpreter\n";
+        return Backend::INTERPRETER;
+    }
+    return backend;
+}
+
+using Seconds = std::chrono::duration<double>;
+
+int recolor_raw(const CommandLine &command)
+{
+    Coloring coloring{load_coloring(command)};
+    std::ifstream in{command.recolor, std::ios::binary};
+    if (!in)
+    {
+        throw std::runtime_error("Couldn't open " + command.recolor);
+    }
+    const auto start{std::chrono::steady_clock::now()};
+    if (command.equalize)
+    {
+        coloring.equalization = cumulative_distribution(raw_histogram(in));
+        in.clear();
+        in.seekg(0);
+    }
+    const Image image{recolor(in, coloring, command.threads)};
+    const auto write_start{std::chrono::steady_clock::now()};
+    write_image(command.output, image);
+    const auto end{std::chrono::steady_clock::now()};
+
+    std::cout << command.output << ": recolored " << command.recolor << ", " << image.width << 'x' << image.height
+              << '\n'
+              << std::fixed << std::setprecision(3)                                  //
+              << "  recolor    " << Seconds{write_start - start}.count() << " s\n" //
+              << "  write      " << Seconds{end - write_start}.count() << " s\n";  //
+    return 0;
+}
+
+struct Outcome
+{
+    RenderStats stats;
+    Seconds write{}; // writing done after rendering; streamed output is included in stats.elapsed
+    int tiles{};
+    int resumed_tiles{};
+    std::uint64_t refined{}; // supersampled pixels
+};
+
+// Histogram coloring without a raw file streams the colored rows instead of building the image.
+Outcome render_equalized_image(const CommandLine &command, const RenderFormula &formula,
+    const RenderOptions &options, const Coloring &coloring, Backend backend)
+{
+    std::ofstream out{command.output, std::ios::binary};
+    if (!out)
+    {
+        throw std::runtime_error("Couldn't open " + command.output);
+    }
+    const ImageFormat format{*image_format(command.output)};
+    Outcome result;
+    result.stats = render_equalized(formula, backend, options, coloring, out, format);
+    if (!out.flush())
+    {
+        throw std::runtime_error("Couldn't write " + command.output);
+    }
+    return result;
+}
+
+Outcome render_in_memory(const CommandLine &command, const RenderFormula &formula, RenderOptions options,
+    Coloring coloring, Backend backend)
+{
+    options.histogram = command.equalize;
+    const RenderResult result{render(formula, backend, options)};
+    const auto write_start{std::chrono::steady_clock::now()};
+    if (command.equalize)
+    {
+        coloring.equalization = cumulative_distribution(result.histogram);
+    }
+    write_image(command.output, colorize(result, coloring));
+    if (!command.raw.empty())
+    {
+        std::ofstream raw{command.raw, std::ios::binary};
+        write_raw_iterations(raw, result, options.max_iterations);
+        if (!raw.flush())
+        {
+            throw std::runtime_error("Couldn't write " + command.raw);
+        }
+    }
+    return {result.stats, Seconds{std::chrono::steady_clock::now() - write_start}};
+}
+
+Outcome render_antialiased_image(const CommandLine &command, const RenderFormula &formula,
+    const RenderOptions &options, const Coloring &coloring, Backend backend)
+{
+    AntiAliasOptions antialias;
+    antialias.samples = command.antialias;
+    const AntiAliasResult result{render_antialiased(formula, backend, options, coloring, antialias)};
+    const auto write_start{std::chrono::steady_clock::now()};
+    write_image(command.output, result.image);
+    Outcome outcome{result.stats, Seconds{std::chrono::steady_clock::now() - write_start}};
+    outcome.refined = result.refined;
+    return outcome;
+}
+
+Outcome render_orbit_density_image(const CommandLine &command, const RenderFormula &formula,
+    const RenderOptions &options, const Coloring &coloring, Backend backend)
+{
+    OrbitDensityOptions density;
+    density.samples = command.orbit_samples;
+    density.sampling = command.stratified ? OrbitSampling::STRATIFIED : OrbitSampling::RANDOM;
+    density.importance_grid = command.importance;
+    const OrbitDensityResult result{render_orbit_density(formula, backend, options, density)};
+    const auto write_start{std::chrono::steady_clock::now()};
+    write_image(command.output, colorize(result, coloring));
+    return {result.stats, Seconds{std::chrono::steady_clock::now() - write_start}};
+}
+
+// Only a tile or band of pixels is in memory at a time.
+Outcome render_out_of_core(const CommandLine &command, const RenderFormula &formula, const RenderOptions &options,
+    Coloring coloring, Backend backend)
+{
+    const ImageFormat format{*image_format(command.output)};
+    if (command.raw.empty())
+    {
+        std::ofstream out{command.output, std::ios::binary};
+        if (!out)
+        {
+            throw std::runtime_error("Couldn't open " + command.output);
+        }
+        Outcome result;
+        result.stats = render_streamed(formula, backend, options, coloring, out, format, command.tile_size);
+        if (!out.flush())
+        {
+            throw std::runtime_error("Couldn't write " + command.output);
+        }
+        return result;
+    }
+
+    TileOptions tiles;
+    tiles.tile_width = command.tile_size;
+    tiles.tile_height = command.tile_size;
+    const TiledRenderStats stats{render_tiled(formula, backend, options, tiles, command.raw)};
+    const auto write_start{std::chrono::steady_clock::now()};
+    std::ifstream raw{command.raw, std::ios::binary};
+    if (command.equalize)
+    {
+        coloring.equalization = cumulative_distribution(raw_histogram(raw));
+        raw.clear();
+        raw.seekg(0);
+    }
+    std::ofstream out{command.output, std::ios::binary};
+    if (!out)
+    {
+        throw std::runtime_error("Couldn't open " + command.output);
+    }
+    write_streamed_image(raw, out, format, coloring);
+    if (!out.flush())
+    {
+        throw std::runtime_error("Couldn't write " + command.output);
+    }
+    return {stats.render, Seconds{std::chrono::steady_clock::now() - write_start}, stats.tiles, stats.resumed_tiles};
+}
+
+int main(const std::vector<std::string_view> &args)
+{
+    const std::optional<CommandLine> command{parse_command_line(args)};
+    if (!command)
+    {
+        return usage(args[0]);
+    }
+    if (!image_format(command->output))
+    {
+        std::cerr << "Error: unknown image format for " << command->output << "; use .png or .ppm\n";
+        return 1;
+    }
+    const TraceFile trace_file{command->trace};
+    if (!command->recolor.empty())
+    {
+        return recolor_raw(*command);
+    }
+
+    RenderFormula formula;
+    RenderOptions options;
+    load(*command, formula, options);
+    const Coloring coloring{load_coloring(*command)};
+
+    const Backend backend{usable_backend(formula, command->backend, options.compile)};
+    Outcome outcome;
+    if (command->tile_size > 0)
+    {
+        outcome = render_out_of_core(*command, formula, options, coloring, backend);
+    }
+    else if (command->orbit_samples > 0)
+    {
+        outcome = render_orbit_density_image(*command, formula, options, coloring, backend);
+    }
+    else if (command->antialias > 0)
+    {
+        outcome = render_antialiased_image(*command, formula, options, coloring, backend);
+    }
+    else if (command->equalize && command->raw.empty())
+    {
+        outcome = render_equalized_image(*command, formula, options, coloring, backend);
+    }
+    else
+    {
+        outcome = render_in_memory(*command, formula, options, coloring, backend);
+    }
+
+    const RenderStats &stats{outcome.stats};
+    std::cout << command->output << ": " << formula.name << ", " << options.viewport.pixel_width << 'x'
+              << options.viewport.pixel_height << ", " << options.max_iterations << " iterations maximum, "
+              << to_string(backend) << ", " << stats.threads << " threads\n";
+    if (outcome.tiles > 0)
+    {
+        std::cout << "  tiles      " << outcome.tiles << ", " << outcome.resumed_tiles << " resumed\n";
+    }
+    if (stats.mirrored > 0)
+    {
+        std::cout << "  mirrored   " << stats.mirrored << " pixels\n";
+    }
+    if (command->antialias > 0)
+    {
+        std::cout << "  refined    " << outcome.refined << " pixels\n";
+    }
+    if (command->orbit_samples > 0)
+    {
+        std::cout << "  samples    " << stats.pixels << " orbits\n";
+    }
+    std::cout << std::fixed << std::setprecision(3)                                     //
+              << "  setup      " << stats.setup.count() << " s\n"                     //
+              << "  render     " << stats.elapsed.count() << " s\n"                   //
+              << "  write      " << outcome.write.count() << " s\n"                   //
+              << "  pixels     " << pixels_per_second(stats) / 1.0e6 << " M/s\n"      //
+              << "  iterations " << iterations_per_second(stats) / 1.0e9 << " G/s\n"; //
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string_view> args;
+    for (int i = 0; i < argc; ++i)
+    {
+        args.emplace_back(argv[i]);
+    }
+    try
+    {
+        return main(args);
+    }
+    catch (const std::exception &error)
+    {
+        std::cerr << "Error: " << error.what() << '\n';
+        return 1;
+    }
+}